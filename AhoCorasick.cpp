@@ -0,0 +1,136 @@
+#include "AhoCorasick.h"
+
+#include <QtCore/QHash>
+
+
+AhoCorasick::AhoCorasick(const QStringList& patterns, Qt::CaseSensitivity caseSensitivity)
+{
+    QStringList keys;
+    keys.reserve(patterns.size());
+    for (const QString& pattern : patterns)
+        keys.append((caseSensitivity == Qt::CaseInsensitive) ? pattern.toCaseFolded() : pattern);
+
+    // dense character classes, 0 is reserved for characters which are not part of any pattern
+    QHash<ushort, quint16> classOfChar;
+    for (const QString& key : qAsConst(keys))
+        for (QChar c : key)
+            if (!classOfChar.contains(c.unicode()))
+                classOfChar.insert(c.unicode(), static_cast<quint16>(classOfChar.size() + 1));
+    m_classCount = classOfChar.size() + 1;
+    m_charClasses.fill(0, 0x10000);
+    if (caseSensitivity == Qt::CaseInsensitive)
+    {
+        for (int u = 0; u < 0x10000; ++u)
+            m_charClasses[u] = classOfChar.value(QChar(static_cast<ushort>(u)).toCaseFolded().unicode(), 0);
+    }
+    else
+    {
+        for (auto iter = classOfChar.cbegin(); iter != classOfChar.cend(); ++iter)
+            m_charClasses[iter.key()] = iter.value();
+    }
+
+    // trie; -1 marks missing transition until failure links are resolved
+    auto addState = [this](int depth)
+    {
+        m_transitions.insert(m_transitions.size(), m_classCount, -1);
+        m_depths.append(depth);
+        m_outputs.append(-1);
+        return m_stateCount++;
+    };
+    addState(0);
+    m_patternLengths.reserve(keys.size());
+    for (int patternIdx = 0; patternIdx < keys.size(); ++patternIdx)
+    {
+        const QString& key = keys.at(patternIdx);
+        m_patternLengths.append(key.size());
+        if (key.isEmpty())
+            continue;
+        int state = 0;
+        for (QChar c : key)
+        {
+            const int transitionIdx = state * m_classCount + classOfChar.value(c.unicode());
+            if (m_transitions.at(transitionIdx) == -1)
+            {
+                const int newState = addState(m_depths.at(state) + 1);
+                m_transitions[transitionIdx] = newState;
+            }
+            state = m_transitions.at(transitionIdx);
+        }
+        if (m_outputs.at(state) == -1)
+            m_outputs[state] = patternIdx;
+    }
+
+    // breadth-first: failure link of a state is shallower, so its transitions and output are final when the state is processed
+    QVector<int> failures(m_stateCount, 0);
+    QVector<int> queue;
+    queue.reserve(m_stateCount);
+    for (int c = 0; c < m_classCount; ++c)
+    {
+        int& next = m_transitions[c];
+        if (next == -1)
+            next = 0;
+        else
+            queue.append(next);
+    }
+    for (int queueIdx = 0; queueIdx < queue.size(); ++queueIdx)
+    {
+        const int state = queue.at(queueIdx);
+        const int failure = failures.at(state);
+        if (m_outputs.at(state) == -1)
+            m_outputs[state] = m_outputs.at(failure);
+        for (int c = 0; c < m_classCount; ++c)
+        {
+            int& next = m_transitions[state * m_classCount + c];
+            const int failureNext = m_transitions.at(failure * m_classCount + c);
+            if (next == -1)
+            {
+                next = failureNext;
+            }
+            else
+            {
+                failures[next] = failureNext;
+                queue.append(next);
+            }
+        }
+    }
+}
+
+void AhoCorasick::findAll(const QString& text, QVector<Match>& matches) const
+{
+    Match match;
+    int from = 0;
+    while (findNext(text, from, match))
+    {
+        matches.append(match);
+        from = match.start + match.length;
+    }
+}
+
+bool AhoCorasick::findNext(const QString& text, int from, Match& match) const
+{
+    if (isEmpty())
+        return false;
+    const QChar* data = text.constData();
+    const int size = text.size();
+    int state = 0;
+    Match candidate{-1, 0, -1};
+    for (int i = qMax(from, 0); i < size; ++i)
+    {
+        state = m_transitions.at(state * m_classCount + m_charClasses.at(data[i].unicode()));
+        const int patternIdx = m_outputs.at(state);
+        if (patternIdx != -1)
+        {
+            const int length = m_patternLengths.at(patternIdx);
+            const int start = i + 1 - length;
+            if ((candidate.patternIdx == -1) || (start < candidate.start) || ((start == candidate.start) && (length > candidate.length)))
+                candidate = {start, length, patternIdx};
+        }
+        // any later match starts within text spelled by current state, so once that begins after candidate's start nothing can beat it
+        if ((candidate.patternIdx != -1) && ((candidate.start < i + 1 - m_depths.at(state)) || (i + 1 == size)))
+        {
+            match = candidate;
+            return true;
+        }
+    }
+    return false;
+}
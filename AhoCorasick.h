@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+/* Aho-Corasick automaton over a set of literal patterns; finds all of them in a single pass over the text.
+ * Built as a full DFA: characters used by patterns are mapped to dense classes, every other character to class 0,
+ * so each text character costs one table lookup regardless of the number of patterns.
+ * Case insensitive automaton matches case folded patterns against case folded characters. */
+class AhoCorasick
+{
+public:
+    struct Match
+    {
+        int start;
+        int length;
+        int patternIdx; // index in patterns passed to constructor
+    };
+
+    AhoCorasick() = default;
+    // Empty patterns are ignored; of identical patterns the first one is reported
+    AhoCorasick(const QStringList& patterns, Qt::CaseSensitivity caseSensitivity);
+
+    bool isEmpty() const { return m_stateCount <= 1; }
+    int stateCount() const { return m_stateCount; }
+
+    // Appends leftmost-longest non-overlapping matches in text: at each position the longest pattern starting there wins,
+    // and the scan continues after its end
+    void findAll(const QString& text, QVector<Match>& matches) const;
+    // Leftmost-longest match starting at from or later; false if there's none
+    bool findNext(const QString& text, int from, Match& match) const;
+
+private:
+    int m_classCount = 1;
+    int m_stateCount = 0;
+    QVector<quint16> m_charClasses;   // UTF-16 code unit -> character class
+    QVector<int> m_transitions;       // state * m_classCount + class -> state
+    QVector<int> m_depths;            // length of the text spelled by state
+    QVector<int> m_outputs;           // longest pattern ending in state (itself or via suffix links), -1 if none
+    QVector<int> m_patternLengths;
+};
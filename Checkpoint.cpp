@@ -0,0 +1,227 @@
+#include "Checkpoint.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSettings>
+#include <QtCore/QStringList>
+
+#include "Utils.h"
+
+namespace
+{
+
+// Record tags, a record is a line of tab separated fields after its tag
+constexpr char walkedDirTag = 'D';
+constexpr char scannedFileTag = 'F';
+constexpr char scannedDirFilesTag = 'S';
+constexpr char executeTag = 'E';
+constexpr char plannedTag = 'P';
+constexpr char doneTag = 'X';
+
+QByteArray recordOf(char tag, const QStringList& fields)
+{
+    QByteArray record(1, tag);
+    for (const QString& field : fields)
+        record.append('\t').append(escapeLogField(field));
+    record.append('\n');
+    return record;
+}
+
+} // namespace
+
+
+Checkpoint::Checkpoint(const QString& basePath)
+    : m_runFilePath(basePath + ".ini")
+    , m_logFile(basePath + ".log")
+{}
+
+bool Checkpoint::begin(const std::function<void(QSettings& runFile)>& writeRun)
+{
+    discard();
+    {
+        QSettings runFile(m_runFilePath, QSettings::IniFormat);
+        runFile.setValue("Run/started", QDateTime::currentDateTime().toString(Qt::ISODate));
+        writeRun(runFile);
+        runFile.sync();
+        if (runFile.status() != QSettings::NoError)
+            return false;
+    }
+    if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        QFile::remove(m_runFilePath);
+        return false;
+    }
+    m_isActive = true;
+    return true;
+}
+
+bool Checkpoint::resume()
+{
+    reset();
+    if (!QFileInfo::exists(m_runFilePath) || !m_logFile.open(QIODevice::ReadWrite | QIODevice::Append))
+        return false;
+    m_logFile.seek(0);
+    const QByteArray logData = m_logFile.readAll();
+    load(logData);
+    // records go on after a torn one, not into it
+    if (!logData.isEmpty() && !logData.endsWith('\n'))
+        m_logFile.write("\n");
+    m_isActive = true;
+    m_isResumed = true;
+    return true;
+}
+
+void Checkpoint::discard()
+{
+    reset();
+    m_logFile.remove();
+    QFile::remove(m_runFilePath);
+}
+
+void Checkpoint::reset()
+{
+    m_isActive = false;
+    m_isResumed = false;
+    m_stage = Stage::Search;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_buffer.clear();
+    }
+    m_walkedDirs.clear();
+    m_scannedDirs.clear();
+    m_scannedFiles.clear();
+    m_plannedLines.clear();
+    m_doneEntries.clear();
+    m_logFile.close();
+}
+
+void Checkpoint::readRun(const std::function<void(QSettings& runFile)>& readRun) const
+{
+    QSettings runFile(m_runFilePath, QSettings::IniFormat);
+    readRun(runFile);
+}
+
+void Checkpoint::beginExecute()
+{
+    m_stage = Stage::Execute;
+    add(executeTag, QStringList());
+}
+
+void Checkpoint::addWalkedDir(const QString& dirPath)
+{
+    add(walkedDirTag, {dirPath});
+}
+
+void Checkpoint::addScannedDirFiles(const QString& dirPath)
+{
+    add(scannedDirFilesTag, {dirPath});
+}
+
+void Checkpoint::addScannedFiles(const QStringList& filePaths)
+{
+    if (!m_isActive || filePaths.isEmpty())
+        return;
+    QByteArray records;
+    for (const QString& filePath : filePaths)
+        records.append(recordOf(scannedFileTag, {filePath}));
+    QMutexLocker locker(&m_mutex);
+    m_buffer.append(records);
+}
+
+void Checkpoint::addPlanned(int step, const QString& path, const QVector<int>& lineIdxs)
+{
+    QStringList lineNumbers;
+    lineNumbers.reserve(lineIdxs.size());
+    for (int lineIdx : lineIdxs)
+        lineNumbers.append(QString::number(lineIdx));
+    add(plannedTag, {QString::number(step), path, lineNumbers.join(',')});
+}
+
+void Checkpoint::addDone(int step, const QString& path)
+{
+    add(doneTag, {QString::number(step), path});
+}
+
+void Checkpoint::flush()
+{
+    QByteArray records;
+    {
+        QMutexLocker locker(&m_mutex);
+        records.swap(m_buffer);
+    }
+    if (records.isEmpty() || !m_logFile.isOpen())
+        return;
+    m_logFile.write(records);
+    m_logFile.flush();
+}
+
+bool Checkpoint::isPending(int step, const QString& path, QVector<int>* pLineIdxs) const
+{
+    const QPair<int, QString> entryKey(step, path);
+    auto planIter = m_plannedLines.constFind(entryKey);
+    if ((planIter == m_plannedLines.constEnd()) || m_doneEntries.contains(entryKey))
+        return false;
+    if (pLineIdxs != nullptr)
+        *pLineIdxs = planIter.value();
+    return true;
+}
+
+void Checkpoint::add(char tag, const QStringList& fields)
+{
+    if (!m_isActive)
+        return;
+    const QByteArray record = recordOf(tag, fields);
+    QMutexLocker locker(&m_mutex);
+    m_buffer.append(record);
+}
+
+void Checkpoint::load(const QByteArray& logData)
+{
+    int lineBegin = 0;
+    for (int lineEnd = logData.indexOf('\n'); lineEnd != -1; lineBegin = lineEnd + 1, lineEnd = logData.indexOf('\n', lineBegin))
+    {
+        const QList<QByteArray> fields = logData.mid(lineBegin, lineEnd - lineBegin).split('\t');
+        const QByteArray& tag = fields.front();
+        if (tag.size() != 1)
+            continue;
+        switch (tag.at(0))
+        {
+        case walkedDirTag:
+            if (fields.size() >= 2)
+                m_walkedDirs.insert(unescapeLogField(fields.at(1)));
+            break;
+        case scannedFileTag:
+            if (fields.size() >= 2)
+                m_scannedFiles.insert(unescapeLogField(fields.at(1)));
+            break;
+        case scannedDirFilesTag:
+            if (fields.size() >= 2)
+                m_scannedDirs.insert(unescapeLogField(fields.at(1)));
+            break;
+        case executeTag:
+            // plan of a resumed execute holds what was left of the one before it
+            m_stage = Stage::Execute;
+            m_plannedLines.clear();
+            m_doneEntries.clear();
+            break;
+        case plannedTag:
+            if (fields.size() >= 4)
+            {
+                QVector<int> lineIdxs;
+                for (const QByteArray& lineNumber : fields.at(3).split(','))
+                {
+                    if (!lineNumber.isEmpty())
+                        lineIdxs.append(lineNumber.toInt());
+                }
+                m_plannedLines.insert(qMakePair(fields.at(1).toInt(), unescapeLogField(fields.at(2))), lineIdxs);
+            }
+            break;
+        case doneTag:
+            if (fields.size() >= 3)
+                m_doneEntries.insert(qMakePair(fields.at(1).toInt(), unescapeLogField(fields.at(2))));
+            break;
+        default:
+            break;
+        }
+    }
+}
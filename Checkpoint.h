@@ -0,0 +1,86 @@
+#pragma once
+
+#include <functional>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QPair>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+class QSettings;
+
+/* Progress of the current search or execute, kept so that a run interrupted by a crash or by closing the window can be resumed
+ * on the next start. The run (its settings) is described once in <basePath>.ini, its progress is appended to <basePath>.log
+ * as records of what's been done:
+ *  - directories whose whole subtree was walked without results: a resumed search doesn't enter them;
+ *  - directories whose own files were all scanned without results (a subdirectory had some): a resumed search doesn't read them;
+ *  - files scanned without results in directories where other files had some: a resumed search doesn't read them;
+ *  - entries an execute was started with (with lines checked in file contents entries) and each one it has done.
+ * Parts of the tree with results are walked again on resume, which rebuilds their results at the cost of listing their
+ * directories and reading files with results. A resumed execute then runs planned entries that aren't done yet.
+ * Records are added from any thread into a buffer and appended to the log by flush(), which GUI thread calls a few times
+ * per second, so adding one costs a lock and a copy; records of a directory's files are added at once. The log isn't synced: it survives the application going down, not the
+ * machine. A record torn by a crash is the last line of the log and is ignored. */
+class Checkpoint
+{
+public:
+    enum class Stage { Search, Execute };
+
+    explicit Checkpoint(const QString& basePath);
+
+    // Starts recording a new run in place of any previous checkpoint; writeRun(runFile) describes the run
+    bool begin(const std::function<void(QSettings& runFile)>& writeRun);
+    // Loads the checkpoint of an interrupted run and goes on recording into it; false if there's none
+    bool resume();
+    // Run is finished or isn't going to be resumed: stops recording and removes the checkpoint
+    void discard();
+    bool isActive() const { return m_isActive; }
+    bool isResumed() const { return m_isResumed; }
+
+    void readRun(const std::function<void(QSettings& runFile)>& readRun) const;
+    // Execute stage starts with an empty plan, previous plan and what's done of it are kept until resumed run has used them
+    void beginExecute();
+    Stage stage() const { return m_stage; }
+
+    // Called from any thread while the run goes on, nothing is recorded unless active.
+    // step is the execute step (preset) path belongs to, lineIdxs are checked lines of a file contents entry.
+    void addWalkedDir(const QString& dirPath);
+    void addScannedDirFiles(const QString& dirPath);
+    void addScannedFiles(const QStringList& filePaths);
+    void addPlanned(int step, const QString& path, const QVector<int>& lineIdxs = QVector<int>());
+    void addDone(int step, const QString& path);
+    // Appends records added since the last flush to the log; GUI thread only
+    void flush();
+
+    // What the interrupted run had done, as loaded by resume(); read-only afterwards, so safe to use from any thread
+    bool isWalkedDir(const QString& dirPath) const { return m_walkedDirs.contains(dirPath); }
+    bool isScannedDirFiles(const QString& dirPath) const { return m_scannedDirs.contains(dirPath); }
+    bool isScannedFile(const QString& filePath) const { return m_scannedFiles.contains(filePath); }
+    bool hasPlan() const { return !m_plannedLines.isEmpty(); }
+    // Whether path was planned for execute step and isn't done yet; pLineIdxs receives its checked lines
+    bool isPending(int step, const QString& path, QVector<int>* pLineIdxs = nullptr) const;
+
+private:
+    // Stops recording and forgets loaded checkpoint, files stay
+    void reset();
+    void add(char tag, const QStringList& fields);
+    void load(const QByteArray& logData);
+
+    QString m_runFilePath;
+    QFile m_logFile;
+    bool m_isActive = false;
+    bool m_isResumed = false;
+    Stage m_stage = Stage::Search;
+    QMutex m_mutex;       // guards m_buffer
+    QByteArray m_buffer;  // records not written yet
+    QSet<QString> m_walkedDirs;
+    QSet<QString> m_scannedDirs;
+    QSet<QString> m_scannedFiles;
+    QHash<QPair<int, QString>, QVector<int>> m_plannedLines;
+    QSet<QPair<int, QString>> m_doneEntries;
+};
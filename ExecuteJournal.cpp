@@ -0,0 +1,318 @@
+#include "ExecuteJournal.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QSaveFile>
+
+#include "FileFingerprint.h"
+#include "RenamePlan.h"
+#include "Utils.h"
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+static const QString journalDirName = ".qMultiFileEditor_journal";
+
+namespace
+{
+
+// Index record tags, a record is a line of tab separated fields after its tag
+constexpr char editTag = 'E';
+constexpr char renameTag = 'R';
+
+// Makes dstPath share all data extents of srcPath; dstPath is created if isNewFile, otherwise its contents are replaced
+bool cloneFile(const QString& srcPath, const QString& dstPath, bool isNewFile)
+{
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+    const int srcFd = ::open(QFile::encodeName(srcPath).constData(), O_RDONLY | O_CLOEXEC);
+    if (srcFd == -1)
+        return false;
+    const int dstFlags = isNewFile ? (O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC) : (O_WRONLY | O_TRUNC | O_CLOEXEC);
+    const int dstFd = ::open(QFile::encodeName(dstPath).constData(), dstFlags, 0600);
+    const bool isOk = (dstFd != -1) && (::ioctl(dstFd, FICLONE, srcFd) == 0);
+    if (dstFd != -1)
+        ::close(dstFd);
+    ::close(srcFd);
+    if (!isOk && isNewFile && (dstFd != -1))
+        ::unlink(QFile::encodeName(dstPath).constData());
+    return isOk;
+#else
+    Q_UNUSED(srcPath)
+    Q_UNUSED(dstPath)
+    Q_UNUSED(isNewFile)
+    return false;
+#endif
+}
+
+bool writeFileData(const QString& filePath, const QByteArray& data, QString& errorText)
+{
+    QFile file(filePath);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate) && (file.write(data) == data.size()))
+        return true;
+    errorText = file.errorString();
+    return false;
+}
+
+// Where path is after renames of one step: every renamed ancestor (or path itself) gets its new name
+QString renamedPath(const QString& path, const QHash<QString, QString>& newNameByOldPath, QHash<QString, QString>& renamedPathCache)
+{
+    auto cacheIter = renamedPathCache.constFind(path);
+    if (cacheIter != renamedPathCache.constEnd())
+        return cacheIter.value();
+    const int separatorIdx = path.lastIndexOf('/');
+    if (separatorIdx <= 0)
+        return path;
+    const QString parentPath = renamedPath(path.left(separatorIdx), newNameByOldPath, renamedPathCache);
+    const QString name = newNameByOldPath.value(path, path.mid(separatorIdx + 1));
+    const QString result = QDir(parentPath).filePath(name);
+    renamedPathCache.insert(path, result);
+    return result;
+}
+
+} // namespace
+
+
+ExecuteJournal::ExecuteJournal(const QString& dirPath)
+    : m_dirPath(dirPath)
+    , m_indexFile(dirPath + "/journal.log")
+{}
+
+QString ExecuteJournal::newDirPath(const QString& rootDirPath)
+{
+    return QString("%1/%2/%3-%4")
+           .arg(rootDirPath, journalDirName, QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"))
+           .arg(QCoreApplication::applicationPid());
+}
+
+bool ExecuteJournal::create(QString& errorText)
+{
+    if (!QDir().mkpath(m_dirPath + "/clones") || !QDir().mkpath(m_dirPath + "/blobs"))
+    {
+        errorText = QString("Failed to create directory %1").arg(m_dirPath);
+        return false;
+    }
+    if (!m_indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        errorText = QString("Failed to create %1: %2").arg(m_indexFile.fileName(), m_indexFile.errorString());
+        return false;
+    }
+    return true;
+}
+
+void ExecuteJournal::nextStep()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_edits.isEmpty() || !m_renames.isEmpty())
+        ++m_step;
+}
+
+bool ExecuteJournal::addEdit(const QString& filePath, QString& errorText)
+{
+    QString cloneName;
+    {
+        QMutexLocker locker(&m_mutex);
+        cloneName = QString("clones/%1").arg(m_cloneCount++);
+    }
+    if (cloneFile(filePath, QString("%1/%2").arg(m_dirPath, cloneName), true))
+    {
+        const qint64 fileSize = QFileInfo(filePath).size();
+        QMutexLocker locker(&m_mutex);
+        if (!appendRecord(editTag, {QString::number(m_step), filePath, cloneName, "1"}))
+        {
+            errorText = QString("Failed to record for undo: %1").arg(m_indexFile.errorString());
+            return false;
+        }
+        m_edits.append(Edit{m_step, filePath, cloneName, true});
+        ++m_usage.clonedCount;
+        m_usage.clonedBytes += fileSize;
+        return true;
+    }
+
+    // no reflinks here, contents are stored instead
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        errorText = QString("Failed to snapshot for undo: %1").arg(file.errorString());
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    const QString blobName = QString("blobs/%1-%2").arg(FileFingerprint::hashOf(data.constData(), data.size()), 16, 16, QChar('0')).arg(data.size());
+    // blob is written while holding the lock, so an edit referring to it never sees it half-written
+    QMutexLocker locker(&m_mutex);
+    if (!m_blobNames.contains(blobName))
+    {
+        // empty contents stay an empty blob, qUncompress() can't tell them from damaged ones
+        const QByteArray compressedData = data.isEmpty() ? QByteArray() : qCompress(data);
+        QSaveFile blobFile(QString("%1/%2").arg(m_dirPath, blobName));
+        if (!blobFile.open(QIODevice::WriteOnly) || (blobFile.write(compressedData) != compressedData.size()) || !blobFile.commit())
+        {
+            errorText = QString("Failed to snapshot for undo: %1").arg(blobFile.errorString());
+            return false;
+        }
+        m_blobNames.insert(blobName);
+        ++m_usage.storedCount;
+        m_usage.storedBytes += compressedData.size();
+    }
+    if (!appendRecord(editTag, {QString::number(m_step), filePath, blobName, "0"}))
+    {
+        errorText = QString("Failed to record for undo: %1").arg(m_indexFile.errorString());
+        return false;
+    }
+    m_edits.append(Edit{m_step, filePath, blobName, false});
+    return true;
+}
+
+void ExecuteJournal::addRename(const QString& parentPath, const QString& oldName, const QString& newName)
+{
+    QMutexLocker locker(&m_mutex);
+    // the rename is done already, a journal missing it is told by close()
+    m_isIndexOk &= appendRecord(renameTag, {QString::number(m_step), parentPath, oldName, newName});
+    m_renames.append(Rename{m_step, parentPath, oldName, newName});
+}
+
+bool ExecuteJournal::close()
+{
+    QMutexLocker locker(&m_mutex);
+    m_indexFile.close();
+    return m_isIndexOk;
+}
+
+ExecuteJournal::Usage ExecuteJournal::usage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_usage;
+}
+
+bool ExecuteJournal::load()
+{
+    QFile indexFile(m_dirPath + "/journal.log");
+    if (!indexFile.open(QIODevice::ReadOnly))
+        return false;
+    m_edits.clear();
+    m_renames.clear();
+    readIndex(indexFile.readAll());
+    return true;
+}
+
+ExecuteJournal::UndoResult ExecuteJournal::undo(std::atomic<qint64>& doneCount, const std::atomic<bool>& isCancelRequested)
+{
+    UndoResult result;
+    QMutex resultMutex;
+    int lastStep = 0;
+    for (const Edit& edit : qAsConst(m_edits))
+        lastStep = qMax(lastStep, edit.step);
+    for (const Rename& rename : qAsConst(m_renames))
+        lastStep = qMax(lastStep, rename.step);
+
+    for (int step = lastStep; step >= 0; --step)
+    {
+        QVector<int> editIdxs;
+        for (int i = 0; i < m_edits.size(); ++i)
+        {
+            if (m_edits.at(i).step == step)
+                editIdxs.append(i);
+        }
+        QtConcurrent::blockingMap(editIdxs, [&](int& editIdx)
+        {
+            if (isCancelRequested.load(std::memory_order_relaxed))
+                return;
+            const Edit& edit = m_edits.at(editIdx);
+            QString errorText;
+            const bool isOk = restore(edit, errorText);
+            doneCount.fetch_add(1, std::memory_order_relaxed);
+            QMutexLocker locker(&resultMutex);
+            if (isOk)
+                ++result.restoredCount;
+            else
+                result.failures.append(QString("%1: %2").arg(edit.filePath, errorText));
+        });
+
+        // renames of a step are reverted from where they ended up, the plan puts children before their renamed parents
+        QHash<QString, QString> newNameByOldPath;
+        for (const Rename& rename : qAsConst(m_renames))
+        {
+            if (rename.step == step)
+                newNameByOldPath.insert(QDir(rename.parentPath).filePath(rename.oldName), rename.newName);
+        }
+        if (newNameByOldPath.isEmpty())
+            continue;
+        QHash<QString, QString> renamedPathCache;
+        RenamePlan plan(doneCount, isCancelRequested);
+        int operationCount = 0;
+        for (const Rename& rename : qAsConst(m_renames))
+        {
+            if (rename.step == step)
+                operationCount = plan.add(renamedPath(rename.parentPath, newNameByOldPath, renamedPathCache), rename.newName, rename.oldName) + 1;
+        }
+        plan.execute();
+        for (int opIdx = 0; opIdx < operationCount; ++opIdx)
+        {
+            const RenamePlan::Operation& operation = plan.operation(opIdx);
+            if (!operation.isDone)
+                continue;
+            if (operation.isOk)
+                ++result.renamedCount;
+            else
+                result.failures.append(QString("%1: %2").arg(QDir(operation.parentPath).filePath(operation.oldName), operation.errorText));
+        }
+    }
+    return result;
+}
+
+bool ExecuteJournal::restore(const Edit& edit, QString& errorText) const
+{
+    const QString snapshotPath = QString("%1/%2").arg(m_dirPath, edit.snapshotName);
+    // written in place, so the file keeps its inode, owner and permissions
+    if (edit.isClone && cloneFile(snapshotPath, edit.filePath, false))
+        return true;
+    QFile snapshotFile(snapshotPath);
+    if (!snapshotFile.open(QIODevice::ReadOnly))
+    {
+        errorText = QString("Snapshot is missing: %1").arg(snapshotFile.errorString());
+        return false;
+    }
+    const QByteArray snapshotData = snapshotFile.readAll();
+    const QByteArray data = (edit.isClone || snapshotData.isEmpty()) ? snapshotData : qUncompress(snapshotData);
+    if (data.isEmpty() && !snapshotData.isEmpty())
+    {
+        errorText = "Snapshot is damaged";
+        return false;
+    }
+    return writeFileData(edit.filePath, data, errorText);
+}
+
+bool ExecuteJournal::appendRecord(char tag, const QStringList& fields)
+{
+    QByteArray record(1, tag);
+    for (const QString& field : fields)
+        record.append('\t').append(escapeLogField(field));
+    record.append('\n');
+    // handed to the system right away: the entry must outlive the application, if not the machine
+    return (m_indexFile.write(record) == record.size()) && m_indexFile.flush();
+}
+
+void ExecuteJournal::readIndex(const QByteArray& indexData)
+{
+    // a record torn by a crash is the last line and has no line end, it's left out
+    int lineBegin = 0;
+    for (int lineEnd = indexData.indexOf('\n'); lineEnd != -1; lineBegin = lineEnd + 1, lineEnd = indexData.indexOf('\n', lineBegin))
+    {
+        const QList<QByteArray> fields = indexData.mid(lineBegin, lineEnd - lineBegin).split('\t');
+        if ((fields.size() < 5) || (fields.front().size() != 1))
+            continue;
+        const int step = fields.at(1).toInt();
+        if (fields.front().at(0) == editTag)
+            m_edits.append(Edit{step, unescapeLogField(fields.at(2)), unescapeLogField(fields.at(3)), fields.at(4) == "1"});
+        else if (fields.front().at(0) == renameTag)
+            m_renames.append(Rename{step, unescapeLogField(fields.at(2)), unescapeLogField(fields.at(3)), unescapeLogField(fields.at(4))});
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+/* Journal of one execute, enough to undo its content edits and renames.
+ * Original contents are snapshotted right before a file is overwritten: cloned with FICLONE where the filesystem supports
+ * reflinks (Btrfs, XFS, bcachefs...), which shares extents with the original and costs no data copy at all; otherwise stored
+ * compressed under their XXH64 and size, so files with the same contents are stored once. Renames are logged as pairs of names.
+ * The journal lives in a hidden directory inside the search root, so clones land on the same filesystem as the files.
+ * Entries are grouped into steps (one per preset of a multi-preset execute); undo replays steps in reverse order, restoring
+ * files of a step in parallel and reverting its renames through a RenamePlan. Removals can't be undone.
+ * Each entry is appended to the index journal.log as it's recorded, an edit before its file is overwritten and a rename
+ * right after it's done, so an execute cut short by a crash leaves a journal of everything it had changed. */
+class ExecuteJournal
+{
+public:
+    struct Usage
+    {
+        int clonedCount = 0;
+        qint64 clonedBytes = 0; // shared with originals, takes no space until either copy changes
+        int storedCount = 0;
+        qint64 storedBytes = 0; // compressed, each distinct contents once
+    };
+
+    struct UndoResult
+    {
+        int restoredCount = 0;
+        int renamedCount = 0;
+        QStringList failures;   // "path: reason"
+    };
+
+    // Journal kept in dirPath, created by create() or read by load()
+    explicit ExecuteJournal(const QString& dirPath);
+    // Journal directory of an execute in rootDirPath
+    static QString newDirPath(const QString& rootDirPath);
+
+    // Creates the journal directory and its index; errorText tells why it failed
+    bool create(QString& errorText);
+    void nextStep();
+    // Snapshots current contents of filePath and records it; it must not be overwritten if this fails. Safe to call from any thread.
+    bool addEdit(const QString& filePath, QString& errorText);
+    // Records a rename that's been done. Safe to call from any thread.
+    void addRename(const QString& parentPath, const QString& oldName, const QString& newName);
+    // Stops recording; false if any entry failed to reach the index
+    bool close();
+    Usage usage() const;
+
+    bool load();
+    int entryCount() const { return m_edits.size() + m_renames.size(); }
+    // doneCount is incremented for every reverted entry; entries not started yet are skipped once isCancelRequested is set
+    UndoResult undo(std::atomic<qint64>& doneCount, const std::atomic<bool>& isCancelRequested);
+
+    const QString& dirPath() const { return m_dirPath; }
+
+private:
+    struct Edit
+    {
+        int step;
+        QString filePath;
+        QString snapshotName;
+        bool isClone;
+    };
+    struct Rename
+    {
+        int step;
+        QString parentPath; // before the rename
+        QString oldName;
+        QString newName;
+    };
+
+    bool restore(const Edit& edit, QString& errorText) const;
+    // Appends a record of tag and fields to the index; m_mutex must be held
+    bool appendRecord(char tag, const QStringList& fields);
+    void readIndex(const QByteArray& indexData);
+
+    QString m_dirPath;
+    int m_step = 0;
+    mutable QMutex m_mutex; // guards members below while recording
+    QFile m_indexFile;
+    bool m_isIndexOk = true;
+    QVector<Edit> m_edits;
+    QVector<Rename> m_renames;
+    QSet<QString> m_blobNames;
+    int m_cloneCount = 0;
+    Usage m_usage;
+};
@@ -0,0 +1,215 @@
+#include "ExecutionPlan.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+
+namespace
+{
+
+const QByteArray planMagic("QMFEPLAN");
+constexpr quint32 planVersion = 1;
+// Fixed so that plans are read the same by any Qt 5 build
+constexpr QDataStream::Version streamVersion = QDataStream::Qt_5_6;
+
+} // namespace
+
+
+int ExecutionPlan::entryCount() const
+{
+    int count = 0;
+    for (const Step& step : steps)
+        count += step.files.size() + step.targets.size();
+    return count;
+}
+
+bool ExecutionPlan::save(const QString& filePath, QString& errorText) const
+{
+    QByteArray data;
+    {
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream.setVersion(streamVersion);
+        stream << rootPaths << static_cast<quint32>(steps.size());
+        for (const Step& step : steps)
+        {
+            stream << step.presetName << static_cast<qint32>(step.actionType) << static_cast<qint32>(step.actionTarget);
+            stream << static_cast<quint32>(step.files.size());
+            for (const FileEdits& file : step.files)
+            {
+                stream << static_cast<qint32>(file.rootIdx) << file.path << file.size << file.contentHash;
+                stream << static_cast<quint32>(file.edits.size());
+                for (const LineEdit& edit : file.edits)
+                    stream << static_cast<qint32>(edit.lineIdx) << static_cast<qint32>(edit.start) << static_cast<qint32>(edit.length) << edit.replacement;
+            }
+            stream << static_cast<quint32>(step.targets.size());
+            for (const Target& target : step.targets)
+                stream << static_cast<qint32>(target.rootIdx) << target.path << target.isDir << target.newName;
+        }
+    }
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        errorText = file.errorString();
+        return false;
+    }
+    // version is big-endian like the rest of the stream, so a plan moves between hosts
+    QByteArray header;
+    {
+        QDataStream headerStream(&header, QIODevice::WriteOnly);
+        headerStream.writeRawData(planMagic.constData(), planMagic.size());
+        headerStream << planVersion;
+    }
+    const QByteArray payload = qCompress(data);
+    if ((file.write(header) != header.size()) || (file.write(payload) != payload.size()) || !file.flush())
+    {
+        errorText = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ExecutionPlan::load(const QString& filePath, QString& errorText)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        errorText = file.errorString();
+        return false;
+    }
+    const QByteArray fileData = file.readAll();
+    quint32 version = 0;
+    const int headerSize = planMagic.size() + static_cast<int>(sizeof(version));
+    if ((fileData.size() < headerSize) || !fileData.startsWith(planMagic))
+    {
+        errorText = "Not an execution plan";
+        return false;
+    }
+    QDataStream headerStream(fileData);
+    headerStream.skipRawData(planMagic.size());
+    headerStream >> version;
+    if (version != planVersion)
+    {
+        errorText = QString("Unsupported plan version %1").arg(version);
+        return false;
+    }
+    const QByteArray data = qUncompress(fileData.mid(headerSize));
+    QDataStream stream(data);
+    stream.setVersion(streamVersion);
+    rootPaths.clear();
+    steps.clear();
+    bool isActionKnown = true;
+    // a plan may come from anywhere, it's run against the roots given to it and must not reach out of them
+    bool isEveryEntryInRoot = true;
+    quint32 stepCount = 0;
+    stream >> rootPaths >> stepCount;
+    // counts are trusted no further than the data goes: a short or damaged stream stops reading
+    for (quint32 stepIdx = 0; (stepIdx < stepCount) && (stream.status() == QDataStream::Ok); ++stepIdx)
+    {
+        Step step;
+        qint32 actionType = 0;
+        qint32 actionTarget = 0;
+        quint32 fileCount = 0;
+        stream >> step.presetName >> actionType >> actionTarget >> fileCount;
+        step.actionType = static_cast<ActionType>(actionType);
+        step.actionTarget = static_cast<ActionTarget>(actionTarget);
+        isActionKnown = isActionKnown && ((step.actionType == ActionType::Remove) || (step.actionType == ActionType::Replace))
+                        && ((step.actionTarget == ActionTarget::Files) || (step.actionTarget == ActionTarget::Dirs)
+                            || (step.actionTarget == ActionTarget::FilesDirs) || (step.actionTarget == ActionTarget::FileContents));
+        for (quint32 fileIdx = 0; (fileIdx < fileCount) && (stream.status() == QDataStream::Ok); ++fileIdx)
+        {
+            FileEdits fileEdits;
+            qint32 rootIdx = 0;
+            quint32 editCount = 0;
+            stream >> rootIdx >> fileEdits.path >> fileEdits.size >> fileEdits.contentHash >> editCount;
+            fileEdits.rootIdx = rootIdx;
+            isEveryEntryInRoot = isEveryEntryInRoot && isInRoot(fileEdits.rootIdx, fileEdits.path);
+            for (quint32 editIdx = 0; (editIdx < editCount) && (stream.status() == QDataStream::Ok); ++editIdx)
+            {
+                qint32 lineIdx = 0;
+                qint32 start = 0;
+                qint32 length = 0;
+                QString replacement;
+                stream >> lineIdx >> start >> length >> replacement;
+                fileEdits.edits.append(LineEdit{lineIdx, start, length, replacement});
+            }
+            step.files.append(fileEdits);
+        }
+        quint32 targetCount = 0;
+        stream >> targetCount;
+        for (quint32 targetIdx = 0; (targetIdx < targetCount) && (stream.status() == QDataStream::Ok); ++targetIdx)
+        {
+            Target target;
+            qint32 rootIdx = 0;
+            stream >> rootIdx >> target.path >> target.isDir >> target.newName;
+            target.rootIdx = rootIdx;
+            isEveryEntryInRoot = isEveryEntryInRoot && isInRoot(target.rootIdx, target.path);
+            step.targets.append(target);
+        }
+        steps.append(step);
+    }
+    if (data.isEmpty() || (stream.status() != QDataStream::Ok) || rootPaths.isEmpty() || !isActionKnown)
+    {
+        errorText = "Plan file is damaged";
+        return false;
+    }
+    if (!isEveryEntryInRoot)
+    {
+        errorText = "Plan has entries outside of its search roots";
+        return false;
+    }
+    return true;
+}
+
+bool ExecutionPlan::locate(const QString& absolutePath, int& rootIdx, QString& relativePath) const
+{
+    for (int i = 0; i < rootPaths.size(); ++i)
+    {
+        if (absolutePath.startsWith(rootPaths.at(i) + '/'))
+        {
+            rootIdx = i;
+            relativePath = QDir(rootPaths.at(i)).relativeFilePath(absolutePath);
+            return isInRoot(rootIdx, relativePath);
+        }
+    }
+    return false;
+}
+
+QString ExecutionPlan::absolutePath(int rootIdx, const QString& relativePath) const
+{
+    return QDir::cleanPath(QDir(rootPaths.value(rootIdx)).filePath(relativePath));
+}
+
+bool ExecutionPlan::isInRoot(int rootIdx, const QString& relativePath) const
+{
+    if ((rootIdx < 0) || (rootIdx >= rootPaths.size()) || relativePath.isEmpty() || QDir::isAbsolutePath(relativePath))
+        return false;
+    const QString cleanPath = QDir::cleanPath(relativePath);
+    return (cleanPath != ".") && (cleanPath != "..") && !cleanPath.startsWith("../");
+}
+
+ExecutionPlan::LineEdit ExecutionPlan::lineEditOf(int lineIdx, const QString& line, const QString& replacedLine)
+{
+    const int maxLength = qMin(line.size(), replacedLine.size());
+    int prefixLength = 0;
+    while ((prefixLength < maxLength) && (line.at(prefixLength) == replacedLine.at(prefixLength)))
+        ++prefixLength;
+    int suffixLength = 0;
+    while ((suffixLength < maxLength - prefixLength)
+           && (line.at(line.size() - 1 - suffixLength) == replacedLine.at(replacedLine.size() - 1 - suffixLength)))
+        ++suffixLength;
+    return LineEdit{lineIdx, prefixLength, line.size() - prefixLength - suffixLength,
+                    replacedLine.mid(prefixLength, replacedLine.size() - prefixLength - suffixLength)};
+}
+
+bool ExecutionPlan::isApplicable(const LineEdit& edit, const QStringList& lines)
+{
+    return (edit.lineIdx >= 0) && (edit.lineIdx < lines.size()) && (edit.start >= 0) && (edit.length >= 0)
+        && (edit.start + edit.length <= lines.at(edit.lineIdx).size());
+}
+
+QString ExecutionPlan::replaced(const QString& line, const LineEdit& edit)
+{
+    QString result = line;
+    result.replace(edit.start, edit.length, edit.replacement);
+    return result;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+#include "Utils.h"
+
+/* Checked results of a search saved to be executed later: in another session, or headless on another machine with the same tree.
+ * A step per executed search (preset), each with what its execute would do:
+ *  - files of file contents results with size and XXH64 of their contents as the search read them, and an edit per checked line:
+ *    the range of the line its matches cover and what the range is replaced with;
+ *  - targets of remove or rename results, with their type and new name.
+ * Paths are kept relative to search roots, so the tree may be somewhere else when the plan is loaded, roots can be given anew.
+ * Loading doesn't search again: it reads only files of the plan and checks their size and hash, which also gives back lines the
+ * edits apply to, and checks that targets are still there with the same type. Entries that fail are shown and not executed.
+ * The file is a short header and the plan serialized by QDataStream, compressed with qCompress. */
+struct ExecutionPlan
+{
+    struct LineEdit
+    {
+        int lineIdx;
+        int start;          // replaced range of the line
+        int length;
+        QString replacement;
+    };
+    struct FileEdits
+    {
+        int rootIdx;
+        QString path;       // relative to the root
+        qint64 size;        // of contents the edits were planned on
+        quint64 contentHash;
+        QVector<LineEdit> edits;
+    };
+    struct Target
+    {
+        int rootIdx;
+        QString path;       // relative to the root
+        bool isDir;
+        QString newName;    // empty for remove
+    };
+    struct Step
+    {
+        QString presetName; // empty for a single search
+        ActionType actionType;
+        ActionTarget actionTarget;
+        QVector<FileEdits> files;
+        QVector<Target> targets;
+    };
+
+    QStringList rootPaths;
+    QVector<Step> steps;
+
+    int entryCount() const;
+    bool save(const QString& filePath, QString& errorText) const;
+    bool load(const QString& filePath, QString& errorText);
+
+    // Root of absolutePath (first one it's in) and the path relative to it; false if it's in none of them
+    bool locate(const QString& absolutePath, int& rootIdx, QString& relativePath) const;
+    QString absolutePath(int rootIdx, const QString& relativePath) const;
+    // Whether rootIdx is a root of the plan and relativePath names an entry inside it, not the root or anything above it
+    bool isInRoot(int rootIdx, const QString& relativePath) const;
+
+    // Single edit taking line to replacedLine: the range between their common prefix and common suffix
+    static LineEdit lineEditOf(int lineIdx, const QString& line, const QString& replacedLine);
+    // false if edit doesn't fit line
+    static bool isApplicable(const LineEdit& edit, const QStringList& lines);
+    static QString replaced(const QString& line, const LineEdit& edit);
+};
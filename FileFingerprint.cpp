@@ -0,0 +1,172 @@
+#include "FileFingerprint.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+
+// FAT keeps 2 s, ext3 and HFS+ 1 s; a write within this window after capture may leave mtime unchanged
+constexpr qint64 racyWindowNs = 2000000000LL;
+
+struct Metadata
+{
+    qint64 size = -1;
+    qint64 mtimeNs = 0;
+    quint64 inode = 0;
+};
+
+bool readMetadata(const QString& filePath, Metadata& metadata)
+{
+#if defined(Q_OS_LINUX) && defined(STATX_BASIC_STATS)
+    struct statx fileStatx;
+    if (::statx(AT_FDCWD, QFile::encodeName(filePath).constData(), 0, STATX_SIZE | STATX_MTIME | STATX_INO, &fileStatx) == 0)
+    {
+        metadata.size = static_cast<qint64>(fileStatx.stx_size);
+        metadata.mtimeNs = static_cast<qint64>(fileStatx.stx_mtime.tv_sec) * 1000000000LL + fileStatx.stx_mtime.tv_nsec;
+        metadata.inode = fileStatx.stx_ino;
+        return true;
+    }
+    if (errno != ENOSYS) // else kernel predates statx()
+        return false;
+#endif
+    const QFileInfo fileInfo(filePath);
+    if (!fileInfo.exists())
+        return false;
+    metadata.size = fileInfo.size();
+    metadata.mtimeNs = fileInfo.lastModified().toMSecsSinceEpoch() * 1000000LL;
+    metadata.inode = 0;
+    return true;
+}
+
+constexpr quint64 prime1 = 0x9E3779B185EBCA87ULL;
+constexpr quint64 prime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr quint64 prime3 = 0x165667B19E3779F9ULL;
+constexpr quint64 prime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr quint64 prime5 = 0x27D4EB2F165667C5ULL;
+
+inline quint64 rotl(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline quint64 read64(const char* data)
+{
+    quint64 value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline quint32 read32(const char* data)
+{
+    quint32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline quint64 mixRound(quint64 acc, quint64 input)
+{
+    return rotl(acc + input * prime2, 31) * prime1;
+}
+
+inline quint64 mergeRound(quint64 acc, quint64 value)
+{
+    return (acc ^ mixRound(0, value)) * prime1 + prime4;
+}
+
+} // namespace
+
+
+FileFingerprint FileFingerprint::ofMetadata(const QString& filePath)
+{
+    Metadata metadata;
+    if (!readMetadata(filePath, metadata))
+        return FileFingerprint();
+    return ofMetadata(metadata.size, metadata.mtimeNs, metadata.inode);
+}
+
+FileFingerprint FileFingerprint::ofMetadata(qint64 size, qint64 mtimeNs, quint64 inode)
+{
+    FileFingerprint fingerprint;
+    fingerprint.size = size;
+    fingerprint.mtimeNs = mtimeNs;
+    fingerprint.inode = inode;
+    fingerprint.isRacy = (QDateTime::currentMSecsSinceEpoch() * 1000000LL - mtimeNs) < racyWindowNs;
+    return fingerprint;
+}
+
+bool FileFingerprint::isUnchangedAt(const QString& filePath) const
+{
+    if (!isValid())
+        return true;
+    Metadata metadata;
+    if (!readMetadata(filePath, metadata) || (metadata.size != size))
+        return false;
+    if ((metadata.mtimeNs == mtimeNs) && (metadata.inode == inode) && !isRacy)
+        return true;
+    // raw bytes, as FileReader reads them for the search
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const QByteArray data = file.readAll();
+    return hashOf(data.constData(), data.size()) == contentHash;
+}
+
+quint64 FileFingerprint::hashOf(const char* data, qint64 size, quint64 seed)
+{
+    const char* const pEnd = data + size;
+    quint64 hash;
+    if (size >= 32)
+    {
+        // four independent lanes keep the multiplier pipeline full
+        quint64 v1 = seed + prime1 + prime2;
+        quint64 v2 = seed + prime2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - prime1;
+        const char* const pLimit = pEnd - 32;
+        do
+        {
+            v1 = mixRound(v1, read64(data));
+            v2 = mixRound(v2, read64(data + 8));
+            v3 = mixRound(v3, read64(data + 16));
+            v4 = mixRound(v4, read64(data + 24));
+            data += 32;
+        } while (data <= pLimit);
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    }
+    else
+    {
+        hash = seed + prime5;
+    }
+    hash += static_cast<quint64>(size);
+
+    for (; data + 8 <= pEnd; data += 8)
+        hash = rotl(hash ^ mixRound(0, read64(data)), 27) * prime1 + prime4;
+    if (data + 4 <= pEnd)
+    {
+        hash = rotl(hash ^ (static_cast<quint64>(read32(data)) * prime1), 23) * prime2 + prime3;
+        data += 4;
+    }
+    for (; data < pEnd; ++data)
+        hash = rotl(hash ^ (static_cast<quint64>(static_cast<unsigned char>(*data)) * prime5), 11) * prime1;
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+
+/* Cheap identity of file contents taken while a search reads the file, used by execute to avoid overwriting files that
+ * changed meanwhile (an editor saving, a build running) with stale lines.
+ * Metadata is taken before the file is read, so a change during reading shows up as a mismatch later, never as a match.
+ * Verification compares metadata first (statx() on Linux, only the fields needed) and re-reads and re-hashes contents only
+ * when metadata can't tell: same size but different mtime or inode (touched, or saved by rename with the same contents),
+ * or mtime too close to the capture for coarse filesystem timestamps to tell a later write apart.
+ * Contents hash is XXH64 of the bytes as read by the search. */
+struct FileFingerprint
+{
+    qint64 size = -1;         // -1 if not captured, such file is never reported as changed
+    qint64 mtimeNs = 0;
+    quint64 inode = 0;
+    quint64 contentHash = 0;
+    bool isRacy = false;      // modified within timestamp granularity before capture
+
+    bool isValid() const { return size >= 0; }
+    // Takes metadata of filePath; call before reading the file, then setContent() with the data read
+    static FileFingerprint ofMetadata(const QString& filePath);
+    // Same from metadata already taken (e.g. by a batched statx)
+    static FileFingerprint ofMetadata(qint64 size, qint64 mtimeNs, quint64 inode);
+    void setContent(const QByteArray& data) { contentHash = hashOf(data.constData(), data.size()); }
+    // false if file at filePath was changed, replaced by a different one or removed since capture
+    bool isUnchangedAt(const QString& filePath) const;
+
+    static quint64 hashOf(const char* data, qint64 size, quint64 seed = 0);
+};
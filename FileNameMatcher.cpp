@@ -0,0 +1,448 @@
+#include "FileNameMatcher.h"
+
+#include "Utils.h"
+
+
+namespace {
+
+// Upper limit of alternatives a regex may expand to (e.g. "(a|b)(c|d)?" expands to 6); larger ones go to PCRE
+constexpr int maxAlternatives = 256;
+
+struct Token
+{
+    enum Kind { Char, AnyChar, Gap, Begin, End };
+    Kind kind;
+    QChar ch = QChar();
+    int minGap = 0;
+};
+using Sequence = QVector<Token>;
+using Alternatives = QVector<Sequence>;
+
+/* Expands the supported regex subset into the list of plain token sequences.
+ * Any construct outside of the subset makes parse() fail, and the whole pattern is left to PCRE. */
+class RegExpParser
+{
+public:
+    explicit RegExpParser(const QString& pattern) : m_pattern(pattern) {}
+
+    bool parse(Alternatives& result)
+    {
+        return parseAlternation(result) && (m_pos == m_pattern.size());
+    }
+
+private:
+    bool parseAlternation(Alternatives& result)
+    {
+        while (true)
+        {
+            Alternatives sequences;
+            if (!parseSequence(sequences))
+                return false;
+            result += sequences;
+            if (result.size() > maxAlternatives)
+                return false;
+            if (!isAt('|'))
+                return true;
+            ++m_pos;
+        }
+    }
+
+    bool parseSequence(Alternatives& result)
+    {
+        result = {Sequence()};
+        while ((m_pos < m_pattern.size()) && !isAt('|') && !isAt(')'))
+        {
+            const QChar c = m_pattern.at(m_pos);
+            Alternatives atom;
+            if (c == '(')
+            {
+                ++m_pos;
+                if (m_pattern.midRef(m_pos, 2) == QLatin1String("?:"))
+                    m_pos += 2;
+                else if (isAt('?')) // lookarounds, named groups, inline options
+                    return false;
+                if (!parseAlternation(atom) || !isAt(')'))
+                    return false;
+                ++m_pos;
+            }
+            else if (c == '.')
+            {
+                ++m_pos;
+                if (isAt('*') || isAt('+'))
+                {
+                    const int minGap = isAt('+') ? 1 : 0;
+                    ++m_pos;
+                    if (isAt('?') || isAt('+')) // lazy and possessive quantifiers don't change what matches, but keep it simple
+                        return false;
+                    for (Sequence& sequence : result)
+                        sequence.append({Token::Gap, QChar(), minGap});
+                    continue;
+                }
+                atom = {Sequence{{Token::AnyChar}}};
+            }
+            else if (c == '^')
+            {
+                ++m_pos;
+                atom = {Sequence{{Token::Begin}}};
+            }
+            else if (c == '$')
+            {
+                ++m_pos;
+                atom = {Sequence{{Token::End}}};
+            }
+            else if (c == '\\')
+            {
+                if (m_pos + 1 >= m_pattern.size())
+                    return false;
+                const QChar escaped = m_pattern.at(m_pos + 1);
+                if (escaped.isLetterOrNumber()) // character classes, assertions, back-references
+                    return false;
+                m_pos += 2;
+                atom = {Sequence{{Token::Char, escaped}}};
+            }
+            else if (QStringLiteral("[]{}*+?").contains(c))
+            {
+                return false;
+            }
+            else
+            {
+                ++m_pos;
+                atom = {Sequence{{Token::Char, c}}};
+            }
+
+            if (isAt('?'))
+            {
+                ++m_pos;
+                if (isAt('?') || isAt('+'))
+                    return false;
+                atom.append(Sequence());
+            }
+            else if (isAt('*') || isAt('+') || isAt('{'))
+            {
+                return false;
+            }
+
+            if (result.size() * atom.size() > maxAlternatives)
+                return false;
+            Alternatives product;
+            product.reserve(result.size() * atom.size());
+            for (const Sequence& prefix : qAsConst(result))
+                for (const Sequence& suffix : qAsConst(atom))
+                    product.append(prefix + suffix);
+            result = product;
+        }
+        return true;
+    }
+
+    bool isAt(char c) const { return (m_pos < m_pattern.size()) && (m_pattern.at(m_pos) == QLatin1Char(c)); }
+
+    const QString& m_pattern;
+    int m_pos = 0;
+};
+
+inline QChar foldedChar(QChar c, Qt::CaseSensitivity caseSensitivity)
+{
+    return (caseSensitivity == Qt::CaseSensitive) ? c : c.toCaseFolded();
+}
+
+} // namespace
+
+FileNameMatcher::FileNameMatcher(const QRegularExpression& regExp)
+    : m_regExp(regExp)
+{
+    m_caseSensitivity = regExp.patternOptions().testFlag(QRegularExpression::CaseInsensitiveOption) ? Qt::CaseInsensitive : Qt::CaseSensitive;
+    if (!isValid())
+        return;
+    m_regExp.optimize();
+
+    const QRegularExpression::PatternOptions supportedOptions = QRegularExpression::CaseInsensitiveOption
+                                                              | QRegularExpression::DontCaptureOption;
+    QVector<GlobPattern> patterns;
+    if (((regExp.patternOptions() & ~supportedOptions) == QRegularExpression::NoPatternOption) && parseRegExp(regExp.pattern(), patterns))
+    {
+        for (const GlobPattern& pattern : qAsConst(patterns))
+            addAlternative(pattern);
+    }
+    else
+    {
+        m_hasFallback = true;
+        m_fallbackRegExp = m_regExp;
+    }
+}
+
+FileNameMatcher FileNameMatcher::fromWildcardFilters(const QString& filters, Qt::CaseSensitivity caseSensitivity)
+{
+    FileNameMatcher matcher;
+    matcher.m_caseSensitivity = caseSensitivity;
+    QRegularExpression::PatternOptions options = QRegularExpression::DontCaptureOption;
+    if (caseSensitivity == Qt::CaseInsensitive)
+        options |= QRegularExpression::CaseInsensitiveOption;
+    matcher.m_regExp = QRegularExpression(regExpFromWildcardFilters(filters), options);
+    if (!matcher.isValid())
+        return matcher;
+    matcher.m_regExp.optimize();
+
+    QStringList complexGlobs;
+    const QStringList globs = wildcardFiltersFromString(filters);
+    for (const QString& glob : globs)
+    {
+        GlobPattern pattern;
+        if (parseGlob(glob, pattern))
+            matcher.addAlternative(pattern);
+        else
+            complexGlobs.append(QRegularExpression::wildcardToRegularExpression(glob));
+    }
+    if (!complexGlobs.isEmpty())
+    {
+        matcher.m_hasFallback = true;
+        matcher.m_fallbackRegExp = QRegularExpression(complexGlobs.join('|'), options);
+        matcher.m_fallbackRegExp.optimize();
+    }
+    return matcher;
+}
+
+bool FileNameMatcher::matches(const QString& fileName) const
+{
+    if (m_isMatchAll)
+        return true;
+    const QChar* data = fileName.constData();
+    const int size = fileName.size();
+    if (m_hasAnyChar)
+    {
+        // PCRE treats surrogate pair as a single character while segments compare UTF-16 units
+        for (int i = 0; i < size; ++i)
+            if (data[i].isSurrogate())
+                return m_regExp.match(fileName).hasMatch();
+    }
+
+    if (!m_exactNames.isEmpty())
+    {
+        const uint hash = hashOf(data, size);
+        for (auto iter = m_exactNameIndex.constFind(hash); (iter != m_exactNameIndex.cend()) && (iter.key() == hash); ++iter)
+            if (equals(data, size, m_exactNames.at(iter.value())))
+                return true;
+    }
+    if (!m_extensions.isEmpty())
+    {
+        const int dotIdx = fileName.lastIndexOf(QLatin1Char('.'));
+        if (dotIdx != -1)
+        {
+            const QChar* extension = data + dotIdx + 1;
+            const int extensionSize = size - dotIdx - 1;
+            const uint hash = hashOf(extension, extensionSize);
+            for (auto iter = m_extensionIndex.constFind(hash); (iter != m_extensionIndex.cend()) && (iter.key() == hash); ++iter)
+            {
+                const ExtensionEntry& entry = m_extensions.at(iter.value());
+                if ((dotIdx >= entry.minBaseLength) && equals(extension, extensionSize, entry.extension))
+                    return true;
+            }
+        }
+    }
+    for (const GlobPattern& glob : m_globs)
+        if (matchesGlob(fileName, glob))
+            return true;
+    if (m_hasFallback)
+        return m_fallbackRegExp.match(fileName).hasMatch();
+    return false;
+}
+
+void FileNameMatcher::addAlternative(const GlobPattern& pattern)
+{
+    const int gapCount = pattern.segments.size() - 1;
+    bool hasAnyChar = false;
+    for (const Segment& segment : pattern.segments)
+        hasAnyChar |= !segment.anyCharPositions.isEmpty();
+
+    GlobPattern folded = pattern;
+    if (m_caseSensitivity == Qt::CaseInsensitive)
+        for (Segment& segment : folded.segments)
+            segment.text = segment.text.toCaseFolded();
+
+    if ((gapCount == 0) && !hasAnyChar)
+    {
+        m_exactNameIndex.insert(hashOf(folded.segments.front().text.constData(), folded.segments.front().length()), m_exactNames.size());
+        m_exactNames.append(folded.segments.front().text);
+        return;
+    }
+    if ((gapCount == 1) && folded.segments.front().text.isEmpty() && !hasAnyChar)
+    {
+        const QString& tail = folded.segments.back().text;
+        if (tail.isEmpty() && (folded.minGaps.back() <= 1)) // "*", ".*", ".+": names are never empty
+        {
+            m_isMatchAll = true;
+            return;
+        }
+        if ((tail.size() >= 2) && (tail.front() == QLatin1Char('.')) && !tail.midRef(1).contains(QLatin1Char('.')))
+        {
+            const QString extension = tail.mid(1);
+            m_extensionIndex.insert(hashOf(extension.constData(), extension.size()), m_extensions.size());
+            m_extensions.append({extension, folded.minGaps.back()});
+            return;
+        }
+    }
+    m_hasAnyChar |= hasAnyChar;
+    m_globs.append(folded);
+}
+
+bool FileNameMatcher::matchesSegment(const QString& fileName, int position, const Segment& segment) const
+{
+    const QChar* data = fileName.constData() + position;
+    const QChar* text = segment.text.constData();
+    auto anyCharIter = segment.anyCharPositions.cbegin();
+    for (int i = 0; i < segment.length(); ++i)
+    {
+        if ((anyCharIter != segment.anyCharPositions.cend()) && (*anyCharIter == i))
+        {
+            ++anyCharIter;
+            continue;
+        }
+        if (foldedChar(data[i], m_caseSensitivity) != text[i])
+            return false;
+    }
+    return true;
+}
+
+bool FileNameMatcher::matchesGlob(const QString& fileName, const GlobPattern& pattern) const
+{
+    const QVector<Segment>& segments = pattern.segments;
+    const int lastIdx = segments.size() - 1;
+    const Segment& head = segments.front();
+    if ((head.length() > fileName.size()) || !matchesSegment(fileName, 0, head))
+        return false;
+    if (lastIdx == 0)
+        return head.length() == fileName.size();
+
+    // Gaps are unbounded, so leftmost placement of every middle segment is never worse than any other placement
+    const Segment& tail = segments.back();
+    const int tailPos = fileName.size() - tail.length();
+    int pos = head.length();
+    if ((tailPos < pos) || !matchesSegment(fileName, tailPos, tail))
+        return false;
+    for (int i = 1; i < lastIdx; ++i)
+    {
+        const Segment& segment = segments.at(i);
+        pos += pattern.minGaps.at(i);
+        while ((pos + segment.length() <= tailPos) && !matchesSegment(fileName, pos, segment))
+            ++pos;
+        if (pos + segment.length() > tailPos)
+            return false;
+        pos += segment.length();
+    }
+    return pos + pattern.minGaps.at(lastIdx) <= tailPos;
+}
+
+uint FileNameMatcher::hashOf(const QChar* data, int size) const
+{
+    uint hash = 2166136261u; // FNV-1a
+    for (int i = 0; i < size; ++i)
+        hash = (hash ^ foldedChar(data[i], m_caseSensitivity).unicode()) * 16777619u;
+    return hash;
+}
+
+bool FileNameMatcher::equals(const QChar* data, int size, const QString& text) const
+{
+    if (size != text.size())
+        return false;
+    const QChar* textData = text.constData();
+    for (int i = 0; i < size; ++i)
+        if (foldedChar(data[i], m_caseSensitivity) != textData[i])
+            return false;
+    return true;
+}
+
+bool FileNameMatcher::parseGlob(const QString& glob, GlobPattern& pattern)
+{
+    pattern.segments = {Segment()};
+    pattern.minGaps = {0};
+    for (const QChar c : glob)
+    {
+        if (c == QLatin1Char('*'))
+        {
+            if (pattern.segments.back().text.isEmpty() && (pattern.segments.size() > 1))
+                continue; // "**" is the same as "*"
+            pattern.segments.append(Segment());
+            pattern.minGaps.append(0);
+        }
+        else if (c == QLatin1Char('?'))
+        {
+            Segment& segment = pattern.segments.back();
+            segment.anyCharPositions.append(segment.length());
+            segment.text.append(QChar());
+        }
+        else if (c == QLatin1Char('['))
+        {
+            return false;
+        }
+        else
+        {
+            pattern.segments.back().text.append(c);
+        }
+    }
+    return true;
+}
+
+bool FileNameMatcher::parseRegExp(const QString& regExpPattern, QVector<GlobPattern>& patterns)
+{
+    Alternatives alternatives;
+    if (!RegExpParser(regExpPattern).parse(alternatives))
+        return false;
+
+    for (const Sequence& sequence : qAsConst(alternatives))
+    {
+        int begin = 0;
+        int end = sequence.size();
+        bool isAnchoredStart = false;
+        bool isAnchoredEnd = false;
+        while ((begin < end) && (sequence.at(begin).kind == Token::Begin))
+        {
+            isAnchoredStart = true;
+            ++begin;
+        }
+        while ((end > begin) && (sequence.at(end - 1).kind == Token::End))
+        {
+            isAnchoredEnd = true;
+            --end;
+        }
+
+        GlobPattern pattern;
+        pattern.segments = {Segment()};
+        pattern.minGaps = {0};
+        auto appendGap = [&pattern](int minGap)
+        {
+            if (pattern.segments.back().text.isEmpty() && (pattern.segments.size() > 1))
+            {
+                pattern.minGaps.back() += minGap;
+                return;
+            }
+            pattern.segments.append(Segment());
+            pattern.minGaps.append(minGap);
+        };
+        // QRegularExpression::match() searches anywhere in the name, so unanchored side is an implicit ".*"
+        if (!isAnchoredStart)
+            appendGap(0);
+        for (int i = begin; i < end; ++i)
+        {
+            const Token& token = sequence.at(i);
+            Segment& segment = pattern.segments.back();
+            switch (token.kind)
+            {
+            case Token::Char:
+                segment.text.append(token.ch);
+                break;
+            case Token::AnyChar:
+                segment.anyCharPositions.append(segment.length());
+                segment.text.append(QChar());
+                break;
+            case Token::Gap:
+                appendGap(token.minGap);
+                break;
+            default: // anchor in the middle of alternative
+                return false;
+            }
+        }
+        if (!isAnchoredEnd)
+            appendGap(0);
+        patterns.append(pattern);
+    }
+    return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QtCore/QHash>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+/* File name filter compiled into the cheapest structure that can answer it.
+ * Patterns are split into alternatives, each one placed into:
+ *  - exact name lookup ("Makefile", "CMakeCache.txt"),
+ *  - extension lookup ("*.cpp", ".+\.(a|o|exe)"),
+ *  - glob check of literal segments separated by gaps ("moc_*.cpp", "ui_.+\.(h|hpp)", "*.pro.user*"),
+ * Lookups hash the file name in place, so matching an entry doesn't allocate.
+ * PCRE is only used as a fallback for alternatives that can't be expressed this way (character classes, \d, bounded repeats etc.).
+ * Regex patterns are converted when they consist of literals, '.', '.*', '.+', groups of alternatives, '?' after an atom and ^\$ anchors,
+ * which covers the built-in cleanup presets. */
+class FileNameMatcher
+{
+public:
+    FileNameMatcher() = default;
+    // regExp is kept as is for highlighting; its CaseInsensitiveOption defines case sensitivity of the fast path
+    explicit FileNameMatcher(const QRegularExpression& regExp);
+    // filters are quoted wildcards as entered in lineEdit_filePattern, e.g. "*.cpp" "*.h" "Makefile*"
+    static FileNameMatcher fromWildcardFilters(const QString& filters, Qt::CaseSensitivity caseSensitivity);
+
+    bool isValid() const { return m_regExp.isValid() && !m_regExp.pattern().isEmpty(); }
+    // true if no alternative needs PCRE
+    bool isFullyCompiled() const { return !m_hasFallback; }
+    bool matches(const QString& fileName) const;
+    // Regular expression equivalent to the whole matcher; used for highlighting of matched names
+    const QRegularExpression& regExp() const { return m_regExp; }
+
+private:
+    // Literal text with optional single-character wildcards ('?' in globs, '.' in regex)
+    struct Segment
+    {
+        QString text;
+        QVector<int> anyCharPositions;
+        int length() const { return text.size(); }
+    };
+    // segments[0] gap[1] segments[1] ... gap[n] segments[n]; gap is "any characters, at least minGap[i]"
+    struct GlobPattern
+    {
+        QVector<Segment> segments;
+        QVector<int> minGaps; // minGaps[0] is unused
+    };
+    struct ExtensionEntry
+    {
+        QString extension;
+        int minBaseLength; // 0 for "*.ext", 1 for ".+\.ext"
+    };
+
+    void addAlternative(const GlobPattern& pattern);
+    bool matchesSegment(const QString& fileName, int position, const Segment& segment) const;
+    bool matchesGlob(const QString& fileName, const GlobPattern& pattern) const;
+    uint hashOf(const QChar* data, int size) const;
+    bool equals(const QChar* data, int size, const QString& text) const;
+
+    static bool parseGlob(const QString& glob, GlobPattern& pattern);
+    static bool parseRegExp(const QString& regExpPattern, QVector<GlobPattern>& patterns);
+
+    Qt::CaseSensitivity m_caseSensitivity = Qt::CaseSensitive;
+    QRegularExpression m_regExp;
+    QRegularExpression m_fallbackRegExp;
+    bool m_hasFallback = false;
+    bool m_isMatchAll = false;
+    bool m_hasAnyChar = false; // some glob has single-character wildcard
+
+    QVector<QString> m_exactNames;
+    QMultiHash<uint, int> m_exactNameIndex; // name hash -> index in m_exactNames
+    QVector<ExtensionEntry> m_extensions;
+    QMultiHash<uint, int> m_extensionIndex; // extension hash -> index in m_extensions
+    QVector<GlobPattern> m_globs;
+};
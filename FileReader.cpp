@@ -0,0 +1,550 @@
+#include "FileReader.h"
+
+#include <climits>
+#include <vector>
+
+#include <QtCore/QFile>
+
+#include "Throttle.h"
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#endif
+
+#if defined(Q_OS_LINUX) && __has_include(<linux/io_uring.h>)
+#define FILEREADER_HAS_URING
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+// Page cache hints of sparing reads, see FileReader.h
+void adviseOpened(int fd, qint64 readaheadSize)
+{
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, (readaheadSize > 0) ? POSIX_FADV_RANDOM : POSIX_FADV_SEQUENTIAL);
+#else
+    Q_UNUSED(fd)
+    Q_UNUSED(readaheadSize)
+#endif
+}
+
+void adviseReadahead(int fd, qint64 offset, qint64 size)
+{
+#ifdef POSIX_FADV_WILLNEED
+    ::posix_fadvise(fd, offset, size, POSIX_FADV_WILLNEED);
+#else
+    Q_UNUSED(fd)
+    Q_UNUSED(offset)
+    Q_UNUSED(size)
+#endif
+}
+
+void adviseDrop(int fd)
+{
+#ifdef POSIX_FADV_DONTNEED
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#else
+    Q_UNUSED(fd)
+#endif
+}
+
+} // namespace
+
+#ifdef FILEREADER_HAS_URING
+/* Minimal io_uring driver over raw syscalls, enough for reading files.
+ * Every slot holds one file from openat until its close completes, with at most two operations outstanding, so the rings
+ * (sized for two operations per slot) never overflow. user_data of an operation is its slot index and step. */
+class FileReader::Uring
+{
+public:
+    static std::unique_ptr<Uring> create(int queueDepth);
+    ~Uring();
+
+    // Returns false if the ring failed; files not passed to onRead yet are left for the caller then.
+    // A failed ring is kept (operations still in flight may write to its slots) but never used again.
+    bool read(const QStringList& filePaths, const std::function<void(int fileIdx, File& file)>& onRead, std::vector<bool>& isDelivered,
+              const std::function<bool(int fileIdx, const File& file)>& isToRead, bool isSparingCache, qint64 readaheadSize, Throttle* pThrottle);
+    bool isFailed() const { return m_isFailed; }
+
+private:
+    enum Step : quint64 { Open, Stat, Read, Close };
+    struct Slot
+    {
+        int fileIdx = -1;
+        QByteArray path;       // referenced by openat and statx until both complete
+        struct statx fileStatx;
+        int pendingCount = 0;  // openat and statx not completed yet
+        int fd = -1;
+        int openError = 0;
+        bool isStatOk = false;
+        bool isSkipped = false; // declined by isToRead
+        QByteArray data;
+        qint64 readSize = 0;
+        qint64 requestSize = 0; // of the read in flight
+    };
+
+    Uring() = default;
+    bool isSupported() const;
+    io_uring_sqe* nextSqe(int slotIdx, Step step);
+    bool submitAndWait();
+    void admit(int slotIdx, int fileIdx, const QString& filePath);
+    void submitRead(int slotIdx);
+    void submitClose(int slotIdx);
+    static void setMetadata(const struct statx& fileStatx, File& file);
+    // Returns true once the file is finished, successfully or not
+    bool onCompletion(int slotIdx, Step step, int result);
+
+    int m_ringFd = -1;
+    io_uring_params m_params{};
+    void* m_sqRing = MAP_FAILED;
+    void* m_cqRing = MAP_FAILED;
+    size_t m_sqRingSize = 0;
+    size_t m_cqRingSize = 0;
+    io_uring_sqe* m_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    unsigned* m_sqHead = nullptr;
+    unsigned* m_sqTail = nullptr;
+    unsigned m_sqLocalTail = 0; // entries up to it are filled, published to the kernel on submit
+    unsigned* m_sqArray = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    io_uring_cqe* m_cqes = nullptr;
+    unsigned m_cqMask = 0;
+    std::vector<Slot> m_slots;
+    bool m_isFailed = false;
+    bool m_isSparingCache = false; // of the read() in progress
+    qint64 m_readaheadSize = 0;
+    const std::function<bool(int fileIdx, const File& file)>* m_pIsToRead = nullptr;
+};
+
+namespace
+{
+
+constexpr quint64 stepBits = 2;
+constexpr qint64 unknownSizeCapacity = 64 * 1024;
+
+int setupRing(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int enterRing(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+} // namespace
+
+std::unique_ptr<FileReader::Uring> FileReader::Uring::create(int queueDepth)
+{
+    std::unique_ptr<Uring> uring(new Uring);
+    unsigned entries = 1;
+    while (entries < 2 * static_cast<unsigned>(qBound(1, queueDepth, 2048)))
+        entries <<= 1;
+    uring->m_ringFd = setupRing(entries, &uring->m_params);
+    if (uring->m_ringFd < 0)
+        return nullptr;
+
+    const io_uring_params& params = uring->m_params;
+    uring->m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    uring->m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool isSingleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (isSingleMmap)
+        uring->m_sqRingSize = uring->m_cqRingSize = qMax(uring->m_sqRingSize, uring->m_cqRingSize);
+    uring->m_sqRing = ::mmap(nullptr, uring->m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->m_ringFd, IORING_OFF_SQ_RING);
+    if (uring->m_sqRing == MAP_FAILED)
+        return nullptr;
+    uring->m_cqRing = isSingleMmap ? uring->m_sqRing
+                                   : ::mmap(nullptr, uring->m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->m_ringFd, IORING_OFF_CQ_RING);
+    if (uring->m_cqRing == MAP_FAILED)
+        return nullptr;
+    void* sqes = ::mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->m_ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return nullptr;
+    uring->m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+    char* sqRing = static_cast<char*>(uring->m_sqRing);
+    char* cqRing = static_cast<char*>(uring->m_cqRing);
+    uring->m_sqHead = reinterpret_cast<unsigned*>(sqRing + params.sq_off.head);
+    uring->m_sqTail = reinterpret_cast<unsigned*>(sqRing + params.sq_off.tail);
+    uring->m_sqLocalTail = *uring->m_sqTail;
+    uring->m_sqArray = reinterpret_cast<unsigned*>(sqRing + params.sq_off.array);
+    uring->m_sqMask = *reinterpret_cast<unsigned*>(sqRing + params.sq_off.ring_mask);
+    uring->m_cqHead = reinterpret_cast<unsigned*>(cqRing + params.cq_off.head);
+    uring->m_cqTail = reinterpret_cast<unsigned*>(cqRing + params.cq_off.tail);
+    uring->m_cqes = reinterpret_cast<io_uring_cqe*>(cqRing + params.cq_off.cqes);
+    uring->m_cqMask = *reinterpret_cast<unsigned*>(cqRing + params.cq_off.ring_mask);
+    uring->m_slots.resize(qMin(static_cast<unsigned>(qBound(1, queueDepth, 2048)), params.sq_entries / 2));
+    if (!uring->isSupported())
+        return nullptr;
+    return uring;
+}
+
+FileReader::Uring::~Uring()
+{
+    if (m_sqes != MAP_FAILED)
+        ::munmap(m_sqes, m_params.sq_entries * sizeof(io_uring_sqe));
+    if ((m_cqRing != MAP_FAILED) && (m_cqRing != m_sqRing))
+        ::munmap(m_cqRing, m_cqRingSize);
+    if (m_sqRing != MAP_FAILED)
+        ::munmap(m_sqRing, m_sqRingSize);
+    if (m_ringFd >= 0)
+        ::close(m_ringFd);
+}
+
+bool FileReader::Uring::isSupported() const
+{
+    // openat, statx and read appeared in 5.6 together with the probe itself
+    const int opCount = 256;
+    std::vector<char> probeBuffer(sizeof(io_uring_probe) + opCount * sizeof(io_uring_probe_op), 0);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeBuffer.data());
+    if (::syscall(__NR_io_uring_register, m_ringFd, IORING_REGISTER_PROBE, probe, opCount) < 0)
+        return false;
+    for (int opcode : {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE})
+    {
+        if ((opcode > probe->last_op) || ((probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) == 0))
+            return false;
+    }
+    return true;
+}
+
+bool FileReader::Uring::read(const QStringList& filePaths, const std::function<void(int fileIdx, File& file)>& onRead, std::vector<bool>& isDelivered,
+                             const std::function<bool(int fileIdx, const File& file)>& isToRead, bool isSparingCache, qint64 readaheadSize, Throttle* pThrottle)
+{
+    m_isSparingCache = isSparingCache;
+    m_readaheadSize = readaheadSize;
+    m_pIsToRead = isToRead ? &isToRead : nullptr;
+    std::vector<int> freeSlotIdxs;
+    for (int slotIdx = static_cast<int>(m_slots.size()) - 1; slotIdx >= 0; --slotIdx)
+        freeSlotIdxs.push_back(slotIdx);
+    int nextFileIdx = 0;
+    while (true)
+    {
+        while ((nextFileIdx < filePaths.size()) && !freeSlotIdxs.empty())
+        {
+            if (pThrottle != nullptr)
+                pThrottle->acquire(1);
+            admit(freeSlotIdxs.back(), nextFileIdx, filePaths.at(nextFileIdx));
+            freeSlotIdxs.pop_back();
+            ++nextFileIdx;
+        }
+        if (freeSlotIdxs.size() == m_slots.size())
+            return true;
+        if (!submitAndWait())
+        {
+            m_isFailed = true;
+            return false;
+        }
+
+        unsigned cqHead = *m_cqHead;
+        const unsigned cqTail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        for (; cqHead != cqTail; ++cqHead)
+        {
+            const io_uring_cqe& cqe = m_cqes[cqHead & m_cqMask];
+            const int slotIdx = static_cast<int>(cqe.user_data >> stepBits);
+            const Step step = static_cast<Step>(cqe.user_data & ((1 << stepBits) - 1));
+            Slot& slot = m_slots[slotIdx];
+            if (!onCompletion(slotIdx, step, cqe.res))
+                continue;
+            if (step == Close)
+            {
+                freeSlotIdxs.push_back(slotIdx);
+                continue;
+            }
+            // delivered as soon as data is in, the close goes on in the kernel meanwhile
+            File file;
+            file.isSkipped = slot.isSkipped;
+            file.isOk = !slot.isSkipped && (slot.openError == 0) && (slot.readSize >= 0);
+            if ((file.isOk || file.isSkipped) && slot.isStatOk)
+                setMetadata(slot.fileStatx, file);
+            if (file.isOk)
+            {
+                slot.data.resize(static_cast<int>(slot.readSize));
+                file.data = std::move(slot.data);
+                file.fingerprint.setContent(file.data);
+            }
+            slot.data = QByteArray();
+            isDelivered[slot.fileIdx] = true;
+            if (pThrottle != nullptr)
+                pThrottle->acquire(0, file.data.size());
+            onRead(slot.fileIdx, file);
+            if (slot.fd >= 0)
+            {
+                // cheap enough to be done right here rather than as another step
+                if (m_isSparingCache && file.isCacheDropped)
+                    adviseDrop(slot.fd);
+                submitClose(slotIdx);
+            }
+            else
+                freeSlotIdxs.push_back(slotIdx);
+        }
+        __atomic_store_n(m_cqHead, cqHead, __ATOMIC_RELEASE);
+    }
+}
+
+io_uring_sqe* FileReader::Uring::nextSqe(int slotIdx, Step step)
+{
+    // never full: at most two operations per slot are outstanding and each enter consumes all queued ones
+    const unsigned sqeIdx = m_sqLocalTail++ & m_sqMask;
+    io_uring_sqe* sqe = &m_sqes[sqeIdx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = (static_cast<quint64>(slotIdx) << stepBits) | step;
+    m_sqArray[sqeIdx] = sqeIdx;
+    return sqe;
+}
+
+bool FileReader::Uring::submitAndWait()
+{
+    // the kernel sees filled entries only after the tail passes them
+    __atomic_store_n(m_sqTail, m_sqLocalTail, __ATOMIC_RELEASE);
+    while (true)
+    {
+        const unsigned toSubmit = m_sqLocalTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+        if (enterRing(m_ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS) >= 0)
+            return true;
+        if ((errno != EINTR) && (errno != EAGAIN) && (errno != EBUSY))
+            return false;
+    }
+}
+
+void FileReader::Uring::admit(int slotIdx, int fileIdx, const QString& filePath)
+{
+    Slot& slot = m_slots[slotIdx];
+    slot.fileIdx = fileIdx;
+    slot.path = QFile::encodeName(filePath);
+    slot.pendingCount = 2;
+    slot.fd = -1;
+    slot.openError = 0;
+    slot.isStatOk = false;
+    slot.isSkipped = false;
+    slot.readSize = 0;
+
+    io_uring_sqe* openSqe = nextSqe(slotIdx, Open);
+    openSqe->opcode = IORING_OP_OPENAT;
+    openSqe->fd = AT_FDCWD;
+    openSqe->addr = reinterpret_cast<quint64>(slot.path.constData());
+    openSqe->open_flags = O_RDONLY | O_CLOEXEC | O_NOCTTY;
+
+    // taken before the read is submitted, as FileFingerprint requires
+    io_uring_sqe* statSqe = nextSqe(slotIdx, Stat);
+    statSqe->opcode = IORING_OP_STATX;
+    statSqe->fd = AT_FDCWD;
+    statSqe->addr = reinterpret_cast<quint64>(slot.path.constData());
+    statSqe->len = STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_INO | STATX_NLINK;
+    statSqe->off = reinterpret_cast<quint64>(&slot.fileStatx);
+}
+
+void FileReader::Uring::submitRead(int slotIdx)
+{
+    Slot& slot = m_slots[slotIdx];
+    io_uring_sqe* sqe = nextSqe(slotIdx, Read);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = slot.fd;
+    slot.requestSize = slot.data.size() - slot.readSize;
+    if (m_isSparingCache && (m_readaheadSize > 0))
+    {
+        slot.requestSize = qMin(slot.requestSize, m_readaheadSize);
+        adviseReadahead(slot.fd, slot.readSize + slot.requestSize, m_readaheadSize);
+    }
+    sqe->addr = reinterpret_cast<quint64>(slot.data.data() + slot.readSize);
+    sqe->len = static_cast<quint32>(slot.requestSize);
+    sqe->off = static_cast<quint64>(slot.readSize);
+}
+
+void FileReader::Uring::submitClose(int slotIdx)
+{
+    Slot& slot = m_slots[slotIdx];
+    io_uring_sqe* sqe = nextSqe(slotIdx, Close);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = slot.fd;
+    slot.fd = -1;
+}
+
+void FileReader::Uring::setMetadata(const struct statx& fileStatx, File& file)
+{
+    file.fingerprint = FileFingerprint::ofMetadata(static_cast<qint64>(fileStatx.stx_size),
+                                                   static_cast<qint64>(fileStatx.stx_mtime.tv_sec) * 1000000000LL + fileStatx.stx_mtime.tv_nsec,
+                                                   fileStatx.stx_ino);
+    file.device = makedev(fileStatx.stx_dev_major, fileStatx.stx_dev_minor);
+    file.linkCount = fileStatx.stx_nlink;
+}
+
+bool FileReader::Uring::onCompletion(int slotIdx, Step step, int result)
+{
+    Slot& slot = m_slots[slotIdx];
+    switch (step)
+    {
+    case Open:
+    case Stat:
+        if (step == Open)
+        {
+            slot.fd = (result >= 0) ? result : -1;
+            slot.openError = (result >= 0) ? 0 : -result;
+        }
+        else
+        {
+            slot.isStatOk = (result == 0);
+        }
+        if (--slot.pendingCount > 0)
+            return false;
+        if (slot.openError != 0)
+            return true;
+        if (slot.isStatOk && (m_pIsToRead != nullptr))
+        {
+            File file;
+            setMetadata(slot.fileStatx, file);
+            slot.isSkipped = !(*m_pIsToRead)(slot.fileIdx, file);
+            if (slot.isSkipped)
+                return true;
+        }
+        if (m_isSparingCache)
+            adviseOpened(slot.fd, m_readaheadSize);
+        // one byte over the size, so a whole file comes in a single read that ends short
+        slot.data.resize(static_cast<int>(qMin<qint64>(slot.isStatOk ? static_cast<qint64>(slot.fileStatx.stx_size) + 1 : unknownSizeCapacity, INT_MAX / 2)));
+        submitRead(slotIdx);
+        return false;
+    case Read:
+    {
+        if (result < 0)
+        {
+            slot.readSize = -1;
+            return true;
+        }
+        slot.readSize += result;
+        // short read of a regular file is its end; others (pipes, procfs) end on an empty read only
+        if ((result == 0) || ((result < slot.requestSize) && slot.isStatOk && S_ISREG(slot.fileStatx.stx_mode)))
+            return true;
+        if (slot.readSize == slot.data.size())
+        {
+            if (slot.data.size() >= INT_MAX / 2)
+            {
+                slot.readSize = -1;
+                return true;
+            }
+            slot.data.resize(slot.data.size() * 2);
+        }
+        submitRead(slotIdx);
+        return false;
+    }
+    case Close:
+        break;
+    }
+    return true;
+}
+#else
+class FileReader::Uring {};
+#endif
+
+
+FileReader::FileReader(Backend backend, int queueDepth, qint64 readaheadSize)
+    : m_readaheadSize(readaheadSize)
+{
+#ifdef FILEREADER_HAS_URING
+    if (backend != Backend::Sync)
+        m_uring = Uring::create(queueDepth);
+#else
+    Q_UNUSED(backend)
+    Q_UNUSED(queueDepth)
+#endif
+}
+
+FileReader::~FileReader() = default;
+
+FileReader::Backend FileReader::backendFromString(const QString& backendName)
+{
+    if (backendName.compare(QLatin1String("io_uring"), Qt::CaseInsensitive) == 0)
+        return Backend::Uring;
+    if (backendName.compare(QLatin1String("sync"), Qt::CaseInsensitive) == 0)
+        return Backend::Sync;
+    return Backend::Auto;
+}
+
+FileReader::Backend FileReader::backend() const
+{
+#ifdef FILEREADER_HAS_URING
+    if (m_uring && !m_uring->isFailed())
+        return Backend::Uring;
+#endif
+    return Backend::Sync;
+}
+
+void FileReader::read(const QStringList& filePaths, const std::function<void(int fileIdx, File& file)>& onRead, bool isSparingCache,
+                      const std::function<bool(int fileIdx, const File& file)>& isToRead)
+{
+    std::vector<bool> isDelivered(filePaths.size(), false);
+#ifdef FILEREADER_HAS_URING
+    // what a failed ring didn't deliver is read the plain way
+    if (m_uring && !m_uring->isFailed())
+        m_uring->read(filePaths, onRead, isDelivered, isToRead, isSparingCache, m_readaheadSize, m_pThrottle);
+#endif
+    for (int fileIdx = 0; fileIdx < filePaths.size(); ++fileIdx)
+    {
+        if (isDelivered[fileIdx])
+            continue;
+        QFile fileDevice(filePaths.at(fileIdx));
+        File file;
+        if (m_pThrottle != nullptr)
+            m_pThrottle->acquire(1);
+        readSync(fileDevice, file, fileIdx, isToRead, isSparingCache);
+        if (m_pThrottle != nullptr)
+            m_pThrottle->acquire(0, file.data.size());
+        onRead(fileIdx, file);
+        if (isSparingCache && file.isCacheDropped && fileDevice.isOpen())
+            adviseDrop(fileDevice.handle());
+    }
+}
+
+void FileReader::readSync(QFile& fileDevice, File& file, int fileIdx, const std::function<bool(int fileIdx, const File& file)>& isToRead,
+                          bool isSparingCache) const
+{
+    file.fingerprint = FileFingerprint::ofMetadata(fileDevice.fileName());
+    file.isOk = fileDevice.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    if (!file.isOk)
+        return;
+#ifdef Q_OS_UNIX
+    struct stat fileStat;
+    if (::fstat(fileDevice.handle(), &fileStat) == 0)
+    {
+        file.device = fileStat.st_dev;
+        file.linkCount = fileStat.st_nlink;
+        if (isToRead && !isToRead(fileIdx, file))
+        {
+            file.isOk = false;
+            file.isSkipped = true;
+            return;
+        }
+    }
+#else
+    Q_UNUSED(fileIdx)
+    Q_UNUSED(isToRead)
+#endif
+    if (isSparingCache)
+        adviseOpened(fileDevice.handle(), m_readaheadSize);
+    if (!isSparingCache || (m_readaheadSize <= 0))
+    {
+        file.data = fileDevice.readAll();
+    }
+    else
+    {
+        while (true)
+        {
+            adviseReadahead(fileDevice.handle(), fileDevice.pos() + m_readaheadSize, m_readaheadSize);
+            const QByteArray chunk = fileDevice.read(m_readaheadSize);
+            if (chunk.isEmpty())
+                break;
+            file.data.append(chunk);
+        }
+        file.isOk = (fileDevice.error() == QFileDevice::NoError);
+    }
+    file.fingerprint.setContent(file.data);
+}
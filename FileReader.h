@@ -0,0 +1,71 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+#include "FileFingerprint.h"
+
+class QFile;
+class Throttle;
+
+/* Reads whole files for content searches.
+ * Trees of many small files are bound by per-file syscall latency rather than by bandwidth: open, stat, read and close are a
+ * round trip each. The io_uring backend (Linux 5.6+) keeps up to queueDepth files in flight, submitting openat and statx of a file
+ * together, then its read, then its close, and reaps completions in batches, so one io_uring_enter() covers steps of many files
+ * and the kernel overlaps their I/O. The sync backend opens and reads files one at a time; it's the only one elsewhere and is
+ * fallen back to when io_uring is missing, disabled (kernel.io_uring_disabled, seccomp) or lacks any of the opcodes.
+ * A read may spare the page cache for one-pass scans of trees larger than memory: files are hinted as read sequentially
+ * (POSIX_FADV_SEQUENTIAL) and those the caller marks while handling them are dropped from the cache (POSIX_FADV_DONTNEED)
+ * before being closed. Dropping can't tell pages the scan brought in from ones others had cached; dirty pages are never dropped.
+ * With a readahead size set, sparing reads go in requests of that size: kernel readahead is turned off (POSIX_FADV_RANDOM)
+ * and each request is preceded by an explicit readahead (POSIX_FADV_WILLNEED) of the next one.
+ * With a throttle set, each file is taken from its files budget before it's opened and from its bytes budget once read.
+ * With isToRead given, each file is passed to it once opened and stat'ed, before its read is submitted; a file it declines isn't
+ * read and is delivered skipped, with its metadata only. Files whose metadata couldn't be taken are read without asking.
+ * A reader is used by one thread at a time. */
+class FileReader
+{
+public:
+    enum class Backend { Auto, Uring, Sync };
+
+    struct File
+    {
+        QByteArray data;
+        FileFingerprint fingerprint; // metadata taken before reading, contents hash of data
+        bool isOk = false;           // false if the file couldn't be opened or read
+        bool isSkipped = false;      // declined by isToRead, not read
+        bool isCacheDropped = false; // set by onRead of a sparing read to drop the file from the page cache
+        quint64 device = 0;          // with fingerprint.inode identifies the file; 0 where metadata couldn't be taken
+        quint64 linkCount = 0;       // hard links of the file
+    };
+
+    // readaheadSize of sparing reads, 0 leaves readahead to the kernel
+    explicit FileReader(Backend backend = Backend::Auto, int queueDepth = 32, qint64 readaheadSize = 0);
+    ~FileReader();
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
+    // "auto", "io_uring" or "sync" as stored in settings; anything else is Auto
+    static Backend backendFromString(const QString& backendName);
+    // Backend actually used: Uring or Sync, never Auto
+    Backend backend() const;
+    void setThrottle(Throttle* pThrottle) { m_pThrottle = pThrottle; }
+
+    // Reads every file of filePaths and calls onRead(fileIdx, file) for it in the calling thread, in order of completion;
+    // isToRead(fileIdx, file) is called in the calling thread too
+    void read(const QStringList& filePaths, const std::function<void(int fileIdx, File& file)>& onRead, bool isSparingCache = false,
+              const std::function<bool(int fileIdx, const File& file)>& isToRead = nullptr);
+
+private:
+    void readSync(QFile& fileDevice, File& file, int fileIdx, const std::function<bool(int fileIdx, const File& file)>& isToRead,
+                  bool isSparingCache) const;
+
+    class Uring;
+    std::unique_ptr<Uring> m_uring; // nullptr if reading synchronously
+    qint64 m_readaheadSize = 0;
+    Throttle* m_pThrottle = nullptr;
+};
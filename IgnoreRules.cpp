@@ -0,0 +1,178 @@
+#include "IgnoreRules.h"
+
+#include <QtCore/QFile>
+
+#include <algorithm>
+
+
+bool IgnoreRules::addFile(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    for (const QByteArray& line : lines)
+        addPattern(QString::fromUtf8(line));
+    return true;
+}
+
+void IgnoreRules::addPattern(QString pattern)
+{
+    // trailing spaces are ignored unless escaped with backslash
+    while (pattern.endsWith(' ') && !pattern.endsWith("\\ "))
+        pattern.chop(1);
+    if (pattern.isEmpty() || pattern.startsWith('#'))
+        return;
+
+    Rule rule{Kind::Exact, QString(), QRegularExpression(), false, false, false};
+    if (pattern.startsWith('!'))
+    {
+        rule.isNegated = true;
+        pattern.remove(0, 1);
+    }
+    else if (pattern.startsWith("\\!") || pattern.startsWith("\\#"))
+    {
+        pattern.remove(0, 1);
+    }
+    if (pattern.endsWith('/'))
+    {
+        rule.isDirOnly = true;
+        pattern.chop(1);
+    }
+    // slash at the beginning or in the middle anchors pattern to the directory of the rules file
+    rule.isPathRule = pattern.contains('/');
+    if (pattern.startsWith('/'))
+        pattern.remove(0, 1);
+    // "**/name" matches name at any depth, which is what a pattern without slash does anyway.
+    // "**/a/b" stays a path rule: its leading "**/" is "any directories" of the regular expression.
+    if (rule.isPathRule && pattern.startsWith("**/") && !pattern.midRef(3).contains('/'))
+    {
+        pattern.remove(0, 3);
+        rule.isPathRule = false;
+    }
+    if (pattern.isEmpty())
+        return;
+
+    auto isWildcard = [](QChar c) { return (c == '*') || (c == '?') || (c == '[') || (c == '\\'); };
+    const int wildcardCount = static_cast<int>(std::count_if(pattern.cbegin(), pattern.cend(), isWildcard));
+    if (wildcardCount == 0)
+    {
+        rule.kind = Kind::Exact;
+        rule.text = pattern;
+    }
+    else if ((wildcardCount == 1) && !rule.isPathRule && pattern.startsWith('*'))
+    {
+        rule.kind = Kind::Suffix;
+        rule.text = pattern.mid(1);
+    }
+    else if ((wildcardCount == 1) && !rule.isPathRule && pattern.endsWith('*'))
+    {
+        rule.kind = Kind::Prefix;
+        rule.text = pattern.left(pattern.size() - 1);
+    }
+    else
+    {
+        rule.kind = Kind::RegExp;
+        rule.regExp = QRegularExpression(regExpFromGlob(pattern), QRegularExpression::DontCaptureOption);
+        if (!rule.regExp.isValid())
+            return;
+    }
+    m_hasPathRules |= rule.isPathRule;
+    m_rules.append(rule);
+}
+
+IgnoreRules::Result IgnoreRules::match(const QString& name, const QString& relativePath, bool isDir) const
+{
+    for (int i = m_rules.size() - 1; i >= 0; --i)
+    {
+        const Rule& rule = m_rules.at(i);
+        if (rule.isDirOnly && !isDir)
+            continue;
+        const QString& subject = rule.isPathRule ? relativePath : name;
+        bool isMatch = false;
+        switch (rule.kind)
+        {
+        case Kind::Exact:  isMatch = (subject == rule.text); break;
+        case Kind::Suffix: isMatch = subject.endsWith(rule.text); break;
+        case Kind::Prefix: isMatch = subject.startsWith(rule.text); break;
+        case Kind::RegExp: isMatch = rule.regExp.match(subject).hasMatch(); break;
+        }
+        if (isMatch)
+            return rule.isNegated ? Result::Included : Result::Ignored;
+    }
+    return Result::NoMatch;
+}
+
+QString IgnoreRules::regExpFromGlob(const QString& glob)
+{
+    QString result("^");
+    const int size = glob.size();
+    int i = 0;
+    while (i < size)
+    {
+        const QChar c = glob.at(i);
+        if ((c == '*') && (glob.midRef(i, 2) == QLatin1String("**")))
+        {
+            const bool isSlashBefore = (i == 0) || (glob.at(i - 1) == '/');
+            const bool isSlashAfter = (i + 2 < size) && (glob.at(i + 2) == '/');
+            if (isSlashBefore && isSlashAfter) // "a/**/b" - zero or more directories
+            {
+                result.append("(?:.*/)?");
+                i += 3;
+            }
+            else if (isSlashBefore && (i + 2 == size)) // "a/**" - everything inside
+            {
+                result.append(".*");
+                i += 2;
+            }
+            else // any other "**" is a regular "*"
+            {
+                result.append("[^/]*");
+                i += 2;
+            }
+        }
+        else if (c == '*')
+        {
+            result.append("[^/]*");
+            ++i;
+        }
+        else if (c == '?')
+        {
+            result.append("[^/]");
+            ++i;
+        }
+        else if (c == '[')
+        {
+            int j = i + 1;
+            if ((j < size) && ((glob.at(j) == '!') || (glob.at(j) == '^')))
+                ++j;
+            if ((j < size) && (glob.at(j) == ']'))
+                ++j;
+            while ((j < size) && (glob.at(j) != ']'))
+                ++j;
+            if (j >= size) // no closing bracket - literal '['
+            {
+                result.append("\\[");
+                ++i;
+                continue;
+            }
+            QString charClass = glob.mid(i + 1, j - i - 1);
+            if (charClass.startsWith('!'))
+                charClass[0] = '^';
+            result.append('[').append(charClass).append(']');
+            i = j + 1;
+        }
+        else if ((c == '\\') && (i + 1 < size))
+        {
+            result.append(QRegularExpression::escape(glob.mid(i + 1, 1)));
+            i += 2;
+        }
+        else
+        {
+            result.append(QRegularExpression::escape(QString(c)));
+            ++i;
+        }
+    }
+    result.append('$');
+    return result;
+}
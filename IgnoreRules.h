@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QtCore/QRegularExpression>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+/* Rules of a single .gitignore\.ignore file (gitignore syntax).
+ * Each pattern is compiled once into the cheapest check: exact name, suffix ("*.o"), prefix ("build*"),
+ * and only patterns with '?', '[...]', '**' or several wildcards become a regular expression.
+ * Patterns without '/' are matched against the entry name, patterns with '/' against the path relative to the rules file. */
+class IgnoreRules
+{
+public:
+    enum class Result
+    {
+        NoMatch,
+        Ignored,
+        Included // matched a negated "!pattern"
+    };
+
+    // Appends rules read from filePath; returns false if the file doesn't exist or can't be read
+    bool addFile(const QString& filePath);
+    void addPattern(QString pattern);
+    bool isEmpty() const { return m_rules.isEmpty(); }
+    bool hasPathRules() const { return m_hasPathRules; }
+
+    // relativePath is only used by rules containing '/'; last matching rule wins as in git
+    Result match(const QString& name, const QString& relativePath, bool isDir) const;
+
+private:
+    enum class Kind
+    {
+        Exact,
+        Suffix,
+        Prefix,
+        RegExp
+    };
+    struct Rule
+    {
+        Kind kind;
+        QString text;
+        QRegularExpression regExp;
+        bool isNegated;
+        bool isDirOnly;
+        bool isPathRule;
+    };
+
+    static QString regExpFromGlob(const QString& glob);
+
+    QVector<Rule> m_rules;
+    bool m_hasPathRules = false;
+};
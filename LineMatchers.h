@@ -0,0 +1,110 @@
+#pragma once
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QString>
+#include <QtCore/QStringMatcher>
+#include <QtCore/QVector>
+
+#include "ReplaceTable.h"
+#include "SearchRegExp.h"
+
+/* Matchers of file contents plugged into the line scanning kernel of MultiFileEditor.
+ * Every matcher has the same interface: bool matchLine(const QString& line, QVector<LineMatch>& matches, QString& replacedLine)
+ * fills non-overlapping matches in order and the line with all of them replaced, returning false if nothing matched.
+ * Each match tells where its replacement ends in the replaced line, which is all it takes to find the replacement of every match.
+ * setDeadline(const QElapsedTimer* pTimer, qint64 deadlineNs) bounds the time matchLine() may take and isTimedOut() tells
+ * if the last call gave up (at the deadline or another matching limit); matchers that always finish quickly ignore the deadline.
+ * A matcher keeps references to the compiled pattern and owns its scratch space, so it's created per file and used by one thread only.
+ * Reused scratch space spares per-line allocations of the matcher itself; building replacedLine and PCRE matches still allocate. */
+using LineMatch = SearchRegExp::Match;
+
+// Literal string; case sensitivity is fixed at compile time so the kernel has no runtime choice left
+template<Qt::CaseSensitivity CaseSensitivity>
+class LiteralLineMatcher
+{
+public:
+    LiteralLineMatcher(const QString& searchString, const QString& replaceString)
+        : m_matcher(searchString, CaseSensitivity)
+        , m_length(searchString.length())
+        , m_replaceString(replaceString)
+    {}
+
+    bool matchLine(const QString& line, QVector<LineMatch>& matches, QString& replacedLine)
+    {
+        int index = (m_length > 0) ? m_matcher.indexIn(line) : -1;
+        if (index == -1)
+            return false;
+        matches.clear();
+        replacedLine.clear();
+        int position = 0;
+        // same result as QString::replace(searchString, replaceString, CaseSensitivity): left to right, without overlaps
+        while (index != -1)
+        {
+            replacedLine.append(line.midRef(position, index - position));
+            replacedLine.append(m_replaceString);
+            matches.append(LineMatch{index, index + m_length, replacedLine.size()});
+            position = index + m_length;
+            index = m_matcher.indexIn(line, position);
+        }
+        replacedLine.append(line.midRef(position));
+        return true;
+    }
+    void setDeadline(const QElapsedTimer*, qint64) {}
+    bool isTimedOut() const { return false; }
+
+private:
+    QStringMatcher m_matcher;
+    int m_length;
+    const QString& m_replaceString;
+};
+
+class RegExpLineMatcher
+{
+public:
+    explicit RegExpLineMatcher(const SearchRegExp& searchRegExp)
+        : m_searchRegExp(searchRegExp)
+    {}
+
+    bool matchLine(const QString& line, QVector<LineMatch>& matches, QString& replacedLine)
+    {
+        return m_searchRegExp.matchLine(line, matches, replacedLine, m_context);
+    }
+    void setDeadline(const QElapsedTimer* pTimer, qint64 deadlineNs) { m_context.setDeadline(pTimer, deadlineNs); }
+    bool isTimedOut() const { return m_context.isTimedOut(); }
+
+private:
+    const SearchRegExp& m_searchRegExp;
+    SearchRegExp::MatchContext m_context;
+};
+
+class ReplaceTableLineMatcher
+{
+public:
+    explicit ReplaceTableLineMatcher(const ReplaceTable& replaceTable)
+        : m_replaceTable(replaceTable)
+    {}
+
+    bool matchLine(const QString& line, QVector<LineMatch>& matches, QString& replacedLine)
+    {
+        if (!m_replaceTable.matchLine(line, m_tableMatches))
+            return false;
+        matches.clear();
+        // as ReplaceTable::replaced() builds replacedLine: unchanged text up to each match, then its replacement
+        int replacedEnd = 0;
+        int position = 0;
+        for (const ReplaceTable::Match& match : qAsConst(m_tableMatches))
+        {
+            replacedEnd += (match.start - position) + match.replacement.size();
+            position = match.start + match.length;
+            matches.append(LineMatch{match.start, position, replacedEnd});
+        }
+        replacedLine = ReplaceTable::replaced(line, m_tableMatches);
+        return true;
+    }
+    void setDeadline(const QElapsedTimer*, qint64) {}
+    bool isTimedOut() const { return false; }
+
+private:
+    const ReplaceTable& m_replaceTable;
+    QVector<ReplaceTable::Match> m_tableMatches;
+};
@@ -0,0 +1,850 @@
+#include "LinearRegExp.h"
+
+#include <algorithm>
+#include <limits>
+
+
+// Counted repetitions are expanded, so program size is capped to keep addThread() and thread lists small
+static constexpr int maxProgramSize = 10000;
+static constexpr int maxRepeatCount = 1000;
+// Patterns with this many unbounded repetitions (e.g. ".*a.*b.*c") backtrack polynomially with a high degree
+static constexpr int proneUnboundedRepeatCount = 3;
+
+static bool isWordChar(uint u)
+{
+    return ((u >= 'a') && (u <= 'z')) || ((u >= 'A') && (u <= 'Z')) || ((u >= '0') && (u <= '9')) || (u == '_');
+}
+
+static bool isSpaceChar(uint u)
+{
+    return (u == ' ') || ((u >= '\t') && (u <= '\r'));
+}
+
+static int hexValue(QChar c)
+{
+    const ushort u = c.unicode();
+    if ((u >= '0') && (u <= '9'))
+        return u - '0';
+    if ((u >= 'a') && (u <= 'f'))
+        return u - 'a' + 10;
+    if ((u >= 'A') && (u <= 'F'))
+        return u - 'A' + 10;
+    return -1;
+}
+
+
+bool LinearRegExp::CharClass::contains(uint c) const
+{
+    for (const QPair<uint, uint>& range : ranges)
+        if ((c >= range.first) && (c <= range.second))
+            return true;
+    if (builtins == 0)
+        return false;
+    const bool isDigit = (c >= '0') && (c <= '9');
+    const bool isWord = isWordChar(c);
+    const bool isSpace = isSpaceChar(c);
+    return ((builtins & Digit) && isDigit) || ((builtins & NotDigit) && !isDigit)
+        || ((builtins & Word) && isWord) || ((builtins & NotWord) && !isWord)
+        || ((builtins & Space) && isSpace) || ((builtins & NotSpace) && !isSpace);
+}
+
+
+/* Recursive descent parser building syntax tree of the pattern, then emitting Pike VM program from it.
+ * Any construct outside of supported subset fails compilation instead of being approximated. */
+struct LinearRegExp::Compiler
+{
+    struct Node
+    {
+        enum Kind { Empty, Char, Any, Class, Assert, Concat, Alternation, Repeat, Group };
+        Kind kind = Empty;
+        int value = 0;        // Char: character, Class: index in m_classes, Assert: Assertion, Group: capture index or -1
+        int min = 0;          // Repeat
+        int max = 0;          // Repeat, -1 for unbounded
+        bool isGreedy = true; // Repeat
+        QVector<int> children;
+    };
+
+    Compiler(const QString& pattern, LinearRegExp& regExp)
+        : m_pattern(pattern)
+        , m_regExp(regExp)
+    {}
+
+    bool compile()
+    {
+        const int root = parseAlternation();
+        if (!m_isOk || (m_pos != m_pattern.size()))
+            return false;
+        m_regExp.m_isBacktrackingProne |= (m_unboundedRepeatCount >= proneUnboundedRepeatCount);
+        m_regExp.m_slotCount = 2 * (m_regExp.m_captureCount + 1);
+        addInstruction(Op::Save, 0);
+        emitNode(root);
+        addInstruction(Op::Save, 1);
+        addInstruction(Op::Match);
+        if (!m_isOk)
+            return false;
+        if ((m_regExp.m_program.size() > 1) && (m_regExp.m_program.at(1).op == Op::Char) && (m_regExp.m_program.at(1).x <= 0xFFFF))
+            m_regExp.m_firstChar = m_regExp.m_program.at(1).x;
+        return true;
+    }
+
+private:
+    bool atEnd() const { return m_pos >= m_pattern.size(); }
+    QChar peek() const { return m_pattern.at(m_pos); }
+    bool accept(char c)
+    {
+        if (atEnd() || (peek() != QLatin1Char(c)))
+            return false;
+        ++m_pos;
+        return true;
+    }
+    int fail()
+    {
+        m_isOk = false;
+        return -1;
+    }
+    int addNode(const Node& node)
+    {
+        m_nodes.append(node);
+        return m_nodes.size() - 1;
+    }
+    int addCharNode(uint c)
+    {
+        Node node;
+        node.kind = Node::Char;
+        node.value = static_cast<int>(m_regExp.m_isCaseInsensitive ? QChar::toCaseFolded(c) : c);
+        return addNode(node);
+    }
+    // Character of the pattern at m_pos, a surrogate pair being one character; lone surrogate fails
+    bool parseLiteral(uint& c)
+    {
+        const QChar first = m_pattern.at(m_pos++);
+        c = first.unicode();
+        if (!first.isSurrogate())
+            return true;
+        if (first.isHighSurrogate() && !atEnd() && peek().isLowSurrogate())
+        {
+            c = QChar::surrogateToUcs4(first, m_pattern.at(m_pos++));
+            return true;
+        }
+        fail();
+        return false;
+    }
+    int addClassNode(const CharClass& charClass)
+    {
+        m_regExp.m_classes.append(charClass);
+        Node node;
+        node.kind = Node::Class;
+        node.value = m_regExp.m_classes.size() - 1;
+        return addNode(node);
+    }
+    int addAssertNode(Assertion assertion)
+    {
+        Node node;
+        node.kind = Node::Assert;
+        node.value = static_cast<int>(assertion);
+        return addNode(node);
+    }
+
+    int parseAlternation()
+    {
+        const int first = parseConcat();
+        if (!m_isOk || atEnd() || (peek() != '|'))
+            return first;
+        Node alternation;
+        alternation.kind = Node::Alternation;
+        alternation.children.append(first);
+        while (m_isOk && accept('|'))
+            alternation.children.append(parseConcat());
+        return m_isOk ? addNode(alternation) : -1;
+    }
+
+    int parseConcat()
+    {
+        Node concat;
+        concat.kind = Node::Concat;
+        while (m_isOk && !atEnd() && (peek() != '|') && (peek() != ')'))
+            concat.children.append(parseRepeat());
+        return m_isOk ? addNode(concat) : -1;
+    }
+
+    int parseRepeat()
+    {
+        const int atom = parseAtom();
+        int min = 0;
+        int max = 0;
+        if (!m_isOk || !parseQuantifier(min, max))
+            return atom;
+        const Node::Kind atomKind = m_nodes.at(atom).kind;
+        if ((atomKind == Node::Assert) || (atomKind == Node::Empty))
+            return fail();
+        bool isGreedy = true;
+        if (accept('?'))
+            isGreedy = false;
+        else if (!atEnd() && (peek() == '+')) // possessive
+            return fail();
+        int nextMin = 0;
+        int nextMax = 0;
+        if (!atEnd() && ((peek() == '*') || (peek() == '+') || (peek() == '?') || parseQuantifier(nextMin, nextMax)))
+            return fail();
+        if (((max != -1) && (max < min)) || (min > maxRepeatCount) || (max > maxRepeatCount))
+            return fail();
+        // PCRE backtracks into iterations that matched empty and ends up with captures no lockstep simulation reproduces,
+        // e.g. for (a?)+ or (|b)*: those are left to PCRE. Fixed counts such as (a?){2} iterate the same way in both.
+        if (((max == -1) || (max > min)) && (max != 1) && isNullable(atom))
+            return fail();
+
+        if ((max == -1) || (max > 1))
+        {
+            if (max == -1)
+                ++m_unboundedRepeatCount;
+            if (hasVariablePart(atom))
+                m_regExp.m_isBacktrackingProne = true;
+        }
+        Node repeat;
+        repeat.kind = Node::Repeat;
+        repeat.min = min;
+        repeat.max = max;
+        repeat.isGreedy = isGreedy;
+        repeat.children.append(atom);
+        return addNode(repeat);
+    }
+
+    // Consumes *, +, ?, {n}, {n,} or {n,m}; anything else (including '{' not forming a quantifier, which is a literal) is left as is
+    bool parseQuantifier(int& min, int& max)
+    {
+        if (atEnd())
+            return false;
+        if (accept('*'))
+        {
+            min = 0;
+            max = -1;
+            return true;
+        }
+        if (accept('+'))
+        {
+            min = 1;
+            max = -1;
+            return true;
+        }
+        if (accept('?'))
+        {
+            min = 0;
+            max = 1;
+            return true;
+        }
+        if (peek() != '{')
+            return false;
+        const int startPos = m_pos++;
+        auto parseNumber = [this](int& number)
+        {
+            const int numberPos = m_pos;
+            number = 0;
+            while (!atEnd() && peek().isDigit() && (m_pos - numberPos < 6))
+                number = number * 10 + m_pattern.at(m_pos++).digitValue();
+            return (m_pos != numberPos);
+        };
+        if (parseNumber(min))
+        {
+            max = min;
+            if (accept(','))
+            {
+                if (!parseNumber(max))
+                    max = -1;
+            }
+            if (accept('}'))
+                return true;
+        }
+        m_pos = startPos;
+        return false;
+    }
+
+    int parseAtom()
+    {
+        const QChar c = m_pattern.at(m_pos);
+        if (c.isSurrogate())
+        {
+            uint ucs4 = 0;
+            return parseLiteral(ucs4) ? addCharNode(ucs4) : -1;
+        }
+        ++m_pos;
+        switch (c.unicode())
+        {
+        case '(':
+            return parseGroup();
+        case '[':
+            return parseClass();
+        case '.':
+        {
+            Node node;
+            node.kind = Node::Any;
+            return addNode(node);
+        }
+        case '^':
+            return addAssertNode(Assertion::LineStart);
+        case '$':
+            return addAssertNode(Assertion::LineEnd);
+        case '\\':
+            return parseEscape();
+        case '*':
+        case '+':
+        case '?':
+            return fail(); // nothing to repeat
+        case '{':
+        {
+            --m_pos;
+            int min = 0;
+            int max = 0;
+            if (parseQuantifier(min, max))
+                return fail();
+            ++m_pos;
+            return addCharNode(c.unicode());
+        }
+        default:
+            return addCharNode(c.unicode());
+        }
+    }
+
+    int parseGroup()
+    {
+        int captureIdx = -1;
+        if (accept('?'))
+        {
+            bool isNamed = false;
+            char nameEnd = '>';
+            if (accept(':'))
+            {
+                // non-capturing group
+            }
+            else if (accept('P') && accept('<'))
+                isNamed = true;
+            else if (!atEnd() && (peek() == '<') && (m_pos + 1 < m_pattern.size())
+                     && (m_pattern.at(m_pos + 1) != '=') && (m_pattern.at(m_pos + 1) != '!'))
+                isNamed = accept('<');
+            else if (accept('\''))
+            {
+                isNamed = true;
+                nameEnd = '\'';
+            }
+            else
+                return fail(); // lookaround, inline options, atomic group, ...
+            if (isNamed)
+            {
+                while (!atEnd() && (peek().isLetterOrNumber() || (peek() == '_')))
+                    ++m_pos;
+                if (!accept(nameEnd))
+                    return fail();
+                captureIdx = ++m_regExp.m_captureCount;
+            }
+        }
+        else if (!atEnd() && (peek() == '*')) // backtracking control verbs
+        {
+            return fail();
+        }
+        else
+        {
+            captureIdx = ++m_regExp.m_captureCount;
+        }
+        const int child = parseAlternation();
+        if (!m_isOk || !accept(')'))
+            return fail();
+        Node group;
+        group.kind = Node::Group;
+        group.value = captureIdx;
+        group.children.append(child);
+        return addNode(group);
+    }
+
+    int parseEscape()
+    {
+        if (atEnd())
+            return fail();
+        const QChar e = m_pattern.at(m_pos++);
+        CharClass charClass;
+        switch (e.unicode())
+        {
+        case 'd': charClass.builtins = CharClass::Digit; return addClassNode(charClass);
+        case 'D': charClass.builtins = CharClass::NotDigit; return addClassNode(charClass);
+        case 'w': charClass.builtins = CharClass::Word; return addClassNode(charClass);
+        case 'W': charClass.builtins = CharClass::NotWord; return addClassNode(charClass);
+        case 's': charClass.builtins = CharClass::Space; return addClassNode(charClass);
+        case 'S': charClass.builtins = CharClass::NotSpace; return addClassNode(charClass);
+        case 'b': return addAssertNode(Assertion::WordBoundary);
+        case 'B': return addAssertNode(Assertion::NotWordBoundary);
+        case 'A': return addAssertNode(Assertion::TextStart);
+        case 'z': return addAssertNode(Assertion::TextEnd);
+        case 'Z': return addAssertNode(Assertion::TextEndOrNewline);
+        default:
+        {
+            uint c = 0;
+            if (!parseCharEscape(e, c))
+                return fail();
+            return addCharNode(c);
+        }
+        }
+    }
+
+    // Escapes denoting a single character, same inside and outside of classes except for \b
+    bool parseCharEscape(QChar e, uint& c)
+    {
+        switch (e.unicode())
+        {
+        case 'a': c = 0x07; return true;
+        case 'e': c = 0x1B; return true;
+        case 'f': c = '\f'; return true;
+        case 'n': c = '\n'; return true;
+        case 'r': c = '\r'; return true;
+        case 't': c = '\t'; return true;
+        case 'x': return parseHex(c);
+        default:
+            if (e.isLetterOrNumber() || (e.unicode() > 0x7F))
+                return false;
+            c = e.unicode();
+            return true;
+        }
+    }
+
+    // \xhh with up to two digits or \x{h...}
+    bool parseHex(uint& c)
+    {
+        int value = 0;
+        if (accept('{'))
+        {
+            const int digitsPos = m_pos;
+            while (!atEnd() && (hexValue(peek()) != -1) && (value <= 0x10FFFF))
+                value = value * 16 + hexValue(m_pattern.at(m_pos++));
+            if ((m_pos == digitsPos) || (value > 0x10FFFF) || !accept('}'))
+                return false;
+        }
+        else
+        {
+            for (int i = 0; (i < 2) && !atEnd() && (hexValue(peek()) != -1); ++i)
+                value = value * 16 + hexValue(m_pattern.at(m_pos++));
+        }
+        // lone surrogates never occur in text matched by code points
+        if ((value >= 0xD800) && (value <= 0xDFFF))
+            return false;
+        c = static_cast<uint>(value);
+        return true;
+    }
+
+    int parseClass()
+    {
+        CharClass charClass;
+        charClass.isNegated = accept('^');
+        bool isFirst = true;
+        while (true)
+        {
+            if (atEnd())
+                return fail();
+            if ((peek() == ']') && !isFirst)
+            {
+                ++m_pos;
+                break;
+            }
+            isFirst = false;
+            if ((peek() == '[') && (m_pos + 1 < m_pattern.size())
+                && ((m_pattern.at(m_pos + 1) == ':') || (m_pattern.at(m_pos + 1) == '.') || (m_pattern.at(m_pos + 1) == '=')))
+                return fail(); // POSIX classes
+            uint low = 0;
+            if (!parseClassAtom(charClass, low))
+            {
+                if (!m_isOk)
+                    return -1;
+                continue; // builtin class such as \d
+            }
+            if ((m_pos + 1 < m_pattern.size()) && (peek() == '-') && (m_pattern.at(m_pos + 1) != ']'))
+            {
+                ++m_pos;
+                uint high = 0;
+                if (!parseClassAtom(charClass, high) || (high < low))
+                    return fail();
+                charClass.ranges.append(qMakePair(low, high));
+            }
+            else
+            {
+                charClass.ranges.append(qMakePair(low, low));
+            }
+        }
+        return addClassNode(charClass);
+    }
+
+    // Returns true with c set for a single character; false for builtin class added to charClass or on failure (m_isOk is false then)
+    bool parseClassAtom(CharClass& charClass, uint& c)
+    {
+        if (peek() != '\\')
+            return parseLiteral(c);
+        ++m_pos;
+        if (atEnd())
+        {
+            fail();
+            return false;
+        }
+        const QChar e = m_pattern.at(m_pos++);
+        switch (e.unicode())
+        {
+        case 'd': charClass.builtins |= CharClass::Digit; return false;
+        case 'D': charClass.builtins |= CharClass::NotDigit; return false;
+        case 'w': charClass.builtins |= CharClass::Word; return false;
+        case 'W': charClass.builtins |= CharClass::NotWord; return false;
+        case 's': charClass.builtins |= CharClass::Space; return false;
+        case 'S': charClass.builtins |= CharClass::NotSpace; return false;
+        case 'b': c = 0x08; return true;
+        default:
+            if (parseCharEscape(e, c))
+                return true;
+            fail();
+            return false;
+        }
+    }
+
+    // Node can match strings of different lengths in more than one way: contains unbounded or ranged repetition, or alternation
+    bool hasVariablePart(int nodeIdx) const
+    {
+        const Node& node = m_nodes.at(nodeIdx);
+        if (node.kind == Node::Alternation)
+            return true;
+        if ((node.kind == Node::Repeat) && (node.max != node.min))
+            return true;
+        for (int child : node.children)
+            if (hasVariablePart(child))
+                return true;
+        return false;
+    }
+
+    // Node can match the empty string
+    bool isNullable(int nodeIdx) const
+    {
+        const Node& node = m_nodes.at(nodeIdx);
+        switch (node.kind)
+        {
+        case Node::Empty:
+        case Node::Assert:
+            return true;
+        case Node::Char:
+        case Node::Any:
+        case Node::Class:
+            return false;
+        case Node::Concat:
+            for (int child : node.children)
+                if (!isNullable(child))
+                    return false;
+            return true;
+        case Node::Alternation:
+            for (int child : node.children)
+                if (isNullable(child))
+                    return true;
+            return false;
+        case Node::Repeat:
+            return (node.min == 0) || isNullable(node.children.first());
+        case Node::Group:
+            return isNullable(node.children.first());
+        }
+        return true;
+    }
+
+    int addInstruction(Op op, int x = 0, int y = 0)
+    {
+        if (m_regExp.m_program.size() >= maxProgramSize)
+        {
+            fail();
+            return 0;
+        }
+        m_regExp.m_program.append({op, x, y});
+        return m_regExp.m_program.size() - 1;
+    }
+    void patchSplit(int pc, int bodyPc, int skipPc, bool isGreedy)
+    {
+        if (!m_isOk)
+            return;
+        Instruction& split = m_regExp.m_program[pc];
+        split.x = isGreedy ? bodyPc : skipPc;
+        split.y = isGreedy ? skipPc : bodyPc;
+    }
+
+    void emitNode(int nodeIdx)
+    {
+        if (!m_isOk)
+            return;
+        const Node& node = m_nodes.at(nodeIdx);
+        switch (node.kind)
+        {
+        case Node::Empty:
+            break;
+        case Node::Char:
+            addInstruction(Op::Char, node.value);
+            break;
+        case Node::Any:
+            addInstruction(Op::Any);
+            break;
+        case Node::Class:
+            addInstruction(Op::Class, node.value);
+            break;
+        case Node::Assert:
+            addInstruction(Op::Assert, node.value);
+            break;
+        case Node::Concat:
+            for (int child : node.children)
+                emitNode(child);
+            break;
+        case Node::Alternation:
+        {
+            QVector<int> jumps;
+            for (int i = 0; i + 1 < node.children.size(); ++i)
+            {
+                const int split = addInstruction(Op::Split);
+                emitNode(node.children.at(i));
+                jumps.append(addInstruction(Op::Jmp));
+                patchSplit(split, split + 1, m_regExp.m_program.size(), true);
+            }
+            emitNode(node.children.last());
+            if (m_isOk)
+                for (int jump : qAsConst(jumps))
+                    m_regExp.m_program[jump].x = m_regExp.m_program.size();
+            break;
+        }
+        case Node::Group:
+            if (node.value >= 0)
+                addInstruction(Op::Save, 2 * node.value);
+            emitNode(node.children.first());
+            if (node.value >= 0)
+                addInstruction(Op::Save, 2 * node.value + 1);
+            break;
+        case Node::Repeat:
+        {
+            const int child = node.children.first();
+            for (int i = 0; i < node.min; ++i)
+                emitNode(child);
+            if (node.max == -1)
+            {
+                // as in PCRE, an iteration that consumed nothing ends the loop instead of being repeated
+                const int slot = m_regExp.m_slotCount++;
+                const int split = addInstruction(Op::Split);
+                addInstruction(Op::Save, slot);
+                emitNode(child);
+                addInstruction(Op::Progress, slot, split);
+                patchSplit(split, split + 1, m_regExp.m_program.size(), node.isGreedy);
+            }
+            else
+            {
+                // x{0,3} is emitted as (?:x(?:x(?:x)?)?)?, every optional part skipping to the end
+                QVector<int> splits;
+                for (int i = node.min; i < node.max; ++i)
+                {
+                    splits.append(addInstruction(Op::Split));
+                    emitNode(child);
+                }
+                for (int split : qAsConst(splits))
+                    patchSplit(split, split + 1, m_regExp.m_program.size(), node.isGreedy);
+            }
+            break;
+        }
+        }
+    }
+
+    const QString& m_pattern;
+    LinearRegExp& m_regExp;
+    int m_pos = 0;
+    bool m_isOk = true;
+    int m_unboundedRepeatCount = 0;
+    QVector<Node> m_nodes;
+};
+
+
+LinearRegExp::LinearRegExp(const QString& pattern, Qt::CaseSensitivity caseSensitivity)
+    : m_isCaseInsensitive(caseSensitivity == Qt::CaseInsensitive)
+{
+    m_isValid = Compiler(pattern, *this).compile();
+    if (!m_isValid)
+    {
+        m_program.clear();
+        m_classes.clear();
+    }
+}
+
+bool LinearRegExp::match(const QString& text, int offset, bool isNotEmptyAtOffset, QVector<int>& captures, MatchContext& context) const
+{
+    if (!m_isValid || (offset < 0) || (offset > text.size()))
+        return false;
+    const int slotCount = m_slotCount;
+    const int captureSlotCount = 2 * (m_captureCount + 1);
+    const QChar* data = text.constData();
+    const int size = text.size();
+    if ((offset > 0) && (offset < size) && data[offset].isLowSurrogate() && data[offset - 1].isHighSurrogate())
+        return false; // matches start at character boundaries only
+    const Qt::CaseSensitivity firstCharCase = m_isCaseInsensitive ? Qt::CaseInsensitive : Qt::CaseSensitive;
+
+    // marks of the previous call stay valid as older generations; they are only cleared when the context
+    // is used with a larger program or the generation counter could overflow during this call
+    const int maxGenerationsPerCall = 2 * (size - offset + 2);
+    int& generation = context.m_generation;
+    if ((context.m_lists[0].marks.size() < static_cast<size_t>(m_program.size()))
+        || (generation > std::numeric_limits<int>::max() - maxGenerationsPerCall))
+    {
+        for (ThreadList& list : context.m_lists)
+            list.marks.assign(m_program.size(), -1);
+        generation = 0;
+    }
+    ThreadList* pCurrent = &context.m_lists[0];
+    ThreadList* pNext = &context.m_lists[1];
+    std::vector<int>& work = context.m_work;
+    work.resize(slotCount);
+    bool isMatched = false;
+    pCurrent->reset(++generation);
+    for (int position = offset, nextPosition = offset; ; position = nextPosition)
+    {
+        if (!isMatched)
+        {
+            // no thread alive: jump straight to the next place a match can start at
+            if (pCurrent->pcs.empty() && (m_firstChar != -1))
+            {
+                position = text.indexOf(QChar(static_cast<ushort>(m_firstChar)), position, firstCharCase);
+                if (position == -1)
+                    break;
+            }
+            // new thread has the lowest priority: matches starting earlier win
+            std::fill(work.begin(), work.end(), -1);
+            addThread(*pCurrent, 0, work.data(), data, size, position);
+        }
+        // every thread consumes the same character, a surrogate pair being one
+        uint c = 0;
+        nextPosition = position + 1;
+        if (position < size)
+        {
+            c = data[position].unicode();
+            if (data[position].isHighSurrogate() && (nextPosition < size) && data[nextPosition].isLowSurrogate())
+                c = QChar::surrogateToUcs4(data[position], data[nextPosition++]);
+        }
+        if (pCurrent->pcs.empty())
+        {
+            if (isMatched || (position >= size))
+                break;
+            pCurrent->reset(++generation);
+            continue;
+        }
+
+        pNext->reset(++generation);
+        for (size_t t = 0; t < pCurrent->pcs.size(); ++t)
+        {
+            const int pc = pCurrent->pcs[t];
+            const int* threadCaptures = pCurrent->captures.data() + t * slotCount;
+            const Instruction& instruction = m_program.at(pc);
+            if (instruction.op == Op::Match)
+            {
+                if (isNotEmptyAtOffset && (threadCaptures[0] == offset) && (position == offset))
+                    continue;
+                captures.resize(captureSlotCount);
+                std::copy(threadCaptures, threadCaptures + captureSlotCount, captures.begin());
+                isMatched = true;
+                break; // threads after this one have lower priority
+            }
+            if ((position < size) && isCharMatched(instruction, c))
+            {
+                std::copy(threadCaptures, threadCaptures + slotCount, work.begin());
+                addThread(*pNext, pc + 1, work.data(), data, size, nextPosition);
+            }
+        }
+        std::swap(pCurrent, pNext);
+        if (position >= size)
+            break;
+    }
+    return isMatched;
+}
+
+// Follows empty transitions from pc in priority order and adds every reached consuming or Match instruction to the list.
+// Saves are applied to captures while their continuation is explored and restored afterwards through the stack.
+void LinearRegExp::addThread(ThreadList& list, int pc, int* captures, const QChar* text, int size, int position) const
+{
+    list.stack.clear();
+    list.stack.push_back({pc, -1, 0});
+    while (!list.stack.empty())
+    {
+        const ThreadList::StackEntry entry = list.stack.back();
+        list.stack.pop_back();
+        if (entry.slot >= 0)
+        {
+            captures[entry.slot] = entry.value;
+            continue;
+        }
+        int curPc = entry.pc;
+        while (list.marks[curPc] != list.generation)
+        {
+            list.marks[curPc] = list.generation;
+            const Instruction& instruction = m_program.at(curPc);
+            if (instruction.op == Op::Jmp)
+            {
+                curPc = instruction.x;
+            }
+            else if (instruction.op == Op::Split)
+            {
+                list.stack.push_back({instruction.y, -1, 0});
+                curPc = instruction.x;
+            }
+            else if (instruction.op == Op::Save)
+            {
+                list.stack.push_back({0, instruction.x, captures[instruction.x]});
+                captures[instruction.x] = position;
+                ++curPc;
+            }
+            else if (instruction.op == Op::Progress)
+            {
+                curPc = (captures[instruction.x] != position) ? instruction.y : curPc + 1;
+            }
+            else if (instruction.op == Op::Assert)
+            {
+                if (!isAssertionTrue(static_cast<Assertion>(instruction.x), text, size, position))
+                    break;
+                ++curPc;
+            }
+            else
+            {
+                list.pcs.push_back(curPc);
+                list.captures.insert(list.captures.end(), captures, captures + m_slotCount);
+                break;
+            }
+        }
+    }
+}
+
+bool LinearRegExp::isAssertionTrue(Assertion assertion, const QChar* text, int size, int position) const
+{
+    switch (assertion)
+    {
+    case Assertion::LineStart:
+    case Assertion::TextStart:
+        return (position == 0);
+    case Assertion::TextEnd:
+        return (position == size);
+    case Assertion::LineEnd:
+    case Assertion::TextEndOrNewline:
+        return (position == size) || ((position == size - 1) && (text[position] == '\n'));
+    case Assertion::WordBoundary:
+    case Assertion::NotWordBoundary:
+    {
+        const bool isWordBefore = (position > 0) && isWordChar(text[position - 1].unicode());
+        const bool isWordAfter = (position < size) && isWordChar(text[position].unicode());
+        return ((isWordBefore != isWordAfter) == (assertion == Assertion::WordBoundary));
+    }
+    }
+    return false;
+}
+
+bool LinearRegExp::isCharMatched(const Instruction& instruction, uint c) const
+{
+    switch (instruction.op)
+    {
+    case Op::Char:
+        return (m_isCaseInsensitive ? QChar::toCaseFolded(c) : c) == static_cast<uint>(instruction.x);
+    case Op::Any:
+        return (c != '\n');
+    case Op::Class:
+    {
+        const CharClass& charClass = m_classes.at(instruction.x);
+        bool isContained = charClass.contains(c);
+        if (!isContained && m_isCaseInsensitive)
+            isContained = charClass.contains(QChar::toLower(c)) || charClass.contains(QChar::toUpper(c));
+        return (isContained != charClass.isNegated);
+    }
+    default:
+        return false;
+    }
+}
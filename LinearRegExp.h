@@ -0,0 +1,98 @@
+#pragma once
+
+#include <QtCore/QPair>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include <vector>
+
+/* Regular expression matched in time linear in text length: Thompson NFA simulated in lockstep (Pike VM),
+ * so no pattern can backtrack exponentially. Supports common subset of PCRE syntax: literals and escapes, '.', [...] classes,
+ * \d \w \s and their negations, ^ $ \A \z \Z \b \B, capturing, named and non-capturing groups, alternation,
+ * greedy and lazy * + ? {n,m} quantifiers. Anything else (backreferences, lookarounds, inline options, possessive quantifiers,
+ * Unicode properties, repetition of a subpattern that can match empty such as (a?)+, ...) leaves isValid() false and the caller
+ * is expected to use QRegularExpression instead.
+ * Match semantics are those of PCRE: leftmost-first, same captures, '.' doesn't match '\n', \d \w \s are ASCII only.
+ * Text is matched by code points, a surrogate pair being one character as in PCRE's UTF mode. */
+class LinearRegExp
+{
+    struct ThreadList
+    {
+        struct StackEntry
+        {
+            int pc;
+            int slot;  // >= 0: entry restores captures[slot] to value instead of following pc
+            int value;
+        };
+
+        std::vector<int> pcs;
+        std::vector<int> captures; // slotCount per thread, in the same order as pcs
+        std::vector<int> marks;    // generation in which pc was last visited
+        std::vector<StackEntry> stack;
+        int generation = 0;
+
+        void reset(int newGeneration)
+        {
+            pcs.clear();
+            captures.clear();
+            generation = newGeneration;
+        }
+    };
+
+public:
+    // Scratch space of match(): thread lists grow to the size the pattern needs and are reused by following calls,
+    // so matching line after line doesn't allocate. One context per thread, it may be used with different patterns.
+    class MatchContext
+    {
+        friend class LinearRegExp;
+        ThreadList m_lists[2];
+        std::vector<int> m_work;
+        int m_generation = 0;
+    };
+
+    LinearRegExp() = default;
+    LinearRegExp(const QString& pattern, Qt::CaseSensitivity caseSensitivity);
+
+    bool isValid() const { return m_isValid; }
+    int captureCount() const { return m_captureCount; }
+    // Pattern has a repeated subpattern which itself contains repetition or alternation, e.g. (a+)+ or (a|ab)*:
+    // the kind of pattern a backtracking engine may need exponential time for
+    bool isBacktrackingProne() const { return m_isBacktrackingProne; }
+
+    // Finds the first match starting at offset or later. captures receives start and end of each group (-1 if it didn't participate),
+    // group 0 being the whole match. isNotEmptyAtOffset rejects empty match at offset, as used to continue after an empty match.
+    bool match(const QString& text, int offset, bool isNotEmptyAtOffset, QVector<int>& captures, MatchContext& context) const;
+
+private:
+    enum class Op : quint8 { Char, Any, Class, Split, Jmp, Save, Progress, Assert, Match };
+    enum class Assertion : quint8 { LineStart, LineEnd, TextStart, TextEnd, TextEndOrNewline, WordBoundary, NotWordBoundary };
+    struct Instruction
+    {
+        Op op;
+        int x = 0; // Char: character, Class: index in m_classes, Split: preferred target, Jmp: target, Save and Progress: slot, Assert: Assertion
+        int y = 0; // Split: other target, Progress: target if something was consumed since slot was saved
+    };
+    struct CharClass
+    {
+        enum Builtin : quint8 { Digit = 0x01, NotDigit = 0x02, Word = 0x04, NotWord = 0x08, Space = 0x10, NotSpace = 0x20 };
+        bool isNegated = false;
+        quint8 builtins = 0;
+        QVector<QPair<uint, uint>> ranges;
+
+        bool contains(uint c) const;
+    };
+
+    struct Compiler;
+    void addThread(ThreadList& list, int pc, int* captures, const QChar* text, int size, int position) const;
+    bool isAssertionTrue(Assertion assertion, const QChar* text, int size, int position) const;
+    bool isCharMatched(const Instruction& instruction, uint c) const;
+
+    bool m_isValid = false;
+    bool m_isCaseInsensitive = false;
+    bool m_isBacktrackingProne = false;
+    int m_captureCount = 0;
+    int m_slotCount = 2;  // capture slots followed by hidden slots holding start of current iteration of each unbounded repetition
+    int m_firstChar = -1; // character every match starts with (case folded if case insensitive), -1 if unknown
+    QVector<Instruction> m_program;
+    QVector<CharClass> m_classes;
+};
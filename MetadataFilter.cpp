@@ -0,0 +1,154 @@
+#include "MetadataFilter.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QRegularExpression>
+
+#ifdef Q_OS_UNIX
+#include <pwd.h>
+#endif
+
+namespace
+{
+
+// Number with an optional suffix of multipliers, e.g. "1.5M"; -1 if invalid
+qint64 parseQuantity(const QString& text, const QString& suffixes, const QVector<qint64>& multipliers, bool isSuffixRequired)
+{
+    if (text.isEmpty())
+        return -1;
+    const int suffixIdx = suffixes.indexOf(text.back(), 0, Qt::CaseInsensitive);
+    if ((suffixIdx == -1) && isSuffixRequired)
+        return -1;
+    bool isOk = false;
+    const double number = ((suffixIdx == -1) ? text : text.chopped(1)).toDouble(&isOk);
+    if (!isOk || (number < 0))
+        return -1;
+    return static_cast<qint64>(number * static_cast<double>((suffixIdx == -1) ? 1 : multipliers.at(suffixIdx)));
+}
+
+} // namespace
+
+
+MetadataFilter::MetadataFilter(const QString& spec)
+    : m_nowMs(QDateTime::currentMSecsSinceEpoch())
+{
+    const QStringList termTexts = spec.split(' ', Qt::SkipEmptyParts);
+    for (const QString& termText : termTexts)
+    {
+        Term term;
+        if (!parseTerm(termText, term))
+        {
+            m_terms.clear();
+            return;
+        }
+        m_terms.append(term);
+    }
+}
+
+template<typename T>
+bool MetadataFilter::compare(const T& lhs, const T& rhs, Op op)
+{
+    switch (op)
+    {
+    case Op::Less:
+        return lhs < rhs;
+    case Op::LessEqual:
+        return lhs <= rhs;
+    case Op::Equal:
+        return lhs == rhs;
+    case Op::NotEqual:
+        return lhs != rhs;
+    case Op::GreaterEqual:
+        return lhs >= rhs;
+    case Op::Greater:
+        break;
+    }
+    return lhs > rhs;
+}
+
+bool MetadataFilter::parseTerm(const QString& termText, Term& term)
+{
+    static const QRegularExpression termRegExp("^(size|age|owner|type)(<=|>=|!=|<|>|=)(.+)$");
+    static const QStringList opTexts({"<", "<=", "=", "!=", ">=", ">"});
+    const QRegularExpressionMatch match = termRegExp.match(termText);
+    if (!match.hasMatch())
+    {
+        m_errorString = QString("\"%1\" is not a size, age, owner or type term").arg(termText);
+        return false;
+    }
+    const QString fieldText = match.captured(1);
+    const QString valueText = match.captured(3);
+    term.op = static_cast<Op>(opTexts.indexOf(match.captured(2)));
+    term.field = (fieldText == "size") ? Field::Size : (fieldText == "age") ? Field::Age : (fieldText == "owner") ? Field::Owner : Field::Type;
+    if (((term.field == Field::Owner) || (term.field == Field::Type)) && (term.op != Op::Equal) && (term.op != Op::NotEqual))
+    {
+        m_errorString = QString("\"%1\": %2 takes = or != only").arg(termText, fieldText);
+        return false;
+    }
+
+    QString expectedText;
+    switch (term.field)
+    {
+    case Field::Size:
+        term.value = parseQuantity(valueText, "KMGT", {1LL << 10, 1LL << 20, 1LL << 30, 1LL << 40}, false);
+        expectedText = "a size like 100M";
+        break;
+    case Field::Age:
+        term.value = parseQuantity(valueText, "smhdw", {1000LL, 60 * 1000LL, 3600 * 1000LL, 24 * 3600 * 1000LL, 7 * 24 * 3600 * 1000LL}, true);
+        expectedText = "an age like 7d";
+        break;
+    case Field::Owner:
+    {
+        bool isId = false;
+        term.value = valueText.toUInt(&isId);
+        if (isId)
+            return true;
+        // resolved once here, QFileInfo::owner() would look the name up for every entry
+        term.ownerName = valueText;
+        term.value = -1;
+#ifdef Q_OS_UNIX
+        if (const struct passwd* pPasswd = ::getpwnam(valueText.toLocal8Bit().constData()))
+            term.value = pPasswd->pw_uid;
+#endif
+        return true;
+    }
+    case Field::Type:
+        term.value = (valueText.size() == 1) ? QString("fdl").indexOf(valueText) : -1;
+        expectedText = "f, d or l";
+        break;
+    }
+    if (term.value >= 0)
+        return true;
+    m_errorString = QString("\"%1\": expected %2").arg(termText, expectedText);
+    return false;
+}
+
+bool MetadataFilter::matchesTerms(const QFileInfo& entry) const
+{
+    for (const Term& term : m_terms)
+    {
+        const Op op = term.op;
+        bool isMatch = false;
+        switch (term.field)
+        {
+        case Field::Size:
+            isMatch = compare(entry.size(), term.value, op);
+            break;
+        case Field::Age:
+            isMatch = compare(m_nowMs - entry.lastModified().toMSecsSinceEpoch(), term.value, op);
+            break;
+        case Field::Owner:
+            isMatch = (term.value >= 0) ? compare(static_cast<qint64>(entry.ownerId()), term.value, op)
+                                        : compare(entry.owner(), term.ownerName, op);
+            break;
+        case Field::Type:
+        {
+            const Type type = entry.isSymLink() ? Type::SymLink : entry.isDir() ? Type::Dir : Type::File;
+            isMatch = compare(static_cast<qint64>(type), term.value, op);
+            break;
+        }
+        }
+        if (!isMatch)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+/* Predicates on metadata of search targets, checked right after the name pattern and before any contents are read.
+ * Spec is a space separated list of terms, all of which have to hold:
+ *  - size>100M, size<=4K  size in bytes; K, M, G and T are binary multiples,
+ *  - age>7d, age<12h      time since last modification, in s, m, h, d or w,
+ *  - owner=root, owner!=1000  user name or id,
+ *  - type=f, type!=l      regular file, d directory or l symlink (a symlink is of type l only).
+ * Size and age take <, <=, =, !=, >= and >, owner and type = and != only.
+ * Metadata comes from the QFileInfo of the walk, which keeps what listing the directory has stat()ed, so a term costs no I/O. */
+class MetadataFilter
+{
+public:
+    MetadataFilter() = default;
+    // Ages are counted from the time of construction
+    explicit MetadataFilter(const QString& spec);
+
+    bool isActive() const { return !m_terms.isEmpty(); }
+    bool isValid() const { return m_errorString.isEmpty(); }
+    // Which term is wrong and why, empty if spec is valid
+    const QString& errorString() const { return m_errorString; }
+
+    bool matches(const QFileInfo& entry) const
+    {
+        return m_terms.isEmpty() || matchesTerms(entry);
+    }
+
+private:
+    enum class Field { Size, Age, Owner, Type };
+    enum class Op { Less, LessEqual, Equal, NotEqual, GreaterEqual, Greater };
+    enum class Type { File, Dir, SymLink };
+    struct Term
+    {
+        Field field;
+        Op op;
+        qint64 value = 0; // bytes, milliseconds, user id (-1 if name is unknown here) or Type
+        QString ownerName;
+    };
+
+    template<typename T>
+    static bool compare(const T& lhs, const T& rhs, Op op);
+    bool parseTerm(const QString& termText, Term& term);
+    bool matchesTerms(const QFileInfo& entry) const;
+
+    QVector<Term> m_terms;
+    qint64 m_nowMs = 0;
+    QString m_errorString;
+};
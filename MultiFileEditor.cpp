@@ -1,14 +1,37 @@
 #include "MultiFileEditor.h"
 
+#include <algorithm>
+#include <deque>
 #include <functional>
+#include <limits>
 
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+#include <QtCore/QFutureWatcher>
 #include <QtCore/QRegularExpression>
 #include <QtCore/QSettings>
 #include <QtCore/QTextStream>
+#include <QtWidgets/QDialog>
+#include <QtWidgets/QDialogButtonBox>
 #include <QtWidgets/QFileDialog>
+#include <QtWidgets/QFormLayout>
+#include <QtWidgets/QLabel>
+#include <QtWidgets/QListWidget>
 #include <QtWidgets/QMessageBox>
+#include <QtWidgets/QSpinBox>
+#include <QtWidgets/QVBoxLayout>
 
+#include "FileNameMatcher.h"
+#include "LineMatchers.h"
 #include "MulticolorDelegate.h"
+#include "Profiler.h"
+#include "RenamePlan.h"
+#include "ReplaceTableDialog.h"
+#include "ResultExport.h"
+#include "TaskGroup.h"
+#include "TreeRemover.h"
 
 // #ifdef Q_OS_WIN
 // #include "aclapi.h" // https://stackoverflow.com/questions/5021645/qt-setpermissions-not-setting-permisions
@@ -17,12 +40,35 @@
 #include <QtWidgets/QTextEdit>
 
 
+// Loads and compiles replace table of a search; Remove drops replacements so that matches are just cut out
+static bool loadReplaceTable(const QString& filePath, ActionType actionType, Qt::CaseSensitivity caseSensitivity, ReplaceTable& replaceTable)
+{
+    if (!replaceTable.load(filePath))
+        return false;
+    if (actionType == ActionType::Remove)
+    {
+        QVector<ReplaceTable::Pair> pairs = replaceTable.pairs();
+        for (ReplaceTable::Pair& pair : pairs)
+            pair.replaceWith.clear();
+        replaceTable.setPairs(pairs);
+    }
+    return replaceTable.compile(caseSensitivity);
+}
+
+
 MultiFileEditor::MultiFileEditor(QWidget* parent)
     : QWidget(parent)
+    , m_folderIcon(":/Icons/folder_15x15.png")
+    , m_fileIcon(":/Icons/file_12x15.png")
+    , m_okIcon(":/Icons/checkmark_ok_16x16.png")
+    , m_errorIcon(":/Icons/checkmark_error_16x16.png")
+    , m_trash(g_trashListPath)
+    , m_checkpoint(g_checkpointPath)
     , ui(new Ui::MultiFileEditor)
 {
     QApplication::setApplicationName("qMultiFileEditor");
     ui->setupUi(this);
+    ui->progressBar_execute->setVisible(false);
     MulticolorDelegateV2* delegate = new MulticolorDelegateV2(ui->treeWidget_results);
     ui->treeWidget_results->setItemDelegate(delegate);
 
@@ -38,44 +84,54 @@ MultiFileEditor::MultiFileEditor(QWidget* parent)
 
     loadSettings();
     loadAllPresets();
+    m_trash.resumePurges();
     ui->comboBox_presets->setCurrentIndex(-1);
 
     connect(ui->comboBox_presets, &QComboBox::textActivated, this, &MultiFileEditor::fillPreset);
     connect(ui->pushButton_savePreset,   &QPushButton::clicked, this, &MultiFileEditor::savePreset);
     connect(ui->pushButton_removePreset, &QPushButton::clicked, this, &MultiFileEditor::removePreset);
+    connect(ui->pushButton_runPresets,   &QPushButton::clicked, this, &MultiFileEditor::runPresets);
     connect(ui->comboBox_actionType,    qOverload<int>(&QComboBox::activated), this, &MultiFileEditor::onActionCombosActivated);
     connect(ui->comboBox_actionTarget,  qOverload<int>(&QComboBox::activated), this, &MultiFileEditor::onActionCombosActivated);
     connect(ui->pushButton_browseDirectory, &QPushButton::clicked, this, &MultiFileEditor::getExistingDirectory);
+    connect(ui->pushButton_browseReplaceTable, &QPushButton::clicked, this, &MultiFileEditor::getReplaceTableFile);
+    connect(ui->pushButton_editReplaceTable,   &QPushButton::clicked, this, &MultiFileEditor::editReplaceTable);
     connect(ui->pushButton_reset,           &QPushButton::clicked, this, &MultiFileEditor::reset);
     connect(ui->pushButton_execute,         &QPushButton::clicked, this, &MultiFileEditor::execute);
+    connect(ui->pushButton_searchToFile,    &QPushButton::clicked, this, &MultiFileEditor::searchToFile);
+    connect(ui->pushButton_savePlan,        &QPushButton::clicked, this, &MultiFileEditor::savePlan);
+    connect(ui->pushButton_loadPlan,        &QPushButton::clicked, this, &MultiFileEditor::loadPlan);
+    connect(ui->pushButton_undo,            &QPushButton::clicked, this, &MultiFileEditor::undoLastExecute);
+    connect(ui->pushButton_throttle,        &QPushButton::clicked, this, &MultiFileEditor::showThrottleDialog);
     // TODO: optimize to omit excessive rechecking?
     connect(ui->lineEdit_dirPath,       &QLineEdit::editingFinished, this, &MultiFileEditor::checkAllValidity);
     connect(ui->lineEdit_filePattern,   &QLineEdit::editingFinished, this, &MultiFileEditor::checkAllValidity);
     connect(ui->lineEdit_searchFor,     &QLineEdit::editingFinished, this, &MultiFileEditor::checkAllValidity);
     connect(ui->lineEdit_replaceWith,   &QLineEdit::editingFinished, this, &MultiFileEditor::checkAllValidity);
+    connect(ui->lineEdit_replaceTable,  &QLineEdit::editingFinished, this, &MultiFileEditor::onActionCombosActivated);
+    connect(ui->lineEdit_metadata,      &QLineEdit::editingFinished, this, &MultiFileEditor::checkAllValidity);
     connect(ui->checkBox_isRegExpFilePattern,   &QCheckBox::clicked, this, &MultiFileEditor::checkAllValidity);
     connect(ui->checkBox_isRegExpSearchReplace, &QCheckBox::clicked, this, &MultiFileEditor::checkAllValidity);
 
+    m_progressTimer.setInterval(250); // a few times per second is enough for a human and costs nothing to workers
+    connect(&m_progressTimer, &QTimer::timeout, this, &MultiFileEditor::updateProgress);
+
     onActionCombosActivated();
+    // asked once the window is shown
+    QMetaObject::invokeMethod(this, &MultiFileEditor::offerResume, Qt::QueuedConnection);
 }
 
 MultiFileEditor::~MultiFileEditor()
 {
+    if (m_isHeadless)
+    {
+        delete ui;
+        return;
+    }
     QSettings settingsFile(g_settingsPath, QSettings::IniFormat, this);
     // save last preset
     settingsFile.beginGroup("LastPreset");
-    settingsFile.setValue("action_type", ui->comboBox_actionType->currentData(Qt::UserRole));
-    settingsFile.setValue("action_target", ui->comboBox_actionTarget->currentData(Qt::UserRole));
-    settingsFile.setValue("recursive", ui->checkBox_isRecursive->isChecked());
-    settingsFile.setValue("case_sensitive", ui->checkBox_isCaseSensitive->isChecked());
-    settingsFile.setValue("autoconfirm_execute", ui->checkBox_isAutoconfirmExecute->isChecked());
-    settingsFile.setValue("re_file_pattern", ui->checkBox_isRegExpFilePattern->isChecked());
-    settingsFile.setValue("re_search_replace", ui->checkBox_isRegExpSearchReplace->isChecked());
-    settingsFile.setValue("highlight_match", ui->checkBox_isHighlightMatch->isChecked());
-    settingsFile.setValue("dir_path", ui->lineEdit_dirPath->text());
-    settingsFile.setValue("file_pattern", ui->lineEdit_filePattern->text());
-    settingsFile.setValue("search_for", ui->lineEdit_searchFor->text());
-    settingsFile.setValue("replace_with", ui->lineEdit_replaceWith->text());
+    writePreset(settingsFile, presetFromUi());
     settingsFile.endGroup();
     // save last settings
     settingsFile.beginGroup("LastSettings");
@@ -85,6 +141,14 @@ MultiFileEditor::~MultiFileEditor()
     settingsFile.setValue("width", geo.width());
     settingsFile.setValue("height", geo.height());
     settingsFile.endGroup();
+    // save throttle, it's changed from GUI
+    const Throttle::Limits throttleLimits = m_throttle.limits();
+    settingsFile.beginGroup("Throttle");
+    settingsFile.setValue("io_priority", Throttle::ioPriorityToString(throttleLimits.ioPriority));
+    settingsFile.setValue("max_mb_per_sec", throttleLimits.bytesPerSec / (1024 * 1024));
+    settingsFile.setValue("max_files_per_sec", throttleLimits.filesPerSec);
+    settingsFile.setValue("max_threads", throttleLimits.threadCount);
+    settingsFile.endGroup();
 
     delete ui;
 }
@@ -136,37 +200,77 @@ void MultiFileEditor::onActionCombosActivated()
             ui->checkBox_isRegExpSearchReplace->setChecked(true);
         }
     }
+    const bool isContents = (actionTarget == ActionTarget::FileContents);
+    ui->lineEdit_replaceTable->setEnabled(isContents);
+    ui->pushButton_browseReplaceTable->setEnabled(isContents);
+    ui->pushButton_editReplaceTable->setEnabled(isContents);
+    if (isContents && !ui->lineEdit_replaceTable->text().isEmpty())
+    {
+        // table replaces single search\replace pair
+        ui->checkBox_isRegExpSearchReplace->setEnabled(false);
+        ui->lineEdit_searchFor->setEnabled(false);
+        ui->lineEdit_replaceWith->setEnabled(false);
+    }
     checkAllValidity();
     return;
 }
 
 void MultiFileEditor::getExistingDirectory()
 {
-    QString startingPath(ui->lineEdit_dirPath->text());
+    const QStringList dirPaths = dirPathsFromString(ui->lineEdit_dirPath->text());
+    QString startingPath = dirPaths.isEmpty() ? QString() : dirPaths.back();
     if (QDir(startingPath).exists() == false)
         startingPath = QDir::currentPath();
     QString dirPath = QFileDialog::getExistingDirectory(
         this, "Pick a directory", startingPath, QFileDialog::ShowDirsOnly);
-    if (!dirPath.isEmpty() && QDir(dirPath).exists())
+    // picked directory is added to a list of roots, replaces a single one
+    if (!dirPath.isEmpty() && QDir(dirPath).exists() && ui->lineEdit_dirPath->text().trimmed().startsWith('"'))
+        ui->lineEdit_dirPath->setText(QString("%1 \"%2\"").arg(ui->lineEdit_dirPath->text().trimmed(), dirPath));
+    else if (!dirPath.isEmpty() && QDir(dirPath).exists())
         ui->lineEdit_dirPath->setText(dirPath);
     emit ui->lineEdit_dirPath->editingFinished();
     return;
 }
 
+void MultiFileEditor::getReplaceTableFile()
+{
+    QString filePath = QFileDialog::getOpenFileName(
+        this, "Pick a replace table", ui->lineEdit_replaceTable->text(), "Replace tables (*.tsv);;All files (*)");
+    if (!filePath.isEmpty())
+        ui->lineEdit_replaceTable->setText(filePath);
+    emit ui->lineEdit_replaceTable->editingFinished();
+    return;
+}
+
+void MultiFileEditor::editReplaceTable()
+{
+    ReplaceTableDialog dialog(ui->lineEdit_replaceTable->text(), this);
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+    ui->lineEdit_replaceTable->setText(dialog.filePath());
+    emit ui->lineEdit_replaceTable->editingFinished();
+    return;
+}
+
 bool MultiFileEditor::checkDirectoryValidity()
 {
     bool isValid = true;
-    if ((ui->lineEdit_dirPath->text().isEmpty() == false) && QDir(ui->lineEdit_dirPath->text()).exists())
+    const QStringList dirPaths = dirPathsFromString(ui->lineEdit_dirPath->text());
+    auto missingIter = std::find_if(dirPaths.begin(), dirPaths.end(), [](const QString& dirPath)
+    {
+        return dirPath.isEmpty() || !QDir(dirPath).exists();
+    });
+    if (!dirPaths.isEmpty() && (missingIter == dirPaths.end()))
     {
         isValid = true;
         ui->label_directoryCheckMark->setPixmap(QPixmap(":/Icons/checkmark_ok_16x16.png"));
-        ui->label_directoryCheckMark->setToolTip("Directory is valid");
+        ui->label_directoryCheckMark->setToolTip((dirPaths.size() == 1) ? QString("Directory is valid") : QString("All %1 directories are valid").arg(dirPaths.size()));
     }
     else
     {
         isValid = false;
         ui->label_directoryCheckMark->setPixmap(QPixmap(":/Icons/checkmark_error_16x16.png"));
-        ui->label_directoryCheckMark->setToolTip("Directory doesn't exist");
+        ui->label_directoryCheckMark->setToolTip((dirPaths.size() <= 1) ? QString("Directory doesn't exist") : QString("Directory doesn't exist: %1").arg(*missingIter));
     }
     return isValid;
 }
@@ -228,12 +332,56 @@ bool MultiFileEditor::checkSearchReplaceValidity()
     return isValid;
 }
 
+bool MultiFileEditor::checkReplaceTableValidity()
+{
+    bool isValid = true;
+    if (ui->lineEdit_replaceTable->isEnabled() && !ui->lineEdit_replaceTable->text().isEmpty())
+    {
+        ReplaceTable replaceTable;
+        if (!replaceTable.load(ui->lineEdit_replaceTable->text()) || !replaceTable.compile(Qt::CaseSensitive))
+        {
+            isValid = false;
+            ui->label_replaceTableCheckMark->setPixmap(QPixmap(":/Icons/checkmark_error_16x16.png"));
+            ui->label_replaceTableCheckMark->setToolTip(replaceTable.errorString());
+        }
+        else
+        {
+            ui->label_replaceTableCheckMark->setPixmap(QPixmap(":/Icons/checkmark_ok_16x16.png"));
+            ui->label_replaceTableCheckMark->setToolTip(QString("Replace table is valid, %1 pairs").arg(replaceTable.pairs().size()));
+        }
+    }
+    else
+    {
+        ui->label_replaceTableCheckMark->clear();
+        ui->label_replaceTableCheckMark->setToolTip(QString());
+    }
+    return isValid;
+}
+
+bool MultiFileEditor::checkMetadataValidity()
+{
+    const MetadataFilter metadataFilter(ui->lineEdit_metadata->text());
+    if (metadataFilter.isValid())
+    {
+        ui->label_metadataCheckMark->setPixmap(QPixmap(":/Icons/checkmark_ok_16x16.png"));
+        ui->label_metadataCheckMark->setToolTip(metadataFilter.isActive() ? "Metadata conditions are valid" : "No metadata conditions");
+    }
+    else
+    {
+        ui->label_metadataCheckMark->setPixmap(QPixmap(":/Icons/checkmark_error_16x16.png"));
+        ui->label_metadataCheckMark->setToolTip(metadataFilter.errorString());
+    }
+    return metadataFilter.isValid();
+}
+
 void MultiFileEditor::checkAllValidity()
 {
     bool isAllValid = true;
     isAllValid &= checkDirectoryValidity();
     isAllValid &= checkFilePatternValidity();
     isAllValid &= checkSearchReplaceValidity();
+    isAllValid &= checkReplaceTableValidity();
+    isAllValid &= checkMetadataValidity();
     if (isAllValid)
     {
         ui->pushButton_execute->setEnabled(true);
@@ -242,6 +390,7 @@ void MultiFileEditor::checkAllValidity()
     {
         ui->pushButton_execute->setEnabled(false);
     }
+    ui->pushButton_searchToFile->setEnabled(isAllValid && !m_isSearchDone);
     return;
 }
 
@@ -252,37 +401,15 @@ void MultiFileEditor::savePreset()
         QMessageBox::critical(this, "Error", "Preset name can't be empty");
         return;
     }
+    const QString presetName = ui->comboBox_presets->currentText();
+    MFEPreset& preset = m_presetMap[presetName];
+    preset = presetFromUi();
+    preset.presetName = presetName;
     QSettings presetsFile(g_presetsPath, QSettings::IniFormat, this);
-    presetsFile.beginGroup(ui->comboBox_presets->currentText());
-    presetsFile.setValue("action_type", ui->comboBox_actionType->currentData(Qt::UserRole));
-    presetsFile.setValue("action_target", ui->comboBox_actionTarget->currentData(Qt::UserRole));
-    presetsFile.setValue("recursive", ui->checkBox_isRecursive->isChecked());
-    presetsFile.setValue("case_sensitive", ui->checkBox_isCaseSensitive->isChecked());
-    presetsFile.setValue("autoconfirm_execute", ui->checkBox_isAutoconfirmExecute->isChecked());
-    presetsFile.setValue("re_file_pattern", ui->checkBox_isRegExpFilePattern->isChecked());
-    presetsFile.setValue("re_search_replace", ui->checkBox_isRegExpSearchReplace->isChecked());
-    presetsFile.setValue("highlight_match", ui->checkBox_isHighlightMatch->isChecked());
-    presetsFile.setValue("dir_path", ui->lineEdit_dirPath->text());
-    presetsFile.setValue("file_pattern", ui->lineEdit_filePattern->text());
-    presetsFile.setValue("search_for", ui->lineEdit_searchFor->text());
-    presetsFile.setValue("replace_with", ui->lineEdit_replaceWith->text());
+    presetsFile.beginGroup(presetName);
+    writePreset(presetsFile, preset);
     presetsFile.endGroup();
 
-    MFEPreset& preset = m_presetMap[ui->comboBox_presets->currentText()];
-    preset.actionType = ui->comboBox_actionType->currentData(Qt::UserRole).toInt();
-    preset.actionTarget = ui->comboBox_actionTarget->currentData(Qt::UserRole).toInt();
-    preset.isRecursive = ui->checkBox_isRecursive->isChecked();
-    preset.isCaseSensitive = ui->checkBox_isCaseSensitive->isChecked();
-    preset.isAutoconfirmExecute = ui->checkBox_isAutoconfirmExecute->isChecked();
-    preset.isRegExpFilePattern = ui->checkBox_isRegExpFilePattern->isChecked();
-    preset.isRegExpSearchReplace = ui->checkBox_isRegExpSearchReplace->isChecked();
-    preset.isHighlightMatch = ui->checkBox_isHighlightMatch->isChecked();
-    preset.dirPath = ui->lineEdit_dirPath->text();
-    preset.filePattern = ui->lineEdit_filePattern->text();
-    preset.searchFor = ui->lineEdit_searchFor->text();
-    preset.replaceWith = ui->lineEdit_replaceWith->text();
-    preset.presetName = ui->comboBox_presets->currentText();
-
     QMessageBox::information(this, "Saved", "Preset successfully saved");
     return;
 }
@@ -304,7 +431,36 @@ void MultiFileEditor::removePreset()
 
 void MultiFileEditor::fillPreset(const QString& presetName)
 {
-    MFEPreset& preset = m_presetMap[presetName]; // TODO: safer to use .find() ?
+    applyPreset(m_presetMap[presetName]); // TODO: safer to use .find() ?
+    return;
+}
+
+MFEPreset MultiFileEditor::presetFromUi() const
+{
+    MFEPreset preset;
+    preset.actionType = ui->comboBox_actionType->currentData(Qt::UserRole).toInt();
+    preset.actionTarget = ui->comboBox_actionTarget->currentData(Qt::UserRole).toInt();
+    preset.isRecursive = ui->checkBox_isRecursive->isChecked();
+    preset.isCaseSensitive = ui->checkBox_isCaseSensitive->isChecked();
+    preset.isAutoconfirmExecute = ui->checkBox_isAutoconfirmExecute->isChecked();
+    preset.isRegExpFilePattern = ui->checkBox_isRegExpFilePattern->isChecked();
+    preset.isRegExpSearchReplace = ui->checkBox_isRegExpSearchReplace->isChecked();
+    preset.isHighlightMatch = ui->checkBox_isHighlightMatch->isChecked();
+    preset.isRespectIgnoreFiles = ui->checkBox_isRespectIgnoreFiles->isChecked();
+    preset.isSparePageCache = ui->checkBox_isSparePageCache->isChecked();
+    preset.isOneFileSystem = ui->checkBox_isOneFileSystem->isChecked();
+    preset.dirPath = ui->lineEdit_dirPath->text();
+    preset.filePattern = ui->lineEdit_filePattern->text();
+    preset.searchFor = ui->lineEdit_searchFor->text();
+    preset.replaceWith = ui->lineEdit_replaceWith->text();
+    preset.excludeDirs = ui->lineEdit_excludeDirs->text();
+    preset.metadataFilter = ui->lineEdit_metadata->text();
+    preset.replaceTable = ui->lineEdit_replaceTable->text();
+    return preset;
+}
+
+void MultiFileEditor::applyPreset(const MFEPreset& preset)
+{
     ui->comboBox_actionType->setCurrentIndex(ui->comboBox_actionType->findData(preset.actionType, Qt::UserRole));
     ui->comboBox_actionTarget->setCurrentIndex(ui->comboBox_actionTarget->findData(preset.actionTarget, Qt::UserRole));
     ui->checkBox_isRecursive->setChecked(preset.isRecursive);
@@ -313,13 +469,18 @@ void MultiFileEditor::fillPreset(const QString& presetName)
     ui->checkBox_isRegExpFilePattern->setChecked(preset.isRegExpFilePattern);
     ui->checkBox_isRegExpSearchReplace->setChecked(preset.isRegExpSearchReplace);
     ui->checkBox_isHighlightMatch->setChecked(preset.isHighlightMatch);
+    ui->checkBox_isRespectIgnoreFiles->setChecked(preset.isRespectIgnoreFiles);
+    ui->checkBox_isSparePageCache->setChecked(preset.isSparePageCache);
+    ui->checkBox_isOneFileSystem->setChecked(preset.isOneFileSystem);
     if (!preset.dirPath.isEmpty())
         ui->lineEdit_dirPath->setText(preset.dirPath);
     ui->lineEdit_filePattern->setText(preset.filePattern);
     ui->lineEdit_searchFor->setText(preset.searchFor);
     ui->lineEdit_replaceWith->setText(preset.replaceWith);
+    ui->lineEdit_excludeDirs->setText(preset.excludeDirs);
+    ui->lineEdit_metadata->setText(preset.metadataFilter);
+    ui->lineEdit_replaceTable->setText(preset.replaceTable);
     onActionCombosActivated();
-    return;
 }
 
 void MultiFileEditor::loadSettings()
@@ -332,22 +493,55 @@ void MultiFileEditor::loadSettings()
     int width = settingsFile.value("width").toInt();
     int height = settingsFile.value("height").toInt();
     this->setGeometry(x, y, width, height);
+    setLastJournalDirPath(settingsFile.value("journal_dir").toString());
+    settingsFile.endGroup();
+
+    settingsFile.beginGroup("Profiling");
+    const bool isProfilingEnabled = settingsFile.value("enabled", false).toBool();
+    m_traceFilePath = settingsFile.value("trace_file").toString();
+    Profiler::setEnabled(isProfilingEnabled);
+    Profiler::setTraceEnabled(isProfilingEnabled && !m_traceFilePath.isEmpty());
+    settingsFile.endGroup();
+
+    settingsFile.beginGroup("Search");
+    m_regExpEngine = SearchRegExp::engineFromString(settingsFile.value("regexp_engine", "auto").toString());
+    m_lineTimeBudgetNs = settingsFile.value("line_time_budget_ms", 1000).toLongLong() * 1000000;
+    m_fileTimeBudgetNs = settingsFile.value("file_time_budget_ms", 10000).toLongLong() * 1000000;
+    m_pcreMatchLimit = settingsFile.value("pcre_match_limit", 1000000).toInt();
+    m_ioBackend = FileReader::backendFromString(settingsFile.value("io_backend", "auto").toString());
+    m_ioQueueDepth = settingsFile.value("io_queue_depth", 32).toInt();
+    m_readaheadSize = settingsFile.value("readahead_kb", 0).toLongLong() * 1024;
+    settingsFile.endGroup();
+
+    settingsFile.beginGroup("Results");
+    // negative limit keeps all results in memory
+    m_resultStore.setMemoryLimit(settingsFile.value("memory_limit_mb", 1024).toLongLong() * 1024 * 1024);
+    m_resultStore.setSpillDirPath(settingsFile.value("spill_dir").toString());
+    settingsFile.endGroup();
+
+    settingsFile.beginGroup("Throttle");
+    Throttle::Limits throttleLimits;
+    throttleLimits.ioPriority = Throttle::ioPriorityFromString(settingsFile.value("io_priority", "normal").toString());
+    throttleLimits.bytesPerSec = settingsFile.value("max_mb_per_sec", 0).toLongLong() * 1024 * 1024;
+    throttleLimits.filesPerSec = settingsFile.value("max_files_per_sec", 0).toLongLong();
+    throttleLimits.threadCount = settingsFile.value("max_threads", 0).toInt();
+    m_throttle.setLimits(throttleLimits);
+    settingsFile.endGroup();
+
+    settingsFile.beginGroup("Remove");
+    m_isDetachRemove = settingsFile.value("detach_to_trash", false).toBool();
+    settingsFile.endGroup();
+
+    settingsFile.beginGroup("Journal");
+    m_isJournalEnabled = settingsFile.value("enabled", true).toBool();
+    settingsFile.endGroup();
+
+    settingsFile.beginGroup("Checkpoint");
+    m_isCheckpointEnabled = settingsFile.value("enabled", true).toBool();
     settingsFile.endGroup();
 
     settingsFile.beginGroup("LastPreset");
-    ui->comboBox_actionType->setCurrentIndex(ui->comboBox_actionType->findData(settingsFile.value("action_type").toInt(), Qt::UserRole));
-    ui->comboBox_actionTarget->setCurrentIndex(ui->comboBox_actionTarget->findData(settingsFile.value("action_target").toInt(), Qt::UserRole));
-    ui->checkBox_isRecursive->setChecked(settingsFile.value("recursive").toBool());
-    ui->checkBox_isCaseSensitive->setChecked(settingsFile.value("case_sensitive").toBool());
-    ui->checkBox_isAutoconfirmExecute->setChecked(settingsFile.value("autoconfirm_execute").toBool());
-    ui->checkBox_isRegExpFilePattern->setChecked(settingsFile.value("re_file_pattern").toBool());
-    ui->checkBox_isRegExpSearchReplace->setChecked(settingsFile.value("autoconfirm_execute").toBool());
-    ui->checkBox_isHighlightMatch->setChecked(settingsFile.value("highlight_match").toBool());
-    ui->lineEdit_dirPath->setText(settingsFile.value("dir_path").toString());
-    ui->lineEdit_filePattern->setText(settingsFile.value("file_pattern").toString());
-    ui->lineEdit_searchFor->setText(settingsFile.value("search_for").toString());
-    ui->lineEdit_replaceWith->setText(settingsFile.value("replace_with").toString());
-    onActionCombosActivated();
+    applyPreset(readPreset(settingsFile));
     settingsFile.endGroup();
 }
 
@@ -360,18 +554,7 @@ void MultiFileEditor::loadAllPresets()
     {
         presetsFile.beginGroup(curPresetName);
         MFEPreset& curPreset = m_presetMap[curPresetName];
-        curPreset.actionType = presetsFile.value("action_type").toUInt();
-        curPreset.actionTarget = presetsFile.value("action_target").toInt();
-        curPreset.isRecursive = presetsFile.value("recursive").toBool();
-        curPreset.isCaseSensitive = presetsFile.value("case_sensitive").toBool();
-        curPreset.isAutoconfirmExecute = presetsFile.value("autoconfirm_execute").toBool();
-        curPreset.isRegExpFilePattern = presetsFile.value("re_file_pattern").toBool();
-        curPreset.isRegExpSearchReplace = presetsFile.value("re_search_replace").toBool();
-        curPreset.isHighlightMatch = presetsFile.value("highlight_match").toBool();
-        curPreset.dirPath = presetsFile.value("dir_path").toString();
-        curPreset.filePattern = presetsFile.value("file_pattern").toString();
-        curPreset.searchFor = presetsFile.value("search_for").toString();
-        curPreset.replaceWith = presetsFile.value("replace_with").toString();
+        curPreset = readPreset(presetsFile);
         curPreset.presetName = curPresetName;
         presetsFile.endGroup();
     }
@@ -379,82 +562,374 @@ void MultiFileEditor::loadAllPresets()
     return;
 }
 
+void MultiFileEditor::runPresets()
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle("Run presets");
+    QVBoxLayout* pLayout = new QVBoxLayout(&dialog);
+    pLayout->addWidget(new QLabel("Checked presets are searched in a single pass over current Path and executed one after another."
+                                  "\nDrag presets to change their order.", &dialog));
+    QListWidget* pPresetList = new QListWidget(&dialog);
+    pPresetList->setDragDropMode(QAbstractItemView::InternalMove);
+    for (int i = 0; i < ui->comboBox_presets->count(); ++i)
+    {
+        QListWidgetItem* pItem = new QListWidgetItem(ui->comboBox_presets->itemText(i), pPresetList);
+        pItem->setCheckState(Qt::Unchecked);
+    }
+    pLayout->addWidget(pPresetList);
+    QDialogButtonBox* pButtonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(pButtonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(pButtonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    pLayout->addWidget(pButtonBox);
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    QVector<PresetSearch> searches;
+    QStringList invalidPresets;
+    for (int i = 0; i < pPresetList->count(); ++i)
+    {
+        if (pPresetList->item(i)->checkState() != Qt::Checked)
+            continue;
+        const QString presetName = pPresetList->item(i)->text();
+        PresetSearch search = PresetSearch::fromPreset(m_presetMap.value(presetName), m_regExpEngine, m_pcreMatchLimit);
+        const QString errorString = search.errorString();
+        if (errorString.isEmpty())
+            searches.append(search);
+        else
+            invalidPresets.append(QString("%1: %2").arg(presetName, errorString));
+    }
+    if (!invalidPresets.isEmpty())
+    {
+        QMessageBox::critical(this, "Error", QString("Presets have empty or invalid patterns:\n%1").arg(invalidPresets.join('\n')));
+        return;
+    }
+    if (searches.isEmpty())
+        return;
+    if (!checkDirectoryValidity())
+    {
+        QMessageBox::critical(this, "Error", "Path is not an existing directory");
+        return;
+    }
+    m_presetSearches = searches;
+    execute();
+}
+
+void MultiFileEditor::offerResume()
+{
+    if (m_isHeadless || !m_isCheckpointEnabled || !m_checkpoint.resume())
+        return;
+    QString startedAt;
+    MFEPreset searchPreset;
+    QVector<MFEPreset> presets;
+    m_checkpoint.readRun([&](QSettings& runFile)
+    {
+        startedAt = runFile.value("Run/started").toString();
+        runFile.beginGroup("Search");
+        searchPreset = readPreset(runFile);
+        runFile.endGroup();
+        const int presetCount = runFile.beginReadArray("Presets");
+        for (int i = 0; i < presetCount; ++i)
+        {
+            runFile.setArrayIndex(i);
+            presets.append(readPreset(runFile));
+            presets.back().presetName = runFile.value("name").toString();
+        }
+        runFile.endArray();
+    });
+    const bool isExecuteResumed = (m_checkpoint.stage() == Checkpoint::Stage::Execute) && m_checkpoint.hasPlan();
+    const QString question = isExecuteResumed
+        ? QString("Execute started %1 was interrupted.\nResume it? Results are searched again, skipping what was found empty before,"
+                  " and only entries it hasn't done yet are left checked.")
+        : QString("Search started %1 was interrupted.\nResume it? What was found empty before is skipped.");
+    if (QMessageBox::question(this, "Resume interrupted run?", question.arg(startedAt)) != QMessageBox::Yes)
+    {
+        m_checkpoint.discard();
+        return;
+    }
+
+    // settings and presets are those of the run, even if presets were changed since
+    applyPreset(searchPreset);
+    QVector<PresetSearch> searches;
+    for (const MFEPreset& preset : qAsConst(presets))
+    {
+        PresetSearch search = PresetSearch::fromPreset(preset, m_regExpEngine, m_pcreMatchLimit);
+        if (!search.isValid())
+        {
+            QMessageBox::critical(this, "Error", QString("Can't resume, preset \"%1\": %2").arg(preset.presetName, search.errorString()));
+            m_checkpoint.discard();
+            return;
+        }
+        searches.append(search);
+    }
+    checkAllValidity();
+    if (!checkDirectoryValidity() || (searches.isEmpty() && !ui->pushButton_execute->isEnabled()))
+    {
+        QMessageBox::critical(this, "Error", "Can't resume, settings of the interrupted run are not valid anymore");
+        m_checkpoint.discard();
+        return;
+    }
+    m_presetSearches = searches;
+    m_isResuming = true;
+    execute();
+    if (isExecuteResumed && m_isSearchDone && !m_isCloseRequested)
+    {
+        applyExecuteCursor();
+        execute();
+    }
+    m_isResuming = false;
+}
+
+PresetSearch PresetSearch::fromPreset(const MFEPreset& preset, SearchRegExp::Engine regExpEngine, int pcreMatchLimit)
+{
+    PresetSearch search;
+    search.presetName = preset.presetName;
+    search.actionType = static_cast<ActionType>(preset.actionType);
+    search.actionTarget = static_cast<ActionTarget>(preset.actionTarget);
+    search.isRecursive = preset.isRecursive;
+    search.isHighlight = preset.isHighlightMatch;
+    search.isRegExpSearch = preset.isRegExpSearchReplace;
+    search.isSparePageCache = preset.isSparePageCache;
+    search.isOneFileSystem = preset.isOneFileSystem;
+    search.caseSensitivity = preset.isCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    const QRegularExpression::PatternOptions caseOption = preset.isCaseSensitive ? QRegularExpression::NoPatternOption
+                                                                                 : QRegularExpression::CaseInsensitiveOption;
+
+    if ((search.actionTarget == ActionTarget::FileContents) || (search.actionType == ActionType::Remove))
+    {
+        if (preset.isRegExpFilePattern)
+            search.fileMatcher = FileNameMatcher(QRegularExpression(preset.filePattern, QRegularExpression::DontCaptureOption | caseOption));
+        else
+            search.fileMatcher = FileNameMatcher::fromWildcardFilters(preset.filePattern, search.caseSensitivity);
+    }
+    if ((search.actionTarget == ActionTarget::FileContents) && !preset.replaceTable.isEmpty())
+    {
+        // an unloadable table leaves isCompiled() false, which is reported by isValid()
+        search.isTableSearch = true;
+        loadReplaceTable(preset.replaceTable, search.actionType, search.caseSensitivity, search.replaceTable);
+    }
+    else if (search.actionTarget == ActionTarget::FileContents)
+    {
+        // Remove is just Replace with empty replaceWith string
+        if (search.actionType == ActionType::Replace)
+            search.replaceString = preset.replaceWith;
+        if (search.isRegExpSearch)
+            search.contentRegExp = SearchRegExp(QRegularExpression(preset.searchFor, caseOption), search.replaceString, regExpEngine, pcreMatchLimit);
+        else
+            search.searchString = preset.searchFor;
+    }
+    else if (search.actionType == ActionType::Replace)
+    {
+        search.regExp = QRegularExpression(preset.searchFor, caseOption);
+        search.regExp.optimize();
+        search.replaceString = preset.replaceWith;
+    }
+    search.walkFilter = WalkFilter(preset.excludeDirs, preset.isRespectIgnoreFiles, search.caseSensitivity);
+    search.metadataFilter = MetadataFilter(preset.metadataFilter);
+    return search;
+}
+
+QString PresetSearch::errorString() const
+{
+    const bool isContents = (actionTarget == ActionTarget::FileContents);
+    if (!metadataFilter.isValid())
+        return QString("Metadata: %1").arg(metadataFilter.errorString());
+    if ((isContents || (actionType == ActionType::Remove)) && !fileMatcher.isValid())
+        return "File pattern is empty or invalid";
+    if (isContents && isTableSearch)
+        return replaceTable.isCompiled() ? QString() : replaceTable.errorString();
+    if (isContents && !isRegExpSearch)
+        return searchString.isEmpty() ? QString("Search pattern is empty") : QString();
+    if (isContents)
+        return contentRegExp.regExp().pattern().isEmpty() ? QString("Search pattern is empty") : contentRegExp.errorString();
+    if (actionType == ActionType::Replace)
+        return regExp.pattern().isEmpty() ? QString("Search pattern is empty") : SearchRegExp::errorStringOf(regExp);
+    return QString();
+}
+
 void MultiFileEditor::reset()
 {
     ui->label_resultsText->clear();
     ui->treeWidget_results->clear();
     m_fileDirEntryMap.clear();
     m_fileContentsEntryMap.clear();
+    m_resultStore.clear();
+    m_presetSearches.clear();
     m_isSearchDone = false;
+    m_checkpoint.discard();
     ui->pushButton_execute->setText("Search");
+    ui->pushButton_searchToFile->setEnabled(ui->pushButton_execute->isEnabled());
+    ui->pushButton_savePlan->setEnabled(false);
+    ui->pushButton_loadPlan->setEnabled(true);
     ui->frame_settings->setEnabled(true);
     return;
 }
 
-void MultiFileEditor::execute()
+QString MultiFileEditor::execute()
 {
     ActionType actionType = static_cast<ActionType>(ui->comboBox_actionType->currentData(Qt::UserRole).toInt());
     ActionTarget actionTarget = static_cast<ActionTarget>(ui->comboBox_actionTarget->currentData(Qt::UserRole).toInt());
 
     if (m_isSearchDone) // execute action
     {
-        if (ui->checkBox_isAutoconfirmExecute->isChecked() == false)
+        if (!m_isResuming && !m_isHeadless && (ui->checkBox_isAutoconfirmExecute->isChecked() == false))
         {
             int ret = QMessageBox::question(this, "Perform execute?",
                                             "Are you sure you want to execute selected action?");
             if (ret != QMessageBox::Yes)
-                return;
+                return QString();
         }
+        QString journalErrorText;
+        if (!beginJournal(journalErrorText))
+            return journalErrorText;
+        m_checkpoint.beginExecute();
+        Profiler::reset();
+        ScopedPhaseTimer executeTimer(ProfilePhase::Execute);
+
+        if (m_presetSearches.isEmpty())
+        {
+            QHash<QString, int> editedFiles;
+            QString resultMessage = executeResults(actionType, actionTarget, ui->treeWidget_results->invisibleRootItem(), editedFiles, 0);
+            resultMessage.append(finishJournal());
+            ui->label_resultsText->setText(resultMessage);
+        }
+        else
+        {
+            // each preset is executed as its own step, in the order presets were selected
+            QHash<QString, int> editedFiles;
+            QStringList resultMessages;
+            for (int step = 0; step < m_presetSearches.size(); ++step)
+            {
+                const PresetSearch& search = m_presetSearches.at(step);
+                if (m_isCloseRequested)
+                    break;
+                if (search.pGroupItem->checkState(0) == Qt::Unchecked)
+                    continue;
+                const QString resultMessage = executeResults(search.actionType, search.actionTarget, search.pGroupItem, editedFiles, step);
+                resultMessages.append(QString("%1: %2").arg(search.presetName, resultMessage));
+            }
+            m_presetSearches.clear();
+            resultMessages.append(finishJournal().trimmed());
+            ui->label_resultsText->setText(resultMessages.join('\n').trimmed());
+        }
+        // execute interrupted by closing is kept to be resumed; a headless one doesn't record any
+        if (!m_isCloseRequested && !m_isHeadless)
+            m_checkpoint.discard();
+    }
+    else // perform search
+    {
+        Profiler::reset();
+        m_progress.reset();
+        ui->label_resultsText->clear();
+        ui->treeWidget_results->clear();
+        m_fileDirEntryMap.clear();
+        m_fileContentsEntryMap.clear();
+        m_resultStore.clear();
 
-        if (actionTarget == ActionTarget::FileContents)
+        isRecursive = ui->checkBox_isRecursive->isChecked();
+        isHighlight = ui->checkBox_isHighlightMatch->isChecked();
+        isSparePageCache = ui->checkBox_isSparePageCache->isChecked();
+        isOneFileSystem = ui->checkBox_isOneFileSystem->isChecked();
+        caseSensitivity = ui->checkBox_isCaseSensitive->isChecked() ? Qt::CaseSensitive : Qt::CaseInsensitive;
+        m_walkFilter = WalkFilter(ui->lineEdit_excludeDirs->text(), ui->checkBox_isRespectIgnoreFiles->isChecked(), caseSensitivity);
+        m_metadataFilter = MetadataFilter(ui->lineEdit_metadata->text());
+        // patterns of a single search are compiled before the checkpoint is written or any directory is listed;
+        // presets are compiled, and checked, as they're selected
+        ReplaceTable replaceTable;
+        SearchRegExp contentRegExp;
+        QRegularExpression nameRegExp;
+        QString patternErrorText;
+        if (m_presetSearches.isEmpty() && (actionTarget == ActionTarget::FileContents))
+        {
+            if (!ui->lineEdit_replaceTable->text().isEmpty())
+            {
+                if (!loadReplaceTable(ui->lineEdit_replaceTable->text(), actionType, caseSensitivity, replaceTable))
+                    patternErrorText = replaceTable.errorString();
+            }
+            else if (ui->checkBox_isRegExpSearchReplace->isChecked())
+            {
+                QRegularExpression regExp(ui->lineEdit_searchFor->text());
+                if (ui->checkBox_isCaseSensitive->isChecked() == false)
+                    regExp.setPatternOptions(regExp.patternOptions() | QRegularExpression::CaseInsensitiveOption);
+                const QString replaceString = (actionType == ActionType::Remove) ? QString() : ui->lineEdit_replaceWith->text();
+                contentRegExp = SearchRegExp(regExp, replaceString, m_regExpEngine, m_pcreMatchLimit);
+                if (!contentRegExp.isValid())
+                    patternErrorText = contentRegExp.errorString();
+            }
+        }
+        else if (m_presetSearches.isEmpty() && (actionType == ActionType::Replace) && (under_cast(actionTarget & ActionTarget::FilesDirs) != 0))
+        {
+            nameRegExp.setPattern(ui->lineEdit_searchFor->text());
+            if (ui->checkBox_isCaseSensitive->isChecked() == false)
+                nameRegExp.setPatternOptions(nameRegExp.patternOptions() | QRegularExpression::CaseInsensitiveOption);
+            nameRegExp.optimize();
+            if (!nameRegExp.isValid())
+                patternErrorText = SearchRegExp::errorStringOf(nameRegExp);
+        }
+        if (!patternErrorText.isEmpty())
+        {
+            // the search can't run, nor can a resumed one
+            m_checkpoint.discard();
+            QMessageBox::critical(this, "Error", patternErrorText);
+            return QString();
+        }
+        // search to a file leaves nothing to resume: results are in the file as soon as they're found
+        if (!m_isResuming && (m_pExport == nullptr))
+            beginCheckpoint();
+        m_walkVisits.clear();
+        std::vector<WalkContext> walks;
+        for (const QString& rootPath : searchRootPaths())
+            walks.push_back(newWalkContext(rootPath));
+
+        if (!m_presetSearches.isEmpty())
+        {
+            searchPresets(walks);
+        }
+        else if (actionTarget == ActionTarget::FileContents)
         {
-            // Remove is just Replace with empty replaceWith string
-            if ((actionType == ActionType::Remove) || (actionType == ActionType::Replace))
+            if (actionType == ActionType::Remove || actionType == ActionType::Replace)
             {
-                uint fileSuccessCount = 0;
-                uint lineSuccessCount = 0;
-                uint fileFailCount = 0;
-                uint lineFailCount = 0;
+                FileNameMatcher fileMatcher;
+                if (ui->checkBox_isRegExpFilePattern->isChecked())
+                {
+                    QRegularExpression filePatternRegExp(ui->lineEdit_filePattern->text());
+                    if (ui->checkBox_isCaseSensitive->isChecked() == false)
+                        filePatternRegExp.setPatternOptions(filePatternRegExp.patternOptions() | QRegularExpression::CaseInsensitiveOption);
+                    fileMatcher = FileNameMatcher(filePatternRegExp);
+                }
+                else
+                {
+                    fileMatcher = FileNameMatcher::fromWildcardFilters(ui->lineEdit_filePattern->text(), caseSensitivity);
+                }
 
-                QTreeWidgetItemIterator fileItemIter(ui->treeWidget_results, QTreeWidgetItemIterator::HasChildren);
-                for (; *fileItemIter != nullptr; ++fileItemIter)
+                QString replaceString = (actionType == ActionType::Remove) ? QString() : ui->lineEdit_replaceWith->text();
+                if (!ui->lineEdit_replaceTable->text().isEmpty())
                 {
-                    if ((*fileItemIter)->checkState(0) == Qt::Unchecked)
-                        continue;
-                    auto entryIter = m_fileContentsEntryMap.find(reinterpret_cast<uintptr_t>(*fileItemIter));
-                    QFile file(entryIter->fileInfo.canonicalFilePath());
-                    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+                    const QVector<QList<QTreeWidgetItem*>> rootFileItems = walkRoots<QList<QTreeWidgetItem*>>(walks, [&](WalkContext& walk)
                     {
-                        (*fileItemIter)->setData(2, Qt::DisplayRole, "Failed to open file");
-                        (*fileItemIter)->setIcon(2, QIcon(":/Icons/checkmark_error_16x16.png"));
-                        ++fileFailCount;
-                        lineFailCount += (*fileItemIter)->childCount();
-                        continue;
-                    }
-
-                    QStringList& linesList = entryIter.value().lines;
-                    QTreeWidgetItemIterator lineItemIter((*fileItemIter)->child(0));
-                    for (int i = 0; i < (*fileItemIter)->childCount(); ++i, ++lineItemIter)
+                        return searchFileContentsToReplace(walk, walk.rootDir, fileMatcher, replaceTable);
+                    });
+                    ScopedPhaseTimer treeTimer(ProfilePhase::Tree);
+                    addRootFileItems(ui->treeWidget_results->invisibleRootItem(), walks, rootFileItems);
+                }
+                else if (ui->checkBox_isRegExpSearchReplace->isChecked())
+                {
+                    const QVector<QList<QTreeWidgetItem*>> rootFileItems = walkRoots<QList<QTreeWidgetItem*>>(walks, [&](WalkContext& walk)
                     {
-                        (*lineItemIter)->setIcon(2, QIcon(":/Icons/checkmark_ok_16x16.png"));
-                        linesList[(*lineItemIter)->data(0, Qt::UserRole).toUInt()] = (*lineItemIter)->data(1, Qt::DisplayRole).toString();
-                        ++lineSuccessCount;
-                    }
-                    ++fileSuccessCount;
-
-                    QTextStream fileStream(&file);
-                    for (auto& line : entryIter->lines)
-                        fileStream << line << '\n';
-                    file.close();
+                        return searchFileContentsToReplace(walk, walk.rootDir, fileMatcher, contentRegExp);
+                    });
+                    ScopedPhaseTimer treeTimer(ProfilePhase::Tree);
+                    addRootFileItems(ui->treeWidget_results->invisibleRootItem(), walks, rootFileItems);
+                }
+                else
+                {
+                    const QString searchString = ui->lineEdit_searchFor->text();
+                    const QVector<QList<QTreeWidgetItem*>> rootFileItems = walkRoots<QList<QTreeWidgetItem*>>(walks, [&](WalkContext& walk)
+                    {
+                        return searchFileContentsToReplace(walk, walk.rootDir, fileMatcher, searchString, replaceString);
+                    });
+                    ScopedPhaseTimer treeTimer(ProfilePhase::Tree);
+                    addRootFileItems(ui->treeWidget_results->invisibleRootItem(), walks, rootFileItems);
                 }
-                QString resultMessage(QString("Edited entries: %1 lines in %2 files")
-                                      .arg(fileSuccessCount)
-                                      .arg(lineSuccessCount));
-                if (fileFailCount > 0)
-                    resultMessage.append(QString(". Failed to edit: %3 lines in %4 files")
-                                         .arg(fileFailCount)
-                                         .arg(lineFailCount));
-                ui->label_resultsText->setText(resultMessage);
             }
             else
             {
@@ -471,122 +946,47 @@ void MultiFileEditor::execute()
         {
             if (actionType == ActionType::Remove)
             {
-                uint dirSuccessCount = 0;
-                uint fileSuccessCount = 0;
-                uint dirFailCount = 0;
-                uint fileFailCount = 0;
-                QTreeWidgetItemIterator treeIter(ui->treeWidget_results, QTreeWidgetItemIterator::NoChildren);
-                for (; *treeIter != nullptr; ++treeIter)
+                QDir::Filters filters = QDir::NoDotAndDotDot | static_cast<QDir::Filters>(static_cast<int>(actionTarget));
+
+                FileNameMatcher matcher;
+                if (ui->checkBox_isRegExpFilePattern->isChecked())
                 {
-                    if ((*treeIter)->checkState(0) == Qt::Unchecked)
-                        continue;
-                    auto mapIter = m_fileDirEntryMap.find(reinterpret_cast<uintptr_t>(*treeIter));
-                    if ((mapIter != m_fileDirEntryMap.end()) && (mapIter.value().isExecutableTarget == true))
+                    QRegularExpression regExp(ui->lineEdit_filePattern->text(), QRegularExpression::DontCaptureOption);
+                    if (ui->checkBox_isCaseSensitive->isChecked() == false)
+                        regExp.setPatternOptions(regExp.patternOptions() | QRegularExpression::CaseInsensitiveOption);
+                    matcher = FileNameMatcher(regExp);
+                }
+                else
+                {
+                    matcher = FileNameMatcher::fromWildcardFilters(ui->lineEdit_filePattern->text(), caseSensitivity);
+                }
+
+                QVector<QTreeWidgetItem*> rootItems(static_cast<int>(walks.size()), nullptr);
+                if (!matcher.regExp().pattern().isEmpty())
+                {
+                    rootItems = walkRoots<QTreeWidgetItem*>(walks, [&](WalkContext& walk)
                     {
-                        auto entryFileInfo = mapIter.value().fileInfo;
-                        if (entryFileInfo.isDir())
-                        {
-                            // const bool isOk = removeDirRecursively(QDir(entryFileInfo.canonicalFilePath()));
-                            const bool isOk = QDir(entryFileInfo.canonicalFilePath()).removeRecursively(); // apparently it handles permissions just fine?
-                            if (isOk)
-                            {
-                                ++dirSuccessCount;
-                                (*treeIter)->setIcon(2, QIcon(":/Icons/checkmark_ok_16x16.png"));
-                            }
-                            else
-                            {
-                                ++dirFailCount;
-                                (*treeIter)->setIcon(2, QIcon(":/Icons/checkmark_error_16x16.png"));
-                            }
-                        }
-                        else
-                        {
-                            QFile fileToRemove = entryFileInfo.canonicalFilePath();
-                            fileToRemove.setPermissions(allPermissions);
-                            const bool isOk = fileToRemove.remove();
-                            if (isOk)
-                            {
-                                ++fileSuccessCount;
-                                (*treeIter)->setIcon(2, QIcon(":/Icons/checkmark_ok_16x16.png"));
-                            }
-                            else
-                            {
-                                ++fileFailCount;
-                                (*treeIter)->setIcon(2, QIcon(":/Icons/checkmark_error_16x16.png"));
-                            }
-                        }
-                    }
+                        return searchFileDirToRemove(walk, walk.rootDir, filters, matcher);
+                    });
                 }
-                QString resultMessage(QString("Removed entries: %1 directories and %2 files")
-                                      .arg(dirSuccessCount)
-                                      .arg(fileSuccessCount));
-                if ((dirFailCount > 0) || (fileFailCount > 0))
-                    resultMessage.append(QString(". Failed to remove: %3 directories and %4 files")
-                                         .arg(dirFailCount)
-                                         .arg(fileFailCount));
-                ui->label_resultsText->setText(resultMessage);
+                ScopedPhaseTimer treeTimer(ProfilePhase::Tree);
+                addRootItems(ui->treeWidget_results->invisibleRootItem(), walks, rootItems);
             }
             else if (actionType == ActionType::Replace)
             {
-                uint dirSuccessCount = 0;
-                uint fileSuccessCount = 0;
-                uint dirFailCount = 0;
-                uint fileFailCount = 0;
-
-                QTreeWidgetItemIterator treeIter(ui->treeWidget_results);
-                QTreeWidgetItemIterator iterNext(ui->treeWidget_results);
-                while (*(++iterNext) != nullptr)
-                    ++treeIter;
-                for (; *treeIter != nullptr; --treeIter)
+                QDir::Filters filters = QDir::NoDotAndDotDot | static_cast<QDir::Filters>(static_cast<int>(actionTarget));
+
+                QVector<QTreeWidgetItem*> rootItems(static_cast<int>(walks.size()), nullptr);
+                if (!nameRegExp.pattern().isEmpty())
                 {
-                    if ((*treeIter)->checkState(0) == Qt::Unchecked)
-                        continue;
-                    auto entryIter = m_fileDirEntryMap.find(reinterpret_cast<uintptr_t>(*treeIter));
-                    if ((entryIter != m_fileDirEntryMap.end()) && (entryIter.value().isExecutableTarget == true))
+                    const QString replaceString = ui->lineEdit_replaceWith->text();
+                    rootItems = walkRoots<QTreeWidgetItem*>(walks, [&](WalkContext& walk)
                     {
-                        auto entryFileInfo = entryIter.value().fileInfo;
-                        if (entryFileInfo.isDir())
-                        {
-                            bool isOk = QDir(entryFileInfo.canonicalPath())
-                                        .rename(entryFileInfo.fileName(),
-                                                (*treeIter)->text(1));
-                            if (isOk)
-                            {
-                                ++dirSuccessCount;
-                                (*treeIter)->setIcon(2, QIcon(":/Icons/checkmark_ok_16x16.png"));
-                            }
-                            else
-                            {
-                                ++dirFailCount;
-                                (*treeIter)->setIcon(2, QIcon(":/Icons/checkmark_error_16x16.png"));
-                            }
-                        }
-                        else
-                        {
-                            bool isOk = QDir(entryFileInfo.canonicalPath())
-                                        .rename(entryFileInfo.fileName(),
-                                                (*treeIter)->text(1));
-                            if (isOk)
-                            {
-                                ++fileSuccessCount;
-                                (*treeIter)->setIcon(2, QIcon(":/Icons/checkmark_ok_16x16.png"));
-                            }
-                            else
-                            {
-                                ++fileFailCount;
-                                (*treeIter)->setIcon(2, QIcon(":/Icons/checkmark_error_16x16.png"));
-                            }
-                        }
-                    }
+                        return searchFileDirToReplace(walk, walk.rootDir, filters, nameRegExp, replaceString);
+                    });
                 }
-                QString resultMessage(QString("Renamed entries: %1 directories and %2 files")
-                                      .arg(dirSuccessCount)
-                                      .arg(fileSuccessCount));
-                if ((dirFailCount > 0) || (fileFailCount > 0))
-                    resultMessage.append(QString(". Failed to rename: %3 directories and %4 files")
-                                         .arg(dirFailCount)
-                                         .arg(fileFailCount));
-                ui->label_resultsText->setText(resultMessage);
+                ScopedPhaseTimer treeTimer(ProfilePhase::Tree);
+                addRootItems(ui->treeWidget_results->invisibleRootItem(), walks, rootItems);
             }
             else
             {
@@ -609,186 +1009,1303 @@ void MultiFileEditor::execute()
             throw std::runtime_error("Encountered unsupported Action Target which shouldn't even be possible."
                                      "This requires code fixing. The program will now be terminated.");
         }
+        showOtherFileLinks();
     }
-    else // perform search
+    if (!m_isSearchDone) // search totals replace the last live sample
     {
-        ui->label_resultsText->clear();
-        ui->treeWidget_results->clear();
-        m_fileDirEntryMap.clear();
-        m_fileContentsEntryMap.clear();
-
-        isRecursive = ui->checkBox_isRecursive->isChecked();
-        isHighlight = ui->checkBox_isHighlightMatch->isChecked();
-        caseSensitivity = ui->checkBox_isCaseSensitive->isChecked() ? Qt::CaseSensitive : Qt::CaseInsensitive;
-        QDir targetDir(ui->lineEdit_dirPath->text());
-
-        if (actionTarget == ActionTarget::FileContents)
-        {
-            if (actionType == ActionType::Remove || actionType == ActionType::Replace)
-            {
-                QRegularExpression filePatternRegExp;
-                QString filePatternString = ui->lineEdit_filePattern->text();
-                if (ui->checkBox_isRegExpFilePattern->isChecked() == false)
-                    filePatternString = regExpFromWildcardFilters(filePatternString);
-                filePatternRegExp.setPattern(filePatternString);
-                if (ui->checkBox_isCaseSensitive->isChecked() == false)
-                    filePatternRegExp.setPatternOptions(filePatternRegExp.patternOptions() | QRegularExpression::CaseInsensitiveOption);
+        QString summary = ProgressMeter::searchSummary(m_progress);
+        if (m_resultStore.spilledBytes() > 0)
+            summary.append(QString(" (lines of %1 MB of files with results kept on disk)").arg(static_cast<double>(m_resultStore.spilledBytes()) / (1024.0 * 1024.0), 0, 'f', 1));
+        ui->label_resultsText->setText(summary);
+    }
+    {
+        ScopedPhaseTimer expandTimer(ProfilePhase::Expand);
+        ui->treeWidget_results->expandAll();
+    }
+    {
+        ScopedPhaseTimer resizeTimer(ProfilePhase::Resize);
+        ui->treeWidget_results->resizeColumnToContents(0);
+        ui->treeWidget_results->resizeColumnToContents(1);
+    }
+    if (Profiler::isEnabled())
+    {
+        const QString resultText = ui->label_resultsText->text();
+        const QString summary = Profiler::summary();
+        ui->label_resultsText->setText(resultText.isEmpty() ? summary : QString("%1. %2").arg(resultText, summary));
+        if (!m_traceFilePath.isEmpty() && !Profiler::writeChromeTrace(m_traceFilePath))
+            ui->label_resultsText->setToolTip(QString("Failed to write trace file %1").arg(m_traceFilePath));
+    }
+    m_isSearchDone = !m_isSearchDone;
+    ui->pushButton_execute->setText(m_isSearchDone ? "Execute" : "Search");
+    ui->pushButton_searchToFile->setEnabled(!m_isSearchDone);
+    ui->pushButton_savePlan->setEnabled(m_isSearchDone);
+    ui->pushButton_loadPlan->setEnabled(!m_isSearchDone);
+    ui->frame_settings->setEnabled(!m_isSearchDone);
+    return QString();
+}
 
-                QString replaceString = (actionType == ActionType::Remove) ? QString() : ui->lineEdit_replaceWith->text();
-                if (ui->checkBox_isRegExpSearchReplace->isChecked())
+void MultiFileEditor::searchToFile()
+{
+    if (m_isSearchDone || m_isRunning)
+        return;
+    const QString filePath = QFileDialog::getSaveFileName(this, "Search to file", ui->lineEdit_dirPath->text(),
+                                                          "JSON Lines (*.jsonl *.jsonl.gz);;CSV (*.csv *.csv.gz);;All files (*)");
+    if (filePath.isEmpty())
+        return;
+    ResultExport resultExport(filePath);
+    if (!resultExport.open())
+    {
+        QMessageBox::critical(this, "Error", QString("Failed to create %1: %2").arg(filePath, resultExport.errorString()));
+        return;
+    }
+    // results of the previous search go, as they would with a search to the tree
+    m_checkpoint.discard();
+    m_pExport = &resultExport;
+    execute();
+    m_pExport = nullptr;
+    const bool isWritten = resultExport.finish();
+    // there is nothing to execute: settings stay open for the next search
+    if (m_isSearchDone)
+    {
+        m_isSearchDone = false;
+        ui->pushButton_execute->setText("Search");
+        ui->pushButton_searchToFile->setEnabled(true);
+        ui->pushButton_savePlan->setEnabled(false);
+        ui->pushButton_loadPlan->setEnabled(true);
+        ui->frame_settings->setEnabled(true);
+    }
+    const QString resultText = ui->label_resultsText->text();
+    const QString exportText = isWritten
+        ? QString("%1 results written to %2 (%3 MB)").arg(resultExport.rowCount()).arg(filePath)
+                                                     .arg(static_cast<double>(resultExport.writtenBytes()) / (1024.0 * 1024.0), 0, 'f', 1)
+        : QString("Failed to write results to %1: %2").arg(filePath, resultExport.errorString());
+    ui->label_resultsText->setText(resultText.isEmpty() ? exportText : QString("%1\n%2").arg(resultText, exportText));
+}
+
+void MultiFileEditor::savePlan()
+{
+    if (!m_isSearchDone || m_isRunning)
+        return;
+    const QString filePath = QFileDialog::getSaveFileName(this, "Save execution plan", ui->lineEdit_dirPath->text(),
+                                                          "Execution plans (*.qmfeplan);;All files (*)");
+    if (filePath.isEmpty())
+        return;
+    int outsideCount = 0;
+    const ExecutionPlan plan = planFromResults(outsideCount);
+    QString errorText;
+    if (!plan.save(filePath, errorText))
+    {
+        QMessageBox::critical(this, "Error", QString("Failed to save plan to %1: %2").arg(filePath, errorText));
+        return;
+    }
+    const QString resultText = ui->label_resultsText->text();
+    QString planText = QString("Plan of %1 entries saved to %2").arg(plan.entryCount()).arg(filePath);
+    if (outsideCount > 0)
+        planText.append(QString(", %1 entries outside of search roots left out").arg(outsideCount));
+    ui->label_resultsText->setText(resultText.isEmpty() ? planText : QString("%1\n%2").arg(resultText, planText));
+}
+
+void MultiFileEditor::loadPlan()
+{
+    if (m_isSearchDone || m_isRunning)
+        return;
+    const QString filePath = QFileDialog::getOpenFileName(this, "Load execution plan", ui->lineEdit_dirPath->text(),
+                                                          "Execution plans (*.qmfeplan);;All files (*)");
+    if (filePath.isEmpty())
+        return;
+    ExecutionPlan plan;
+    QString errorText;
+    if (!plan.load(filePath, errorText))
+    {
+        QMessageBox::critical(this, "Error", QString("Failed to load plan %1: %2").arg(filePath, errorText));
+        return;
+    }
+    // the tree may be somewhere else than it was when the plan was saved
+    for (QString& rootPath : plan.rootPaths)
+    {
+        if (QFileInfo(rootPath).isDir())
+            continue;
+        const QString movedRootPath = QFileDialog::getExistingDirectory(this, QString("Where is %1 now?").arg(rootPath));
+        if (movedRootPath.isEmpty())
+            return;
+        rootPath = QDir(movedRootPath).canonicalPath();
+    }
+    // results of the previous search are replaced, as by a new search
+    m_checkpoint.discard();
+    ui->label_resultsText->setText(applyPlan(plan));
+}
+
+bool MultiFileEditor::executePlan(const QString& planFilePath, const QStringList& rootPaths, QString& summary)
+{
+    m_isHeadless = true;
+    // the process ends with the execute, there would be nobody left to delete detached trees
+    m_isDetachRemove = false;
+    ExecutionPlan plan;
+    QString errorText;
+    if (!plan.load(planFilePath, errorText))
+    {
+        summary = QString("Failed to load plan %1: %2").arg(planFilePath, errorText);
+        return false;
+    }
+    for (int rootIdx = 0; rootIdx < qMin(rootPaths.size(), plan.rootPaths.size()); ++rootIdx)
+    {
+        const QString rootPath = QDir(rootPaths.at(rootIdx)).canonicalPath();
+        plan.rootPaths[rootIdx] = rootPath.isEmpty() ? rootPaths.at(rootIdx) : rootPath;
+    }
+    for (const QString& rootPath : qAsConst(plan.rootPaths))
+    {
+        if (!QFileInfo(rootPath).isDir())
+        {
+            summary = QString("Search root %1 of the plan not found, give where it is now with --root").arg(rootPath);
+            return false;
+        }
+    }
+    const QString planSummary = applyPlan(plan);
+    const QString executeErrorText = execute();
+    if (m_isSearchDone)
+    {
+        summary = QString("%1\nNot executed: %2").arg(planSummary, executeErrorText);
+        return false;
+    }
+    summary = QString("%1\n%2").arg(planSummary, ui->label_resultsText->text());
+    return true;
+}
+
+ExecutionPlan MultiFileEditor::planFromResults(int& outsideCount) const
+{
+    ExecutionPlan plan;
+    plan.rootPaths = searchRootPaths();
+    if (m_presetSearches.isEmpty())
+    {
+        const ActionType actionType = static_cast<ActionType>(ui->comboBox_actionType->currentData(Qt::UserRole).toInt());
+        const ActionTarget actionTarget = static_cast<ActionTarget>(ui->comboBox_actionTarget->currentData(Qt::UserRole).toInt());
+        plan.steps.append(planStep(plan, QString(), actionType, actionTarget, ui->treeWidget_results->invisibleRootItem(), outsideCount));
+        return plan;
+    }
+    for (const PresetSearch& search : m_presetSearches)
+    {
+        if (search.pGroupItem->checkState(0) != Qt::Unchecked)
+            plan.steps.append(planStep(plan, search.presetName, search.actionType, search.actionTarget, search.pGroupItem, outsideCount));
+    }
+    return plan;
+}
+
+ExecutionPlan::Step MultiFileEditor::planStep(const ExecutionPlan& plan, const QString& presetName, ActionType actionType, ActionTarget actionTarget, QTreeWidgetItem* pRootItem, int& outsideCount) const
+{
+    ExecutionPlan::Step step{presetName, actionType, actionTarget, {}, {}};
+    // the entries executeResults() would take
+    for (QTreeWidgetItem* pItem : subtreeItems(pRootItem))
+    {
+        if (pItem->checkState(0) == Qt::Unchecked)
+            continue;
+        if (actionTarget == ActionTarget::FileContents)
+        {
+            auto entryIter = m_fileContentsEntryMap.constFind(reinterpret_cast<uintptr_t>(pItem));
+            if (entryIter == m_fileContentsEntryMap.constEnd())
+                continue;
+            ExecutionPlan::FileEdits file{0, QString(), entryIter->fingerprint.size, entryIter->fingerprint.contentHash, {}};
+            if (!plan.locate(entryIter->fileInfo.canonicalFilePath(), file.rootIdx, file.path))
+            {
+                ++outsideCount;
+                continue;
+            }
+            for (int i = 0; i < pItem->childCount(); ++i)
+            {
+                const QTreeWidgetItem* pLineItem = pItem->child(i);
+                if (pLineItem->checkState(0) == Qt::Unchecked)
+                    continue;
+                // line as the search read it is the text of its colored item
+                const ColoredText ctext = pLineItem->data(0, Qt::UserRole).value<ColoredText>();
+                file.edits.append(ExecutionPlan::lineEditOf(pLineItem->data(0, LineIndexRole).toInt(), ctext.text, pLineItem->data(1, Qt::DisplayRole).toString()));
+            }
+            step.files.append(file);
+            continue;
+        }
+        if ((actionType == ActionType::Remove) && (pItem->childCount() != 0))
+            continue;
+        auto entryIter = m_fileDirEntryMap.constFind(reinterpret_cast<uintptr_t>(pItem));
+        if ((entryIter == m_fileDirEntryMap.constEnd()) || !entryIter->isExecutableTarget)
+            continue;
+        const QFileInfo& fileInfo = entryIter->fileInfo;
+        ExecutionPlan::Target target{0, QString(), fileInfo.isDir(), (actionType == ActionType::Replace) ? pItem->text(1) : QString()};
+        if (!plan.locate(QDir(fileInfo.canonicalPath()).filePath(fileInfo.fileName()), target.rootIdx, target.path))
+        {
+            ++outsideCount;
+            continue;
+        }
+        step.targets.append(target);
+    }
+    return step;
+}
+
+QString MultiFileEditor::applyPlan(const ExecutionPlan& plan)
+{
+    ui->label_resultsText->clear();
+    ui->treeWidget_results->clear();
+    m_fileDirEntryMap.clear();
+    m_fileContentsEntryMap.clear();
+    m_resultStore.clear();
+    m_presetSearches.clear();
+    m_isSearchDone = false;
+    // execute keeps its journal and trash in the roots of the dir field
+    QStringList quotedRootPaths;
+    for (const QString& rootPath : plan.rootPaths)
+        quotedRootPaths.append(QString("\"%1\"").arg(rootPath));
+    ui->lineEdit_dirPath->setText((plan.rootPaths.size() == 1) ? plan.rootPaths.front() : quotedRootPaths.join(' '));
+
+    QVector<QTreeWidgetItem*> stepItems(plan.steps.size(), nullptr);
+    int mismatchCount = 0;
+    runInBackground([&]()
+    {
+        for (int stepIdx = 0; stepIdx < plan.steps.size(); ++stepIdx)
+            stepItems[stepIdx] = verifyPlanStep(plan, plan.steps.at(stepIdx), mismatchCount);
+    });
+
+    const bool isSingleSearch = (plan.steps.size() == 1) && plan.steps.front().presetName.isEmpty();
+    if (isSingleSearch)
+    {
+        // execute takes action of a single search from the combos
+        const ExecutionPlan::Step& step = plan.steps.front();
+        ui->comboBox_actionType->setCurrentIndex(ui->comboBox_actionType->findData(static_cast<int>(step.actionType), Qt::UserRole));
+        ui->comboBox_actionTarget->setCurrentIndex(ui->comboBox_actionTarget->findData(static_cast<int>(step.actionTarget), Qt::UserRole));
+        onActionCombosActivated();
+        ui->treeWidget_results->invisibleRootItem()->addChildren(stepItems.front()->takeChildren());
+        delete stepItems.front();
+    }
+    else
+    {
+        for (int stepIdx = 0; stepIdx < plan.steps.size(); ++stepIdx)
+        {
+            const ExecutionPlan::Step& step = plan.steps.at(stepIdx);
+            PresetSearch search{};
+            search.presetName = step.presetName;
+            search.actionType = step.actionType;
+            search.actionTarget = step.actionTarget;
+            search.pGroupItem = stepItems.at(stepIdx);
+            search.pGroupItem->setData(0, Qt::DisplayRole, QString("Preset \"%1\"").arg(search.presetName));
+            search.pGroupItem->setCheckState(0, Qt::Checked);
+            ui->treeWidget_results->addTopLevelItem(search.pGroupItem);
+            m_presetSearches.append(search);
+        }
+    }
+    ui->treeWidget_results->expandAll();
+    ui->treeWidget_results->resizeColumnToContents(0);
+    ui->treeWidget_results->resizeColumnToContents(1);
+    m_isSearchDone = true;
+    ui->pushButton_execute->setText("Execute");
+    ui->pushButton_searchToFile->setEnabled(false);
+    ui->pushButton_savePlan->setEnabled(true);
+    ui->pushButton_loadPlan->setEnabled(false);
+    ui->frame_settings->setEnabled(false);
+    QString summary = QString("Plan of %1 entries loaded").arg(plan.entryCount());
+    if (mismatchCount > 0)
+        summary.append(QString(", %1 of them not as planned anymore and left out").arg(mismatchCount));
+    return summary;
+}
+
+QTreeWidgetItem* MultiFileEditor::verifyPlanStep(const ExecutionPlan& plan, const ExecutionPlan::Step& step, int& mismatchCount)
+{
+    QTreeWidgetItem* pStepItem = new QTreeWidgetItem;
+    if (step.actionTarget == ActionTarget::FileContents)
+    {
+        // files are read as a search reads them: contents hash tells they're the same, lines are what edits apply to
+        m_walkVisits.clear();
+        WalkContext walk = newWalkContext(plan.rootPaths.front());
+        QList<QFileInfo> fileInfos;
+        for (const ExecutionPlan::FileEdits& file : step.files)
+            fileInfos.append(QFileInfo(plan.absolutePath(file.rootIdx, file.path)));
+        QVector<QTreeWidgetItem*> fileItems(fileInfos.size(), nullptr);
+        // every file of the plan is read, under whatever paths it's linked
+        readFilesLines(walk, fileInfos, false, [](int /*fileIdx*/, const QString& /*firstLinkPath*/) { return false; },
+                       [&](int fileIdx, const QStringList& lines, const FileFingerprint& fingerprint, bool isOpen, const QString& /*firstLinkPath*/)
+        {
+            const ExecutionPlan::FileEdits& file = step.files.at(fileIdx);
+            const QFileInfo& fileInfo = fileInfos.at(fileIdx);
+            QString errorText;
+            if (!isOpen)
+                errorText = fileInfo.exists() ? QString("Failed to open file") : QString("Not found since plan was saved");
+            else if ((file.size >= 0) && ((fingerprint.size != file.size) || (fingerprint.contentHash != file.contentHash)))
+                errorText = "Changed since plan was saved";
+            else if (!std::all_of(file.edits.begin(), file.edits.end(), [&lines](const ExecutionPlan::LineEdit& edit) { return ExecutionPlan::isApplicable(edit, lines); }))
+                errorText = "Lines don't match the plan";
+            if (!errorText.isEmpty())
+            {
+                QTreeWidgetItem* pFileItem = newFileErrorItem(fileInfo, errorText);
+                pFileItem->setData(0, Qt::DisplayRole, fileInfo.absoluteFilePath());
+                fileItems[fileIdx] = pFileItem;
+                ++mismatchCount;
+                return true;
+            }
+            QTreeWidgetItem* pFileItem = newFileContentsItem(fileInfo, lines);
+            for (const ExecutionPlan::LineEdit& edit : file.edits)
+            {
+                const QString& line = lines.at(edit.lineIdx);
+                QTreeWidgetItem* pLineItem = new QTreeWidgetItem;
+                ColoredText ctext;
+                ctext.text = line;
+                ctext.lineNumber = edit.lineIdx;
+                if (edit.length > 0)
+                    ctext.segments.append(ColoredSegment(edit.start, edit.start + edit.length, Qt::yellow, Qt::black));
+                else
+                    ctext.segments.append(ColoredSegment(0, line.length(), QColor(), QColor()));
+                ctext.normalize();
+                pLineItem->setData(0, Qt::UserRole, QVariant::fromValue(ctext));
+                pLineItem->setData(0, LineIndexRole, edit.lineIdx);
+                pLineItem->setData(1, Qt::DisplayRole, ExecutionPlan::replaced(line, edit));
+                pLineItem->setCheckState(0, Qt::Checked);
+                pFileItem->addChild(pLineItem);
+            }
+            // guards the files from here on, as it does after a search
+            setFileFingerprint(pFileItem, fingerprint);
+            fileItems[fileIdx] = pFileItem;
+            return false;
+        });
+        for (QTreeWidgetItem* pFileItem : qAsConst(fileItems))
+        {
+            if (pFileItem != nullptr)
+                pStepItem->addChild(pFileItem);
+        }
+        return pStepItem;
+    }
+    for (const ExecutionPlan::Target& target : step.targets)
+    {
+        const QFileInfo fileInfo(plan.absolutePath(target.rootIdx, target.path));
+        RunProgress::add(m_progress.filesScanned);
+        QTreeWidgetItem* pItem = new QTreeWidgetItem;
+        pItem->setData(0, Qt::DisplayRole, fileInfo.absoluteFilePath());
+        pItem->setIcon(0, target.isDir ? m_folderIcon : m_fileIcon);
+        if (step.actionType == ActionType::Replace)
+            pItem->setData(1, Qt::DisplayRole, target.newName);
+        if (fileInfo.exists() && (fileInfo.isDir() == target.isDir))
+        {
+            pItem->setCheckState(0, Qt::Checked);
+            addFileDirEntry(pItem, true, fileInfo);
+        }
+        else
+        {
+            pItem->setData(2, Qt::DisplayRole, "Not found since plan was saved");
+            pItem->setIcon(2, m_errorIcon);
+            ++mismatchCount;
+        }
+        pStepItem->addChild(pItem);
+    }
+    return pStepItem;
+}
+
+QString MultiFileEditor::executeResults(ActionType actionType, ActionTarget actionTarget, QTreeWidgetItem* pRootItem, QHash<QString, int>& editedFiles, int step)
+{
+    if (m_journal)
+        m_journal->nextStep();
+    if (actionTarget == ActionTarget::FileContents)
+    {
+        // Remove is just Replace with empty replaceWith string
+        if ((actionType == ActionType::Remove) || (actionType == ActionType::Replace))
+        {
+            uint fileSuccessCount = 0;
+            uint lineSuccessCount = 0;
+            uint fileFailCount = 0;
+            uint lineFailCount = 0;
+            uint fileChangedCount = 0;
+
+            // Edited lines are collected from the tree on GUI thread, files are read back from the result store,
+            // edited and written by worker one at a time, so only lines of the file being written are in memory
+            struct WriteTask
+            {
+                QTreeWidgetItem* fileItem;
+                QString filePath;
+                int linesId;                        // lines in m_resultStore, as read by search or as written by previous preset
+                QVector<QPair<int, QString>> edits; // checked lines: index and replaced line
+                const FileFingerprint* fingerprint; // nullptr if file was already written by this execute
+                bool isDone = false;
+                bool isOk = false;
+                bool isChanged = false;
+                int writtenLinesId = -1;            // lines as written, kept in m_resultStore for later presets
+                QString errorText{};
+            };
+            // a later preset may edit files of this one again
+            const bool isKeepingWritten = (step + 1 < m_presetSearches.size());
+            QVector<WriteTask> tasks;
+            for (QTreeWidgetItem* pFileItem : subtreeItems(pRootItem))
+            {
+                if (pFileItem->checkState(0) == Qt::Unchecked)
+                    continue;
+                auto entryIter = m_fileContentsEntryMap.find(reinterpret_cast<uintptr_t>(pFileItem));
+                if (entryIter == m_fileContentsEntryMap.end())
+                    continue;
+                const QString filePath = entryIter->fileInfo.canonicalFilePath();
+                WriteTask task{pFileItem, filePath, entryIter->linesId, {}, &entryIter->fingerprint};
+                // written by previous preset of this execute, after its own verification; its fingerprint is ours now
+                auto editedIter = editedFiles.constFind(filePath);
+                if (editedIter != editedFiles.constEnd())
                 {
-                    QRegularExpression searchRegExp(ui->lineEdit_searchFor->text());
-                    if (ui->checkBox_isCaseSensitive->isChecked() == false)
-                        searchRegExp.setPatternOptions(searchRegExp.patternOptions() | QRegularExpression::CaseInsensitiveOption);
-                    ui->treeWidget_results->addTopLevelItems(searchFileContentsToReplace(targetDir, filePatternRegExp, searchRegExp, replaceString));
+                    task.linesId = editedIter.value();
+                    task.fingerprint = nullptr;
                 }
-                else
+                QVector<int> checkedLineIdxs;
+                for (int i = 0; i < pFileItem->childCount(); ++i)
                 {
-                    ui->treeWidget_results->addTopLevelItems(searchFileContentsToReplace(targetDir, filePatternRegExp, ui->lineEdit_searchFor->text(), replaceString));
+                    const QTreeWidgetItem* pLineItem = pFileItem->child(i);
+                    if (pLineItem->checkState(0) == Qt::Unchecked)
+                        continue;
+                    const int lineIdx = pLineItem->data(0, LineIndexRole).toInt();
+                    task.edits.append(qMakePair(lineIdx, pLineItem->data(1, Qt::DisplayRole).toString()));
+                    checkedLineIdxs.append(lineIdx);
                 }
+                m_checkpoint.addPlanned(step, filePath, checkedLineIdxs);
+                tasks.append(task);
             }
-            else
+            // the whole plan is in checkpoint before the first file is written
+            m_checkpoint.flush();
+
+            runInBackground([this, &tasks, step, isKeepingWritten]()
             {
-                QMessageBox::critical(this, "MultiFileEditor error",
-                                      "Encountered unsupported Action Type."
-                                      "\nIf it's caused by incorrect preset - fix the preset."
-                                      "\nIf it's caused by something else - it requires code fixing."
-                                      "\nThe program will now be terminated.");
-                throw std::runtime_error("Encountered unsupported Action Type which shouldn't even be possible."
-                                         "This requires code fixing. The program will now be terminated.");
+                for (WriteTask& task : tasks)
+                {
+                    if (m_progress.isCanceled())
+                        break;
+                    task.isChanged = (task.fingerprint != nullptr) && !task.fingerprint->isUnchangedAt(task.filePath);
+                    QStringList lines;
+                    if (!task.isChanged && !m_resultStore.lines(task.linesId, lines))
+                    {
+                        task.errorText = "Failed to read lines back from results kept on disk";
+                    }
+                    // nothing is overwritten without a snapshot to undo it
+                    else if (!task.isChanged && (!m_journal || m_journal->addEdit(task.filePath, task.errorText)))
+                    {
+                        for (const QPair<int, QString>& edit : qAsConst(task.edits))
+                        {
+                            // lines past the last non-empty one aren't kept
+                            if (edit.first < lines.size())
+                                lines[edit.first] = edit.second;
+                        }
+                        m_throttle.acquire(1);
+                        QFile file(task.filePath);
+                        if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+                        {
+                            QTextStream fileStream(&file);
+                            for (const QString& line : qAsConst(lines))
+                                fileStream << line << '\n';
+                            fileStream.flush();
+                            m_throttle.acquire(0, file.size());
+                            file.close();
+                            task.isOk = true;
+                            m_checkpoint.addDone(step, task.filePath);
+                            if (isKeepingWritten)
+                                task.writtenLinesId = m_resultStore.add(lines);
+                        }
+                        else
+                        {
+                            task.errorText = "Failed to open file";
+                        }
+                    }
+                    task.isDone = true;
+                    RunProgress::add(m_progress.tasksDone);
+                }
+            }, tasks.size());
+
+            for (const WriteTask& task : qAsConst(tasks))
+            {
+                if (!task.isDone)
+                    continue;
+                if (task.isChanged)
+                {
+                    task.fileItem->setData(2, Qt::DisplayRole, "Changed since search, skipped");
+                    task.fileItem->setIcon(2, m_errorIcon);
+                    ++fileChangedCount;
+                    lineFailCount += task.fileItem->childCount();
+                    continue;
+                }
+                if (!task.isOk)
+                {
+                    task.fileItem->setData(2, Qt::DisplayRole, task.errorText);
+                    task.fileItem->setIcon(2, m_errorIcon);
+                    ++fileFailCount;
+                    lineFailCount += task.fileItem->childCount();
+                    continue;
+                }
+                if (task.writtenLinesId != -1)
+                    editedFiles.insert(task.filePath, task.writtenLinesId);
+                for (int i = 0; i < task.fileItem->childCount(); ++i)
+                    task.fileItem->child(i)->setIcon(2, m_okIcon);
+                lineSuccessCount += task.fileItem->childCount();
+                ++fileSuccessCount;
             }
+            QString resultMessage(QString("Edited entries: %1 lines in %2 files")
+                                  .arg(lineSuccessCount)
+                                  .arg(fileSuccessCount));
+            if ((fileFailCount > 0) || (fileChangedCount > 0))
+                resultMessage.append(QString(". Failed to edit: %3 lines in %4 files")
+                                     .arg(lineFailCount)
+                                     .arg(fileFailCount + fileChangedCount));
+            if (fileChangedCount > 0)
+                resultMessage.append(QString(" (%1 changed since search)").arg(fileChangedCount));
+            return resultMessage;
         }
-        else if (under_cast(actionTarget & ActionTarget::FilesDirs) != 0)
+        else
         {
-            if (actionType == ActionType::Remove)
+            QMessageBox::critical(this, "MultiFileEditor error",
+                                  "Encountered unsupported Action Type."
+                                  "\nIf it's caused by incorrect preset - fix the preset."
+                                  "\nIf it's caused by something else - it requires code fixing."
+                                  "\nThe program will now be terminated.");
+            throw std::runtime_error("Encountered unsupported Action Type which shouldn't even be possible."
+                                     "This requires code fixing. The program will now be terminated.");
+        }
+    }
+    else if (under_cast(actionTarget & ActionTarget::FilesDirs) != 0)
+    {
+        if (actionType == ActionType::Remove)
+        {
+            uint dirSuccessCount = 0;
+            uint fileSuccessCount = 0;
+            uint dirFailCount = 0;
+            uint fileFailCount = 0;
+
+            struct RemoveTask
             {
-                QDir::Filters filters = QDir::NoDotAndDotDot | static_cast<QDir::Filters>(static_cast<int>(actionTarget));
+                QTreeWidgetItem* item;
+                QString path;
+                bool isDir;
+                bool isDone = false;
+                bool isOk = false;
+                bool isDetached = false;
+                QVector<TreeRemover::Failure> failures{};
+            };
+            QVector<RemoveTask> tasks;
+            for (QTreeWidgetItem* pItem : subtreeItems(pRootItem))
+            {
+                if ((pItem->childCount() != 0) || (pItem->checkState(0) == Qt::Unchecked))
+                    continue;
+                auto mapIter = m_fileDirEntryMap.find(reinterpret_cast<uintptr_t>(pItem));
+                if ((mapIter != m_fileDirEntryMap.end()) && (mapIter.value().isExecutableTarget == true))
+                {
+                    const QFileInfo& entryFileInfo = mapIter.value().fileInfo;
+                    tasks.append({pItem, entryFileInfo.canonicalFilePath(), entryFileInfo.isDir()});
+                    m_checkpoint.addPlanned(step, tasks.back().path);
+                }
+            }
+            m_checkpoint.flush();
 
-                QTreeWidgetItem* pRootItem = nullptr;
-                QRegularExpression regExp;
-                QString regExpPattern = ui->lineEdit_filePattern->text();
-                if (ui->checkBox_isRegExpFilePattern->isChecked() == false)
-                    regExpPattern = regExpFromWildcardFilters(regExpPattern);
-                regExp.setPattern(regExpPattern);
-                regExp.setPatternOptions(regExp.patternOptions() | QRegularExpression::DontCaptureOption);
-                if (ui->checkBox_isCaseSensitive->isChecked() == false)
-                    regExp.setPatternOptions(regExp.patternOptions() | QRegularExpression::CaseInsensitiveOption);
+            // only targets inside a search root are detached, they share its filesystem and its trash
+            const QStringList trashRootPaths = m_isDetachRemove ? searchRootPaths() : QStringList();
+            // targets and subdirectories inside them are spread over remover's threads
+            runInBackground([this, &tasks, &trashRootPaths, step]()
+            {
+                TreeRemover remover(m_progress.entriesRemoved, m_progress.isCancelRequested);
+                remover.setThrottle(&m_throttle);
+                TreeRemover::TaskGroup removeTasks;
+                for (RemoveTask& task : tasks)
+                {
+                    if (m_progress.isCanceled())
+                        break;
+                    remover.run(removeTasks, [this, &remover, &task, &trashRootPaths, step]()
+                    {
+                        auto rootIter = std::find_if(trashRootPaths.begin(), trashRootPaths.end(), [&task](const QString& rootPath)
+                        {
+                            return task.path.startsWith(rootPath + '/');
+                        });
+                        // a rename that fails (e.g. target is a mount point) falls back to removing in place
+                        task.isDetached = (rootIter != trashRootPaths.end()) && m_trash.detach(*rootIter, task.path);
+                        task.isOk = task.isDetached || remover.remove(task.path, task.failures);
+                        if (task.isOk)
+                            m_checkpoint.addDone(step, task.path);
+                        task.isDone = true;
+                        RunProgress::add(m_progress.tasksDone);
+                    });
+                }
+                removeTasks.wait();
+            }, tasks.size());
+            // detached trees are deleted after the results are shown, without holding the GUI
+            m_trash.purgeDetached();
 
-                if (regExpPattern.isEmpty())
-                    pRootItem = new QTreeWidgetItem;
+            uint detachedCount = 0;
+            for (const RemoveTask& task : qAsConst(tasks))
+            {
+                if (!task.isDone)
+                    continue;
+                if (task.isDetached)
+                    ++detachedCount;
+                if (task.isOk)
+                    ++(task.isDir ? dirSuccessCount : fileSuccessCount);
                 else
-                    pRootItem = searchFileDirToRemove(targetDir, filters, regExp);
-                pRootItem->setData(0, Qt::DisplayRole, targetDir.canonicalPath());
-                pRootItem->setIcon(0, QIcon(":/Icons/folder_15x15.png"));
-                m_fileDirEntryMap.insert(reinterpret_cast<uintptr_t>(pRootItem), {false, QFileInfo(targetDir.canonicalPath())});
-                ui->treeWidget_results->addTopLevelItem(pRootItem);
+                    ++(task.isDir ? dirFailCount : fileFailCount);
+                task.item->setIcon(2, task.isOk ? m_okIcon : m_errorIcon);
+                if (task.failures.isEmpty())
+                    continue;
+                // first failure is shown, the rest of them (up to a sane amount) in tooltip
+                const TreeRemover::Failure& firstFailure = task.failures.first();
+                task.item->setData(2, Qt::DisplayRole, (task.failures.size() == 1)
+                                                       ? QString("%1: %2").arg(firstFailure.path, firstFailure.errorText)
+                                                       : QString("%1 entries failed, %2: %3").arg(task.failures.size()).arg(firstFailure.path, firstFailure.errorText));
+                QStringList failureLines;
+                for (int i = 0; i < qMin(task.failures.size(), 50); ++i)
+                    failureLines.append(QString("%1: %2").arg(task.failures.at(i).path, task.failures.at(i).errorText));
+                task.item->setToolTip(2, failureLines.join('\n'));
             }
-            else if (actionType == ActionType::Replace)
+            QString resultMessage(QString("Removed entries: %1 directories and %2 files")
+                                  .arg(dirSuccessCount)
+                                  .arg(fileSuccessCount));
+            if (detachedCount > 0)
+                resultMessage.append(QString(" (%1 detached, deleting in background)").arg(detachedCount));
+            if ((dirFailCount > 0) || (fileFailCount > 0))
+                resultMessage.append(QString(". Failed to remove: %3 directories and %4 files")
+                                     .arg(dirFailCount)
+                                     .arg(fileFailCount));
+            return resultMessage;
+        }
+        else if (actionType == ActionType::Replace)
+        {
+            uint dirSuccessCount = 0;
+            uint fileSuccessCount = 0;
+            uint dirFailCount = 0;
+            uint fileFailCount = 0;
+
+            struct RenameTask
             {
-                QDir::Filters filters = QDir::NoDotAndDotDot | static_cast<QDir::Filters>(static_cast<int>(actionTarget));
+                QTreeWidgetItem* item;
+                int operationIdx;
+                bool isDir;
+            };
+            // Parent paths are taken before any renames; the plan orders each dir rename after renames inside it
+            RenamePlan plan(m_progress.tasksDone, m_progress.isCancelRequested);
+            plan.setThrottle(&m_throttle);
+            QVector<RenameTask> tasks;
+            QStringList operationPaths; // checkpoint path of each operation
+            for (QTreeWidgetItem* pItem : subtreeItems(pRootItem))
+            {
+                if (pItem->checkState(0) == Qt::Unchecked)
+                    continue;
+                auto entryIter = m_fileDirEntryMap.find(reinterpret_cast<uintptr_t>(pItem));
+                if ((entryIter != m_fileDirEntryMap.end()) && (entryIter.value().isExecutableTarget == true))
+                {
+                    const QFileInfo& entryFileInfo = entryIter.value().fileInfo;
+                    const int operationIdx = plan.add(entryFileInfo.canonicalPath(), entryFileInfo.fileName(), pItem->text(1));
+                    tasks.append(RenameTask{pItem, operationIdx, entryFileInfo.isDir()});
+                    operationPaths.append(entryFileInfo.canonicalFilePath());
+                    m_checkpoint.addPlanned(step, operationPaths.back());
+                }
+            }
+            m_checkpoint.flush();
+            // journaled as soon as it's done, an execute cut short still leaves it undoable
+            plan.setOnRenamed([this, &plan, &operationPaths, step](int operationIdx)
+            {
+                m_checkpoint.addDone(step, operationPaths.at(operationIdx));
+                const RenamePlan::Operation& operation = plan.operation(operationIdx);
+                if (m_journal && (operation.oldName != operation.newName))
+                    m_journal->addRename(operation.parentPath, operation.oldName, operation.newName);
+            });
 
-                QTreeWidgetItem* pRootItem = nullptr;
-                QRegularExpression regExp;
-                QString regExpPattern = ui->lineEdit_searchFor->text();
-                regExp.setPattern(regExpPattern);
-                if (ui->checkBox_isCaseSensitive->isChecked() == false)
-                    regExp.setPatternOptions(regExp.patternOptions() | QRegularExpression::CaseInsensitiveOption);
+            runInBackground([&plan]() { plan.execute(); }, tasks.size());
 
-                if (regExpPattern.isEmpty())
-                    pRootItem = new QTreeWidgetItem;
-                else
-                    pRootItem = searchFileDirToReplace(targetDir, filters, regExp, ui->lineEdit_replaceWith->text());
-                pRootItem->setData(0, Qt::DisplayRole, targetDir.canonicalPath());
-                pRootItem->setIcon(0, QIcon(":/Icons/folder_15x15.png"));
-                m_fileDirEntryMap.insert(reinterpret_cast<uintptr_t>(pRootItem), {false, QFileInfo(targetDir.canonicalPath())});
-                ui->treeWidget_results->addTopLevelItem(pRootItem);
-            }
-            else
+            for (const RenameTask& task : qAsConst(tasks))
             {
-                QMessageBox::critical(this, "MultiFileEditor error",
-                                      "Encountered unsupported Action Type."
-                                      "\nIf it's caused by incorrect preset - fix the preset."
-                                      "\nIf it's caused by something else - it requires code fixing."
-                                      "\nThe program will now be terminated.");
-                throw std::runtime_error("Encountered unsupported Action Type which shouldn't even be possible."
-                                         "This requires code fixing. The program will now be terminated.");
+                const RenamePlan::Operation& operation = plan.operation(task.operationIdx);
+                if (!operation.isDone)
+                    continue;
+                if (operation.isOk)
+                    ++(task.isDir ? dirSuccessCount : fileSuccessCount);
+                else
+                    ++(task.isDir ? dirFailCount : fileFailCount);
+                task.item->setIcon(2, operation.isOk ? m_okIcon : m_errorIcon);
+                if (!operation.errorText.isEmpty())
+                {
+                    task.item->setData(2, Qt::DisplayRole, operation.errorText);
+                    task.item->setToolTip(2, QString("%1: %2").arg(QDir(operation.parentPath).filePath(operation.oldName), operation.errorText));
+                }
             }
+            QString resultMessage(QString("Renamed entries: %1 directories and %2 files")
+                                  .arg(dirSuccessCount)
+                                  .arg(fileSuccessCount));
+            if ((dirFailCount > 0) || (fileFailCount > 0))
+                resultMessage.append(QString(". Failed to rename: %3 directories and %4 files")
+                                     .arg(dirFailCount)
+                                     .arg(fileFailCount));
+            if (plan.collisionCount() > 0)
+                resultMessage.append(QString(" (%1 not attempted due to name collisions)").arg(plan.collisionCount()));
+            return resultMessage;
         }
         else
         {
             QMessageBox::critical(this, "MultiFileEditor error",
-                                  "Encountered unsupported Action Target."
+                                  "Encountered unsupported Action Type."
                                   "\nIf it's caused by incorrect preset - fix the preset."
                                   "\nIf it's caused by something else - it requires code fixing."
                                   "\nThe program will now be terminated.");
-            throw std::runtime_error("Encountered unsupported Action Target which shouldn't even be possible."
+            throw std::runtime_error("Encountered unsupported Action Type which shouldn't even be possible."
                                      "This requires code fixing. The program will now be terminated.");
         }
     }
-    ui->treeWidget_results->expandAll();
-    ui->treeWidget_results->resizeColumnToContents(0);
-    ui->treeWidget_results->resizeColumnToContents(1);
-    m_isSearchDone = !m_isSearchDone;
-    ui->pushButton_execute->setText(m_isSearchDone ? "Execute" : "Search");
-    ui->frame_settings->setEnabled(!m_isSearchDone);
-    return;
+    else
+    {
+        QMessageBox::critical(this, "MultiFileEditor error",
+                              "Encountered unsupported Action Target."
+                              "\nIf it's caused by incorrect preset - fix the preset."
+                              "\nIf it's caused by something else - it requires code fixing."
+                              "\nThe program will now be terminated.");
+        throw std::runtime_error("Encountered unsupported Action Target which shouldn't even be possible."
+                                 "This requires code fixing. The program will now be terminated.");
+    }
+}
+
+void MultiFileEditor::updateProgress()
+{
+    if (m_isExecuting)
+    {
+        ui->progressBar_execute->setValue(static_cast<int>(m_progress.tasksDone.load(std::memory_order_relaxed)));
+        ui->label_resultsText->setText(m_progressMeter.executeText(m_progress));
+    }
+    else
+    {
+        ui->label_resultsText->setText(m_progressMeter.searchText(m_progress));
+    }
+    m_checkpoint.flush();
+}
+
+void MultiFileEditor::runInBackground(const std::function<void()>& func, qint64 executeTaskCount)
+{
+    m_progress.reset();
+    m_progress.tasksTotal.store(executeTaskCount, std::memory_order_relaxed);
+    m_isExecuting = (executeTaskCount > 0);
+    m_isRunning = true;
+    {
+        // results and settings must stay untouched while worker is using them
+        WidgetsDisabler disabler([this](bool isEnabled)
+        {
+            ui->frame_settings->setEnabled(isEnabled);
+            ui->treeWidget_results->setEnabled(isEnabled);
+            ui->pushButton_reset->setEnabled(isEnabled);
+            ui->pushButton_execute->setEnabled(isEnabled);
+            ui->pushButton_searchToFile->setEnabled(isEnabled && !m_isSearchDone);
+            ui->pushButton_savePlan->setEnabled(isEnabled && m_isSearchDone);
+            ui->pushButton_loadPlan->setEnabled(isEnabled && !m_isSearchDone);
+            ui->pushButton_undo->setEnabled(isEnabled && !m_lastJournalDirPath.isEmpty());
+        });
+        if (m_isExecuting)
+        {
+            ui->progressBar_execute->setRange(0, static_cast<int>(executeTaskCount));
+            ui->progressBar_execute->setValue(0);
+            ui->progressBar_execute->setVisible(true);
+        }
+        m_progressMeter.start();
+        m_progressTimer.start();
+
+        QEventLoop eventLoop;
+        QFutureWatcher<void> watcher;
+        connect(&watcher, &QFutureWatcher<void>::finished, &eventLoop, &QEventLoop::quit);
+        m_throttle.attach(QThreadPool::globalInstance());
+        watcher.setFuture(QtConcurrent::run(func));
+        eventLoop.exec();
+        m_throttle.detach(QThreadPool::globalInstance());
+
+        m_progressTimer.stop();
+        m_checkpoint.flush();
+        ui->progressBar_execute->setVisible(false);
+    }
+    m_isRunning = false;
+    m_isExecuting = false;
+    if (m_isCloseRequested)
+        QMetaObject::invokeMethod(this, &QWidget::close, Qt::QueuedConnection);
+}
+
+QStringList MultiFileEditor::searchRootPaths() const
+{
+    QStringList rootPaths;
+    for (const QString& dirPath : dirPathsFromString(ui->lineEdit_dirPath->text()))
+    {
+        const QString rootPath = QDir(dirPath).canonicalPath();
+        if (!rootPath.isEmpty())
+            rootPaths.append(rootPath);
+    }
+    auto isInside = [](const QString& path, const QString& dirPath)
+    {
+        return (path != dirPath) && path.startsWith(dirPath.endsWith('/') ? dirPath : dirPath + '/');
+    };
+    QStringList result;
+    for (const QString& rootPath : qAsConst(rootPaths))
+    {
+        const bool isWalkedWithOther = std::any_of(rootPaths.begin(), rootPaths.end(), [&](const QString& otherPath)
+        {
+            return isInside(rootPath, otherPath);
+        });
+        if (!isWalkedWithOther && !result.contains(rootPath))
+            result.append(rootPath);
+    }
+    return result;
+}
+
+WalkContext MultiFileEditor::newWalkContext(const QString& rootPath)
+{
+    WalkContext walk;
+    walk.rootDir = QDir(rootPath);
+    walk.walkFilter = m_walkFilter;
+    walk.pVisits = &m_walkVisits;
+    walk.visitsRoot = m_walkVisits.enterRoot(walk.rootDir.canonicalPath());
+    walk.fileReader = takeFileReader();
+    walk.presetSearches = m_presetSearches;
+    for (PresetSearch& search : walk.presetSearches)
+        search.pGroupItem = nullptr;
+    return walk;
+}
+
+WalkContext MultiFileEditor::newWalkBranch(const WalkContext& walk)
+{
+    WalkContext branch;
+    branch.rootDir = walk.rootDir;
+    branch.walkFilter = walk.walkFilter;
+    branch.pVisits = walk.pVisits;
+    branch.visitsRoot = walk.visitsRoot;
+    branch.fileReader = takeFileReader();
+    branch.presetSearches = walk.presetSearches;
+    return branch;
+}
+
+std::unique_ptr<FileReader> MultiFileEditor::takeFileReader()
+{
+    {
+        QMutexLocker locker(&m_fileReadersMutex);
+        if (!m_idleFileReaders.empty())
+        {
+            std::unique_ptr<FileReader> fileReader = std::move(m_idleFileReaders.back());
+            m_idleFileReaders.pop_back();
+            return fileReader;
+        }
+    }
+    std::unique_ptr<FileReader> fileReader(new FileReader(m_ioBackend, m_ioQueueDepth, m_readaheadSize));
+    fileReader->setThrottle(&m_throttle);
+    return fileReader;
+}
+
+void MultiFileEditor::releaseFileReader(std::unique_ptr<FileReader> fileReader)
+{
+    QMutexLocker locker(&m_fileReadersMutex);
+    m_idleFileReaders.push_back(std::move(fileReader));
+}
+
+template<typename Result, typename WalkRoot>
+QVector<Result> MultiFileEditor::walkRoots(std::vector<WalkContext>& walks, const WalkRoot& walkRoot)
+{
+    QVector<Result> results(static_cast<int>(walks.size()));
+    runInBackground([&]()
+    {
+        QVector<int> rootIdxs(results.size());
+        for (int rootIdx = 0; rootIdx < rootIdxs.size(); ++rootIdx)
+            rootIdxs[rootIdx] = rootIdx;
+        // each thread takes the next root, subdirectories spread to idle threads by walkSubdirs()
+        QtConcurrent::blockingMap(rootIdxs, [&](int& rootIdx) { results[rootIdx] = walkRoot(walks[rootIdx]); });
+    });
+    return results;
+}
+
+template<typename Result, typename WalkSubdir>
+void MultiFileEditor::walkSubdirs(WalkContext& walk, QVector<Result>& results, const WalkSubdir& walkSubdir)
+{
+    QThreadPool* pPool = QThreadPool::globalInstance();
+    Result* pResults = results.data(); // tasks write their own elements, detached once here
+    std::deque<WalkContext> branches; // tasks hold pointers to them
+    {
+        TaskGroup group;
+        for (int subdirIdx = 0; subdirIdx < results.size(); ++subdirIdx)
+        {
+            // the last subdirectory is left to this thread, which would only wait otherwise
+            if ((subdirIdx + 1 < results.size()) && (pPool->activeThreadCount() < pPool->maxThreadCount()))
+            {
+                branches.push_back(newWalkBranch(walk));
+                WalkContext* pBranch = &branches.back();
+                if (group.tryStart(pPool, [&, pBranch, subdirIdx]() { pResults[subdirIdx] = walkSubdir(*pBranch, subdirIdx); }))
+                    continue;
+                releaseFileReader(std::move(pBranch->fileReader));
+                branches.pop_back();
+            }
+            pResults[subdirIdx] = walkSubdir(walk, subdirIdx);
+        }
+        group.wait();
+    }
+    for (WalkContext& branch : branches)
+        releaseFileReader(std::move(branch.fileReader));
+}
+
+void MultiFileEditor::addRootItems(QTreeWidgetItem* pParentItem, const std::vector<WalkContext>& walks, const QVector<QTreeWidgetItem*>& rootItems)
+{
+    for (int rootIdx = 0; rootIdx < rootItems.size(); ++rootIdx)
+    {
+        const QString rootPath = walks.at(rootIdx).rootDir.canonicalPath();
+        QTreeWidgetItem* pRootItem = (rootItems.at(rootIdx) != nullptr) ? rootItems.at(rootIdx) : new QTreeWidgetItem;
+        pRootItem->setData(0, Qt::DisplayRole, rootPath);
+        pRootItem->setIcon(0, m_folderIcon);
+        m_fileDirEntryMap.insert(reinterpret_cast<uintptr_t>(pRootItem), {false, QFileInfo(rootPath)});
+        pParentItem->addChild(pRootItem);
+    }
+}
+
+void MultiFileEditor::addRootFileItems(QTreeWidgetItem* pParentItem, const std::vector<WalkContext>& walks, const QVector<QList<QTreeWidgetItem*>>& rootFileItems)
+{
+    if (rootFileItems.size() == 1)
+    {
+        pParentItem->addChildren(rootFileItems.front());
+        return;
+    }
+    for (int rootIdx = 0; rootIdx < rootFileItems.size(); ++rootIdx)
+    {
+        if (rootFileItems.at(rootIdx).isEmpty())
+            continue;
+        // not an entry of m_fileContentsEntryMap, execute passes it by
+        QTreeWidgetItem* pRootItem = new QTreeWidgetItem;
+        pRootItem->setData(0, Qt::DisplayRole, walks.at(rootIdx).rootDir.canonicalPath());
+        pRootItem->setIcon(0, m_folderIcon);
+        pRootItem->setFlags(pRootItem->flags() | Qt::ItemIsAutoTristate);
+        pRootItem->addChildren(rootFileItems.at(rootIdx));
+        pParentItem->addChild(pRootItem);
+    }
+}
+
+bool MultiFileEditor::beginJournal(QString& errorText)
+{
+    if (!m_isJournalEnabled)
+        return true;
+    // only the last execute can be undone; a headless one keeps the GUI's and tells where its own is
+    if (!m_isHeadless && !m_lastJournalDirPath.isEmpty())
+    {
+        discardJournal(m_lastJournalDirPath);
+        setLastJournalDirPath(QString());
+    }
+    // with several search roots the journal of all of them is kept in the first one
+    const QStringList rootPaths = searchRootPaths();
+    m_journal.reset(new ExecuteJournal(ExecuteJournal::newDirPath(rootPaths.isEmpty() ? QString() : rootPaths.front())));
+    QString createErrorText;
+    if (m_journal->create(createErrorText))
+    {
+        // known from the start, so a journal of an execute cut short by a crash can be undone on the next start
+        if (!m_isHeadless)
+        {
+            QSettings settingsFile(g_settingsPath, QSettings::IniFormat, this);
+            settingsFile.setValue("LastSettings/journal_dir", m_journal->dirPath());
+        }
+        return true;
+    }
+    m_journal.reset();
+    errorText = QString("Failed to create undo journal: %1").arg(createErrorText);
+    // nobody to ask: no execute without undo
+    if (m_isHeadless)
+        return false;
+    int ret = QMessageBox::question(this, "Undo journal unavailable",
+                                    "Failed to create undo journal in searched directory."
+                                    "\nExecute anyway, without a way to undo it?");
+    return ret == QMessageBox::Yes;
+}
+
+QString MultiFileEditor::finishJournal()
+{
+    if (!m_journal)
+        return QString();
+    std::unique_ptr<ExecuteJournal> journal = std::move(m_journal);
+    const bool isIndexOk = journal->close();
+    if ((journal->entryCount() == 0) || !isIndexOk)
+    {
+        discardJournal(journal->dirPath());
+        if (!m_isHeadless)
+            setLastJournalDirPath(QString());
+        return QString();
+    }
+    if (!m_isHeadless)
+        setLastJournalDirPath(journal->dirPath());
+    const ExecuteJournal::Usage usage = journal->usage();
+    QString usageText;
+    if (usage.clonedCount > 0)
+        usageText.append(QString("%1 files cloned (%2 shared with originals)").arg(usage.clonedCount).arg(ProgressMeter::formatBytes(usage.clonedBytes)));
+    if (usage.storedCount > 0)
+        usageText.append(QString("%1%2 snapshots stored in %3").arg(usageText.isEmpty() ? "" : ", ").arg(usage.storedCount).arg(ProgressMeter::formatBytes(usage.storedBytes)));
+    if (m_isHeadless)
+        usageText.append(QString("%1kept in %2").arg(usageText.isEmpty() ? "" : ", ").arg(journal->dirPath()));
+    return usageText.isEmpty() ? QString() : QString("\nUndo journal: %1").arg(usageText);
+}
+
+void MultiFileEditor::discardJournal(const QString& journalDirPath)
+{
+    // <root>/.qMultiFileEditor_journal/<journal>, it goes to the trash of the same root
+    const QString journalsDirPath = QFileInfo(journalDirPath).absolutePath();
+    if (m_trash.detach(QFileInfo(journalsDirPath).absolutePath(), journalDirPath))
+    {
+        m_trash.purgeDetached();
+    }
+    else
+    {
+        std::atomic<qint64> removedCount{0};
+        std::atomic<bool> isCancelRequested{false};
+        QVector<TreeRemover::Failure> failures;
+        TreeRemover(removedCount, isCancelRequested).remove(journalDirPath, failures);
+    }
+    QDir().rmdir(journalsDirPath);
+}
+
+void MultiFileEditor::setLastJournalDirPath(const QString& journalDirPath)
+{
+    m_lastJournalDirPath = journalDirPath;
+    if (journalDirPath.isEmpty())
+    {
+        QSettings settingsFile(g_settingsPath, QSettings::IniFormat, this);
+        settingsFile.remove("LastSettings/journal_dir");
+    }
+    ui->pushButton_undo->setEnabled(!m_lastJournalDirPath.isEmpty());
+}
+
+void MultiFileEditor::beginCheckpoint()
+{
+    if (!m_isCheckpointEnabled)
+        return;
+    m_checkpoint.begin([this](QSettings& runFile)
+    {
+        runFile.beginGroup("Search");
+        writePreset(runFile, presetFromUi());
+        runFile.endGroup();
+        runFile.beginWriteArray("Presets", m_presetSearches.size());
+        for (int i = 0; i < m_presetSearches.size(); ++i)
+        {
+            const QString& presetName = m_presetSearches.at(i).presetName;
+            runFile.setArrayIndex(i);
+            runFile.setValue("name", presetName);
+            writePreset(runFile, m_presetMap.value(presetName));
+        }
+        runFile.endArray();
+    });
+}
+
+void MultiFileEditor::applyExecuteCursor()
+{
+    // execute steps as numbered by execute(): presets in their order or a single one
+    QVector<QTreeWidgetItem*> stepRootItems;
+    if (m_presetSearches.isEmpty())
+        stepRootItems.append(ui->treeWidget_results->invisibleRootItem());
+    for (const PresetSearch& search : qAsConst(m_presetSearches))
+        stepRootItems.append(search.pGroupItem);
+    for (int step = 0; step < stepRootItems.size(); ++step)
+    {
+        for (QTreeWidgetItem* pItem : subtreeItems(stepRootItems.at(step)))
+        {
+            auto contentsIter = m_fileContentsEntryMap.constFind(reinterpret_cast<uintptr_t>(pItem));
+            if (contentsIter != m_fileContentsEntryMap.constEnd())
+            {
+                QVector<int> lineIdxs;
+                const bool isPending = m_checkpoint.isPending(step, contentsIter->fileInfo.canonicalFilePath(), &lineIdxs);
+                for (int i = 0; i < pItem->childCount(); ++i)
+                {
+                    QTreeWidgetItem* pLineItem = pItem->child(i);
+                    const bool isChecked = isPending && lineIdxs.contains(pLineItem->data(0, LineIndexRole).toInt());
+                    pLineItem->setCheckState(0, isChecked ? Qt::Checked : Qt::Unchecked);
+                }
+                continue;
+            }
+            auto entryIter = m_fileDirEntryMap.constFind(reinterpret_cast<uintptr_t>(pItem));
+            if ((entryIter != m_fileDirEntryMap.constEnd()) && entryIter->isExecutableTarget)
+                pItem->setCheckState(0, m_checkpoint.isPending(step, entryIter->fileInfo.canonicalFilePath()) ? Qt::Checked : Qt::Unchecked);
+        }
+    }
+}
+
+void MultiFileEditor::undoLastExecute()
+{
+    if (m_lastJournalDirPath.isEmpty())
+        return;
+    if (ui->checkBox_isAutoconfirmExecute->isChecked() == false)
+    {
+        int ret = QMessageBox::question(this, "Undo last execute?",
+                                        "Restore contents and names of entries changed by the last execute?"
+                                        "\nChanges made to them since then will be lost.");
+        if (ret != QMessageBox::Yes)
+            return;
+    }
+    ExecuteJournal journal(m_lastJournalDirPath);
+    if (!journal.load())
+    {
+        QMessageBox::warning(this, "MultiFileEditor error", "Undo journal of the last execute is missing.");
+        setLastJournalDirPath(QString());
+        return;
+    }
+
+    ExecuteJournal::UndoResult result;
+    runInBackground([&]() { result = journal.undo(m_progress.tasksDone, m_progress.isCancelRequested); }, journal.entryCount());
+
+    // results refer to the state before undo
+    reset();
+    QString resultMessage(QString("Undone: %1 files restored and %2 entries renamed")
+                          .arg(result.restoredCount)
+                          .arg(result.renamedCount));
+    if (!result.failures.isEmpty())
+    {
+        resultMessage.append(QString(". Failed to undo: %1 entries, journal is kept").arg(result.failures.size()));
+        ui->label_resultsText->setToolTip(QStringList(result.failures.mid(0, 50)).join('\n'));
+    }
+    else if (m_progress.isCanceled())
+    {
+        resultMessage.append(". Canceled, journal is kept");
+    }
+    else
+    {
+        discardJournal(m_lastJournalDirPath);
+        setLastJournalDirPath(QString());
+    }
+    ui->label_resultsText->setText(resultMessage);
+}
+
+void MultiFileEditor::showThrottleDialog()
+{
+    // non-modal and kept around, so limits can be changed while a run goes on
+    if (m_pThrottleDialog == nullptr)
+    {
+        const Throttle::Limits limits = m_throttle.limits();
+        m_pThrottleDialog = new QDialog(this);
+        m_pThrottleDialog->setWindowTitle("Throttle");
+        QFormLayout* pLayout = new QFormLayout(m_pThrottleDialog);
+
+        QComboBox* pIoPriorityCombo = new QComboBox(m_pThrottleDialog);
+        pIoPriorityCombo->addItem("Normal", static_cast<int>(Throttle::IoPriority::Normal));
+        pIoPriorityCombo->addItem("Low", static_cast<int>(Throttle::IoPriority::Low));
+        pIoPriorityCombo->addItem("Idle", static_cast<int>(Throttle::IoPriority::Idle));
+        pIoPriorityCombo->setCurrentIndex(pIoPriorityCombo->findData(static_cast<int>(limits.ioPriority)));
+        pIoPriorityCombo->setToolTip("Low: lowest level of best-effort class. Idle: disk is used only when nothing else needs it.");
+        pLayout->addRow("I/O priority:", pIoPriorityCombo);
+
+        auto newLimitSpinBox = [this](int value, int maximum, const QString& suffix, const QString& zeroText)
+        {
+            QSpinBox* pSpinBox = new QSpinBox(m_pThrottleDialog);
+            pSpinBox->setRange(0, maximum);
+            pSpinBox->setSuffix(suffix);
+            pSpinBox->setSpecialValueText(zeroText);
+            pSpinBox->setValue(value);
+            return pSpinBox;
+        };
+        QSpinBox* pBytesSpinBox = newLimitSpinBox(static_cast<int>(limits.bytesPerSec / (1024 * 1024)), 100000, " MB/s", "Unlimited");
+        pLayout->addRow("Read/write:", pBytesSpinBox);
+        QSpinBox* pFilesSpinBox = newLimitSpinBox(static_cast<int>(limits.filesPerSec), 10000000, " files/s", "Unlimited");
+        pLayout->addRow("Files:", pFilesSpinBox);
+        QSpinBox* pThreadsSpinBox = newLimitSpinBox(limits.threadCount, 1024, " threads", "Default");
+        pLayout->addRow("Threads:", pThreadsSpinBox);
+
+        auto applyLimits = [this, pIoPriorityCombo, pBytesSpinBox, pFilesSpinBox, pThreadsSpinBox]()
+        {
+            Throttle::Limits newLimits;
+            newLimits.ioPriority = static_cast<Throttle::IoPriority>(pIoPriorityCombo->currentData().toInt());
+            newLimits.bytesPerSec = static_cast<qint64>(pBytesSpinBox->value()) * 1024 * 1024;
+            newLimits.filesPerSec = pFilesSpinBox->value();
+            newLimits.threadCount = pThreadsSpinBox->value();
+            m_throttle.setLimits(newLimits);
+        };
+        connect(pIoPriorityCombo, qOverload<int>(&QComboBox::activated), m_pThrottleDialog, applyLimits);
+        for (QSpinBox* pSpinBox : {pBytesSpinBox, pFilesSpinBox, pThreadsSpinBox})
+            connect(pSpinBox, qOverload<int>(&QSpinBox::valueChanged), m_pThrottleDialog, applyLimits);
+
+        QDialogButtonBox* pButtonBox = new QDialogButtonBox(QDialogButtonBox::Close, m_pThrottleDialog);
+        connect(pButtonBox, &QDialogButtonBox::rejected, m_pThrottleDialog, &QDialog::reject);
+        pLayout->addRow(pButtonBox);
+    }
+    m_pThrottleDialog->show();
+    m_pThrottleDialog->raise();
+    m_pThrottleDialog->activateWindow();
 }
 
 void MultiFileEditor::closeEvent(QCloseEvent* event)
 {
+    if (m_isRunning)
+    {
+        // worker is still using this object: cancel the run and close once runInBackground has returned
+        m_isCloseRequested = true;
+        m_progress.isCancelRequested.store(true, std::memory_order_relaxed);
+        event->ignore();
+        return;
+    }
+    // closed while idle, nothing is left to resume; a run canceled by closing is kept
+    if (!m_isCloseRequested)
+        m_checkpoint.discard();
     this->deleteLater();
     QWidget::closeEvent(event);
 }
 
-QTreeWidgetItem* MultiFileEditor::searchFileDirToRemove(QDir targetDir, QDir::Filters filters, QRegularExpression regExp)
+QTreeWidgetItem* MultiFileEditor::searchFileDirToRemove(WalkContext& walk, QDir targetDir, QDir::Filters filters, const FileNameMatcher& matcher)
 {
     QTreeWidgetItem* retItem = new QTreeWidgetItem;
+    if (!beginWalkDir(targetDir))
+        return retItem;
+    WalkFilter::DirScope walkScope(walk.walkFilter, targetDir);
     bool isDeleteDirs = ((filters & QDir::Dirs) == QDir::Dirs);
     bool isDeleteFiles = ((filters & QDir::Files) == QDir::Files);
 
     QStringList nameFilters({"*"});
     QDir::SortFlags sortFlags = QDir::Name | QDir::DirsFirst;
-    QList<QFileInfo> allFileDirs = targetDir.entryInfoList(nameFilters, filters, sortFlags);
+    QList<QFileInfo> allFileDirs;
+    {
+        ScopedPhaseTimer walkTimer(ProfilePhase::Walk);
+        allFileDirs = targetDir.entryInfoList(nameFilters, filters, sortFlags);
+        walk.walkFilter.filter(allFileDirs);
+    }
+    ScopedPhaseTimer matchTimer(ProfilePhase::Match);
+    RunProgress::add(m_progress.filesScanned, allFileDirs.size());
+    // rows of the directory's targets while searching to a file
+    QByteArray exportRows;
+    int exportRowCount = 0;
 
     auto iter = allFileDirs.begin();
     // entryInfoList is guaranteed to only contain dirs and\or files (as set by filters) and it's guaranteed that all dirs will be placed before files (as set by sortFlags)
     if (isDeleteDirs || isRecursive)
     {
+        // items of dirs in order of names: matched dirs get theirs right away, subdirs walked get theirs once all are walked
+        QVector<QTreeWidgetItem*> dirItems;
+        QVector<int> subdirSlots;
+        QStringList subdirPaths;
+        QStringList subdirNames;
         for (; (iter != allFileDirs.end()) && iter->isDir(); ++iter)
         {
-            // first check if entry is subject to deletion; true -> no need for recursive call since whole dir will be deleted -> continue
-            if (isDeleteDirs)
+            // first check if entry is subject to deletion; true -> no need for recursive call since whole dir will be deleted
+            if (isDeleteDirs && matcher.matches(iter->fileName()) && m_metadataFilter.matches(*iter))
+            {
+                RunProgress::add(m_progress.hits);
+                if (m_pExport != nullptr)
+                {
+                    m_pExport->appendNameRow(exportRows, iter->absoluteFilePath(), iter->fileName(), QString());
+                    ++exportRowCount;
+                    continue;
+                }
+                ScopedPhaseTimer treeTimer(ProfilePhase::Tree);
+                QTreeWidgetItem* pChildItem = new QTreeWidgetItem;
+                if (isHighlight)
+                    pChildItem->setData(0, Qt::UserRole, QVariant::fromValue(ColoredText(iter->fileName(), 0, matcher.regExp(), 0, Qt::yellow)));
+                else
+                    pChildItem->setData(0, Qt::DisplayRole, iter->fileName());
+                pChildItem->setIcon(0, m_folderIcon);
+                pChildItem->setCheckState(0, Qt::Checked);
+                dirItems.append(pChildItem);
+                addFileDirEntry(pChildItem, true, *iter);
+                continue;
+            }
+            if (isRecursive && enterSubdir(walk, *iter))
+            {
+                subdirSlots.append(dirItems.size());
+                subdirPaths.append(iter->canonicalFilePath());
+                subdirNames.append(iter->fileName());
+                dirItems.append(nullptr);
+            }
+        }
+        QVector<QTreeWidgetItem*> subdirItems(subdirPaths.size(), nullptr);
+        walkSubdirs(walk, subdirItems, [&](WalkContext& subdirWalk, int subdirIdx)
+        {
+            return searchFileDirToRemove(subdirWalk, QDir(subdirPaths.at(subdirIdx)), filters, matcher);
+        });
+        for (int subdirIdx = 0; subdirIdx < subdirItems.size(); ++subdirIdx)
+        {
+            QTreeWidgetItem* pChildItem = subdirItems.at(subdirIdx);
+            if (pChildItem->childCount() != 0)
             {
-                auto reMatch = regExp.match(iter->fileName());
-                if (reMatch.hasMatch())
-                {
-                    QTreeWidgetItem* pChildItem = new QTreeWidgetItem;
-                    if (isHighlight)
-                        pChildItem->setData(0, Qt::UserRole, QVariant::fromValue(ColoredText(iter->fileName(), 0, regExp, reMatch.capturedStart(0), Qt::yellow)));
-                    else
-                        pChildItem->setData(0, Qt::DisplayRole, iter->fileName());
-                    pChildItem->setIcon(0, QIcon(":/Icons/folder_15x15.png"));
-                    pChildItem->setCheckState(0, Qt::Checked);
-                    retItem->addChild(pChildItem);
-                    m_fileDirEntryMap.insert(reinterpret_cast<uintptr_t>(pChildItem), {true, *iter});
-                    goto goto_nextDirEntry;
-                }
+                pChildItem->setData(0, Qt::DisplayRole, subdirNames.at(subdirIdx));
+                pChildItem->setIcon(0, m_folderIcon);
+                dirItems[subdirSlots.at(subdirIdx)] = pChildItem;
             }
-            if (isRecursive)
+            else
             {
-                QTreeWidgetItem* pChildItem = searchFileDirToRemove(QDir(iter->canonicalFilePath()), filters, regExp);
-                if (pChildItem->childCount() != 0)
-                {
-                    pChildItem->setData(0, Qt::DisplayRole, iter->fileName());
-                    pChildItem->setIcon(0, QIcon(":/Icons/folder_15x15.png"));
-                    retItem->addChild(pChildItem);
-                }
-                else
-                {
-                    delete pChildItem;
-                }
+                delete pChildItem;
             }
-goto_nextDirEntry: continue;
+        }
+        for (QTreeWidgetItem* pChildItem : qAsConst(dirItems))
+        {
+            if (pChildItem != nullptr)
+                retItem->addChild(pChildItem);
         }
     }
 
@@ -797,44 +2314,84 @@ goto_nextDirEntry: continue;
     {
         for (; iter != allFileDirs.end(); ++iter)
         {
-            auto reMatch = regExp.match(iter->fileName());
-            if (reMatch.hasMatch())
+            if (matcher.matches(iter->fileName()) && m_metadataFilter.matches(*iter))
             {
+                RunProgress::add(m_progress.hits);
+                if (m_pExport != nullptr)
+                {
+                    m_pExport->appendNameRow(exportRows, iter->absoluteFilePath(), iter->fileName(), QString());
+                    ++exportRowCount;
+                    continue;
+                }
+                ScopedPhaseTimer treeTimer(ProfilePhase::Tree);
                 QTreeWidgetItem* pChildItem = new QTreeWidgetItem;
                 if (isHighlight)
-                    pChildItem->setData(0, Qt::UserRole, QVariant::fromValue(ColoredText(iter->fileName(), 0, regExp, reMatch.capturedStart(0), Qt::yellow)));
+                    pChildItem->setData(0, Qt::UserRole, QVariant::fromValue(ColoredText(iter->fileName(), 0, matcher.regExp(), 0, Qt::yellow)));
                 else
                     pChildItem->setData(0, Qt::DisplayRole, iter->fileName());
-                pChildItem->setIcon(0, QIcon(":/Icons/file_12x15.png"));
+                pChildItem->setIcon(0, m_fileIcon);
                 pChildItem->setCheckState(0, Qt::Checked);
                 retItem->addChild(pChildItem);
-                m_fileDirEntryMap.insert(reinterpret_cast<uintptr_t>(pChildItem), {true, *iter});
+                addFileDirEntry(pChildItem, true, *iter);
             }
         }
     }
+    if (exportRowCount > 0)
+        m_pExport->addRows(exportRows, exportRowCount);
+    if ((retItem->childCount() == 0) && !m_progress.isCanceled())
+        m_checkpoint.addWalkedDir(targetDir.path());
     return retItem;
 }
 
-QTreeWidgetItem* MultiFileEditor::searchFileDirToReplace(QDir targetDir, QDir::Filters filters, QRegularExpression regExp, QString replaceWith)
+QTreeWidgetItem* MultiFileEditor::searchFileDirToReplace(WalkContext& walk, QDir targetDir, QDir::Filters filters, const QRegularExpression& regExp, const QString& replaceWith)
 {
     QTreeWidgetItem* retItem = new QTreeWidgetItem;
+    if (!beginWalkDir(targetDir))
+        return retItem;
+    WalkFilter::DirScope walkScope(walk.walkFilter, targetDir);
     bool isRenameDirs = ((filters & QDir::Dirs) == QDir::Dirs);
     bool isRenameFiles = ((filters & QDir::Files) == QDir::Files);
 
     QStringList nameFilters({"*"});
     QDir::SortFlags sortFlags = QDir::Name | QDir::DirsFirst;
-    QList<QFileInfo> allFileDirs = targetDir.entryInfoList(nameFilters, filters, sortFlags);
+    QList<QFileInfo> allFileDirs;
+    {
+        ScopedPhaseTimer walkTimer(ProfilePhase::Walk);
+        allFileDirs = targetDir.entryInfoList(nameFilters, filters, sortFlags);
+        walk.walkFilter.filter(allFileDirs);
+    }
+    ScopedPhaseTimer matchTimer(ProfilePhase::Match);
+    RunProgress::add(m_progress.filesScanned, allFileDirs.size());
+    // rows of the directory's targets while searching to a file
+    QByteArray exportRows;
+    int exportRowCount = 0;
 
     auto iter = allFileDirs.begin();
     // entryInfoList is guaranteed to only contain dirs and\or files (as set by filters) and it's guaranteed that all dirs will be placed before files (as set by sortFlags)
     if (isRenameDirs || isRecursive)
     {
-        for (; (iter != allFileDirs.end()) && iter->isDir(); ++iter)
+        // subdirs are walked first, as their contents are renamed before them
+        const auto dirsEnd = std::find_if(iter, allFileDirs.end(), [](const QFileInfo& fileInfo) { return !fileInfo.isDir(); });
+        QVector<int> dirSubdirIdxs;
+        QStringList subdirPaths;
+        for (auto dirIter = iter; dirIter != dirsEnd; ++dirIter)
+        {
+            const bool isSubdirWalked = isRecursive && enterSubdir(walk, *dirIter);
+            dirSubdirIdxs.append(isSubdirWalked ? subdirPaths.size() : -1);
+            if (isSubdirWalked)
+                subdirPaths.append(dirIter->canonicalFilePath());
+        }
+        QVector<QTreeWidgetItem*> subdirItems(subdirPaths.size(), nullptr);
+        walkSubdirs(walk, subdirItems, [&](WalkContext& subdirWalk, int subdirIdx)
+        {
+            return searchFileDirToReplace(subdirWalk, QDir(subdirPaths.at(subdirIdx)), filters, regExp, replaceWith);
+        });
+        for (int dirIdx = 0; iter != dirsEnd; ++iter, ++dirIdx)
         {
             QTreeWidgetItem* pChildItem = nullptr;
-            if (isRecursive)
+            if (dirSubdirIdxs.at(dirIdx) != -1)
             {
-                pChildItem = searchFileDirToReplace(QDir(iter->canonicalFilePath()), filters, regExp, replaceWith);
+                pChildItem = subdirItems.at(dirSubdirIdxs.at(dirIdx));
                 if (pChildItem->childCount() == 0)
                 {
                     delete pChildItem;
@@ -843,15 +2400,23 @@ QTreeWidgetItem* MultiFileEditor::searchFileDirToReplace(QDir targetDir, QDir::F
                 else
                 {
                     pChildItem->setData(0, Qt::DisplayRole, iter->fileName());
-                    pChildItem->setIcon(0, QIcon(":/Icons/folder_15x15.png"));
+                    pChildItem->setIcon(0, m_folderIcon);
                     retItem->addChild(pChildItem);
                 }
             }
             if (isRenameDirs)
             {
                 auto reMatch = regExp.match(iter->fileName());
-                if (reMatch.hasMatch())
+                if (reMatch.hasMatch() && m_metadataFilter.matches(*iter))
                 {
+                    RunProgress::add(m_progress.hits);
+                    if (m_pExport != nullptr)
+                    {
+                        m_pExport->appendNameRow(exportRows, iter->absoluteFilePath(), iter->fileName(), iter->fileName().replace(regExp, replaceWith));
+                        ++exportRowCount;
+                        continue;
+                    }
+                    ScopedPhaseTimer treeTimer(ProfilePhase::Tree);
                     if (pChildItem == nullptr)
                     {
                         pChildItem = new QTreeWidgetItem;
@@ -859,12 +2424,12 @@ QTreeWidgetItem* MultiFileEditor::searchFileDirToReplace(QDir targetDir, QDir::F
                             pChildItem->setData(0, Qt::UserRole, QVariant::fromValue(ColoredText(iter->fileName(), 0, regExp, reMatch.capturedStart(0), Qt::yellow)));
                         else
                             pChildItem->setData(0, Qt::DisplayRole, iter->fileName());
-                        pChildItem->setIcon(0, QIcon(":/Icons/folder_15x15.png"));
+                        pChildItem->setIcon(0, m_folderIcon);
                         retItem->addChild(pChildItem);
                     }
                     pChildItem->setData(1, Qt::DisplayRole, iter->fileName().replace(regExp, replaceWith));
                     pChildItem->setCheckState(0, Qt::Checked);
-                    m_fileDirEntryMap.insert(reinterpret_cast<uintptr_t>(pChildItem), {true, *iter});
+                    addFileDirEntry(pChildItem, true, *iter);
                 }
             }
         }
@@ -876,38 +2441,112 @@ QTreeWidgetItem* MultiFileEditor::searchFileDirToReplace(QDir targetDir, QDir::F
         for (; iter != allFileDirs.end(); ++iter)
         {
             auto reMatch = regExp.match(iter->fileName());
-            if (reMatch.hasMatch())
+            if (reMatch.hasMatch() && m_metadataFilter.matches(*iter))
             {
+                RunProgress::add(m_progress.hits);
+                if (m_pExport != nullptr)
+                {
+                    m_pExport->appendNameRow(exportRows, iter->absoluteFilePath(), iter->fileName(), iter->fileName().replace(regExp, replaceWith));
+                    ++exportRowCount;
+                    continue;
+                }
+                ScopedPhaseTimer treeTimer(ProfilePhase::Tree);
                 QTreeWidgetItem* pChildItem = new QTreeWidgetItem;
                 if (isHighlight)
                     pChildItem->setData(0, Qt::UserRole, QVariant::fromValue(ColoredText(iter->fileName(), 0, regExp, reMatch.capturedStart(0), Qt::yellow)));
                 else
                     pChildItem->setData(0, Qt::DisplayRole, iter->fileName());
                 pChildItem->setData(1, Qt::DisplayRole, iter->fileName().replace(regExp, replaceWith));
-                pChildItem->setIcon(0, QIcon(":/Icons/file_12x15.png"));
+                pChildItem->setIcon(0, m_fileIcon);
                 pChildItem->setCheckState(0, Qt::Checked);
                 retItem->addChild(pChildItem);
-                m_fileDirEntryMap.insert(reinterpret_cast<uintptr_t>(pChildItem), {true, *iter});
+                addFileDirEntry(pChildItem, true, *iter);
             }
         }
     }
+    if (exportRowCount > 0)
+        m_pExport->addRows(exportRows, exportRowCount);
+    if ((retItem->childCount() == 0) && !m_progress.isCanceled())
+        m_checkpoint.addWalkedDir(targetDir.path());
     return retItem;
 }
 
-QList<QTreeWidgetItem*> MultiFileEditor::searchFileContentsToReplace(QDir targetDir, QRegularExpression filePatternRegExp, QRegularExpression searchRegExp, QString replaceString)
+template<typename IsScannedAt, typename OnFileRead>
+void MultiFileEditor::readFilesLines(WalkContext& walk, const QList<QFileInfo>& fileInfos, bool isSparingCache, const IsScannedAt& isScannedAt,
+                                     const OnFileRead& onFileRead)
+{
+    if (fileInfos.isEmpty())
+        return;
+    QStringList filePaths;
+    filePaths.reserve(fileInfos.size());
+    for (const QFileInfo& fileInfo : fileInfos)
+        filePaths.append(fileInfo.canonicalFilePath());
+    // scanning runs between completions and is timed as match, what's left is submitting and waiting for reads
+    ScopedPhaseTimer readTimer(ProfilePhase::Read, fileInfos.front().absolutePath());
+    QVector<QString> firstLinkPaths(fileInfos.size());
+    walk.fileReader->read(filePaths, [&](int fileIdx, FileReader::File& file)
+    {
+        if (file.isSkipped)
+        {
+            onFileRead(fileIdx, QStringList(), file.fingerprint, false, firstLinkPaths.at(fileIdx));
+            return;
+        }
+        ScopedPhaseTimer matchTimer(ProfilePhase::Match);
+        RunProgress::add(m_progress.filesScanned);
+        RunProgress::add(m_progress.bytesRead, file.data.size());
+        // raw bytes: CRLF line ends are dropped by readLine(), lone CRs stay in lines
+        QStringList lines;
+        QTextStream fileStream(file.data);
+        while (file.isOk && !fileStream.atEnd())
+            lines.append(fileStream.readLine());
+        file.data.clear();
+        file.isCacheDropped = onFileRead(fileIdx, lines, file.fingerprint, file.isOk, firstLinkPaths.at(fileIdx));
+    }, isSparingCache, [&](int fileIdx, const FileReader::File& file)
+    {
+        // identity comes from the reader's stat before anything is read; stat follows symlinks, so a symlinked file has the identity of its target
+        const QFileInfo& fileInfo = fileInfos.at(fileIdx);
+        if ((file.linkCount > 1) || ((file.linkCount == 1) && fileInfo.isSymLink()))
+            firstLinkPaths[fileIdx] = walk.pVisits->addFileLink({file.device, file.fingerprint.inode}, fileInfo.absoluteFilePath());
+        return firstLinkPaths.at(fileIdx).isEmpty() || !isScannedAt(fileIdx, firstLinkPaths.at(fileIdx));
+    });
+}
+
+template<typename ScanFunc>
+QList<QTreeWidgetItem*> MultiFileEditor::searchFileContents(WalkContext& walk, QDir targetDir, const FileNameMatcher& fileMatcher, const ScanFunc& scanFile)
 {
     QList<QTreeWidgetItem*> retList;
+    if (!beginWalkDir(targetDir))
+        return retList;
+    WalkFilter::DirScope walkScope(walk.walkFilter, targetDir);
     QStringList nameFilters({"*"});
     QDir::Filters filters = QDir::NoDotAndDotDot | QDir::Dirs | QDir::Files;
     QDir::SortFlags sortFlags = QDir::Name | QDir::DirsFirst;
-    QList<QFileInfo> allFileDirs = targetDir.entryInfoList(nameFilters, filters, sortFlags);
+    QList<QFileInfo> allFileDirs;
+    {
+        ScopedPhaseTimer walkTimer(ProfilePhase::Walk);
+        allFileDirs = targetDir.entryInfoList(nameFilters, filters, sortFlags);
+        walk.walkFilter.filter(allFileDirs);
+    }
+    ScopedPhaseTimer matchTimer(ProfilePhase::Match);
 
     auto iter = allFileDirs.begin();
-    // entryInfoList is guaranteed to only contain dirs and files (as set by filters) and it's guaranteed that all dirs will be placed before files (as set by sortFlags)
+    // entryInfoList is guaranteed to only contain dirs and files (as set by filters)
+    // and it's guaranteed that all dirs will be placed before files (as set by sortFlags)
     if (isRecursive)
     {
+        QStringList subdirPaths;
         for (; (iter != allFileDirs.end()) && iter->isDir(); ++iter)
-            retList.append(searchFileContentsToReplace(iter->canonicalFilePath(), filePatternRegExp, searchRegExp, replaceString));
+        {
+            if (enterSubdir(walk, *iter))
+                subdirPaths.append(iter->canonicalFilePath());
+        }
+        QVector<QList<QTreeWidgetItem*>> subdirFileItems(subdirPaths.size());
+        walkSubdirs(walk, subdirFileItems, [&](WalkContext& subdirWalk, int subdirIdx)
+        {
+            return searchFileContents(subdirWalk, subdirPaths.at(subdirIdx), fileMatcher, scanFile);
+        });
+        for (const QList<QTreeWidgetItem*>& fileItems : qAsConst(subdirFileItems))
+            retList.append(fileItems);
     }
     else
     {
@@ -917,144 +2556,643 @@ QList<QTreeWidgetItem*> MultiFileEditor::searchFileContentsToReplace(QDir target
     }
 
     // and it's guaranteed that only files will be from here on out
-    for (; iter != allFileDirs.end(); ++iter)
+    QList<QFileInfo> contentFiles;
+    const bool isDirFilesScanned = m_checkpoint.isScannedDirFiles(targetDir.path());
+    for (; (iter != allFileDirs.end()) && !isDirFilesScanned; ++iter)
     {
-        if (filePatternRegExp.match(iter->fileName()).hasMatch())
-        {
-            QTreeWidgetItem* pFileItem = new QTreeWidgetItem;
-            pFileItem->setData(0, Qt::DisplayRole, iter->canonicalFilePath());
-            pFileItem->setIcon(0, QIcon(":/Icons/file_12x15.png"));
-            QFile file(iter->canonicalFilePath());
-            if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-            {
-                pFileItem->setData(2, Qt::DisplayRole, "Failed to open file");
-                pFileItem->setIcon(2, QIcon(":/Icons/checkmark_error_16x16.png"));
-                continue;
-            }
-            pFileItem->setFlags(pFileItem->flags() | Qt::ItemIsAutoTristate);
-            auto entry = m_fileContentsEntryMap.insert(reinterpret_cast<uintptr_t>(pFileItem), {*iter, QStringList()});
-            QStringList& fileLines = entry.value().lines;
+        // metadata comes with the listing, contents are read only for files passing it and not found empty before
+        if (fileMatcher.matches(iter->fileName()) && m_metadataFilter.matches(*iter) && !m_checkpoint.isScannedFile(iter->canonicalFilePath()))
+            contentFiles.append(*iter);
+    }
+    QStringList scannedFilePaths; // without results, checkpointed once the directory is done
+    // reads complete in any order, items keep the order of names
+    QVector<QTreeWidgetItem*> fileItems(contentFiles.size(), nullptr);
+    readFilesLines(walk, contentFiles, isSparePageCache, [](int /*fileIdx*/, const QString& /*firstLinkPath*/) { return true; },
+                   [&](int fileIdx, const QStringList& lines, const FileFingerprint& fingerprint, bool isOpen, const QString& firstLinkPath)
+    {
+        if (!firstLinkPath.isEmpty())
+            return false;
+        // a file searched to a file gets rows of its matches only
+        if (!isOpen && (m_pExport != nullptr))
+            return true;
+        const QFileInfo& fileInfo = contentFiles.at(fileIdx);
+        QTreeWidgetItem* pFileItem = isOpen ? scanFile(fileInfo, lines) : newFileErrorItem(fileInfo, "Failed to open file");
+        if (pFileItem != nullptr)
+            setFileFingerprint(pFileItem, fingerprint);
+        else
+            scannedFilePaths.append(fileInfo.canonicalFilePath());
+        fileItems[fileIdx] = pFileItem;
+        return pFileItem == nullptr;
+    });
+    const int subdirItemCount = retList.size();
+    for (QTreeWidgetItem* pFileItem : qAsConst(fileItems))
+    {
+        if (pFileItem != nullptr)
+            retList.append(pFileItem);
+    }
+    checkpointDirFiles(targetDir.path(), retList.isEmpty(), retList.size() == subdirItemCount, scannedFilePaths);
+    return retList;
+}
 
-            uint lineIdx = 0;
-            QTextStream fileStream(&file);
-            while (!fileStream.atEnd())
-            {
-                QString line = fileStream.readLine();
-                auto reMatch = searchRegExp.match(line);
-                if (reMatch.hasMatch())
-                {
-                    QTreeWidgetItem* pLineItem = new QTreeWidgetItem;
-                    QString postReplaceLine = line;
-                    postReplaceLine.replace(searchRegExp, replaceString);
-                    if (isHighlight)
-                        pLineItem->setData(0, Qt::UserRole, QVariant::fromValue(ColoredText(line, lineIdx, searchRegExp, reMatch.capturedStart(0))));
-                    else
-                        pLineItem->setData(0, Qt::UserRole, QVariant::fromValue(ColoredText(line, lineIdx, searchRegExp, reMatch.capturedStart(0), QColor(), QColor())));
-                    pLineItem->setData(1, Qt::DisplayRole, postReplaceLine);
-                    pLineItem->setCheckState(0, Qt::Checked);
-                    pFileItem->addChild(pLineItem);
-                }
-                fileLines.append(line);
-                ++lineIdx;
-            }
+QList<QTreeWidgetItem*> MultiFileEditor::searchFileContentsToReplace(WalkContext& walk, QDir targetDir, const FileNameMatcher& fileMatcher, const SearchRegExp& searchRegExp)
+{
+    return searchFileContents(walk, targetDir, fileMatcher, [&](const QFileInfo& fileInfo, const QStringList& lines)
+    {
+        return scanFileLines(fileInfo, lines, searchRegExp, isHighlight);
+    });
+}
 
-            if (pFileItem->childCount() != 0)
-            {
-                retList.append(pFileItem);
-                while (fileLines.back().isEmpty())
-                    fileLines.removeLast();
-            }
-            else
+QList<QTreeWidgetItem*> MultiFileEditor::searchFileContentsToReplace(WalkContext& walk, QDir targetDir, const FileNameMatcher& fileMatcher, QString searchString, QString replaceString)
+{
+    return searchFileContents(walk, targetDir, fileMatcher, [&](const QFileInfo& fileInfo, const QStringList& lines)
+    {
+        return scanFileLines(fileInfo, lines, searchString, replaceString, caseSensitivity, isHighlight);
+    });
+}
+
+QList<QTreeWidgetItem*> MultiFileEditor::searchFileContentsToReplace(WalkContext& walk, QDir targetDir, const FileNameMatcher& fileMatcher, const ReplaceTable& replaceTable)
+{
+    return searchFileContents(walk, targetDir, fileMatcher, [&](const QFileInfo& fileInfo, const QStringList& lines)
+    {
+        return scanFileLines(fileInfo, lines, replaceTable, isHighlight);
+    });
+}
+
+void MultiFileEditor::searchPresets(std::vector<WalkContext>& walks)
+{
+    QVector<int> allSearches;
+    for (int i = 0; i < m_presetSearches.size(); ++i)
+    {
+        PresetSearch& search = m_presetSearches[i];
+        search.pGroupItem = new QTreeWidgetItem;
+        search.pGroupItem->setData(0, Qt::DisplayRole, QString("Preset \"%1\"").arg(search.presetName));
+        search.pGroupItem->setCheckState(0, Qt::Checked);
+        allSearches.append(i);
+    }
+
+    const QVector<QVector<QTreeWidgetItem*>> rootItems = walkRoots<QVector<QTreeWidgetItem*>>(walks, [&](WalkContext& walk)
+    {
+        return searchPresetsInDir(walk, walk.rootDir, allSearches);
+    });
+
+    ScopedPhaseTimer treeTimer(ProfilePhase::Tree);
+    for (int i = 0; i < m_presetSearches.size(); ++i)
+    {
+        PresetSearch& search = m_presetSearches[i];
+        if (search.actionTarget != ActionTarget::FileContents)
+        {
+            QVector<QTreeWidgetItem*> searchRootItems;
+            for (const QVector<QTreeWidgetItem*>& walkRootItems : rootItems)
+                searchRootItems.append(walkRootItems.at(i));
+            addRootItems(search.pGroupItem, walks, searchRootItems);
+        }
+        else
+        {
+            // dir item of a content search is a flat list of the root's file items
+            QVector<QList<QTreeWidgetItem*>> rootFileItems;
+            for (const QVector<QTreeWidgetItem*>& walkRootItems : rootItems)
             {
-                m_fileContentsEntryMap.erase(entry);
-                delete pFileItem;
+                QTreeWidgetItem* pRootItem = walkRootItems.at(i);
+                rootFileItems.append((pRootItem != nullptr) ? pRootItem->takeChildren() : QList<QTreeWidgetItem*>());
+                delete pRootItem;
             }
+            addRootFileItems(search.pGroupItem, walks, rootFileItems);
         }
+        ui->treeWidget_results->addTopLevelItem(search.pGroupItem);
     }
-    return retList;
 }
 
-QList<QTreeWidgetItem*> MultiFileEditor::searchFileContentsToReplace(QDir targetDir, QRegularExpression filePatternRegExp, QString searchString, QString replaceString)
+QVector<QTreeWidgetItem*> MultiFileEditor::searchPresetsInDir(WalkContext& walk, QDir targetDir, const QVector<int>& activeSearches)
 {
-    QList<QTreeWidgetItem*> retList;
+    QVector<PresetSearch>& searches = walk.presetSearches;
+    QVector<QTreeWidgetItem*> retItems(activeSearches.size(), nullptr);
+    if (!beginWalkDir(targetDir))
+        return retItems;
+    std::deque<WalkFilter::DirScope> walkScopes;
+    for (int searchIdx : activeSearches)
+        walkScopes.emplace_back(searches[searchIdx].walkFilter, targetDir);
+
     QStringList nameFilters({"*"});
     QDir::Filters filters = QDir::NoDotAndDotDot | QDir::Dirs | QDir::Files;
     QDir::SortFlags sortFlags = QDir::Name | QDir::DirsFirst;
-    QList<QFileInfo> allFileDirs = targetDir.entryInfoList(nameFilters, filters, sortFlags);
+    QList<QFileInfo> allFileDirs;
+    {
+        ScopedPhaseTimer walkTimer(ProfilePhase::Walk);
+        allFileDirs = targetDir.entryInfoList(nameFilters, filters, sortFlags);
+    }
+    ScopedPhaseTimer matchTimer(ProfilePhase::Match);
+    RunProgress::add(m_progress.filesScanned, allFileDirs.size());
+
+    auto dirItemOf = [&retItems](int activeIdx)
+    {
+        if (retItems.at(activeIdx) == nullptr)
+            retItems[activeIdx] = new QTreeWidgetItem;
+        return retItems.at(activeIdx);
+    };
+    auto addHitItem = [this](QTreeWidgetItem* pParentItem, const QFileInfo& entry, const PresetSearch& search, const QRegularExpression& highlightRegExp, int matchOffset)
+    {
+        RunProgress::add(m_progress.hits);
+        ScopedPhaseTimer treeTimer(ProfilePhase::Tree);
+        QTreeWidgetItem* pChildItem = new QTreeWidgetItem;
+        if (search.isHighlight)
+            pChildItem->setData(0, Qt::UserRole, QVariant::fromValue(ColoredText(entry.fileName(), 0, highlightRegExp, matchOffset, Qt::yellow)));
+        else
+            pChildItem->setData(0, Qt::DisplayRole, entry.fileName());
+        pChildItem->setIcon(0, entry.isDir() ? m_folderIcon : m_fileIcon);
+        pChildItem->setCheckState(0, Qt::Checked);
+        pParentItem->addChild(pChildItem);
+        addFileDirEntry(pChildItem, true, entry);
+        return pChildItem;
+    };
 
     auto iter = allFileDirs.begin();
-    // entryInfoList is guaranteed to only contain dirs and files (as set by filters)
-    // and it's guaranteed that all dirs will be placed before files (as set by sortFlags)
-    if (isRecursive)
+    // entryInfoList is guaranteed to only contain dirs and files (as set by filters) and it's guaranteed that all dirs will be placed before files (as set by sortFlags)
+    // dirs are gone through twice: first which searches descend into which of them, then, once those are walked, their items in order of names
+    struct DirSearches
     {
-        for (; (iter != allFileDirs.end()) && iter->isDir(); ++iter)
-            retList.append(searchFileContentsToReplace(iter->canonicalFilePath(), filePatternRegExp, searchString, replaceString));
-    }
-    else
+        QVector<bool> isVisible;
+        QVector<bool> isRemoveHit;
+        int subdirIdx = -1;
+    };
+    QVector<DirSearches> dirSearches;
+    QStringList subdirPaths;
+    QVector<QVector<int>> subdirSearches;  // searches which descend into each subdir
+    QVector<QVector<int>> subdirActiveIdxs; // their positions in activeSearches
+    for (auto dirIter = iter; (dirIter != allFileDirs.end()) && dirIter->isDir(); ++dirIter)
     {
-        // increment iter to skip all dirs
-        for (; (iter != allFileDirs.end()) && iter->isDir(); ++iter)
-            continue;
+        DirSearches dir;
+        dir.isVisible.fill(false, activeSearches.size());
+        dir.isRemoveHit.fill(false, activeSearches.size());
+        QVector<int> childSearches;
+        QVector<int> childActiveIdx;
+        for (int i = 0; i < activeSearches.size(); ++i)
+        {
+            PresetSearch& search = searches[activeSearches.at(i)];
+            if (search.walkFilter.isFiltered(*dirIter))
+                continue;
+            // dir subject to deletion is removed as a whole, no need to look inside
+            if ((search.actionType == ActionType::Remove) && (search.actionTarget != ActionTarget::FileContents)
+                && (under_cast(search.actionTarget & ActionTarget::Dirs) != 0) && search.fileMatcher.matches(dirIter->fileName())
+                && search.metadataFilter.matches(*dirIter))
+            {
+                dir.isRemoveHit[i] = true;
+                continue;
+            }
+            dir.isVisible[i] = true;
+            if (search.isRecursive)
+            {
+                childSearches.append(activeSearches.at(i));
+                childActiveIdx.append(i);
+            }
+        }
+
+        // searches go into a dir walked under another path by none of them, into other filesystems unless they stay on one
+        if (!childSearches.isEmpty())
+        {
+            const WalkVisits::Dir visit = walk.pVisits->enterDir(dirIter->canonicalFilePath(), walk.visitsRoot);
+            for (int j = childSearches.size() - 1; j >= 0; --j)
+            {
+                if ((visit == WalkVisits::Dir::Revisited) || ((visit == WalkVisits::Dir::NewOnOtherFileSystem) && searches.at(childSearches.at(j)).isOneFileSystem))
+                {
+                    childSearches.removeAt(j);
+                    childActiveIdx.removeAt(j);
+                }
+            }
+        }
+        if (!childSearches.isEmpty())
+        {
+            dir.subdirIdx = subdirPaths.size();
+            subdirPaths.append(dirIter->canonicalFilePath());
+            subdirSearches.append(childSearches);
+            subdirActiveIdxs.append(childActiveIdx);
+        }
+        dirSearches.append(dir);
     }
+    QVector<QVector<QTreeWidgetItem*>> subdirItems(subdirPaths.size());
+    walkSubdirs(walk, subdirItems, [&](WalkContext& subdirWalk, int subdirIdx)
+    {
+        return searchPresetsInDir(subdirWalk, QDir(subdirPaths.at(subdirIdx)), subdirSearches.at(subdirIdx));
+    });
 
-    // and it's guaranteed that only files will be from here on out
-    for (; iter != allFileDirs.end(); ++iter)
-        if (filePatternRegExp.match(iter->fileName()).hasMatch())
-        {
-            QTreeWidgetItem* pFileItem = new QTreeWidgetItem;
-            pFileItem->setData(0, Qt::DisplayRole, iter->canonicalFilePath());
-            pFileItem->setIcon(0, QIcon(":/Icons/file_12x15.png"));
-            QFile file(iter->canonicalFilePath());
-            if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    for (int dirIdx = 0; dirIdx < dirSearches.size(); ++iter, ++dirIdx)
+    {
+        const DirSearches& dir = dirSearches.at(dirIdx);
+        QVector<QTreeWidgetItem*> childItems(activeSearches.size(), nullptr);
+        if (dir.subdirIdx != -1)
+        {
+            const QVector<int>& childActiveIdx = subdirActiveIdxs.at(dir.subdirIdx);
+            for (int j = 0; j < childActiveIdx.size(); ++j)
+                childItems[childActiveIdx.at(j)] = subdirItems.at(dir.subdirIdx).at(j);
+        }
+
+        for (int i = 0; i < activeSearches.size(); ++i)
+        {
+            const PresetSearch& search = searches.at(activeSearches.at(i));
+            if (dir.isRemoveHit.at(i))
+                addHitItem(dirItemOf(i), *iter, search, search.fileMatcher.regExp(), 0);
+            if (!dir.isVisible.at(i))
+                continue;
+            QTreeWidgetItem* pChildItem = childItems.at(i);
+            if ((pChildItem != nullptr) && (pChildItem->childCount() == 0))
             {
-                pFileItem->setData(2, Qt::DisplayRole, "Failed to open file");
-                pFileItem->setIcon(2, QIcon(":/Icons/checkmark_error_16x16.png"));
+                delete pChildItem;
+                pChildItem = nullptr;
+            }
+            else if ((pChildItem != nullptr) && (search.actionTarget == ActionTarget::FileContents))
+            {
+                // file items of a content search make a flat list
+                dirItemOf(i)->addChildren(pChildItem->takeChildren());
+                delete pChildItem;
                 continue;
             }
-            pFileItem->setFlags(pFileItem->flags() | Qt::ItemIsAutoTristate);
-            auto entry = m_fileContentsEntryMap.insert(reinterpret_cast<uintptr_t>(pFileItem), {*iter, QStringList()});
-            QStringList& fileLines = entry.value().lines;
-
-            uint lineIdx = 0;
-            QTextStream fileStream(&file);
-            while (!fileStream.atEnd())
+            else if (pChildItem != nullptr)
+            {
+                pChildItem->setData(0, Qt::DisplayRole, iter->fileName());
+                pChildItem->setIcon(0, m_folderIcon);
+                dirItemOf(i)->addChild(pChildItem);
+            }
+            if ((search.actionType == ActionType::Replace) && (search.actionTarget != ActionTarget::FileContents)
+                && (under_cast(search.actionTarget & ActionTarget::Dirs) != 0))
             {
-                QString line = fileStream.readLine();
-                int index = line.indexOf(searchString, 0, caseSensitivity);
-                if (index != -1)
+                auto reMatch = search.regExp.match(iter->fileName());
+                if (reMatch.hasMatch() && search.metadataFilter.matches(*iter))
                 {
-                    QTreeWidgetItem* pLineItem = new QTreeWidgetItem;
-                    QString postReplaceLine = line;
-                    postReplaceLine.replace(searchString, replaceString, caseSensitivity);
-                    ColoredText ctext;
-                    ctext.text = line;
-                    ctext.lineNumber = lineIdx;
-                    if (isHighlight)
-                        ctext.segments.append(ColoredSegment(index, searchString.length(), Qt::yellow, Qt::black));
+                    if (pChildItem == nullptr)
+                    {
+                        pChildItem = addHitItem(dirItemOf(i), *iter, search, search.regExp, reMatch.capturedStart(0));
+                    }
                     else
-                        ctext.segments.append(ColoredSegment(0, line.length(), QColor(), QColor()));
-                    ctext.normalize();
-                    pLineItem->setData(0, Qt::UserRole, QVariant::fromValue(ctext));
-                    pLineItem->setData(1, Qt::DisplayRole, postReplaceLine);
-                    pLineItem->setCheckState(0, Qt::Checked);
-                    pFileItem->addChild(pLineItem);
+                    {
+                        RunProgress::add(m_progress.hits);
+                        pChildItem->setCheckState(0, Qt::Checked);
+                        addFileDirEntry(pChildItem, true, *iter);
+                    }
+                    pChildItem->setData(1, Qt::DisplayRole, iter->fileName().replace(search.regExp, search.replaceString));
                 }
-                fileLines.append(line);
             }
+        }
+    }
 
-            if (pFileItem->childCount() != 0)
+    // and it's guaranteed that only files will be from here on out
+    auto isContentSearched = [](const QFileInfo& entry, const PresetSearch& search)
+    {
+        return (search.actionTarget == ActionTarget::FileContents) && !search.walkFilter.isFiltered(entry) && search.fileMatcher.matches(entry.fileName())
+               && search.metadataFilter.matches(entry);
+    };
+    // file is read once for all presets searching its contents, files of the dir are read as one batch
+    bool isAnySparingCache = false;
+    for (int searchIdx : activeSearches)
+        isAnySparingCache |= (searches.at(searchIdx).actionTarget == ActionTarget::FileContents) && searches.at(searchIdx).isSparePageCache;
+    QList<QFileInfo> contentFiles;
+    QVector<int> contentFileIdxs(static_cast<int>(allFileDirs.end() - iter), -1);
+    const bool isDirFilesScanned = m_checkpoint.isScannedDirFiles(targetDir.path());
+    for (auto fileIter = iter; (fileIter != allFileDirs.end()) && !isDirFilesScanned; ++fileIter)
+    {
+        for (int searchIdx : activeSearches)
+        {
+            if (isContentSearched(*fileIter, searches.at(searchIdx)))
+            {
+                if (!m_checkpoint.isScannedFile(fileIter->canonicalFilePath()))
+                {
+                    contentFileIdxs[static_cast<int>(fileIter - iter)] = contentFiles.size();
+                    contentFiles.append(*fileIter);
+                }
+                break;
+            }
+        }
+    }
+    // file item of each active search per read file, added in order of names below
+    QVector<QVector<QTreeWidgetItem*>> contentItems(contentFiles.size());
+    QStringList scannedFilePaths; // without results of any search, checkpointed once the directory is done
+    bool isNoContentItems = true;
+    // a file met before is read again only for searches that scan it here but not under the first path's name
+    const auto isScannedAt = [&](int fileIdx, const QString& firstLinkPath)
+    {
+        const QString firstLinkName = QFileInfo(firstLinkPath).fileName();
+        return std::all_of(activeSearches.begin(), activeSearches.end(), [&](int searchIdx)
+        {
+            const PresetSearch& search = searches.at(searchIdx);
+            return !isContentSearched(contentFiles.at(fileIdx), search) || search.fileMatcher.matches(firstLinkName);
+        });
+    };
+    readFilesLines(walk, contentFiles, isAnySparingCache, isScannedAt,
+                   [&](int fileIdx, const QStringList& lines, const FileFingerprint& fingerprint, bool isOpen, const QString& firstLinkPath)
+    {
+        const QString firstLinkName = QFileInfo(firstLinkPath).fileName();
+        const QFileInfo& fileInfo = contentFiles.at(fileIdx);
+        QVector<QTreeWidgetItem*>& fileItems = contentItems[fileIdx];
+        fileItems.fill(nullptr, activeSearches.size());
+        // kept cached if any preset that read it wants it cached or has results in it
+        bool isCacheDropped = true;
+        for (int i = 0; i < activeSearches.size(); ++i)
+        {
+            const PresetSearch& search = searches.at(activeSearches.at(i));
+            if (!isContentSearched(fileInfo, search))
+                continue;
+            // scanned by this search under the path the file was first met at
+            if (!firstLinkPath.isEmpty() && search.fileMatcher.matches(firstLinkName))
             {
-                retList.append(pFileItem);
-                while (fileLines.back().isEmpty())
-                    fileLines.removeLast();
+                isCacheDropped = false;
+                continue;
             }
+            isCacheDropped &= search.isSparePageCache;
+            QTreeWidgetItem* pFileItem = nullptr;
+            if (!isOpen)
+                pFileItem = newFileErrorItem(fileInfo, "Failed to open file");
+            else if (search.isTableSearch)
+                pFileItem = scanFileLines(fileInfo, lines, search.replaceTable, search.isHighlight);
+            else if (search.isRegExpSearch)
+                pFileItem = scanFileLines(fileInfo, lines, search.contentRegExp, search.isHighlight);
             else
+                pFileItem = scanFileLines(fileInfo, lines, search.searchString, search.replaceString, search.caseSensitivity, search.isHighlight);
+            if (pFileItem != nullptr)
+            {
+                setFileFingerprint(pFileItem, fingerprint);
+                isCacheDropped = false;
+            }
+            fileItems[i] = pFileItem;
+        }
+        const bool isNoFileItems = std::all_of(fileItems.begin(), fileItems.end(), [](QTreeWidgetItem* pFileItem) { return pFileItem == nullptr; });
+        if (firstLinkPath.isEmpty() && isNoFileItems)
+            scannedFilePaths.append(fileInfo.canonicalFilePath());
+        isNoContentItems &= isNoFileItems;
+        return isCacheDropped;
+    });
+
+    for (int fileIdx = 0; iter != allFileDirs.end(); ++iter, ++fileIdx)
+    {
+        const int contentFileIdx = contentFileIdxs.at(fileIdx);
+        for (int i = 0; i < activeSearches.size(); ++i)
+        {
+            PresetSearch& search = searches[activeSearches.at(i)];
+            if (search.walkFilter.isFiltered(*iter))
+                continue;
+            if (search.actionTarget == ActionTarget::FileContents)
+            {
+                QTreeWidgetItem* pFileItem = (contentFileIdx != -1) ? contentItems.at(contentFileIdx).value(i) : nullptr;
+                if (pFileItem != nullptr)
+                    dirItemOf(i)->addChild(pFileItem);
+            }
+            else if (under_cast(search.actionTarget & ActionTarget::Files) != 0)
+            {
+                if (search.actionType == ActionType::Remove)
+                {
+                    if (search.fileMatcher.matches(iter->fileName()) && search.metadataFilter.matches(*iter))
+                        addHitItem(dirItemOf(i), *iter, search, search.fileMatcher.regExp(), 0);
+                }
+                else
+                {
+                    auto reMatch = search.regExp.match(iter->fileName());
+                    if (reMatch.hasMatch() && search.metadataFilter.matches(*iter))
+                    {
+                        QTreeWidgetItem* pChildItem = addHitItem(dirItemOf(i), *iter, search, search.regExp, reMatch.capturedStart(0));
+                        pChildItem->setData(1, Qt::DisplayRole, iter->fileName().replace(search.regExp, search.replaceString));
+                    }
+                }
+            }
+        }
+    }
+    const bool isNoDirItems = std::all_of(retItems.begin(), retItems.end(), [](QTreeWidgetItem* pItem) { return pItem == nullptr; });
+    checkpointDirFiles(targetDir.path(), isNoDirItems, isNoContentItems, scannedFilePaths);
+    return retItems;
+}
+
+template<typename LineMatcher, bool IsHighlightMatch, bool IsBudgeted>
+QTreeWidgetItem* MultiFileEditor::scanLines(const QFileInfo& fileInfo, const QStringList& lines, LineMatcher& lineMatcher)
+{
+    QTreeWidgetItem* pFileItem = nullptr;
+    QVector<LineMatch> matches;
+    QString postReplaceLine;
+    // rows of the file while searching to a file, handed over once the whole file is scanned
+    QByteArray exportRows;
+    int exportRowCount = 0;
+    QString filePath;
+    // only time spent in matching is counted, building of result items doesn't depend on the pattern
+    QElapsedTimer budgetTimer;
+    if constexpr (IsBudgeted)
+        budgetTimer.start();
+    qint64 fileMatchNs = 0;
+    for (int lineIdx = 0; lineIdx < lines.size(); ++lineIdx)
+    {
+        const QString& line = lines.at(lineIdx);
+        const qint64 lineStartNs = IsBudgeted ? budgetTimer.nsecsElapsed() : 0;
+        if constexpr (IsBudgeted)
+        {
+            // the matcher gives up by itself at whichever budget runs out first instead of finishing the line
+            qint64 deadlineNs = std::numeric_limits<qint64>::max();
+            if (m_lineTimeBudgetNs > 0)
+                deadlineNs = lineStartNs + m_lineTimeBudgetNs;
+            if (m_fileTimeBudgetNs > 0)
+                deadlineNs = qMin(deadlineNs, lineStartNs + m_fileTimeBudgetNs - fileMatchNs);
+            lineMatcher.setDeadline(&budgetTimer, deadlineNs);
+        }
+        const bool isMatched = lineMatcher.matchLine(line, matches, postReplaceLine);
+        bool isTimedOut = lineMatcher.isTimedOut();
+        if constexpr (IsBudgeted)
+        {
+            const qint64 lineMatchNs = budgetTimer.nsecsElapsed() - lineStartNs;
+            fileMatchNs += lineMatchNs;
+            isTimedOut |= ((m_lineTimeBudgetNs > 0) && (lineMatchNs > m_lineTimeBudgetNs)) || ((m_fileTimeBudgetNs > 0) && (fileMatchNs > m_fileTimeBudgetNs));
+        }
+        if (isTimedOut)
+        {
+            RunProgress::add(m_progress.timedOut);
+            if (pFileItem != nullptr)
             {
-                m_fileContentsEntryMap.erase(entry);
+                // lines of the file taken so far aren't offered, nor kept
+                int linesId = -1;
+                {
+                    QMutexLocker locker(&m_entryMapMutex);
+                    auto entryIter = m_fileContentsEntryMap.find(reinterpret_cast<uintptr_t>(pFileItem));
+                    linesId = entryIter->linesId;
+                    m_fileContentsEntryMap.erase(entryIter);
+                }
+                m_resultStore.remove(linesId);
                 delete pFileItem;
             }
+            // none of the file's rows are exported either, as none of its lines would be offered
+            if (m_pExport != nullptr)
+                return nullptr;
+            return newFileErrorItem(fileInfo, QString("Timed out at line %1").arg(lineIdx + 1));
         }
-    return retList;
+        if (!isMatched)
+            continue;
+        RunProgress::add(m_progress.hits);
+        if (m_pExport != nullptr)
+        {
+            if (filePath.isEmpty())
+                filePath = fileInfo.canonicalFilePath();
+            // replacement of a match is what's between the unchanged text before it and its replacedEnd
+            int matchEnd = 0;
+            int replacedEnd = 0;
+            for (const LineMatch& match : qAsConst(matches))
+            {
+                const int replacedStart = replacedEnd + (match.start - matchEnd);
+                m_pExport->appendRow(exportRows, filePath, lineIdx + 1, match.start + 1, line.midRef(match.start, match.end - match.start),
+                                     postReplaceLine.midRef(replacedStart, match.replacedEnd - replacedStart));
+                matchEnd = match.end;
+                replacedEnd = match.replacedEnd;
+            }
+            exportRowCount += matches.size();
+            continue;
+        }
+        ScopedPhaseTimer treeTimer(ProfilePhase::Tree);
+        if (pFileItem == nullptr)
+            pFileItem = newFileContentsItem(fileInfo, lines);
+        QTreeWidgetItem* pLineItem = new QTreeWidgetItem;
+        ColoredText ctext;
+        ctext.text = line;
+        ctext.lineNumber = lineIdx;
+        if constexpr (IsHighlightMatch)
+        {
+            for (const LineMatch& match : qAsConst(matches))
+                ctext.segments.append(ColoredSegment(match.start, match.end, Qt::yellow, Qt::black));
+        }
+        else
+        {
+            ctext.segments.append(ColoredSegment(0, line.length(), QColor(), QColor()));
+        }
+        ctext.normalize();
+        pLineItem->setData(0, Qt::UserRole, QVariant::fromValue(ctext));
+        pLineItem->setData(0, LineIndexRole, lineIdx);
+        pLineItem->setData(1, Qt::DisplayRole, postReplaceLine);
+        pLineItem->setCheckState(0, Qt::Checked);
+        pFileItem->addChild(pLineItem);
+    }
+    if (exportRowCount > 0)
+        m_pExport->addRows(exportRows, exportRowCount);
+    return pFileItem;
+}
+
+template<typename LineMatcher>
+QTreeWidgetItem* MultiFileEditor::scanFileLinesWith(const QFileInfo& fileInfo, const QStringList& lines, LineMatcher& lineMatcher, bool isHighlightMatch)
+{
+    const bool isBudgeted = (m_lineTimeBudgetNs > 0) || (m_fileTimeBudgetNs > 0);
+    if (isHighlightMatch)
+    {
+        return isBudgeted ? scanLines<LineMatcher, true, true>(fileInfo, lines, lineMatcher)
+                          : scanLines<LineMatcher, true, false>(fileInfo, lines, lineMatcher);
+    }
+    return isBudgeted ? scanLines<LineMatcher, false, true>(fileInfo, lines, lineMatcher)
+                      : scanLines<LineMatcher, false, false>(fileInfo, lines, lineMatcher);
+}
+
+QTreeWidgetItem* MultiFileEditor::scanFileLines(const QFileInfo& fileInfo, const QStringList& lines, const SearchRegExp& searchRegExp, bool isHighlightMatch)
+{
+    RegExpLineMatcher lineMatcher(searchRegExp);
+    return scanFileLinesWith(fileInfo, lines, lineMatcher, isHighlightMatch);
+}
+
+QTreeWidgetItem* MultiFileEditor::scanFileLines(const QFileInfo& fileInfo, const QStringList& lines, const QString& searchString, const QString& replaceString, Qt::CaseSensitivity searchCaseSensitivity, bool isHighlightMatch)
+{
+    if (searchCaseSensitivity == Qt::CaseSensitive)
+    {
+        LiteralLineMatcher<Qt::CaseSensitive> lineMatcher(searchString, replaceString);
+        return scanFileLinesWith(fileInfo, lines, lineMatcher, isHighlightMatch);
+    }
+    LiteralLineMatcher<Qt::CaseInsensitive> lineMatcher(searchString, replaceString);
+    return scanFileLinesWith(fileInfo, lines, lineMatcher, isHighlightMatch);
+}
+
+QTreeWidgetItem* MultiFileEditor::scanFileLines(const QFileInfo& fileInfo, const QStringList& lines, const ReplaceTable& replaceTable, bool isHighlightMatch)
+{
+    ReplaceTableLineMatcher lineMatcher(replaceTable);
+    return scanFileLinesWith(fileInfo, lines, lineMatcher, isHighlightMatch);
+}
+
+bool MultiFileEditor::beginWalkDir(const QDir& targetDir)
+{
+    RunProgress::add(m_progress.dirsVisited);
+    m_throttle.acquire(0); // applies I/O priority and waits out bandwidth overdrawn by previous directory
+    // targetDir path is canonical, as checkpoint records it
+    return !m_progress.isCanceled() && !m_checkpoint.isWalkedDir(targetDir.path());
+}
+
+bool MultiFileEditor::enterSubdir(WalkContext& walk, const QFileInfo& dirInfo)
+{
+    const WalkVisits::Dir dir = walk.pVisits->enterDir(dirInfo.canonicalFilePath(), walk.visitsRoot);
+    return (dir == WalkVisits::Dir::New) || ((dir == WalkVisits::Dir::NewOnOtherFileSystem) && !isOneFileSystem);
+}
+
+void MultiFileEditor::checkpointDirFiles(const QString& dirPath, bool isNoSubtreeResults, bool isNoFileResults, const QStringList& scannedFilePaths)
+{
+    // canceled directory may have files left unread, only those scanned are known
+    const bool isDone = !m_progress.isCanceled();
+    if (isDone && isNoSubtreeResults)
+        m_checkpoint.addWalkedDir(dirPath);
+    else if (isDone && isNoFileResults && !scannedFilePaths.isEmpty())
+        m_checkpoint.addScannedDirFiles(dirPath);
+    else
+        m_checkpoint.addScannedFiles(scannedFilePaths);
+}
+
+void MultiFileEditor::addFileDirEntry(QTreeWidgetItem* pItem, bool isExecutableTarget, const QFileInfo& fileInfo)
+{
+    QMutexLocker locker(&m_entryMapMutex);
+    m_fileDirEntryMap.insert(reinterpret_cast<uintptr_t>(pItem), {isExecutableTarget, fileInfo});
+}
+
+void MultiFileEditor::showOtherFileLinks()
+{
+    for (auto entryIter = m_fileContentsEntryMap.constBegin(); entryIter != m_fileContentsEntryMap.constEnd(); ++entryIter)
+    {
+        const QStringList otherLinks = m_walkVisits.otherLinks(entryIter->fileInfo.absoluteFilePath());
+        if (otherLinks.isEmpty())
+            continue;
+        QTreeWidgetItem* pFileItem = reinterpret_cast<QTreeWidgetItem*>(entryIter.key());
+        pFileItem->setData(2, Qt::DisplayRole, QString("Also at: %1").arg(otherLinks.join("; ")));
+        pFileItem->setToolTip(2, otherLinks.join('\n'));
+    }
+}
+
+QTreeWidgetItem* MultiFileEditor::newFileContentsItem(const QFileInfo& fileInfo, const QStringList& lines)
+{
+    QTreeWidgetItem* pFileItem = new QTreeWidgetItem;
+    pFileItem->setData(0, Qt::DisplayRole, fileInfo.canonicalFilePath());
+    pFileItem->setIcon(0, m_fileIcon);
+    pFileItem->setFlags(pFileItem->flags() | Qt::ItemIsAutoTristate);
+    // trailing empty lines are not written back
+    QStringList fileLines = lines;
+    while (!fileLines.isEmpty() && fileLines.back().isEmpty())
+        fileLines.removeLast();
+    const int linesId = m_resultStore.add(fileLines);
+    QMutexLocker locker(&m_entryMapMutex);
+    m_fileContentsEntryMap.insert(reinterpret_cast<uintptr_t>(pFileItem), {fileInfo, linesId});
+    return pFileItem;
+}
+
+void MultiFileEditor::setFileFingerprint(QTreeWidgetItem* pFileItem, const FileFingerprint& fingerprint)
+{
+    QMutexLocker locker(&m_entryMapMutex);
+    auto entryIter = m_fileContentsEntryMap.find(reinterpret_cast<uintptr_t>(pFileItem));
+    if (entryIter != m_fileContentsEntryMap.end())
+        entryIter.value().fingerprint = fingerprint;
+}
+
+QTreeWidgetItem* MultiFileEditor::newFileErrorItem(const QFileInfo& fileInfo, const QString& errorText)
+{
+    QTreeWidgetItem* pFileItem = new QTreeWidgetItem;
+    pFileItem->setData(0, Qt::DisplayRole, fileInfo.canonicalFilePath());
+    pFileItem->setIcon(0, m_fileIcon);
+    pFileItem->setData(2, Qt::DisplayRole, errorText);
+    pFileItem->setIcon(2, m_errorIcon);
+    return pFileItem;
+}
+
+QVector<QTreeWidgetItem*> MultiFileEditor::subtreeItems(QTreeWidgetItem* pRootItem)
+{
+    QVector<QTreeWidgetItem*> items;
+    QVector<QTreeWidgetItem*> stack;
+    for (int i = pRootItem->childCount() - 1; i >= 0; --i)
+        stack.append(pRootItem->child(i));
+    while (!stack.isEmpty())
+    {
+        QTreeWidgetItem* pItem = stack.takeLast();
+        items.append(pItem);
+        for (int i = pItem->childCount() - 1; i >= 0; --i)
+            stack.append(pItem->child(i));
+    }
+    return items;
 }
 
 bool MultiFileEditor::removeDirRecursively(QDir targetDir)
@@ -1,12 +1,32 @@
 #pragma once
 
 #include <array>
+#include <memory>
+#include <vector>
 
 #include <QtCore/QDir>
+#include <QtCore/QMutex>
+#include <QtCore/QTimer>
 
+#include "Checkpoint.h"
+#include "ExecuteJournal.h"
+#include "ExecutionPlan.h"
+#include "FileFingerprint.h"
+#include "FileNameMatcher.h"
+#include "FileReader.h"
+#include "MetadataFilter.h"
+#include "Progress.h"
+#include "ReplaceTable.h"
+#include "ResultStore.h"
+#include "SearchRegExp.h"
+#include "Throttle.h"
+#include "Trash.h"
 #include "Utils.h"
+#include "WalkFilter.h"
+#include "WalkVisits.h"
 #include "ui_MultiFileEditor.h"
 
+class ResultExport;
 
 struct FileDirEntry
 {
@@ -17,42 +37,256 @@ struct FileDirEntry
 struct FileContentsEntry
 {
     QFileInfo fileInfo;
-    QStringList lines;
+    int linesId = -1;              // lines of the file in MultiFileEditor::m_resultStore
+    FileFingerprint fingerprint{}; // of the file as read by search, checked before lines are written back
+};
+
+// Line items of file contents results keep ColoredText in Qt::UserRole and index of the line in FileContentsEntry::lines in this role
+constexpr int LineIndexRole = Qt::UserRole + 1;
+
+// One preset of a multi-preset run: settings resolved from MFEPreset plus the top-level item grouping its results
+struct PresetSearch
+{
+    QString presetName;
+    ActionType actionType;
+    ActionTarget actionTarget;
+    bool isRecursive;
+    bool isHighlight;
+    bool isRegExpSearch;
+    bool isSparePageCache;
+    bool isOneFileSystem;
+    Qt::CaseSensitivity caseSensitivity;
+    FileNameMatcher fileMatcher; // file pattern of Remove files\dirs and of File contents
+    QRegularExpression regExp;   // name pattern of Replace files\dirs
+    SearchRegExp contentRegExp;  // search pattern of File contents with isRegExpSearch
+    QString searchString;
+    QString replaceString;
+    bool isTableSearch = false;  // File contents searched with replaceTable instead of regExp/searchString
+    ReplaceTable replaceTable;
+    WalkFilter walkFilter;
+    MetadataFilter metadataFilter; // checked on targets after fileMatcher or regExp
+    QTreeWidgetItem* pGroupItem = nullptr;
+
+    static PresetSearch fromPreset(const MFEPreset& preset, SearchRegExp::Engine regExpEngine, int pcreMatchLimit);
+    bool isValid() const { return errorString().isEmpty(); }
+    // Why the preset can't be searched, empty if it can
+    QString errorString() const;
+};
+
+// Walk of one search root, or a branch of it walking a subdirectory on another thread (see MultiFileEditor::walkSubdirs()).
+// All a walk changes as it goes is its own: ignore files of the directories it's in, its reader and its copies of preset searches,
+// whose filters keep such a stack too. What has been visited is shared by all walks of the search.
+struct WalkContext
+{
+    QDir rootDir;
+    WalkFilter walkFilter; // of a single search, presets use their own
+    WalkVisits* pVisits = nullptr;
+    WalkVisits::Root visitsRoot;
+    std::unique_ptr<FileReader> fileReader;
+    // Copies of MultiFileEditor::m_presetSearches, their pGroupItem isn't used
+    QVector<PresetSearch> presetSearches;
 };
 
 class MultiFileEditor : public QWidget
 {
     Q_OBJECT
+    friend class MultiFileEditorBenchmark; // bench/MultiFileEditorBenchmark.cpp drives private search functions directly
 public:
     explicit MultiFileEditor(QWidget *parent = 0);
     ~MultiFileEditor();
 
+    // Command line run: loads plan from planFilePath (roots moved to rootPaths, in order, if given), executes it without asking
+    // and returns what was done in summary; false if the plan couldn't be loaded or executed. The window isn't shown.
+    bool executePlan(const QString& planFilePath, const QStringList& rootPaths, QString& summary);
+
 private:
     bool m_isSearchDone = false;
+    // Filled by walks of all roots at once while searching, guarded by m_entryMapMutex until they're done
+    QMutex m_entryMapMutex;
     QHash<uintptr_t, FileDirEntry> m_fileDirEntryMap;
     QHash<uintptr_t, FileContentsEntry> m_fileContentsEntryMap;
+    // Lines of files in m_fileContentsEntryMap, spilled to disk past a memory limit; see ResultStore.h
+    ResultStore m_resultStore;
+    // Set while searching to a file: walks write rows there and build no result items; see ResultExport.h
+    ResultExport* m_pExport = nullptr;
     std::array<int, 3> m_resultsColumnWidth;
 
     QHash<QString, MFEPreset> m_presetMap;
+    QString m_traceFilePath;
+
+    RunProgress m_progress;
+    // Limits of I/O priority, bandwidth and threads of every run; changed from its dialog while a run goes on
+    Throttle m_throttle{m_progress.isCancelRequested};
+    QDialog* m_pThrottleDialog = nullptr;
+    ProgressMeter m_progressMeter;
+    QTimer m_progressTimer;
+    bool m_isRunning = false;
+    bool m_isExecuting = false;
+    bool m_isCloseRequested = false;
+
+    // Created once on GUI thread: QIcon(path) reads the image file and is not meant to be created in worker threads
+    QIcon m_folderIcon;
+    QIcon m_fileIcon;
+    QIcon m_okIcon;
+    QIcon m_errorIcon;
+
+    // Built on GUI thread before the search and copied into the walk of each root
+    WalkFilter m_walkFilter;
+    // Size, age, owner and type conditions on targets, built with m_walkFilter and shared by walks of all roots
+    MetadataFilter m_metadataFilter;
+
+    // Non-empty while results of a multi-preset run are shown; executed in this order
+    QVector<PresetSearch> m_presetSearches;
+
+    // Regex file contents search: engine choice and time limits of matching, 0 means unlimited.
+    // A file exceeding either limit is reported as timed out and none of its lines are offered for replacement.
+    // Matching stops as soon as a limit is reached; a single PCRE match is bounded by PCRE's match limit (0 keeps PCRE's default).
+    SearchRegExp::Engine m_regExpEngine = SearchRegExp::Engine::Auto;
+    qint64 m_lineTimeBudgetNs = 0;
+    qint64 m_fileTimeBudgetNs = 0;
+    int m_pcreMatchLimit = 0;
+    // Readers of content searches, one per walk and branch, read files a directory at a time; see FileReader.h for backends.
+    // Readers of finished branches are kept for the next ones, so a branch doesn't set up a reader of its own.
+    FileReader::Backend m_ioBackend = FileReader::Backend::Auto;
+    int m_ioQueueDepth = 32;
+    qint64 m_readaheadSize = 0;
+    QMutex m_fileReadersMutex;
+    std::vector<std::unique_ptr<FileReader>> m_idleFileReaders;
+    // Directories and linked files met by walks of all roots of the search
+    WalkVisits m_walkVisits;
+
+    // Remove detaches targets into the trash of the search root and deletes them in background, see Trash.h
+    bool m_isDetachRemove = false;
+    Trash m_trash;
+
+    // Undo journal of the execute in progress (nullptr if journaling is off) and directory of the last saved one
+    bool m_isJournalEnabled = true;
+    std::unique_ptr<ExecuteJournal> m_journal;
+    QString m_lastJournalDirPath;
+
+    // Progress of the run going on, resumed on next start if the run is interrupted; see Checkpoint.h
+    bool m_isCheckpointEnabled = true;
+    Checkpoint m_checkpoint;
+    bool m_isResuming = false; // run is the resumed one: it goes on recording the checkpoint and needs no execute confirmation
+    // executePlan() run from command line: nothing is asked, checkpoint and settings of the GUI are left as they were
+    bool m_isHeadless = false;
 
     bool isRecursive = false;
     bool isHighlight = false;
+    bool isSparePageCache = false;
+    bool isOneFileSystem = false;
     Qt::CaseSensitivity caseSensitivity = Qt::CaseInsensitive;
 
 private:
-    QTreeWidgetItem* searchFileDirToRemove(QDir targetDir, QDir::Filters filters, QRegularExpression regExp);
-    QTreeWidgetItem* searchFileDirToReplace(QDir targetDir, QDir::Filters filters, QRegularExpression regExp, QString replaceString);
-    QList<QTreeWidgetItem*> searchFileContentsToReplace(QDir targetDir, QRegularExpression filePatternRegExp, QRegularExpression searchRegExp, QString replaceString);
-    QList<QTreeWidgetItem*> searchFileContentsToReplace(QDir targetDir, QRegularExpression filePatternRegExp, QString searchString, QString replaceString);
+    // Canonical paths of roots listed in dir path field, without repeated roots and roots inside other roots (walked with those)
+    QStringList searchRootPaths() const;
+    // Walk of rootPath with copies of m_walkFilter and m_presetSearches; roots of a search are entered into m_walkVisits in order
+    WalkContext newWalkContext(const QString& rootPath);
+    // Branch of walk for a subdirectory of the directory it's in now: copies of its filters and searches and an idle reader
+    WalkContext newWalkBranch(const WalkContext& walk);
+    std::unique_ptr<FileReader> takeFileReader();
+    void releaseFileReader(std::unique_ptr<FileReader> fileReader);
+    // Walks all roots at once in background and returns walkRoot(walk) of each. Roots are tasks of the global pool, each thread
+    // taking the next root once it's done with one; directories of a root spread to threads left idle, see walkSubdirs().
+    template<typename Result, typename WalkRoot>
+    QVector<Result> walkRoots(std::vector<WalkContext>& walks, const WalkRoot& walkRoot);
+    // Sets results[subdirIdx] = walkSubdir(subdirWalk, subdirIdx) for each subdirectory of the directory walk is in and returns
+    // once all are done. While the global pool has idle threads subdirectories go to them on branches of walk, the rest and
+    // the last one are walked by this thread, so a large root or a single one is searched by all threads.
+    template<typename Result, typename WalkSubdir>
+    void walkSubdirs(WalkContext& walk, QVector<Result>& results, const WalkSubdir& walkSubdir);
+    // Root item of each walk under pParentItem, rootItems may hold nullptr for roots without results
+    void addRootItems(QTreeWidgetItem* pParentItem, const std::vector<WalkContext>& walks, const QVector<QTreeWidgetItem*>& rootItems);
+    // File items of content searches under pParentItem, grouped under an item of their root if there are several roots
+    void addRootFileItems(QTreeWidgetItem* pParentItem, const std::vector<WalkContext>& walks, const QVector<QList<QTreeWidgetItem*>>& rootFileItems);
+    QTreeWidgetItem* searchFileDirToRemove(WalkContext& walk, QDir targetDir, QDir::Filters filters, const FileNameMatcher& matcher);
+    QTreeWidgetItem* searchFileDirToReplace(WalkContext& walk, QDir targetDir, QDir::Filters filters, const QRegularExpression& regExp, const QString& replaceString);
+    QList<QTreeWidgetItem*> searchFileContentsToReplace(WalkContext& walk, QDir targetDir, const FileNameMatcher& fileMatcher, const SearchRegExp& searchRegExp);
+    QList<QTreeWidgetItem*> searchFileContentsToReplace(WalkContext& walk, QDir targetDir, const FileNameMatcher& fileMatcher, QString searchString, QString replaceString);
+    QList<QTreeWidgetItem*> searchFileContentsToReplace(WalkContext& walk, QDir targetDir, const FileNameMatcher& fileMatcher, const ReplaceTable& replaceTable);
+    // Walk shared by searchFileContentsToReplace overloads: scanFile(fileInfo, lines) is called for every file accepted by fileMatcher
+    template<typename ScanFunc>
+    QList<QTreeWidgetItem*> searchFileContents(WalkContext& walk, QDir targetDir, const FileNameMatcher& fileMatcher, const ScanFunc& scanFile);
+    // Single walk for all searches listed in activeSearches (indices in walk.presetSearches); returns dir item of each of them, nullptr if it has no results.
+    // Dir item of a content search holds file items of the whole subtree, in order of the walk.
+    QVector<QTreeWidgetItem*> searchPresetsInDir(WalkContext& walk, QDir targetDir, const QVector<int>& activeSearches);
+    void searchPresets(std::vector<WalkContext>& walks);
+    // Reads files for content search as one batch; onFileRead(fileIdx, lines, fingerprint, isOpen, firstLinkPath) is called for
+    // each of them in order of completion, isOpen is false if the file can't be read. firstLinkPath is set if the file was met
+    // before under another path (hard link, symlink): it's been scanned there already, unless searches differ between the paths.
+    // Such a file isn't read at all if isScannedAt(fileIdx, firstLinkPath) says so; onFileRead gets it with no lines then.
+    // With isSparingCache the file is dropped from the page cache afterwards if onFileRead returns true (nothing in it is going to be executed).
+    template<typename IsScannedAt, typename OnFileRead>
+    void readFilesLines(WalkContext& walk, const QList<QFileInfo>& fileInfos, bool isSparingCache, const IsScannedAt& isScannedAt,
+                        const OnFileRead& onFileRead);
+    // Counts targetDir as visited and throttles the walk; false if it's not to be walked: the run is canceled or a resumed checkpoint has it done
+    bool beginWalkDir(const QDir& targetDir);
+    // Whether the walk goes into subdirectory dirInfo: not if it was walked under another path or is on another filesystem with isOneFileSystem
+    bool enterSubdir(WalkContext& walk, const QFileInfo& dirInfo);
+    // Marks pItem as a target (or not) in m_fileDirEntryMap; called by walks of all roots
+    void addFileDirEntry(QTreeWidgetItem* pItem, bool isExecutableTarget, const QFileInfo& fileInfo);
+    // Checkpoints a content searched directory once it's done: its whole subtree if that has no results, otherwise
+    // all its files at once if none of them has results, otherwise each of its files scanned without results
+    void checkpointDirFiles(const QString& dirPath, bool isNoSubtreeResults, bool isNoFileResults, const QStringList& scannedFilePaths);
+    // Other paths of hard-linked or symlinked files with results go to their Indication column
+    void showOtherFileLinks();
+    // Fingerprint of read file goes to entry of its results, if there are any
+    void setFileFingerprint(QTreeWidgetItem* pFileItem, const FileFingerprint& fingerprint);
+    // Returns item of the file with an item per matched line, or nullptr if nothing matched or matches went to m_pExport
+    QTreeWidgetItem* scanFileLines(const QFileInfo& fileInfo, const QStringList& lines, const SearchRegExp& searchRegExp, bool isHighlightMatch);
+    QTreeWidgetItem* scanFileLines(const QFileInfo& fileInfo, const QStringList& lines, const QString& searchString, const QString& replaceString, Qt::CaseSensitivity searchCaseSensitivity, bool isHighlightMatch);
+    QTreeWidgetItem* scanFileLines(const QFileInfo& fileInfo, const QStringList& lines, const ReplaceTable& replaceTable, bool isHighlightMatch);
+    // Picks instantiation of scanLines() for highlight mode and whether time budget is set
+    template<typename LineMatcher>
+    QTreeWidgetItem* scanFileLinesWith(const QFileInfo& fileInfo, const QStringList& lines, LineMatcher& lineMatcher, bool isHighlightMatch);
+    // Line scanning kernel of all content searches, see LineMatchers.h; options are template parameters to keep branches out of the loop
+    template<typename LineMatcher, bool IsHighlightMatch, bool IsBudgeted>
+    QTreeWidgetItem* scanLines(const QFileInfo& fileInfo, const QStringList& lines, LineMatcher& lineMatcher);
+    QTreeWidgetItem* newFileContentsItem(const QFileInfo& fileInfo, const QStringList& lines);
+    QTreeWidgetItem* newFileErrorItem(const QFileInfo& fileInfo, const QString& errorText);
+    // Executes checked results under pRootItem and returns summary message.
+    // editedFiles holds lines (ids in m_resultStore) of files written earlier in the same run, so that later presets keep those edits.
+    // step is the index of the preset (0 for a single search) that checkpoint records entries under.
+    QString executeResults(ActionType actionType, ActionTarget actionTarget, QTreeWidgetItem* pRootItem, QHash<QString, int>& editedFiles, int step);
+    // All descendants of pRootItem in pre-order
+    static QVector<QTreeWidgetItem*> subtreeItems(QTreeWidgetItem* pRootItem);
     bool removeDirRecursively(QDir targetDir);
+    // Runs func in a worker thread while GUI stays responsive and shows live m_progress; returns when func is done.
+    // executeTaskCount > 0 marks an execute run with known total, which is shown with progress bar and ETA.
+    void runInBackground(const std::function<void()>& func, qint64 executeTaskCount = 0);
+    // Journal of execute: started before first action, saved after last one; returns false if user cancels execute
+    // errorText tells why an execute can't go on
+    bool beginJournal(QString& errorText);
+    QString finishJournal();
+    void discardJournal(const QString& journalDirPath);
+    void setLastJournalDirPath(const QString& journalDirPath);
+    // Settings fields as a preset and back; presetName is left empty
+    MFEPreset presetFromUi() const;
+    void applyPreset(const MFEPreset& preset);
+    // Starts checkpoint of a search with current settings and presets, if checkpoints are enabled
+    void beginCheckpoint();
+    // Leaves checked only results a resumed execute has yet to do, with lines the interrupted one had checked
+    void applyExecuteCursor();
+    // Checked results as a plan, a step per preset (one for a single search)
+    // Entries outside all search roots (reached through a symlink) can't be put in a plan, they're counted in outsideCount
+    ExecutionPlan planFromResults(int& outsideCount) const;
+    ExecutionPlan::Step planStep(const ExecutionPlan& plan, const QString& presetName, ActionType actionType, ActionTarget actionTarget, QTreeWidgetItem* pRootItem, int& outsideCount) const;
+    // Shows plan as results ready to execute, in place of current ones; returns summary of its verification
+    QString applyPlan(const ExecutionPlan& plan);
+    // Item with results of step that are still as planned, and those that aren't with the reason; mismatchCount counts the latter
+    QTreeWidgetItem* verifyPlanStep(const ExecutionPlan& plan, const ExecutionPlan::Step& step, int& mismatchCount);
 
 private slots:
     void onActionCombosActivated();
     void getExistingDirectory();
+    void getReplaceTableFile();
+    void editReplaceTable();
 
     bool checkDirectoryValidity();
     bool checkFilePatternValidity();
     bool checkSearchReplaceValidity();
+    bool checkReplaceTableValidity();
+    bool checkMetadataValidity();
     void checkAllValidity();
 
     void savePreset();
@@ -60,9 +294,20 @@ private slots:
     void fillPreset(const QString& presetName);
     void loadSettings();
     void loadAllPresets();
+    void runPresets();
+    void offerResume();
 
     void reset();
-    void execute();
+    // Returns why the execute didn't start, empty if it ran or was declined
+    QString execute();
+    // Search with current settings whose results are streamed to a file picked by user instead of the results tree
+    void searchToFile();
+    // Checked results saved to be executed later, see ExecutionPlan.h
+    void savePlan();
+    void loadPlan();
+    void undoLastExecute();
+    void showThrottleDialog();
+    void updateProgress();
 
     void closeEvent(QCloseEvent* event) final;
 
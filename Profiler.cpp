@@ -0,0 +1,228 @@
+#include "Profiler.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+
+std::atomic<bool> Profiler::s_isEnabled{false};
+std::atomic<bool> Profiler::s_isTraceEnabled{false};
+std::array<std::atomic<qint64>, static_cast<int>(ProfilePhase::Count)> Profiler::s_phaseNs{};
+
+namespace {
+
+struct TraceEvent
+{
+    ProfilePhase phase;
+    qint64 startNs;
+    qint64 durationNs;
+    QString detail;
+};
+
+struct TraceBuffer
+{
+    int tid = 0;
+    QString threadName;
+    QVector<TraceEvent> events;
+};
+
+QMutex s_traceMutex;                 // guards s_liveBuffers, s_retiredBuffers and contents of every buffer
+QList<TraceBuffer*> s_liveBuffers;
+QList<TraceBuffer> s_retiredBuffers; // buffers of threads that already finished
+std::atomic<int> s_nextTid{1};
+
+// Registers thread's buffer on first use and keeps its events after the thread finishes
+class ThreadTraceRegistration
+{
+public:
+    ThreadTraceRegistration()
+    {
+        buffer.tid = s_nextTid.fetch_add(1, std::memory_order_relaxed);
+        QThread* thread = QThread::currentThread();
+        if ((QCoreApplication::instance() != nullptr) && (thread == QCoreApplication::instance()->thread()))
+            buffer.threadName = "main";
+        else if (!thread->objectName().isEmpty())
+            buffer.threadName = thread->objectName();
+        else
+            buffer.threadName = QString("worker %1").arg(buffer.tid);
+        QMutexLocker locker(&s_traceMutex);
+        s_liveBuffers.append(&buffer);
+    }
+    ~ThreadTraceRegistration()
+    {
+        QMutexLocker locker(&s_traceMutex);
+        s_liveBuffers.removeOne(&buffer);
+        if (!buffer.events.isEmpty())
+            s_retiredBuffers.append(buffer);
+    }
+
+    TraceBuffer buffer;
+};
+
+TraceBuffer& threadTraceBuffer()
+{
+    thread_local ThreadTraceRegistration registration;
+    return registration.buffer;
+}
+
+thread_local ScopedPhaseTimer* t_currentScope = nullptr;
+
+qint64 clockNs()
+{
+    static const QElapsedTimer clock = [](){ QElapsedTimer timer; timer.start(); return timer; }();
+    return clock.nsecsElapsed();
+}
+
+QByteArray jsonEscaped(const QString& string)
+{
+    QByteArray result;
+    const QByteArray utf8 = string.toUtf8();
+    result.reserve(utf8.size() + 2);
+    for (char c : utf8)
+    {
+        switch (c)
+        {
+        case '"':  result.append("\\\""); break;
+        case '\\': result.append("\\\\"); break;
+        case '\n': result.append("\\n"); break;
+        case '\r': result.append("\\r"); break;
+        case '\t': result.append("\\t"); break;
+        default:
+            if ((static_cast<uchar>(c) < 0x20))
+                result.append("\\u00").append(QByteArray::number(static_cast<uchar>(c), 16).rightJustified(2, '0'));
+            else
+                result.append(c);
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+void Profiler::setEnabled(bool isEnabled)
+{
+    s_isEnabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+void Profiler::setTraceEnabled(bool isEnabled)
+{
+    s_isTraceEnabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+void Profiler::reset()
+{
+    for (auto& phaseNs : s_phaseNs)
+        phaseNs.store(0, std::memory_order_relaxed);
+    QMutexLocker locker(&s_traceMutex);
+    for (TraceBuffer* buffer : qAsConst(s_liveBuffers))
+        buffer->events.clear();
+    s_retiredBuffers.clear();
+}
+
+qint64 Profiler::phaseNs(ProfilePhase phase)
+{
+    return s_phaseNs[static_cast<int>(phase)].load(std::memory_order_relaxed);
+}
+
+QString Profiler::summary()
+{
+    QStringList parts;
+    for (int i = 0; i < static_cast<int>(ProfilePhase::Count); ++i)
+    {
+        const qint64 ns = s_phaseNs[i].load(std::memory_order_relaxed);
+        if (ns > 0)
+            parts.append(QString("%1 %2s").arg(phaseName(static_cast<ProfilePhase>(i))).arg(static_cast<double>(ns) / 1e9, 0, 'f', 2));
+    }
+    return parts.join(", ");
+}
+
+bool Profiler::writeChromeTrace(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray json("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool isFirst = true;
+    auto appendBuffer = [&](const TraceBuffer& buffer)
+    {
+        const QByteArray tid = QByteArray::number(buffer.tid);
+        json.append(isFirst ? "" : ",\n");
+        isFirst = false;
+        json.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":").append(pid)
+            .append(",\"tid\":").append(tid)
+            .append(",\"args\":{\"name\":\"").append(jsonEscaped(buffer.threadName)).append("\"}}");
+        for (const TraceEvent& event : buffer.events)
+        {
+            json.append(",\n{\"name\":\"").append(phaseName(event.phase))
+                .append("\",\"cat\":\"qMultiFileEditor\",\"ph\":\"X\",\"ts\":").append(QByteArray::number(static_cast<double>(event.startNs) / 1000.0, 'f', 3))
+                .append(",\"dur\":").append(QByteArray::number(static_cast<double>(event.durationNs) / 1000.0, 'f', 3))
+                .append(",\"pid\":").append(pid)
+                .append(",\"tid\":").append(tid);
+            if (!event.detail.isEmpty())
+                json.append(",\"args\":{\"detail\":\"").append(jsonEscaped(event.detail)).append("\"}");
+            json.append("}");
+        }
+        if (json.size() > (1 << 20))
+        {
+            file.write(json);
+            json.clear();
+        }
+    };
+
+    {
+        QMutexLocker locker(&s_traceMutex);
+        for (const TraceBuffer* buffer : qAsConst(s_liveBuffers))
+            if (!buffer->events.isEmpty())
+                appendBuffer(*buffer);
+        for (const TraceBuffer& buffer : qAsConst(s_retiredBuffers))
+            appendBuffer(buffer);
+    }
+    json.append("\n]}\n");
+    file.write(json);
+    return file.error() == QFileDevice::NoError;
+}
+
+const char* Profiler::phaseName(ProfilePhase phase)
+{
+    switch (phase)
+    {
+    case ProfilePhase::Walk:    return "walk";
+    case ProfilePhase::Read:    return "read";
+    case ProfilePhase::Match:   return "match";
+    case ProfilePhase::Tree:    return "tree";
+    case ProfilePhase::Expand:  return "expand";
+    case ProfilePhase::Resize:  return "resize";
+    case ProfilePhase::Execute: return "execute";
+    default:                    return "unknown";
+    }
+}
+
+void Profiler::beginScope(ScopedPhaseTimer* timer)
+{
+    timer->m_isActive = true;
+    timer->m_parent = t_currentScope;
+    t_currentScope = timer;
+    timer->m_startNs = clockNs();
+}
+
+void Profiler::endScope(ScopedPhaseTimer* timer)
+{
+    const qint64 durationNs = clockNs() - timer->m_startNs;
+    s_phaseNs[static_cast<int>(timer->m_phase)].fetch_add(durationNs - timer->m_childNs, std::memory_order_relaxed);
+    if (timer->m_parent != nullptr)
+        timer->m_parent->m_childNs += durationNs;
+    t_currentScope = timer->m_parent;
+
+    if (isTraceEnabled())
+    {
+        TraceBuffer& buffer = threadTraceBuffer();
+        QMutexLocker locker(&s_traceMutex);
+        buffer.events.append({timer->m_phase, timer->m_startNs, durationNs, timer->m_detail});
+    }
+}
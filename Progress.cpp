@@ -0,0 +1,110 @@
+#include "Progress.h"
+
+
+void RunProgress::reset()
+{
+    dirsVisited.store(0, std::memory_order_relaxed);
+    filesScanned.store(0, std::memory_order_relaxed);
+    bytesRead.store(0, std::memory_order_relaxed);
+    hits.store(0, std::memory_order_relaxed);
+    timedOut.store(0, std::memory_order_relaxed);
+    tasksDone.store(0, std::memory_order_relaxed);
+    entriesRemoved.store(0, std::memory_order_relaxed);
+    tasksTotal.store(0, std::memory_order_relaxed);
+    isCancelRequested.store(false, std::memory_order_relaxed);
+}
+
+void ProgressMeter::start()
+{
+    m_timer.start();
+    m_lastNs = 0;
+    m_lastFiles = 0;
+    m_lastBytes = 0;
+    m_lastTasks = 0;
+}
+
+QString ProgressMeter::searchText(const RunProgress& progress)
+{
+    const qint64 nowNs = m_timer.nsecsElapsed();
+    const qint64 files = progress.filesScanned.load(std::memory_order_relaxed);
+    const qint64 bytes = progress.bytesRead.load(std::memory_order_relaxed);
+    const double seconds = qMax(static_cast<double>(nowNs - m_lastNs) / 1e9, 1e-3);
+    const double filesPerSec = static_cast<double>(files - m_lastFiles) / seconds;
+    const double bytesPerSec = static_cast<double>(bytes - m_lastBytes) / seconds;
+    m_lastNs = nowNs;
+    m_lastFiles = files;
+    m_lastBytes = bytes;
+
+    QString text = QString("Searching: %1 dirs, %2 files")
+                   .arg(progress.dirsVisited.load(std::memory_order_relaxed))
+                   .arg(files);
+    if (bytes > 0)
+        text.append(QString(", %1").arg(formatBytes(bytes)));
+    text.append(QString(", %1 hits | %2 files/s")
+                .arg(progress.hits.load(std::memory_order_relaxed))
+                .arg(filesPerSec, 0, 'f', 0));
+    if (bytes > 0)
+        text.append(QString(", %1/s").arg(formatBytes(static_cast<qint64>(bytesPerSec))));
+    return text;
+}
+
+QString ProgressMeter::executeText(const RunProgress& progress)
+{
+    const qint64 nowNs = m_timer.nsecsElapsed();
+    const qint64 done = progress.tasksDone.load(std::memory_order_relaxed);
+    const qint64 total = progress.tasksTotal.load(std::memory_order_relaxed);
+    const double seconds = qMax(static_cast<double>(nowNs - m_lastNs) / 1e9, 1e-3);
+    const double tasksPerSec = static_cast<double>(done - m_lastTasks) / seconds;
+    m_lastNs = nowNs;
+    m_lastTasks = done;
+
+    QString text = QString("Executing: %1 / %2 (%3%) | %4 entries/s")
+                   .arg(done)
+                   .arg(total)
+                   .arg((total > 0) ? (done * 100 / total) : 0)
+                   .arg(tasksPerSec, 0, 'f', 0);
+    const qint64 removed = progress.entriesRemoved.load(std::memory_order_relaxed);
+    if (removed > 0)
+        text.append(QString(", %1 removed").arg(removed));
+    if ((done > 0) && (done < total))
+    {
+        const double averagePerSec = static_cast<double>(done) / qMax(static_cast<double>(nowNs) / 1e9, 1e-3);
+        text.append(QString(", ETA %1").arg(formatDuration(static_cast<qint64>(static_cast<double>(total - done) / averagePerSec))));
+    }
+    return text;
+}
+
+QString ProgressMeter::searchSummary(const RunProgress& progress)
+{
+    const qint64 bytes = progress.bytesRead.load(std::memory_order_relaxed);
+    QString text = QString("Searched %1 dirs, %2 files")
+                   .arg(progress.dirsVisited.load(std::memory_order_relaxed))
+                   .arg(progress.filesScanned.load(std::memory_order_relaxed));
+    if (bytes > 0)
+        text.append(QString(", %1").arg(formatBytes(bytes)));
+    text.append(QString(": %1 hits").arg(progress.hits.load(std::memory_order_relaxed)));
+    const qint64 timedOut = progress.timedOut.load(std::memory_order_relaxed);
+    if (timedOut > 0)
+        text.append(QString(", %1 files timed out").arg(timedOut));
+    if (progress.isCanceled())
+        text.append(" (canceled)");
+    return text;
+}
+
+QString ProgressMeter::formatBytes(qint64 bytes)
+{
+    if (bytes < 1024)
+        return QString("%1 B").arg(bytes);
+    if (bytes < 1024 * 1024)
+        return QString("%1 KB").arg(static_cast<double>(bytes) / 1024.0, 0, 'f', 1);
+    if (bytes < 1024LL * 1024 * 1024)
+        return QString("%1 MB").arg(static_cast<double>(bytes) / (1024.0 * 1024.0), 0, 'f', 1);
+    return QString("%1 GB").arg(static_cast<double>(bytes) / (1024.0 * 1024.0 * 1024.0), 0, 'f', 2);
+}
+
+QString ProgressMeter::formatDuration(qint64 seconds)
+{
+    if (seconds >= 3600)
+        return QString("%1:%2:%3").arg(seconds / 3600).arg((seconds / 60) % 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0'));
+    return QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QString>
+
+/* Live counters of a running search or execute.
+ * Workers bump them with relaxed atomic adds (no ordering, no locks), GUI thread samples them by timer.
+ * Counters are only ever read for display, so a sample being a few increments behind is fine. */
+struct RunProgress
+{
+    std::atomic<qint64> dirsVisited{0};
+    std::atomic<qint64> filesScanned{0};
+    std::atomic<qint64> bytesRead{0};
+    std::atomic<qint64> hits{0};
+    std::atomic<qint64> timedOut{0};   // files skipped for exceeding regex time budget
+    std::atomic<qint64> tasksDone{0};  // execute only
+    std::atomic<qint64> entriesRemoved{0}; // execute only; files and dirs inside removed trees included
+    std::atomic<qint64> tasksTotal{0}; // execute only; known before execute starts, so ETA can be estimated
+    std::atomic<bool> isCancelRequested{false};
+
+    static void add(std::atomic<qint64>& counter, qint64 value = 1) { counter.fetch_add(value, std::memory_order_relaxed); }
+    bool isCanceled() const { return isCancelRequested.load(std::memory_order_relaxed); }
+    void reset();
+};
+
+/* Turns successive samples of RunProgress into human-readable text with rates and ETA.
+ * Rates are measured between two consecutive samples, so a stall (e.g. slow NFS mount or pathological regex) shows immediately;
+ * ETA uses average rate since start as it's more stable. */
+class ProgressMeter
+{
+public:
+    void start();
+    // e.g. "Searching: 120 dirs, 3400 files, 56.7 MB, 89 hits | 1200 files/s, 20.5 MB/s"
+    QString searchText(const RunProgress& progress);
+    // e.g. "Executing: 1200 / 5000 (24%) | 300 entries/s, ETA 0:13"
+    QString executeText(const RunProgress& progress);
+    // Totals of a finished search, e.g. "Searched 120 dirs, 3400 files, 56.7 MB: 89 hits"
+    static QString searchSummary(const RunProgress& progress);
+
+    static QString formatBytes(qint64 bytes);
+    static QString formatDuration(qint64 seconds);
+
+private:
+    QElapsedTimer m_timer;
+    qint64 m_lastNs = 0;
+    qint64 m_lastFiles = 0;
+    qint64 m_lastBytes = 0;
+    qint64 m_lastTasks = 0;
+};
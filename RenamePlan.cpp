@@ -0,0 +1,359 @@
+#include "RenamePlan.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QThread>
+
+#include "Throttle.h"
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct RenamePlan::Group
+{
+    QString dirPath;
+    QVector<int> opIdxs;
+    int dirOpIdx = -1; // operation renaming this directory itself, waits for all operations of the group
+    std::atomic<int> remainingCount{0};
+    QMutex mutex;
+    int dirFd = -1;    // opened by first started operation, closed by last finished one
+};
+
+struct RenamePlan::Node
+{
+    int groupIdx = -1;
+    int subgroupIdx = -1;   // group of entries inside renamed directory
+    int predecessorIdx = -1; // operation renaming away the entry holding new name now
+    int dependentIdx = -1;
+    bool isSettled = false; // done before execution starts: collision or nothing to rename
+    std::atomic<int> pendingCount{0};
+};
+
+namespace
+{
+
+QString entryPath(const QString& dirPath, const QString& name)
+{
+    return dirPath.endsWith('/') ? (dirPath + name) : QString("%1/%2").arg(dirPath, name);
+}
+
+// Key of name in hash index: names differing in case only are the same entry on case-insensitive filesystems
+QString nameKey(const QString& name)
+{
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+    return name.toCaseFolded();
+#else
+    return name;
+#endif
+}
+
+bool isValidName(const QString& name)
+{
+    return !name.isEmpty() && (name != ".") && (name != "..") && !name.contains('/')
+#ifdef Q_OS_WIN
+           && !name.contains('\\')
+#endif
+           ;
+}
+
+#ifdef Q_OS_UNIX
+// Returns 0 or errno; existing newName is never replaced
+int renameNoReplace(int dirFd, const QByteArray& oldName, const QByteArray& newName, bool isSameKey)
+{
+#ifdef RENAME_NOREPLACE
+    if (::renameat2(dirFd, oldName.constData(), dirFd, newName.constData(), RENAME_NOREPLACE) == 0)
+        return 0;
+    if ((errno != EINVAL) && (errno != ENOSYS)) // else kernel or filesystem doesn't support the flag
+        return errno;
+#endif
+    // case-only rename finds entry itself on case-insensitive filesystems
+    struct stat entryStat;
+    if (!isSameKey && (::fstatat(dirFd, newName.constData(), &entryStat, AT_SYMLINK_NOFOLLOW) == 0))
+        return EEXIST;
+    return (::renameat(dirFd, oldName.constData(), dirFd, newName.constData()) == 0) ? 0 : errno;
+}
+#endif
+
+} // namespace
+
+
+RenamePlan::RenamePlan(std::atomic<qint64>& doneCount, const std::atomic<bool>& isCancelRequested)
+    : m_doneCount(doneCount)
+    , m_isCancelRequested(isCancelRequested)
+{
+    // renaming is bound by metadata latency rather than CPU, same as removing
+    m_pool.setMaxThreadCount(2 * QThread::idealThreadCount());
+}
+
+RenamePlan::~RenamePlan()
+{
+    m_pool.waitForDone();
+    if (m_pThrottle != nullptr)
+        m_pThrottle->detach(&m_pool);
+#ifdef Q_OS_UNIX
+    for (const std::unique_ptr<Group>& pGroup : m_groups)
+    {
+        if (pGroup->dirFd != -1)
+            ::close(pGroup->dirFd);
+    }
+#endif
+}
+
+void RenamePlan::setThrottle(Throttle* pThrottle)
+{
+    if (m_pThrottle != nullptr)
+        m_pThrottle->detach(&m_pool);
+    m_pThrottle = pThrottle;
+    if (m_pThrottle != nullptr)
+        m_pThrottle->attach(&m_pool);
+}
+
+int RenamePlan::add(const QString& parentPath, const QString& oldName, const QString& newName)
+{
+    Operation operation;
+    operation.parentPath = parentPath;
+    operation.oldName = oldName;
+    operation.newName = newName;
+    m_operations.append(operation);
+    return m_operations.size() - 1;
+}
+
+void RenamePlan::execute()
+{
+    buildGroups();
+    for (const std::unique_ptr<Group>& pGroup : m_groups)
+        findCollisions(*pGroup);
+
+    // every dependency count is set before the first operation starts and may decrement one
+    int runCount = 0;
+    for (int opIdx = 0; opIdx < m_operations.size(); ++opIdx)
+    {
+        const Node& node = m_nodes[opIdx];
+        if (node.isSettled)
+        {
+            m_doneCount.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        ++runCount;
+        m_groups[node.groupIdx]->remainingCount.fetch_add(1, std::memory_order_relaxed);
+        if (node.predecessorIdx != -1)
+            m_nodes[node.predecessorIdx].dependentIdx = opIdx;
+    }
+    QVector<int> readyOpIdxs;
+    for (int opIdx = 0; opIdx < m_operations.size(); ++opIdx)
+    {
+        Node& node = m_nodes[opIdx];
+        if (node.isSettled)
+            continue;
+        int pendingCount = (node.predecessorIdx != -1) ? 1 : 0;
+        if (node.subgroupIdx != -1)
+        {
+            Group& subgroup = *m_groups[node.subgroupIdx];
+            subgroup.dirOpIdx = opIdx;
+            pendingCount += subgroup.remainingCount.load(std::memory_order_relaxed);
+        }
+        node.pendingCount.store(pendingCount, std::memory_order_relaxed);
+        if (pendingCount == 0)
+            readyOpIdxs.append(opIdx);
+    }
+    for (int opIdx : qAsConst(readyOpIdxs))
+        start(opIdx);
+    m_finished.acquire(runCount);
+}
+
+void RenamePlan::buildGroups()
+{
+    m_nodes = std::vector<Node>(m_operations.size());
+    QHash<QString, int> groupIdxByPath;
+    for (int opIdx = 0; opIdx < m_operations.size(); ++opIdx)
+    {
+        const QString& parentPath = m_operations.at(opIdx).parentPath;
+        auto groupIter = groupIdxByPath.find(parentPath);
+        if (groupIter == groupIdxByPath.end())
+        {
+            groupIter = groupIdxByPath.insert(parentPath, static_cast<int>(m_groups.size()));
+            m_groups.emplace_back(new Group);
+            m_groups.back()->dirPath = parentPath;
+        }
+        m_nodes[opIdx].groupIdx = groupIter.value();
+        m_groups[groupIter.value()]->opIdxs.append(opIdx);
+    }
+    for (int opIdx = 0; opIdx < m_operations.size(); ++opIdx)
+    {
+        const Operation& operation = m_operations.at(opIdx);
+        m_nodes[opIdx].subgroupIdx = groupIdxByPath.value(entryPath(operation.parentPath, operation.oldName), -1);
+    }
+}
+
+void RenamePlan::findCollisions(Group& group)
+{
+    // entries that actually move, by old name; the rest keep their names
+    QHash<QString, int> opIdxByOldKey;
+    for (int opIdx : qAsConst(group.opIdxs))
+    {
+        Operation& operation = m_operations[opIdx];
+        if (operation.newName == operation.oldName)
+        {
+            m_nodes[opIdx].isSettled = true;
+            operation.isDone = true;
+            operation.isOk = true;
+        }
+        else if (!isValidName(operation.newName))
+        {
+            setCollision(opIdx, QString("\"%1\" is not a valid name").arg(operation.newName));
+        }
+        else
+        {
+            opIdxByOldKey.insert(nameKey(operation.oldName), opIdx);
+        }
+    }
+
+    QHash<QString, int> opIdxByNewKey;
+    for (int opIdx : qAsConst(group.opIdxs))
+    {
+        if (m_nodes[opIdx].isSettled)
+            continue;
+        const Operation& operation = m_operations.at(opIdx);
+        const QString newKey = nameKey(operation.newName);
+        auto otherIter = opIdxByNewKey.constFind(newKey);
+        if (otherIter != opIdxByNewKey.constEnd())
+        {
+            const int otherOpIdx = otherIter.value();
+            setCollision(otherOpIdx, QString("\"%1\" is renamed to the same name").arg(operation.oldName));
+            setCollision(opIdx, QString("\"%1\" is renamed to the same name").arg(m_operations.at(otherOpIdx).oldName));
+            continue;
+        }
+        opIdxByNewKey.insert(newKey, opIdx);
+        if (newKey == nameKey(operation.oldName))
+            continue;
+        const int holderOpIdx = opIdxByOldKey.value(newKey, -1);
+        if (holderOpIdx != -1)
+            m_nodes[opIdx].predecessorIdx = holderOpIdx;
+        else if (QFileInfo(entryPath(group.dirPath, operation.newName)).exists() || QFileInfo(entryPath(group.dirPath, operation.newName)).isSymLink())
+            setCollision(opIdx, QString("\"%1\" already exists").arg(operation.newName));
+    }
+
+    // each entry has at most one predecessor, so waiting chains are simple paths or cycles
+    QHash<int, int> walkIdByOpIdx;
+    for (int opIdx : qAsConst(group.opIdxs))
+    {
+        int curOpIdx = opIdx;
+        while ((curOpIdx != -1) && !walkIdByOpIdx.contains(curOpIdx))
+        {
+            walkIdByOpIdx.insert(curOpIdx, opIdx);
+            curOpIdx = m_nodes[curOpIdx].predecessorIdx;
+        }
+        if ((curOpIdx == -1) || (walkIdByOpIdx.value(curOpIdx) != opIdx))
+            continue;
+        int cycleOpIdx = curOpIdx;
+        do
+        {
+            setCollision(cycleOpIdx, "Renames form a cycle");
+            cycleOpIdx = m_nodes[cycleOpIdx].predecessorIdx;
+        } while (cycleOpIdx != curOpIdx);
+    }
+
+    // whoever waits for a collided entry to free its name would wait forever
+    bool isChanged = true;
+    while (isChanged)
+    {
+        isChanged = false;
+        for (int opIdx : qAsConst(group.opIdxs))
+        {
+            const int predecessorIdx = m_nodes[opIdx].predecessorIdx;
+            if (!m_nodes[opIdx].isSettled && (predecessorIdx != -1) && m_nodes[predecessorIdx].isSettled)
+            {
+                setCollision(opIdx, QString("\"%1\" keeps this name, it can't be renamed").arg(m_operations.at(predecessorIdx).oldName));
+                isChanged = true;
+            }
+        }
+    }
+}
+
+void RenamePlan::setCollision(int opIdx, const QString& errorText)
+{
+    Node& node = m_nodes[opIdx];
+    if (node.isSettled)
+        return;
+    node.isSettled = true;
+    Operation& operation = m_operations[opIdx];
+    operation.isDone = true;
+    operation.isOk = false;
+    operation.errorText = errorText;
+    ++m_collisionCount;
+}
+
+void RenamePlan::start(int opIdx)
+{
+    m_pool.start([this, opIdx]()
+    {
+        rename(opIdx);
+        finish(opIdx);
+    });
+}
+
+void RenamePlan::rename(int opIdx)
+{
+    if (m_isCancelRequested.load(std::memory_order_relaxed))
+        return;
+    if (m_pThrottle != nullptr)
+        m_pThrottle->acquire(1);
+    Operation& operation = m_operations[opIdx];
+    Group& group = *m_groups[m_nodes[opIdx].groupIdx];
+#ifdef Q_OS_UNIX
+    int dirFd = -1;
+    int error = 0;
+    {
+        QMutexLocker locker(&group.mutex);
+        if (group.dirFd == -1)
+        {
+            group.dirFd = ::open(QFile::encodeName(group.dirPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            error = errno;
+        }
+        dirFd = group.dirFd;
+    }
+    if (dirFd != -1)
+        error = renameNoReplace(dirFd, QFile::encodeName(operation.oldName), QFile::encodeName(operation.newName),
+                                nameKey(operation.oldName) == nameKey(operation.newName));
+    operation.isOk = (error == 0);
+    if (!operation.isOk)
+        operation.errorText = QString::fromLocal8Bit(std::strerror(error));
+#else
+    operation.isOk = QDir(group.dirPath).rename(operation.oldName, operation.newName);
+    if (!operation.isOk)
+        operation.errorText = "Failed to rename";
+#endif
+    operation.isDone = true;
+    if (operation.isOk && m_onRenamed)
+        m_onRenamed(opIdx);
+    m_doneCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RenamePlan::finish(int opIdx)
+{
+    const Node& node = m_nodes[opIdx];
+    Group& group = *m_groups[node.groupIdx];
+    if (group.remainingCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+#ifdef Q_OS_UNIX
+        QMutexLocker locker(&group.mutex);
+        if (group.dirFd != -1)
+            ::close(group.dirFd);
+        group.dirFd = -1;
+#endif
+    }
+    for (int dependentIdx : {group.dirOpIdx, node.dependentIdx})
+    {
+        if ((dependentIdx != -1) && (m_nodes[dependentIdx].pendingCount.fetch_sub(1, std::memory_order_acq_rel) == 1))
+            start(dependentIdx);
+    }
+    m_finished.release();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QtCore/QMutex>
+#include <QtCore/QSemaphore>
+#include <QtCore/QString>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
+class Throttle;
+
+/* Renames many files and directories at once, in parallel where it's safe.
+ * Renames are grouped by their parent directory. On POSIX systems each directory is opened once and its entries are renamed
+ * with renameat() relative to it, never replacing an existing entry. A rename starts as soon as what it depends on is done:
+ * renaming a directory waits for renames inside it only (their parent path is the old one), a rename to a name another
+ * entry of the same directory is being renamed from waits for that entry. Everything else runs on any idle thread.
+ * Collisions are found before anything is renamed, using a hash index of old and new names of every directory:
+ * two entries renamed to the same name, a new name taken by an entry staying in place, renames forming a cycle
+ * and renames waiting for one of those. None of them is attempted, each one fails with explanation instead. */
+class RenamePlan
+{
+public:
+    struct Operation
+    {
+        QString parentPath; // canonical path of containing directory before any renames
+        QString oldName;
+        QString newName;
+        bool isDone = false;
+        bool isOk = false;
+        QString errorText;
+    };
+
+    // doneCount is incremented for every finished operation; operations not started yet are skipped once isCancelRequested is set
+    RenamePlan(std::atomic<qint64>& doneCount, const std::atomic<bool>& isCancelRequested);
+    ~RenamePlan();
+    // Every rename is taken from files budget of pThrottle, which also limits threads of the pool
+    void setThrottle(Throttle* pThrottle);
+    // onRenamed(opIdx) is called on the renaming thread right after each successful rename
+    void setOnRenamed(const std::function<void(int opIdx)>& onRenamed) { m_onRenamed = onRenamed; }
+
+    // Adds rename of entry oldName inside parentPath, returns its index. Operations may be added in any order.
+    int add(const QString& parentPath, const QString& oldName, const QString& newName);
+    // Finds collisions, then runs all other renames and returns once they're done or skipped
+    void execute();
+
+    const Operation& operation(int index) const { return m_operations.at(index); }
+    int collisionCount() const { return m_collisionCount; }
+
+private:
+    struct Group;
+    struct Node;
+
+    void buildGroups();
+    void findCollisions(Group& group);
+    void setCollision(int opIdx, const QString& errorText);
+    void start(int opIdx);
+    void rename(int opIdx);
+    void finish(int opIdx);
+
+    std::atomic<qint64>& m_doneCount;
+    const std::atomic<bool>& m_isCancelRequested;
+    QVector<Operation> m_operations;
+    std::vector<std::unique_ptr<Group>> m_groups;
+    std::vector<Node> m_nodes;
+    int m_collisionCount = 0;
+    QSemaphore m_finished;
+    QThreadPool m_pool;
+    Throttle* m_pThrottle = nullptr;
+    std::function<void(int opIdx)> m_onRenamed;
+};
@@ -0,0 +1,285 @@
+#include "ReplaceTable.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+
+namespace
+{
+
+// true if regExp refers to a group or to itself by number, which the alternation of all regex pairs would renumber
+bool hasNumberedReference(const QString& regExp)
+{
+    const int size = regExp.size();
+    bool isInClass = false;
+    int i = 0;
+    while (i < size)
+    {
+        const QChar c = regExp.at(i);
+        const QChar next = (i + 1 < size) ? regExp.at(i + 1) : QChar();
+        const QChar afterNext = (i + 2 < size) ? regExp.at(i + 2) : QChar();
+        if (c == '\\')
+        {
+            if (next == 'Q') // literal up to \E
+            {
+                const int end = regExp.indexOf(QLatin1String("\\E"), i + 2);
+                i = (end == -1) ? size : end + 2;
+                continue;
+            }
+            if (!isInClass && next.isDigit() && (next != '0'))
+                return true;
+            if (!isInClass && (next == 'g') && (afterNext.isDigit() || (afterNext == '-') || (afterNext == '+') || (afterNext == '{')))
+            {
+                const QChar inBraces = (i + 3 < size) ? regExp.at(i + 3) : QChar();
+                if ((afterNext != '{') || inBraces.isDigit() || (inBraces == '-') || (inBraces == '+'))
+                    return true;
+            }
+            i += 2;
+            continue;
+        }
+        if (isInClass)
+        {
+            isInClass = (c != ']');
+            ++i;
+            continue;
+        }
+        if (c == '[')
+        {
+            // ']' right after '[' or "[^" is a member, not the end
+            isInClass = true;
+            i += (next == '^') ? 2 : 1;
+            if ((i < size) && (regExp.at(i) == ']'))
+                ++i;
+            continue;
+        }
+        // (?1), (?+1), (?-1), (?R) calls and (?(1)...) conditions
+        if ((c == '(') && (next == '?'))
+        {
+            const QChar third = (i + 3 < size) ? regExp.at(i + 3) : QChar();
+            if (afterNext.isDigit() || (afterNext == 'R') || (((afterNext == '+') || (afterNext == '-') || (afterNext == '(')) && third.isDigit()))
+                return true;
+        }
+        ++i;
+    }
+    return false;
+}
+
+} // namespace
+
+
+bool ReplaceTable::load(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        m_errorString = QString("Failed to open %1").arg(filePath);
+        return false;
+    }
+    QVector<Pair> pairs;
+    QTextStream fileStream(&file);
+    fileStream.setCodec("UTF-8");
+    while (!fileStream.atEnd())
+    {
+        const QString line = fileStream.readLine();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        const QStringList fields = line.split('\t');
+        Pair pair;
+        pair.searchFor = fields.at(0);
+        pair.replaceWith = fields.value(1);
+        pair.isRegExp = (fields.value(2).trimmed() == QLatin1String("re"));
+        pairs.append(pair);
+    }
+    setPairs(pairs);
+    return true;
+}
+
+bool ReplaceTable::save(const QString& filePath) const
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream fileStream(&file);
+    fileStream.setCodec("UTF-8");
+    for (const Pair& pair : m_pairs)
+    {
+        fileStream << pair.searchFor << '\t' << pair.replaceWith;
+        if (pair.isRegExp)
+            fileStream << "\tre";
+        fileStream << '\n';
+    }
+    fileStream.flush();
+    return (file.error() == QFileDevice::NoError);
+}
+
+void ReplaceTable::setPairs(const QVector<Pair>& pairs)
+{
+    m_pairs = pairs;
+    m_isCompiled = false;
+    m_errorString.clear();
+}
+
+bool ReplaceTable::compile(Qt::CaseSensitivity caseSensitivity)
+{
+    m_isCompiled = false;
+    m_literalPairs.clear();
+    m_regExpPairs.clear();
+    m_regExpGroups.clear();
+    m_regExpCaptureCounts.clear();
+    if (m_pairs.isEmpty())
+    {
+        m_errorString = "Replace table is empty";
+        return false;
+    }
+
+    const QRegularExpression::PatternOptions caseOption = (caseSensitivity == Qt::CaseSensitive) ? QRegularExpression::NoPatternOption
+                                                                                                 : QRegularExpression::CaseInsensitiveOption;
+    QStringList literals;
+    QStringList alternatives;
+    int groupCount = 0;
+    for (int pairIdx = 0; pairIdx < m_pairs.size(); ++pairIdx)
+    {
+        const Pair& pair = m_pairs.at(pairIdx);
+        if (pair.searchFor.isEmpty())
+        {
+            m_errorString = QString("Search pattern of pair %1 is empty").arg(pairIdx + 1);
+            return false;
+        }
+        if (!pair.isRegExp)
+        {
+            literals.append(pair.searchFor);
+            m_literalPairs.append(pairIdx);
+            continue;
+        }
+        const QRegularExpression regExp(pair.searchFor, caseOption);
+        if (!regExp.isValid())
+        {
+            m_errorString = QString("Regular expression of pair %1 is invalid: %2").arg(pairIdx + 1).arg(regExp.errorString());
+            return false;
+        }
+        if (hasNumberedReference(pair.searchFor))
+        {
+            m_errorString = QString("Regular expression of pair %1 refers to a group by number, name the group instead: (?<name>...) and \\k<name>").arg(pairIdx + 1);
+            return false;
+        }
+        m_regExpPairs.append(pairIdx);
+        m_regExpGroups.append(++groupCount);
+        m_regExpCaptureCounts.append(regExp.captureCount());
+        groupCount += regExp.captureCount();
+        alternatives.append(QString("(%1)").arg(pair.searchFor));
+    }
+
+    m_literalMatcher = AhoCorasick(literals, caseSensitivity);
+    m_regExp = QRegularExpression();
+    if (!alternatives.isEmpty())
+    {
+        m_regExp = QRegularExpression(alternatives.join('|'), caseOption);
+        if (!m_regExp.isValid()) // e.g. same group name used by several pairs
+        {
+            m_errorString = QString("Combined regular expression is invalid: %1").arg(m_regExp.errorString());
+            return false;
+        }
+        m_regExp.optimize();
+    }
+    m_errorString.clear();
+    m_isCompiled = true;
+    return true;
+}
+
+bool ReplaceTable::matchLine(const QString& line, QVector<Match>& matches) const
+{
+    matches.clear();
+    // next match of each kind, searched again from the end of a taken match once it falls behind it: a match dropped for
+    // overlapping the taken one may hide one that starts inside it
+    AhoCorasick::Match literal{-1, 0, -1};
+    bool isLiteralDone = m_literalMatcher.isEmpty();
+    Match regExpMatch{-1, 0, QString()};
+    bool isRegExpDone = m_regExpPairs.isEmpty();
+    int regExpFrom = 0; // past an empty match, so that it isn't found again
+    int position = 0;
+    while (true)
+    {
+        if (!isLiteralDone && (literal.start < position))
+            isLiteralDone = !m_literalMatcher.findNext(line, position, literal);
+        if (!isRegExpDone && (regExpMatch.start < position))
+        {
+            const QRegularExpressionMatch match = m_regExp.match(line, qMax(position, regExpFrom));
+            isRegExpDone = !match.hasMatch();
+            if (!isRegExpDone)
+            {
+                int regExpIdx = 0;
+                while ((regExpIdx + 1 < m_regExpGroups.size()) && (match.capturedStart(m_regExpGroups.at(regExpIdx)) == -1))
+                    ++regExpIdx;
+                regExpMatch = {match.capturedStart(0), match.capturedLength(0), expandReplacement(match, regExpIdx)};
+            }
+        }
+        if (isLiteralDone && isRegExpDone)
+            break;
+        // leftmost first, longer one on tie
+        bool isLiteral = isRegExpDone;
+        if (!isLiteralDone && !isRegExpDone)
+            isLiteral = (literal.start < regExpMatch.start) || ((literal.start == regExpMatch.start) && (literal.length >= regExpMatch.length));
+        if (isLiteral)
+        {
+            matches.append({literal.start, literal.length, m_pairs.at(m_literalPairs.at(literal.patternIdx)).replaceWith});
+            position = literal.start + literal.length;
+        }
+        else
+        {
+            matches.append(regExpMatch);
+            position = regExpMatch.start + regExpMatch.length;
+            regExpFrom = (regExpMatch.length == 0) ? position + 1 : position;
+            regExpMatch.start = -1;
+        }
+    }
+    return !matches.isEmpty();
+}
+
+QString ReplaceTable::replaced(const QString& line, const QVector<Match>& matches)
+{
+    QString result;
+    result.reserve(line.size());
+    int position = 0;
+    for (const Match& match : matches)
+    {
+        result.append(line.midRef(position, match.start - position));
+        result.append(match.replacement);
+        position = match.start + match.length;
+    }
+    result.append(line.midRef(position));
+    return result;
+}
+
+QString ReplaceTable::expandReplacement(const QRegularExpressionMatch& match, int regExpIdx) const
+{
+    const QString& replaceWith = m_pairs.at(m_regExpPairs.at(regExpIdx)).replaceWith;
+    if (!replaceWith.contains('\\'))
+        return replaceWith;
+    const int firstGroup = m_regExpGroups.at(regExpIdx);
+    const int captureCount = m_regExpCaptureCounts.at(regExpIdx);
+    QString result;
+    result.reserve(replaceWith.size());
+    for (int i = 0; i < replaceWith.size(); ++i)
+    {
+        const QChar c = replaceWith.at(i);
+        if ((c != '\\') || (i + 1 >= replaceWith.size()) || !replaceWith.at(i + 1).isDigit())
+        {
+            result.append(c);
+            continue;
+        }
+        // same as QString::replace(): one or two digits, the second one only if such group exists
+        int groupNumber = replaceWith.at(i + 1).digitValue();
+        ++i;
+        if ((i + 1 < replaceWith.size()) && replaceWith.at(i + 1).isDigit())
+        {
+            const int twoDigitNumber = groupNumber * 10 + replaceWith.at(i + 1).digitValue();
+            if (twoDigitNumber <= captureCount)
+            {
+                groupNumber = twoDigitNumber;
+                ++i;
+            }
+        }
+        if (groupNumber <= captureCount)
+            result.append(match.captured(firstGroup + groupNumber));
+    }
+    return result;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QtCore/QRegularExpression>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "AhoCorasick.h"
+
+/* Table of search -> replace pairs applied to file contents in a single pass per line.
+ * Literal pairs are matched by one Aho-Corasick automaton, regex pairs are combined into one alternation.
+ * Matches of both kinds are merged leftmost-longest without overlaps: after each taken match both searches go on from its end,
+ * so a match dropped for overlapping it doesn't hide one starting inside it. Regex pairs matching at the same position are
+ * tried in table order. Regex pairs can't use numbered backreferences (\1, \g{1}, (?1), ...): their groups are renumbered
+ * in the alternation, named ones ((?<name>...) and \k<name>) are to be used instead.
+ * File format is UTF-8 text with a pair per line: "search<TAB>replace" for literals and "search<TAB>replace<TAB>re" for regular expressions;
+ * empty lines and lines starting with '#' are skipped. */
+class ReplaceTable
+{
+public:
+    struct Pair
+    {
+        QString searchFor;
+        QString replaceWith;
+        bool isRegExp = false;
+    };
+    struct Match
+    {
+        int start;
+        int length;
+        QString replacement;
+    };
+
+    bool load(const QString& filePath);
+    bool save(const QString& filePath) const;
+    const QVector<Pair>& pairs() const { return m_pairs; }
+    void setPairs(const QVector<Pair>& pairs);
+
+    // Builds matchers of current pairs; returns false if the table is empty or has invalid pair (see errorString())
+    bool compile(Qt::CaseSensitivity caseSensitivity);
+    bool isCompiled() const { return m_isCompiled; }
+    const QString& errorString() const { return m_errorString; }
+
+    // Fills matches of the line, ordered by position; returns false if nothing matched
+    bool matchLine(const QString& line, QVector<Match>& matches) const;
+    static QString replaced(const QString& line, const QVector<Match>& matches);
+
+private:
+    // Expands \N references of regex pair replacement; group numbers are relative to the pair's own pattern
+    QString expandReplacement(const QRegularExpressionMatch& match, int regExpIdx) const;
+
+    QVector<Pair> m_pairs;
+    bool m_isCompiled = false;
+    QString m_errorString;
+
+    AhoCorasick m_literalMatcher;
+    QVector<int> m_literalPairs;      // automaton pattern index -> pair index
+    QRegularExpression m_regExp;      // (re0)|(re1)|... of all regex pairs
+    QVector<int> m_regExpPairs;       // alternative index -> pair index
+    QVector<int> m_regExpGroups;      // alternative index -> number of the group wrapping it
+    QVector<int> m_regExpCaptureCounts;
+};
@@ -0,0 +1,122 @@
+#include "ReplaceTableDialog.h"
+
+#include <QtWidgets/QDialogButtonBox>
+#include <QtWidgets/QFileDialog>
+#include <QtWidgets/QHBoxLayout>
+#include <QtWidgets/QHeaderView>
+#include <QtWidgets/QMessageBox>
+#include <QtWidgets/QPushButton>
+#include <QtWidgets/QTableWidget>
+#include <QtWidgets/QVBoxLayout>
+
+
+ReplaceTableDialog::ReplaceTableDialog(const QString& filePath, QWidget* parent)
+    : QDialog(parent)
+    , m_filePath(filePath)
+    , m_pTable(new QTableWidget(0, 3, this))
+{
+    setWindowTitle("Replace table");
+    resize(700, 500);
+    m_pTable->setHorizontalHeaderLabels({"Search for", "Replace with", "RE"});
+    m_pTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_pTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    m_pTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
+
+    QPushButton* pAddButton = new QPushButton("Add", this);
+    QPushButton* pRemoveButton = new QPushButton("Remove", this);
+    QPushButton* pImportButton = new QPushButton("Import...", this);
+    pImportButton->setToolTip("Appends pairs from another table file");
+    QDialogButtonBox* pButtonBox = new QDialogButtonBox(QDialogButtonBox::Save | QDialogButtonBox::Cancel, this);
+
+    QHBoxLayout* pRowButtonsLayout = new QHBoxLayout;
+    pRowButtonsLayout->addWidget(pAddButton);
+    pRowButtonsLayout->addWidget(pRemoveButton);
+    pRowButtonsLayout->addWidget(pImportButton);
+    pRowButtonsLayout->addStretch();
+    QVBoxLayout* pLayout = new QVBoxLayout(this);
+    pLayout->addWidget(m_pTable);
+    pLayout->addLayout(pRowButtonsLayout);
+    pLayout->addWidget(pButtonBox);
+
+    connect(pAddButton, &QPushButton::clicked, this, [this]() { addRow(ReplaceTable::Pair()); });
+    connect(pRemoveButton, &QPushButton::clicked, this, [this]()
+    {
+        const QList<QTableWidgetSelectionRange> ranges = m_pTable->selectedRanges();
+        for (auto iter = ranges.crbegin(); iter != ranges.crend(); ++iter)
+            for (int row = iter->bottomRow(); row >= iter->topRow(); --row)
+                m_pTable->removeRow(row);
+    });
+    connect(pImportButton, &QPushButton::clicked, this, &ReplaceTableDialog::importFile);
+    connect(pButtonBox, &QDialogButtonBox::accepted, this, &ReplaceTableDialog::saveAndAccept);
+    connect(pButtonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    ReplaceTable table;
+    if (!m_filePath.isEmpty() && table.load(m_filePath))
+        for (const ReplaceTable::Pair& pair : table.pairs())
+            addRow(pair);
+}
+
+void ReplaceTableDialog::addRow(const ReplaceTable::Pair& pair)
+{
+    const int row = m_pTable->rowCount();
+    m_pTable->insertRow(row);
+    m_pTable->setItem(row, 0, new QTableWidgetItem(pair.searchFor));
+    m_pTable->setItem(row, 1, new QTableWidgetItem(pair.replaceWith));
+    QTableWidgetItem* pRegExpItem = new QTableWidgetItem;
+    pRegExpItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable);
+    pRegExpItem->setCheckState(pair.isRegExp ? Qt::Checked : Qt::Unchecked);
+    m_pTable->setItem(row, 2, pRegExpItem);
+}
+
+void ReplaceTableDialog::importFile()
+{
+    const QString importPath = QFileDialog::getOpenFileName(this, "Import replace table", m_filePath);
+    if (importPath.isEmpty())
+        return;
+    ReplaceTable table;
+    if (!table.load(importPath))
+    {
+        QMessageBox::critical(this, "Error", table.errorString());
+        return;
+    }
+    for (const ReplaceTable::Pair& pair : table.pairs())
+        addRow(pair);
+}
+
+void ReplaceTableDialog::saveAndAccept()
+{
+    QVector<ReplaceTable::Pair> pairs;
+    for (int row = 0; row < m_pTable->rowCount(); ++row)
+    {
+        ReplaceTable::Pair pair;
+        pair.searchFor = m_pTable->item(row, 0)->text();
+        pair.replaceWith = m_pTable->item(row, 1)->text();
+        pair.isRegExp = (m_pTable->item(row, 2)->checkState() == Qt::Checked);
+        if (pair.searchFor.contains('\t') || pair.replaceWith.contains('\t'))
+        {
+            QMessageBox::critical(this, "Error", QString("Row %1 contains tab character which can't be stored in table file").arg(row + 1));
+            return;
+        }
+        if (!pair.searchFor.isEmpty())
+            pairs.append(pair);
+    }
+    ReplaceTable table;
+    table.setPairs(pairs);
+    if (!table.compile(Qt::CaseSensitive))
+    {
+        QMessageBox::critical(this, "Error", table.errorString());
+        return;
+    }
+    if (m_filePath.isEmpty())
+    {
+        m_filePath = QFileDialog::getSaveFileName(this, "Save replace table", QString(), "Replace tables (*.tsv);;All files (*)");
+        if (m_filePath.isEmpty())
+            return;
+    }
+    if (!table.save(m_filePath))
+    {
+        QMessageBox::critical(this, "Error", QString("Failed to save %1").arg(m_filePath));
+        return;
+    }
+    accept();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QtWidgets/QDialog>
+
+#include "ReplaceTable.h"
+
+class QTableWidget;
+
+// Editor of replace table file: one row per pair with Search for, Replace with and RE columns
+class ReplaceTableDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    ReplaceTableDialog(const QString& filePath, QWidget* parent = nullptr);
+
+    // Path the table was saved to; may differ from initial one if it was empty
+    const QString& filePath() const { return m_filePath; }
+
+private:
+    void addRow(const ReplaceTable::Pair& pair);
+    void importFile();
+    void saveAndAccept();
+
+    QString m_filePath;
+    QTableWidget* m_pTable;
+};
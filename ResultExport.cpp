@@ -0,0 +1,225 @@
+#include "ResultExport.h"
+
+#include <array>
+
+namespace
+{
+
+// Shared buffer is written out once it's past this size
+constexpr int blockSize = 1024 * 1024;
+
+// CRC-32 of gzip trailer (ISO 3309 polynomial)
+quint32 crc32(const QByteArray& data)
+{
+    static const std::array<quint32, 256> table = []()
+    {
+        std::array<quint32, 256> result{};
+        for (quint32 i = 0; i < 256; ++i)
+        {
+            quint32 crc = i;
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc & 1) ? (0xEDB88320u ^ (crc >> 1)) : (crc >> 1);
+            result[i] = crc;
+        }
+        return result;
+    }();
+    quint32 crc = 0xFFFFFFFFu;
+    for (const char byte : data)
+        crc = table[(crc ^ static_cast<uchar>(byte)) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void appendLittleEndian32(QByteArray& data, quint32 value)
+{
+    for (int byteIdx = 0; byteIdx < 4; ++byteIdx)
+        data.append(static_cast<char>((value >> (8 * byteIdx)) & 0xFF));
+}
+
+// data as a gzip member (RFC 1952). qCompress gives a 4-byte length and a zlib stream (RFC 1950): a 2-byte header,
+// raw deflate data and a 4-byte Adler-32; deflate data goes between gzip header and trailer as it is.
+QByteArray gzipMember(const QByteArray& data)
+{
+    const QByteArray zlibData = qCompress(data);
+    // magic, deflate, no flags, no modification time, no extra flags, unknown OS
+    static const char header[] = {'\x1f', '\x8b', '\x08', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\xff'};
+    QByteArray member(header, sizeof(header));
+    member.append(zlibData.constData() + 6, zlibData.size() - 10);
+    appendLittleEndian32(member, crc32(data));
+    appendLittleEndian32(member, static_cast<quint32>(data.size()));
+    return member;
+}
+
+void appendJsonString(QByteArray& rows, const QStringRef& text)
+{
+    // escaped byte by byte: bytes of multi-byte UTF-8 sequences are all >= 0x80 and go as they are
+    const QByteArray utf8 = text.toUtf8();
+    rows.append('"');
+    for (const char byte : utf8)
+    {
+        switch (byte)
+        {
+        case '"':
+            rows.append("\\\"");
+            break;
+        case '\\':
+            rows.append("\\\\");
+            break;
+        case '\t':
+            rows.append("\\t");
+            break;
+        case '\n':
+            rows.append("\\n");
+            break;
+        case '\r':
+            rows.append("\\r");
+            break;
+        default:
+            if (static_cast<uchar>(byte) < 0x20)
+                rows.append("\\u00").append(QByteArray::number(static_cast<uchar>(byte), 16).rightJustified(2, '0'));
+            else
+                rows.append(byte);
+            break;
+        }
+    }
+    rows.append('"');
+}
+
+void appendCsvField(QByteArray& rows, const QStringRef& text)
+{
+    rows.append('"');
+    rows.append(text.toUtf8().replace('"', "\"\""));
+    rows.append('"');
+}
+
+} // namespace
+
+
+ResultExport::ResultExport(const QString& filePath)
+    : m_file(filePath)
+{
+    QString formatPath = filePath;
+    if (formatPath.endsWith(".gz", Qt::CaseInsensitive))
+    {
+        m_isGzip = true;
+        formatPath.chop(3);
+    }
+    m_format = formatPath.endsWith(".csv", Qt::CaseInsensitive) ? Format::Csv : Format::Jsonl;
+}
+
+bool ResultExport::open()
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        m_isFailed = true;
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    // written at once: blocks may reach the file in any order
+    if (m_format == Format::Csv)
+        writeBlock("path,line,column,match,replacement\r\n");
+    return !m_isFailed;
+}
+
+void ResultExport::appendRow(QByteArray& rows, const QString& path, int lineNumber, int column, const QStringRef& match, const QStringRef& replacement) const
+{
+    const QStringRef pathRef(&path);
+    if (m_format == Format::Csv)
+    {
+        appendCsvField(rows, pathRef);
+        rows.append(',');
+        if (lineNumber > 0)
+            rows.append(QByteArray::number(lineNumber)).append(',').append(QByteArray::number(column));
+        else
+            rows.append(',');
+        rows.append(',');
+        appendCsvField(rows, match);
+        rows.append(',');
+        appendCsvField(rows, replacement);
+        rows.append("\r\n");
+        return;
+    }
+    rows.append("{\"path\":");
+    appendJsonString(rows, pathRef);
+    if (lineNumber > 0)
+        rows.append(",\"line\":").append(QByteArray::number(lineNumber)).append(",\"column\":").append(QByteArray::number(column));
+    else
+        rows.append(",\"line\":null,\"column\":null");
+    rows.append(",\"match\":");
+    appendJsonString(rows, match);
+    rows.append(",\"replacement\":");
+    appendJsonString(rows, replacement);
+    rows.append("}\n");
+}
+
+void ResultExport::appendNameRow(QByteArray& rows, const QString& path, const QString& name, const QString& newName) const
+{
+    appendRow(rows, path, 0, 0, QStringRef(&name), QStringRef(&newName));
+}
+
+void ResultExport::addRows(const QByteArray& rows, int rowCount)
+{
+    QByteArray block;
+    {
+        QMutexLocker locker(&m_bufferMutex);
+        m_buffer.append(rows);
+        m_rowCount += rowCount;
+        if (m_buffer.size() < blockSize)
+            return;
+        block.swap(m_buffer);
+    }
+    writeBlock(block);
+}
+
+bool ResultExport::finish()
+{
+    QByteArray block;
+    {
+        QMutexLocker locker(&m_bufferMutex);
+        block.swap(m_buffer);
+    }
+    writeBlock(block);
+    QMutexLocker locker(&m_fileMutex);
+    if (m_file.isOpen() && !m_file.flush() && !m_isFailed)
+    {
+        m_isFailed = true;
+        m_errorString = m_file.errorString();
+    }
+    m_file.close();
+    return !m_isFailed;
+}
+
+qint64 ResultExport::rowCount() const
+{
+    QMutexLocker locker(&m_bufferMutex);
+    return m_rowCount;
+}
+
+qint64 ResultExport::writtenBytes() const
+{
+    QMutexLocker locker(&m_fileMutex);
+    return m_writtenBytes;
+}
+
+QString ResultExport::errorString() const
+{
+    QMutexLocker locker(&m_fileMutex);
+    return m_errorString;
+}
+
+void ResultExport::writeBlock(const QByteArray& block)
+{
+    if (block.isEmpty())
+        return;
+    // compressed outside of the lock, walks of other roots go on writing meanwhile
+    const QByteArray data = m_isGzip ? gzipMember(block) : block;
+    QMutexLocker locker(&m_fileMutex);
+    if (m_isFailed)
+        return;
+    if (m_file.write(data) != data.size())
+    {
+        m_isFailed = true;
+        m_errorString = m_file.errorString();
+        return;
+    }
+    m_writtenBytes += data.size();
+}
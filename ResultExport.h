@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+
+/* Results of a search streamed to a file instead of the results tree, for searches with more hits than the tree can hold or
+ * than anyone is going to look through. A row per match: path, line, column, matched text and what it's replaced with.
+ * Line and column are 1-based, column counts UTF-16 code units as the editor does. Rows of file and directory targets have
+ * no line and column; their match is the name and their replacement the new name (empty for remove).
+ * Format comes from the file name: *.csv is CSV (RFC 4180, header row, all text fields quoted), anything else JSON Lines,
+ * an object per row. A further .gz compresses the file with gzip.
+ * Walks of all roots add rows at once. Each formats rows of a file or directory into its own buffer and hands them over with
+ * addRows(); they go to a shared buffer that's written out as a block once it's past a megabyte, so the file is written in
+ * large blocks and rows of one addRows() are never split. Compressed blocks are gzip members of their own, which gzip readers
+ * take as one stream, and each is compressed by the thread that filled it without holding up the others. */
+class ResultExport
+{
+public:
+    enum class Format { Jsonl, Csv };
+
+    explicit ResultExport(const QString& filePath);
+    ResultExport(const ResultExport&) = delete;
+    ResultExport& operator=(const ResultExport&) = delete;
+
+    Format format() const { return m_format; }
+    bool isGzip() const { return m_isGzip; }
+    QString filePath() const { return m_file.fileName(); }
+
+    // Creates the file (in place of an existing one) and writes CSV header
+    bool open();
+    // Formats a row into rows of the caller; lineNumber 0 leaves line and column out
+    void appendRow(QByteArray& rows, const QString& path, int lineNumber, int column, const QStringRef& match, const QStringRef& replacement) const;
+    // Row of a file or directory target
+    void appendNameRow(QByteArray& rows, const QString& path, const QString& name, const QString& newName) const;
+    // Hands rowCount rows formatted by appendRow() over to be written; any thread
+    void addRows(const QByteArray& rows, int rowCount);
+    // Writes what's left and closes the file; false if any write failed
+    bool finish();
+
+    qint64 rowCount() const;
+    qint64 writtenBytes() const;
+    QString errorString() const;
+
+private:
+    void writeBlock(const QByteArray& block);
+
+    Format m_format = Format::Jsonl;
+    bool m_isGzip = false;
+    mutable QMutex m_bufferMutex; // guards m_buffer and m_rowCount
+    QByteArray m_buffer;
+    qint64 m_rowCount = 0;
+    mutable QMutex m_fileMutex;   // guards all below
+    QFile m_file;
+    qint64 m_writtenBytes = 0;
+    bool m_isFailed = false;
+    QString m_errorString;
+};
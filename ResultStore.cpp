@@ -0,0 +1,194 @@
+#include "ResultStore.h"
+
+#include <cstring>
+
+#include <QtCore/QDir>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+// Rough memory of a held line beyond its characters: QString and its data header
+constexpr qint64 lineOverheadBytes = 32;
+
+qint64 heldBytes(const QStringList& lines)
+{
+    qint64 bytes = 0;
+    for (const QString& line : lines)
+        bytes += lineOverheadBytes + static_cast<qint64>(line.size()) * static_cast<qint64>(sizeof(QChar));
+    return bytes;
+}
+
+// Line count, then each line as its UTF-8 byte count and bytes
+QByteArray encodeLines(const QStringList& lines)
+{
+    QByteArray data;
+    const quint32 lineCount = static_cast<quint32>(lines.size());
+    data.append(reinterpret_cast<const char*>(&lineCount), sizeof(lineCount));
+    for (const QString& line : lines)
+    {
+        const QByteArray lineData = line.toUtf8();
+        const quint32 lineSize = static_cast<quint32>(lineData.size());
+        data.append(reinterpret_cast<const char*>(&lineSize), sizeof(lineSize));
+        data.append(lineData);
+    }
+    return data;
+}
+
+bool decodeLines(const char* pData, qint64 size, QStringList& lines)
+{
+    const char* pEnd = pData + size;
+    quint32 lineCount = 0;
+    if (pEnd - pData < static_cast<qint64>(sizeof(lineCount)))
+        return false;
+    std::memcpy(&lineCount, pData, sizeof(lineCount));
+    pData += sizeof(lineCount);
+    lines.clear();
+    lines.reserve(static_cast<int>(lineCount));
+    for (quint32 i = 0; i < lineCount; ++i)
+    {
+        quint32 lineSize = 0;
+        if (pEnd - pData < static_cast<qint64>(sizeof(lineSize)))
+            return false;
+        std::memcpy(&lineSize, pData, sizeof(lineSize));
+        pData += sizeof(lineSize);
+        if (pEnd - pData < static_cast<qint64>(lineSize))
+            return false;
+        lines.append(QString::fromUtf8(pData, static_cast<int>(lineSize)));
+        pData += lineSize;
+    }
+    return pData == pEnd;
+}
+
+} // namespace
+
+
+ResultStore::ResultStore(qint64 memoryLimit)
+    : m_memoryLimit(memoryLimit)
+{}
+
+ResultStore::~ResultStore()
+{
+    clear();
+}
+
+int ResultStore::add(const QStringList& lines)
+{
+    const qint64 bytes = heldBytes(lines);
+    {
+        QMutexLocker locker(&m_mutex);
+        if ((m_memoryLimit < 0) || (m_memoryBytes + bytes <= m_memoryLimit))
+        {
+            m_memoryBytes += bytes;
+            m_records.append(Record{lines});
+            return m_records.size() - 1;
+        }
+    }
+    // encoded outside of the lock, walks of other roots go on adding meanwhile
+    const QByteArray data = encodeLines(lines);
+    QMutexLocker locker(&m_mutex);
+    Record record;
+    if (!appendToSpill(data, record))
+    {
+        // no room on disk either: held after all
+        record.lines = lines;
+        m_memoryBytes += bytes;
+    }
+    m_records.append(record);
+    return m_records.size() - 1;
+}
+
+bool ResultStore::lines(int id, QStringList& lines)
+{
+    QMutexLocker locker(&m_mutex);
+    const Record& record = m_records.at(id);
+    if (record.offset < 0)
+    {
+        lines = record.lines;
+        return true;
+    }
+    if ((record.offset + record.size > m_mappedSize) && !mapSpill())
+        return false;
+    const bool isDecoded = decodeLines(reinterpret_cast<const char*>(m_pMapped) + record.offset, record.size, lines);
+#ifdef Q_OS_UNIX
+    // lines are the caller's copy now, pages of the record are dropped from the process (not from the file)
+    const qint64 pageSize = ::sysconf(_SC_PAGESIZE);
+    const qint64 pageBegin = (pageSize > 0) ? (record.offset / pageSize * pageSize) : record.offset;
+    ::madvise(m_pMapped + pageBegin, static_cast<size_t>(record.offset + record.size - pageBegin), MADV_DONTNEED);
+#endif
+    return isDecoded;
+}
+
+void ResultStore::remove(int id)
+{
+    QMutexLocker locker(&m_mutex);
+    Record& record = m_records[id];
+    if (record.offset < 0)
+    {
+        m_memoryBytes -= heldBytes(record.lines);
+        record.lines.clear();
+        return;
+    }
+    // the next spill goes over it
+    if (record.offset + record.size == m_spillSize)
+        m_spillSize = record.offset;
+    record = Record();
+}
+
+void ResultStore::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_records.clear();
+    m_memoryBytes = 0;
+    if (m_pMapped != nullptr)
+        m_spillFile->unmap(m_pMapped);
+    m_pMapped = nullptr;
+    m_mappedSize = 0;
+    m_spillFile.reset(); // removes the file
+    m_spillSize = 0;
+}
+
+qint64 ResultStore::spilledBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_spillSize;
+}
+
+bool ResultStore::appendToSpill(const QByteArray& data, Record& record)
+{
+    if (!m_spillFile)
+    {
+        const QString dirPath = m_spillDirPath.isEmpty() ? QDir::tempPath() : m_spillDirPath;
+        std::unique_ptr<QTemporaryFile> spillFile(new QTemporaryFile(QDir(dirPath).filePath("qMultiFileEditor_results_XXXXXX")));
+        if (!spillFile->open())
+            return false;
+        m_spillFile = std::move(spillFile);
+    }
+    // a failed write leaves m_spillSize where it was, the next one goes over what was written of it
+    if (!m_spillFile->seek(m_spillSize) || (m_spillFile->write(data) != data.size()))
+        return false;
+    record.offset = m_spillSize;
+    record.size = data.size();
+    m_spillSize += data.size();
+    return true;
+}
+
+bool ResultStore::mapSpill()
+{
+    // spill file has grown since it was mapped
+    if (m_pMapped != nullptr)
+        m_spillFile->unmap(m_pMapped);
+    m_pMapped = nullptr;
+    m_mappedSize = 0;
+    if (!m_spillFile->flush())
+        return false;
+    m_pMapped = m_spillFile->map(0, m_spillSize);
+    if (m_pMapped == nullptr)
+        return false;
+    m_mappedSize = m_spillSize;
+    return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+
+#include <QtCore/QMutex>
+#include <QtCore/QStringList>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QVector>
+
+/* Lines of files with content results, kept for execute to write them back with checked lines replaced.
+ * A search with hits in millions of files would hold all of them whole in memory, so once held lines take memoryLimit bytes,
+ * lines of further files are spilled: appended to a temporary file in spillDirPath and read back through a mapping of it.
+ * What stays in memory of a spilled file is its place in the spill file, a few dozen bytes, so memory taken by lines
+ * no longer grows with the size of files they are in. Result items still take memory per file and per hit, only searching
+ * to a file keeps memory flat. Pages of the mapping are let go as soon as their lines are decoded.
+ * The spill file is append-only, except that removing the last spilled record gives its space back, and is removed by clear().
+ * Lines are added by walks of all roots at once; reading them back takes the same lock, so it's meant for one thread
+ * at a time (execute). */
+class ResultStore
+{
+public:
+    // memoryLimit < 0 holds everything in memory, 0 spills everything
+    explicit ResultStore(qint64 memoryLimit = 1024LL * 1024 * 1024);
+    ~ResultStore();
+    ResultStore(const ResultStore&) = delete;
+    ResultStore& operator=(const ResultStore&) = delete;
+
+    void setMemoryLimit(qint64 memoryLimit) { m_memoryLimit = memoryLimit; }
+    // Empty spillDirPath is the system temporary directory
+    void setSpillDirPath(const QString& spillDirPath) { m_spillDirPath = spillDirPath; }
+
+    // Stores lines and returns their id
+    int add(const QStringList& lines);
+    // Lines stored under id; false if spilled lines can't be read back
+    bool lines(int id, QStringList& lines);
+    // Forgets lines stored under id, which isn't used afterwards; ids of other lines stay
+    void remove(int id);
+    // Forgets all lines and removes the spill file
+    void clear();
+
+    qint64 spilledBytes() const;
+
+private:
+    struct Record
+    {
+        QStringList lines;  // held in memory
+        qint64 offset = -1; // or place in the spill file, -1 if held
+        qint64 size = 0;
+    };
+    bool appendToSpill(const QByteArray& data, Record& record);
+    bool mapSpill();
+
+    qint64 m_memoryLimit;
+    QString m_spillDirPath;
+    mutable QMutex m_mutex; // guards all below
+    QVector<Record> m_records;
+    qint64 m_memoryBytes = 0;
+    std::unique_ptr<QTemporaryFile> m_spillFile; // created by the first spill
+    qint64 m_spillSize = 0;
+    uchar* m_pMapped = nullptr;
+    qint64 m_mappedSize = 0;
+};
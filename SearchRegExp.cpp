@@ -0,0 +1,136 @@
+#include "SearchRegExp.h"
+
+
+SearchRegExp::SearchRegExp(const QRegularExpression& regExp, const QString& replaceString, Engine engine, int pcreMatchLimit)
+    : m_regExp(regExp)
+    , m_matchRegExp(regExp)
+{
+    // compiles the pattern now instead of on the first match
+    m_regExp.optimize();
+    if (m_regExp.isValid() && (pcreMatchLimit > 0))
+        m_matchRegExp.setPattern(QString("(*LIMIT_MATCH=%1)").arg(pcreMatchLimit) + m_regExp.pattern());
+    m_matchRegExp.optimize();
+    const QRegularExpression::PatternOptions options = m_regExp.patternOptions();
+    if (m_regExp.isValid() && (engine != Engine::Pcre) && ((options & ~QRegularExpression::CaseInsensitiveOption) == 0))
+    {
+        const Qt::CaseSensitivity caseSensitivity = (options & QRegularExpression::CaseInsensitiveOption) ? Qt::CaseInsensitive : Qt::CaseSensitive;
+        m_linearRegExp = LinearRegExp(m_regExp.pattern(), caseSensitivity);
+        m_isLinear = m_linearRegExp.isValid() && ((engine == Engine::Linear) || m_linearRegExp.isBacktrackingProne());
+    }
+
+    // same parsing of back references as in QString::replace(const QRegularExpression&, const QString&)
+    const int captureCount = m_regExp.captureCount();
+    QString literal;
+    for (int i = 0; i < replaceString.size(); ++i)
+    {
+        if ((replaceString.at(i) == '\\') && (i + 1 < replaceString.size()))
+        {
+            int group = replaceString.at(i + 1).digitValue();
+            if ((group > 0) && (group <= captureCount))
+            {
+                ++i;
+                if (i + 1 < replaceString.size())
+                {
+                    const int secondDigit = replaceString.at(i + 1).digitValue();
+                    if ((secondDigit != -1) && (group * 10 + secondDigit <= captureCount))
+                    {
+                        group = group * 10 + secondDigit;
+                        ++i;
+                    }
+                }
+                if (!literal.isEmpty())
+                    m_replacement.append(ReplacementPart{literal, -1});
+                literal.clear();
+                m_replacement.append(ReplacementPart{QString(), group});
+                continue;
+            }
+        }
+        literal.append(replaceString.at(i));
+    }
+    if (!literal.isEmpty())
+        m_replacement.append(ReplacementPart{literal, -1});
+}
+
+SearchRegExp::Engine SearchRegExp::engineFromString(const QString& engineName)
+{
+    if (engineName.compare(QLatin1String("pcre"), Qt::CaseInsensitive) == 0)
+        return Engine::Pcre;
+    if (engineName.compare(QLatin1String("linear"), Qt::CaseInsensitive) == 0)
+        return Engine::Linear;
+    return Engine::Auto;
+}
+
+QString SearchRegExp::errorStringOf(const QRegularExpression& regExp)
+{
+    if (regExp.isValid())
+        return QString();
+    return QString("Invalid regular expression \"%1\": %2 at offset %3").arg(regExp.pattern(), regExp.errorString()).arg(regExp.patternErrorOffset());
+}
+
+bool SearchRegExp::matchLine(const QString& line, QVector<Match>& matches, QString& replacedLine, MatchContext& context) const
+{
+    matches.clear();
+    replacedLine.clear();
+    context.m_isTimedOut = false;
+    int position = 0;
+    if (m_isLinear)
+    {
+        QVector<int>& captures = context.m_captures;
+        bool isNotEmptyAtOffset = false;
+        while ((position <= line.size()) && m_linearRegExp.match(line, position, isNotEmptyAtOffset, captures, context.m_linearContext))
+        {
+            matches.append(Match{captures.at(0), captures.at(1)});
+            replacedLine.append(line.midRef(position, captures.at(0) - position));
+            appendReplacement(replacedLine, [&line, &captures](int group)
+            {
+                const int start = captures.at(2 * group);
+                return (start == -1) ? QStringRef() : line.midRef(start, captures.at(2 * group + 1) - start);
+            });
+            matches.last().replacedEnd = replacedLine.size();
+            isNotEmptyAtOffset = (captures.at(0) == captures.at(1));
+            position = captures.at(1);
+            if (context.isPastDeadline())
+            {
+                context.m_isTimedOut = true;
+                break;
+            }
+        }
+    }
+    else
+    {
+        // Qt allocates match data for every match here, MatchContext can't help with that
+        QRegularExpressionMatchIterator matchIter = m_matchRegExp.globalMatch(line);
+        while (matchIter.hasNext())
+        {
+            if (context.isPastDeadline())
+            {
+                context.m_isTimedOut = true;
+                break;
+            }
+            const QRegularExpressionMatch match = matchIter.next();
+            matches.append(Match{match.capturedStart(0), match.capturedEnd(0)});
+            replacedLine.append(line.midRef(position, match.capturedStart(0) - position));
+            appendReplacement(replacedLine, [&match](int group) { return match.capturedRef(group); });
+            matches.last().replacedEnd = replacedLine.size();
+            position = match.capturedEnd(0);
+        }
+        // iteration also ends at a matching error, which leaves the iterator invalid: match limit was hit
+        context.m_isTimedOut |= !matchIter.isValid();
+    }
+    if (matches.isEmpty() || context.m_isTimedOut)
+        return false;
+    replacedLine.append(line.midRef(position));
+    return true;
+}
+
+template<typename CapturedFunc>
+void SearchRegExp::appendReplacement(QString& result, CapturedFunc captured) const
+{
+    for (const ReplacementPart& part : m_replacement)
+    {
+        if (part.group >= 0)
+            result.append(captured(part.group));
+        else
+            result.append(part.text);
+    }
+}
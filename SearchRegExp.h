@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "LinearRegExp.h"
+
+/* Regular expression search of file contents together with its replacement.
+ * Lines are matched by QRegularExpression (PCRE) or by LinearRegExp. The latter is used when it supports the pattern and engine is Linear,
+ * or engine is Auto and the pattern is prone to catastrophic backtracking.
+ * A single PCRE match is bounded by pcreMatchLimit (PCRE's match limit, 0 keeps its default) and the deadline of MatchContext
+ * is checked between matches, so neither engine spends much longer on a line than it's given.
+ * Replacement follows QString::replace(): \1 to \99 are replaced by captured groups, anything else is taken literally.
+ * The pattern is compiled (and JIT-compiled where PCRE supports it) once in the constructor, so errors are known before
+ * any file is read and matching never compiles. The object is read-only afterwards and may be shared by threads,
+ * each of them passing its own MatchContext. */
+class SearchRegExp
+{
+public:
+    enum class Engine { Auto, Pcre, Linear };
+    struct Match
+    {
+        int start;
+        int end;
+        int replacedEnd = -1; // end of what the match is replaced with in replacedLine
+    };
+
+    // Per-thread scratch space of matchLine(), reused line after line. It makes the linear engine allocation free;
+    // the PCRE path still gets a QRegularExpressionMatch per match from Qt, which has no way to reuse match data.
+    class MatchContext
+    {
+    public:
+        // matchLine() gives up once pTimer reaches deadlineNs; no deadline with nullptr
+        void setDeadline(const QElapsedTimer* pTimer, qint64 deadlineNs)
+        {
+            m_pTimer = pTimer;
+            m_deadlineNs = deadlineNs;
+        }
+        // Last matchLine() gave up at the deadline or at PCRE's match limit, its matches are incomplete
+        bool isTimedOut() const { return m_isTimedOut; }
+
+    private:
+        friend class SearchRegExp;
+        bool isPastDeadline() const { return (m_pTimer != nullptr) && (m_pTimer->nsecsElapsed() > m_deadlineNs); }
+
+        LinearRegExp::MatchContext m_linearContext;
+        QVector<int> m_captures;
+        const QElapsedTimer* m_pTimer = nullptr;
+        qint64 m_deadlineNs = 0;
+        bool m_isTimedOut = false;
+    };
+
+    SearchRegExp() = default;
+    SearchRegExp(const QRegularExpression& regExp, const QString& replaceString, Engine engine = Engine::Auto, int pcreMatchLimit = 0);
+
+    // "auto", "pcre" or "linear" as stored in settings; anything else is Auto
+    static Engine engineFromString(const QString& engineName);
+
+    bool isValid() const { return m_regExp.isValid(); }
+    // Pattern error with its position, empty if valid
+    QString errorString() const { return errorStringOf(m_regExp); }
+    static QString errorStringOf(const QRegularExpression& regExp);
+    bool isLinear() const { return m_isLinear; }
+    const QRegularExpression& regExp() const { return m_regExp; }
+
+    // Fills non-overlapping matches of the line in order and replacedLine with all of them replaced; returns false if nothing matched
+    // or if matching gave up, see MatchContext::isTimedOut()
+    bool matchLine(const QString& line, QVector<Match>& matches, QString& replacedLine, MatchContext& context) const;
+
+private:
+    struct ReplacementPart
+    {
+        QString text;
+        int group = -1; // text of this captured group is inserted instead of text if >= 0
+    };
+    template<typename CapturedFunc>
+    void appendReplacement(QString& result, CapturedFunc captured) const;
+
+    QRegularExpression m_regExp;
+    QRegularExpression m_matchRegExp; // m_regExp with the match limit set, errors are reported of m_regExp
+    LinearRegExp m_linearRegExp;
+    bool m_isLinear = false;
+    QVector<ReplacementPart> m_replacement;
+};
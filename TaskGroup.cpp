@@ -0,0 +1,50 @@
+#include "TaskGroup.h"
+
+#include <QtCore/QRunnable>
+
+namespace
+{
+
+class FunctionTask : public QRunnable
+{
+public:
+    FunctionTask(const std::function<void()>& func, QSemaphore& finished, QThread::Priority priority)
+        : m_func(func)
+        , m_finished(finished)
+        , m_priority(priority)
+    {}
+
+    void run() override
+    {
+        if (m_priority != QThread::InheritPriority)
+            QThread::currentThread()->setPriority(m_priority);
+        m_func();
+        m_finished.release();
+    }
+
+private:
+    std::function<void()> m_func;
+    QSemaphore& m_finished;
+    QThread::Priority m_priority;
+};
+
+} // namespace
+
+
+bool TaskGroup::tryStart(QThreadPool* pPool, const std::function<void()>& func, QThread::Priority priority)
+{
+    FunctionTask* pTask = new FunctionTask(func, m_finished, priority);
+    if (!pPool->tryStart(pTask))
+    {
+        delete pTask;
+        return false;
+    }
+    ++m_startedCount;
+    return true;
+}
+
+void TaskGroup::wait()
+{
+    m_finished.acquire(m_startedCount);
+    m_startedCount = 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <functional>
+
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+/* Tasks handed to idle threads of a pool and waited for together; used for work that splits as it goes, such as subdirectories.
+ * tryStart() only succeeds if a thread is free right now, so a started task never waits in the queue behind its waiting parent
+ * and a task may start and wait for tasks of its own without deadlocking the pool. Owned and waited for by a single thread. */
+class TaskGroup
+{
+public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    ~TaskGroup() { wait(); }
+
+    // Runs func on an idle thread of pPool and returns true; false if no thread is idle, func is left to the caller then.
+    // Started thread gets priority unless it's InheritPriority.
+    bool tryStart(QThreadPool* pPool, const std::function<void()>& func, QThread::Priority priority = QThread::InheritPriority);
+    // Returns once all started tasks are done
+    void wait();
+
+private:
+    QSemaphore m_finished;
+    int m_startedCount = 0;
+};
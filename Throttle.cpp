@@ -0,0 +1,174 @@
+#include "Throttle.h"
+
+#include <cmath>
+
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+constexpr qint64 maxSleepMs = 50;
+
+// I/O priority last applied by the current thread, as generation of Throttle::m_ioPriority
+thread_local const Throttle* t_pAppliedThrottle = nullptr;
+thread_local int t_appliedGeneration = -1;
+
+#ifdef Q_OS_LINUX
+// From linux/ioprio.h, which older kernel headers lack
+constexpr int ioprioWhoProcess = 1;
+constexpr int ioprioClassShift = 13;
+constexpr int ioprioClassBestEffort = 2;
+constexpr int ioprioClassIdle = 3;
+#endif
+
+void setThreadIoPriority(Throttle::IoPriority ioPriority)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_ioprio_set)
+    // class none follows CPU nice value, as threads start out
+    int ioprio = 0;
+    if (ioPriority == Throttle::IoPriority::Low)
+        ioprio = (ioprioClassBestEffort << ioprioClassShift) | 7;
+    else if (ioPriority == Throttle::IoPriority::Idle)
+        ioprio = ioprioClassIdle << ioprioClassShift;
+    // "process" 0 is the calling thread
+    ::syscall(SYS_ioprio_set, ioprioWhoProcess, 0, ioprio);
+#else
+    Q_UNUSED(ioPriority)
+#endif
+}
+
+} // namespace
+
+
+Throttle::Throttle(const std::atomic<bool>& isCancelRequested)
+    : m_isCancelRequested(isCancelRequested)
+{
+    m_timer.start();
+}
+
+Throttle::IoPriority Throttle::ioPriorityFromString(const QString& priorityName)
+{
+    if (priorityName.compare(QLatin1String("low"), Qt::CaseInsensitive) == 0)
+        return IoPriority::Low;
+    if (priorityName.compare(QLatin1String("idle"), Qt::CaseInsensitive) == 0)
+        return IoPriority::Idle;
+    return IoPriority::Normal;
+}
+
+QString Throttle::ioPriorityToString(IoPriority ioPriority)
+{
+    switch (ioPriority)
+    {
+    case IoPriority::Low:
+        return "low";
+    case IoPriority::Idle:
+        return "idle";
+    case IoPriority::Normal:
+        break;
+    }
+    return "normal";
+}
+
+Throttle::Limits Throttle::limits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_limits;
+}
+
+void Throttle::setLimits(const Limits& limits)
+{
+    QMutexLocker locker(&m_mutex);
+    refill();
+    m_limits = limits;
+    for (auto bucketLimit : {std::make_pair(&m_files, limits.filesPerSec), std::make_pair(&m_bytes, limits.bytesPerSec)})
+    {
+        Bucket& bucket = *bucketLimit.first;
+        // a new limit starts with a full second of budget, a debt made under the old one is kept
+        if ((bucket.rate != bucketLimit.second) && (bucket.tokens >= 0))
+            bucket.tokens = static_cast<double>(bucketLimit.second);
+        bucket.rate = qMax<qint64>(bucketLimit.second, 0);
+    }
+    m_isRateLimited.store((m_files.rate > 0) || (m_bytes.rate > 0), std::memory_order_relaxed);
+    if (m_ioPriority.exchange(static_cast<int>(limits.ioPriority), std::memory_order_relaxed) != static_cast<int>(limits.ioPriority))
+        m_ioPriorityGeneration.fetch_add(1, std::memory_order_relaxed);
+    for (auto poolIter = m_ownThreadCounts.constBegin(); poolIter != m_ownThreadCounts.constEnd(); ++poolIter)
+        applyThreadCount(poolIter.key(), poolIter.value());
+}
+
+void Throttle::acquire(qint64 fileCount, qint64 byteCount)
+{
+    applyIoPriority();
+    while (m_isRateLimited.load(std::memory_order_relaxed) && !m_isCancelRequested.load(std::memory_order_relaxed))
+    {
+        qint64 sleepMs = 0;
+        {
+            QMutexLocker locker(&m_mutex);
+            refill();
+            double waitSec = 0;
+            for (const Bucket* pBucket : {&m_files, &m_bytes})
+            {
+                if ((pBucket->rate > 0) && (pBucket->tokens < 0))
+                    waitSec = qMax(waitSec, -pBucket->tokens / static_cast<double>(pBucket->rate));
+            }
+            if (waitSec <= 0)
+            {
+                if (m_files.rate > 0)
+                    m_files.tokens -= static_cast<double>(fileCount);
+                if (m_bytes.rate > 0)
+                    m_bytes.tokens -= static_cast<double>(byteCount);
+                return;
+            }
+            sleepMs = qBound<qint64>(1, static_cast<qint64>(std::ceil(waitSec * 1000.0)), maxSleepMs);
+        }
+        QThread::msleep(static_cast<unsigned long>(sleepMs));
+        applyIoPriority();
+    }
+}
+
+void Throttle::attach(QThreadPool* pPool)
+{
+    QMutexLocker locker(&m_mutex);
+    const int ownThreadCount = pPool->maxThreadCount();
+    m_ownThreadCounts.insert(pPool, ownThreadCount);
+    applyThreadCount(pPool, ownThreadCount);
+}
+
+void Throttle::detach(QThreadPool* pPool)
+{
+    QMutexLocker locker(&m_mutex);
+    auto poolIter = m_ownThreadCounts.find(pPool);
+    if (poolIter == m_ownThreadCounts.end())
+        return;
+    pPool->setMaxThreadCount(poolIter.value());
+    m_ownThreadCounts.erase(poolIter);
+}
+
+void Throttle::applyIoPriority() const
+{
+    const int generation = m_ioPriorityGeneration.load(std::memory_order_relaxed);
+    if ((t_pAppliedThrottle == this) && (t_appliedGeneration == generation))
+        return;
+    setThreadIoPriority(static_cast<IoPriority>(m_ioPriority.load(std::memory_order_relaxed)));
+    t_pAppliedThrottle = this;
+    t_appliedGeneration = generation;
+}
+
+void Throttle::refill()
+{
+    const qint64 nowNs = m_timer.nsecsElapsed();
+    const double elapsedSec = static_cast<double>(nowNs - m_lastRefillNs) / 1e9;
+    m_lastRefillNs = nowNs;
+    for (Bucket* pBucket : {&m_files, &m_bytes})
+        pBucket->tokens = qMin(pBucket->tokens + elapsedSec * static_cast<double>(pBucket->rate), static_cast<double>(pBucket->rate));
+}
+
+void Throttle::applyThreadCount(QThreadPool* pPool, int ownThreadCount) const
+{
+    pPool->setMaxThreadCount((m_limits.threadCount > 0) ? qMin(ownThreadCount, m_limits.threadCount) : ownThreadCount);
+}
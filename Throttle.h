@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+
+class QThreadPool;
+
+/* Keeps searches and executes from starving other work on a shared machine.
+ * I/O priority: workers switch their own thread to the best-effort class at its lowest level or to the idle class
+ * (ioprio_set(), Linux only; the io_uring workers of a thread share its I/O context and follow it). A thread applies the
+ * current class whenever it takes from the budgets, so a change reaches running workers within a file.
+ * Bandwidth: token buckets of files/s and bytes/s, each holding at most one second worth of budget. A taker blocks while either
+ * bucket is overdrawn, then takes what it needs even if that overdraws it: a file bigger than the whole budget still goes
+ * through and whoever comes next waits for it to be paid off, so on average the rate stays at the limit.
+ * Threads: pools attached to the throttle run at most threadCount threads at once.
+ * Limits may be changed from any thread at any time, e.g. from GUI during a run; blocked takers re-check them every 50 ms.
+ * With no rate limit set, taking costs an atomic load and a thread-local compare. */
+class Throttle
+{
+public:
+    enum class IoPriority { Normal, Low, Idle };
+    struct Limits
+    {
+        IoPriority ioPriority = IoPriority::Normal;
+        qint64 bytesPerSec = 0; // 0 means unlimited
+        qint64 filesPerSec = 0;
+        int threadCount = 0;    // 0 leaves each pool its own maximum
+    };
+
+    // Blocked takers give up waiting once isCancelRequested is set
+    explicit Throttle(const std::atomic<bool>& isCancelRequested);
+
+    // "normal", "low" or "idle" as stored in settings; anything else is Normal
+    static IoPriority ioPriorityFromString(const QString& priorityName);
+    static QString ioPriorityToString(IoPriority ioPriority);
+
+    Limits limits() const;
+    void setLimits(const Limits& limits);
+
+    // Blocks while files or bytes budget is overdrawn, then takes fileCount files and byteCount bytes from them.
+    // Bytes known only after the work is done are taken by a later call with fileCount 0.
+    void acquire(qint64 fileCount, qint64 byteCount = 0);
+
+    // Pool's own maximum thread count is remembered and lowered to the limit until the pool is detached
+    void attach(QThreadPool* pPool);
+    void detach(QThreadPool* pPool);
+
+private:
+    struct Bucket
+    {
+        qint64 rate = 0;    // per second, 0 means unlimited
+        double tokens = 0;  // negative when overdrawn
+    };
+
+    void applyIoPriority() const;
+    void refill();
+    void applyThreadCount(QThreadPool* pPool, int ownThreadCount) const;
+
+    const std::atomic<bool>& m_isCancelRequested;
+    std::atomic<bool> m_isRateLimited{false};
+    std::atomic<int> m_ioPriority{static_cast<int>(IoPriority::Normal)};
+    std::atomic<int> m_ioPriorityGeneration{0};
+    mutable QMutex m_mutex; // guards members below
+    Limits m_limits;
+    Bucket m_files;
+    Bucket m_bytes;
+    QElapsedTimer m_timer;
+    qint64 m_lastRefillNs = 0;
+    QHash<QThreadPool*, int> m_ownThreadCounts;
+};
@@ -0,0 +1,119 @@
+#include "Trash.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSettings>
+
+#include "TreeRemover.h"
+
+static const QString trashDirName = ".qMultiFileEditor_trash";
+
+
+Trash::Trash(const QString& listFilePath)
+    : m_listFilePath(listFilePath)
+{
+    // one batch at a time, purging is meant to stay out of the way of searches
+    m_purgePool.setMaxThreadCount(1);
+}
+
+Trash::~Trash()
+{
+    m_isStopRequested.store(true, std::memory_order_relaxed);
+    m_purgePool.clear();
+    m_purgePool.waitForDone();
+}
+
+bool Trash::detach(const QString& rootDirPath, const QString& path)
+{
+    QString batchDirPath;
+    int entryIdx = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto batchIter = m_openBatches.find(rootDirPath);
+        if (batchIter == m_openBatches.end())
+        {
+            const QString batchName = QString("%1-%2-%3")
+                                      .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"))
+                                      .arg(QCoreApplication::applicationPid())
+                                      .arg(m_batchCount++);
+            const QString newBatchDirPath = QString("%1/%2/%3").arg(rootDirPath, trashDirName, batchName);
+            if (!QDir().mkpath(newBatchDirPath))
+                return false;
+            // recorded before anything is moved in, a crash leaves nothing unaccounted for
+            QSettings listFile(m_listFilePath, QSettings::IniFormat);
+            QStringList pendingBatches = listFile.value("Trash/pending").toStringList();
+            pendingBatches.append(newBatchDirPath);
+            listFile.setValue("Trash/pending", pendingBatches);
+            batchIter = m_openBatches.insert(rootDirPath, newBatchDirPath);
+        }
+        batchDirPath = batchIter.value();
+        entryIdx = m_entryCount++;
+    }
+    // plain rename(), never falls back to copying like QFile::rename() does
+    return QDir().rename(path, QString("%1/%2_%3").arg(batchDirPath).arg(entryIdx).arg(QFileInfo(path).fileName()));
+}
+
+void Trash::purgeDetached()
+{
+    QStringList batchDirPaths;
+    {
+        QMutexLocker locker(&m_mutex);
+        batchDirPaths = m_openBatches.values();
+        m_openBatches.clear();
+    }
+    for (const QString& batchDirPath : qAsConst(batchDirPaths))
+        startPurge(batchDirPath);
+}
+
+void Trash::resumePurges()
+{
+    QStringList batchDirPaths;
+    {
+        QMutexLocker locker(&m_mutex);
+        QSettings listFile(m_listFilePath, QSettings::IniFormat);
+        batchDirPaths = listFile.value("Trash/pending").toStringList();
+    }
+    for (const QString& batchDirPath : qAsConst(batchDirPaths))
+    {
+        if (QFileInfo::exists(batchDirPath))
+            startPurge(batchDirPath);
+        else
+            setRecorded(batchDirPath, false);
+    }
+}
+
+void Trash::startPurge(const QString& batchDirPath)
+{
+    QtConcurrent::run(&m_purgePool, [this, batchDirPath]() { purge(batchDirPath); });
+}
+
+void Trash::purge(const QString& batchDirPath)
+{
+    QThread::currentThread()->setPriority(QThread::IdlePriority);
+    std::atomic<qint64> purgedCount{0};
+    TreeRemover remover(purgedCount, m_isStopRequested, 1, QThread::IdlePriority);
+    QVector<TreeRemover::Failure> failures;
+    // a batch that failed (or was stopped) stays recorded and is retried on the next start
+    if (!remover.remove(batchDirPath, failures))
+        return;
+    setRecorded(batchDirPath, false);
+    // trash dir itself goes with its last batch, fails harmlessly while others are still in it
+    QDir().rmdir(QFileInfo(batchDirPath).absolutePath());
+}
+
+void Trash::setRecorded(const QString& batchDirPath, bool isRecorded)
+{
+    QMutexLocker locker(&m_mutex);
+    QSettings listFile(m_listFilePath, QSettings::IniFormat);
+    QStringList pendingBatches = listFile.value("Trash/pending").toStringList();
+    pendingBatches.removeAll(batchDirPath);
+    if (isRecorded)
+        pendingBatches.append(batchDirPath);
+    if (pendingBatches.isEmpty())
+        listFile.remove("Trash/pending");
+    else
+        listFile.setValue("Trash/pending", pendingBatches);
+}
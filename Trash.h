@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QThreadPool>
+
+/* Detach-then-delete removal. An entry is detached by a single rename into a trash batch directory inside the search root,
+ * ".qMultiFileEditor_trash/<batch>", which takes constant time no matter how large the tree is and keeps it on the same filesystem.
+ * Searches don't list hidden entries, so the trash is invisible to them on Unix.
+ * Detached batches are deleted by a low priority background thread independent of searches and executes.
+ * Batch directories are recorded in listFilePath before anything is renamed into them and dropped once purged,
+ * so purges interrupted by exit or crash are picked up again by resumePurges() on the next start. */
+class Trash
+{
+public:
+    explicit Trash(const QString& listFilePath);
+    // Stops purging; what's left stays recorded for the next start
+    ~Trash();
+
+    // Renames entry at path into the open batch of rootDirPath, creating it on first use. Returns false if it can't be renamed
+    // there (e.g. it's on another filesystem than the root), the entry is left untouched then. Safe to call from any thread.
+    bool detach(const QString& rootDirPath, const QString& path);
+    // Closes open batches and queues them for purging
+    void purgeDetached();
+    // Queues batches recorded by previous runs that weren't purged completely
+    void resumePurges();
+
+private:
+    void startPurge(const QString& batchDirPath);
+    void purge(const QString& batchDirPath);
+    void setRecorded(const QString& batchDirPath, bool isRecorded);
+
+    QString m_listFilePath;
+    QMutex m_mutex;                       // guards members below and list file
+    QHash<QString, QString> m_openBatches; // root dir -> batch dir entries are detached into
+    int m_batchCount = 0;
+    int m_entryCount = 0;
+    std::atomic<bool> m_isStopRequested{false};
+    QThreadPool m_purgePool;
+};
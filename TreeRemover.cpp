@@ -0,0 +1,260 @@
+#include "TreeRemover.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include "Utils.h"
+#endif
+
+#include "Throttle.h"
+
+#ifdef Q_OS_UNIX
+namespace
+{
+
+QString entryPath(const QString& dirPath, const char* name)
+{
+    return QString("%1/%2").arg(dirPath, QFile::decodeName(name));
+}
+
+} // namespace
+#endif
+
+
+#ifdef Q_OS_UNIX
+// Mode of a directory of the removed tree, widened by the first unlink in it that lacks permission and put back when it's done
+struct TreeRemover::DirMode
+{
+    QMutex mutex;
+    bool isWidened = false;
+    mode_t originalMode = 0;
+
+    bool widen(int dirFd)
+    {
+        QMutexLocker locker(&mutex);
+        if (isWidened)
+            return true;
+        struct stat dirStat;
+        if ((::fstat(dirFd, &dirStat) != 0) || (::fchmod(dirFd, (dirStat.st_mode & 07777) | S_IRWXU) != 0))
+            return false;
+        originalMode = dirStat.st_mode & 07777;
+        isWidened = true;
+        return true;
+    }
+};
+#endif
+
+TreeRemover::TreeRemover(std::atomic<qint64>& removedCount, const std::atomic<bool>& isCancelRequested, int maxThreadCount, QThread::Priority threadPriority)
+    : m_removedCount(removedCount)
+    , m_isCancelRequested(isCancelRequested)
+    , m_threadPriority(threadPriority)
+{
+    // removal is bound by metadata latency rather than CPU, more requests in flight keep the disk busier
+    m_pool.setMaxThreadCount((maxThreadCount > 0) ? maxThreadCount : 2 * QThread::idealThreadCount());
+}
+
+TreeRemover::~TreeRemover()
+{
+    if (m_pThrottle != nullptr)
+        m_pThrottle->detach(&m_pool);
+}
+
+void TreeRemover::setThrottle(Throttle* pThrottle)
+{
+    if (m_pThrottle != nullptr)
+        m_pThrottle->detach(&m_pool);
+    m_pThrottle = pThrottle;
+    if (m_pThrottle != nullptr)
+        m_pThrottle->attach(&m_pool);
+}
+
+void TreeRemover::run(TaskGroup& group, const std::function<void()>& func)
+{
+    if (!group.tryStart(&m_pool, func, m_threadPriority))
+        func();
+}
+
+void TreeRemover::addFailure(QVector<Failure>& failures, const QString& path, const QString& errorText)
+{
+    QMutexLocker locker(&m_failuresMutex);
+    failures.append(Failure{path, errorText});
+}
+
+#ifdef Q_OS_UNIX
+
+bool TreeRemover::remove(const QString& path, QVector<Failure>& failures)
+{
+    const QFileInfo fileInfo(path);
+    const int parentFd = ::open(QFile::encodeName(fileInfo.absolutePath()).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (parentFd == -1)
+    {
+        addFailure(failures, path, QString::fromLocal8Bit(std::strerror(errno)));
+        return false;
+    }
+    const QByteArray name = QFile::encodeName(fileInfo.fileName());
+    bool isOk = false;
+    struct stat entryStat;
+    if (::fstatat(parentFd, name.constData(), &entryStat, AT_SYMLINK_NOFOLLOW) == -1)
+    {
+        const int error = errno;
+        isOk = (error == ENOENT); // already gone
+        if (!isOk)
+            addFailure(failures, path, QString::fromLocal8Bit(std::strerror(error)));
+    }
+    else if (S_ISDIR(entryStat.st_mode))
+    {
+        isOk = removeDirAt(parentFd, nullptr, name, fileInfo.absolutePath(), failures);
+    }
+    else
+    {
+        isOk = unlinkAt(parentFd, nullptr, name.constData(), 0, fileInfo.absolutePath(), failures);
+    }
+    ::close(parentFd);
+    return isOk;
+}
+
+bool TreeRemover::removeDirAt(int parentFd, DirMode* pParentMode, const QByteArray& name, const QString& parentPath, QVector<Failure>& failures)
+{
+    if (m_isCancelRequested.load(std::memory_order_relaxed))
+        return false;
+    const int openFlags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+    DirMode dirMode;
+    int dirFd = ::openat(parentFd, name.constData(), openFlags);
+    if ((dirFd == -1) && (errno == EACCES))
+    {
+        // directory itself is part of the removed tree: it's made readable, its mode is put back below if it's left
+        struct stat dirStat;
+        if ((::fstatat(parentFd, name.constData(), &dirStat, AT_SYMLINK_NOFOLLOW) == 0)
+            && (::fchmodat(parentFd, name.constData(), (dirStat.st_mode & 07777) | S_IRWXU, 0) == 0))
+        {
+            dirMode.isWidened = true;
+            dirMode.originalMode = dirStat.st_mode & 07777;
+            dirFd = ::openat(parentFd, name.constData(), openFlags);
+        }
+        else
+        {
+            errno = EACCES;
+        }
+    }
+    DIR* pDir = (dirFd != -1) ? ::fdopendir(dirFd) : nullptr;
+    if (pDir == nullptr)
+    {
+        const int error = errno;
+        if (dirFd != -1)
+            ::close(dirFd);
+        if (dirMode.isWidened)
+            ::fchmodat(parentFd, name.constData(), dirMode.originalMode, 0);
+        addFailure(failures, entryPath(parentPath, name.constData()), QString::fromLocal8Bit(std::strerror(error)));
+        return false;
+    }
+
+    const QString dirPath = entryPath(parentPath, name.constData());
+    bool isOk = true;
+    std::atomic<bool> isSubdirsOk{true};
+    {
+        TaskGroup subdirTasks;
+        while (const dirent* pEntry = ::readdir(pDir))
+        {
+            if (m_isCancelRequested.load(std::memory_order_relaxed))
+            {
+                isOk = false;
+                break;
+            }
+            const char* entryName = pEntry->d_name;
+            if ((std::strcmp(entryName, ".") == 0) || (std::strcmp(entryName, "..") == 0))
+                continue;
+            bool isDir = (pEntry->d_type == DT_DIR);
+            if (pEntry->d_type == DT_UNKNOWN) // filesystem doesn't report types in directory entries
+            {
+                struct stat entryStat;
+                isDir = (::fstatat(dirFd, entryName, &entryStat, AT_SYMLINK_NOFOLLOW) == 0) && S_ISDIR(entryStat.st_mode);
+            }
+            if (isDir)
+            {
+                const QByteArray subdirName(entryName);
+                run(subdirTasks, [this, dirFd, &dirMode, subdirName, &dirPath, &failures, &isSubdirsOk]()
+                {
+                    if (!removeDirAt(dirFd, &dirMode, subdirName, dirPath, failures))
+                        isSubdirsOk.store(false, std::memory_order_relaxed);
+                });
+            }
+            else if (!unlinkAt(dirFd, &dirMode, entryName, 0, dirPath, failures))
+            {
+                isOk = false;
+            }
+        }
+        // dirFd has to stay open until all subdirectories using it are done
+        subdirTasks.wait();
+    }
+    // entries are done, a directory left by a failure keeps the mode it had
+    if (dirMode.isWidened)
+        ::fchmod(dirFd, dirMode.originalMode);
+    ::closedir(pDir);
+    if (!isOk || !isSubdirsOk.load(std::memory_order_relaxed))
+        return false;
+    return unlinkAt(parentFd, pParentMode, name.constData(), AT_REMOVEDIR, parentPath, failures);
+}
+
+bool TreeRemover::unlinkAt(int dirFd, DirMode* pDirMode, const char* name, int flags, const QString& dirPath, QVector<Failure>& failures)
+{
+    if (m_pThrottle != nullptr)
+        m_pThrottle->acquire(1);
+    if (::unlinkat(dirFd, name, flags) == 0)
+    {
+        m_removedCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    int error = errno;
+    // removing an entry needs write permission on the directory containing it, not on the entry itself. EPERM (sticky
+    // directory owned by someone else, immutable entry) isn't fixed by that.
+    if ((error == EACCES) && (pDirMode != nullptr) && pDirMode->widen(dirFd))
+    {
+        if (::unlinkat(dirFd, name, flags) == 0)
+        {
+            m_removedCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        error = errno;
+    }
+    if (error == ENOENT) // removed by someone else meanwhile
+        return true;
+    addFailure(failures, entryPath(dirPath, name), QString::fromLocal8Bit(std::strerror(error)));
+    return false;
+}
+
+#else
+
+bool TreeRemover::remove(const QString& path, QVector<Failure>& failures)
+{
+    if (m_pThrottle != nullptr)
+        m_pThrottle->acquire(1);
+    const QFileInfo fileInfo(path);
+    bool isOk = false;
+    if (fileInfo.isDir() && !fileInfo.isSymLink())
+    {
+        isOk = QDir(path).removeRecursively();
+    }
+    else
+    {
+        QFile fileToRemove(path);
+        // If fails on Windows, check https://doc.qt.io/qt-5.15/qfileinfo.html#ntfs-permissions
+        fileToRemove.setPermissions(allPermissions);
+        isOk = fileToRemove.remove();
+    }
+    if (isOk)
+        m_removedCount.fetch_add(1, std::memory_order_relaxed);
+    else
+        addFailure(failures, path, "Failed to remove");
+    return isOk;
+}
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
+#include "TaskGroup.h"
+
+class Throttle;
+
+/* Removes files and whole directory trees as fast as the filesystem allows.
+ * On POSIX systems entries are unlinked with unlinkat() relative to descriptors of their opened parent directories, so no path
+ * is resolved more than once and symlinks inside removed trees are removed, never followed. Subdirectories are handed to idle
+ * threads of own pool as soon as they are found; a thread only descends by itself when no other one is idle, so waiting for
+ * a subtree never waits for work that hasn't started. Permissions are only touched when unlinking fails with EACCES, and only
+ * those of directories inside the removed tree: the containing directory is made writable by owner, unlink is retried once
+ * and the directory gets its mode back once its entries are done. The directory a target is in is never changed.
+ * Elsewhere QDir::removeRecursively() and QFile::remove() do the work.
+ * remove() may be called from several threads at once, e.g. from tasks started by run(). */
+class TreeRemover
+{
+public:
+    struct Failure
+    {
+        QString path;
+        QString errorText;
+    };
+
+    // Tasks started by run(); wait() returns once all of them are done
+    using TaskGroup = ::TaskGroup;
+
+    // removedCount is incremented for every removed entry; removal stops early once isCancelRequested is set.
+    // maxThreadCount of 0 means twice the number of cores; pool threads run with threadPriority.
+    TreeRemover(std::atomic<qint64>& removedCount, const std::atomic<bool>& isCancelRequested,
+                int maxThreadCount = 0, QThread::Priority threadPriority = QThread::InheritPriority);
+    ~TreeRemover();
+    // Every removed entry is taken from files budget of pThrottle, which also limits threads of the pool
+    void setThrottle(Throttle* pThrottle);
+
+    // Removes file, symlink or whole directory at path. Returns false if anything couldn't be removed, failures receives each such entry.
+    bool remove(const QString& path, QVector<Failure>& failures);
+    // Runs func on an idle thread of the pool, or right away in the calling thread if none is idle
+    void run(TaskGroup& group, const std::function<void()>& func);
+
+private:
+#ifdef Q_OS_UNIX
+    struct DirMode;
+    // pParentMode is nullptr for the directory a target is in, its permissions are left alone
+    bool removeDirAt(int parentFd, DirMode* pParentMode, const QByteArray& name, const QString& parentPath, QVector<Failure>& failures);
+    bool unlinkAt(int dirFd, DirMode* pDirMode, const char* name, int flags, const QString& dirPath, QVector<Failure>& failures);
+#endif
+    void addFailure(QVector<Failure>& failures, const QString& path, const QString& errorText);
+
+    std::atomic<qint64>& m_removedCount;
+    const std::atomic<bool>& m_isCancelRequested;
+    QThread::Priority m_threadPriority;
+    Throttle* m_pThrottle = nullptr;
+    QMutex m_failuresMutex;
+    QThreadPool m_pool;
+};
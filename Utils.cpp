@@ -1,6 +1,8 @@
 #include "MultiFileEditor.h"
 
-QString regExpFromWildcardFilters(const QString& inputString)
+#include <QtCore/QSettings>
+
+QStringList wildcardFiltersFromString(const QString& inputString)
 {
     QStringList nameFilters;
     int idxEnd = 0;
@@ -14,7 +16,12 @@ QString regExpFromWildcardFilters(const QString& inputString)
         nameFilters.push_back(inputString.mid(idxBegin, idxEnd - idxBegin));
         idxBegin = inputString.indexOf("\"", idxEnd + 1);
     }
+    return nameFilters;
+}
 
+QString regExpFromWildcardFilters(const QString& inputString)
+{
+    const QStringList nameFilters = wildcardFiltersFromString(inputString);
     if (nameFilters.isEmpty())
         return QString();
     QString result = QRegularExpression::wildcardToRegularExpression(nameFilters.front());
@@ -22,3 +29,80 @@ QString regExpFromWildcardFilters(const QString& inputString)
         result.append("|").append(QRegularExpression::wildcardToRegularExpression(*iter));
     return result;
 }
+
+QStringList dirPathsFromString(const QString& inputString)
+{
+    if (inputString.trimmed().startsWith('"'))
+        return wildcardFiltersFromString(inputString);
+    return inputString.isEmpty() ? QStringList() : QStringList(inputString);
+}
+
+QByteArray escapeLogField(const QString& field)
+{
+    QByteArray result = field.toUtf8();
+    result.replace('\\', "\\\\").replace('\t', "\\t").replace('\n', "\\n");
+    return result;
+}
+
+QString unescapeLogField(const QByteArray& field)
+{
+    QByteArray result;
+    result.reserve(field.size());
+    for (int i = 0; i < field.size(); ++i)
+    {
+        if ((field.at(i) != '\\') || (i + 1 == field.size()))
+        {
+            result.append(field.at(i));
+            continue;
+        }
+        const char escaped = field.at(++i);
+        result.append((escaped == 't') ? '\t' : (escaped == 'n') ? '\n' : escaped);
+    }
+    return QString::fromUtf8(result);
+}
+
+void writePreset(QSettings& settingsFile, const MFEPreset& preset)
+{
+    settingsFile.setValue("action_type", preset.actionType);
+    settingsFile.setValue("action_target", preset.actionTarget);
+    settingsFile.setValue("recursive", preset.isRecursive);
+    settingsFile.setValue("case_sensitive", preset.isCaseSensitive);
+    settingsFile.setValue("autoconfirm_execute", preset.isAutoconfirmExecute);
+    settingsFile.setValue("re_file_pattern", preset.isRegExpFilePattern);
+    settingsFile.setValue("re_search_replace", preset.isRegExpSearchReplace);
+    settingsFile.setValue("highlight_match", preset.isHighlightMatch);
+    settingsFile.setValue("respect_ignore_files", preset.isRespectIgnoreFiles);
+    settingsFile.setValue("spare_page_cache", preset.isSparePageCache);
+    settingsFile.setValue("one_file_system", preset.isOneFileSystem);
+    settingsFile.setValue("dir_path", preset.dirPath);
+    settingsFile.setValue("file_pattern", preset.filePattern);
+    settingsFile.setValue("search_for", preset.searchFor);
+    settingsFile.setValue("replace_with", preset.replaceWith);
+    settingsFile.setValue("exclude_dirs", preset.excludeDirs);
+    settingsFile.setValue("metadata_filter", preset.metadataFilter);
+    settingsFile.setValue("replace_table", preset.replaceTable);
+}
+
+MFEPreset readPreset(const QSettings& settingsFile)
+{
+    MFEPreset preset;
+    preset.actionType = settingsFile.value("action_type").toInt();
+    preset.actionTarget = settingsFile.value("action_target").toInt();
+    preset.isRecursive = settingsFile.value("recursive").toBool();
+    preset.isCaseSensitive = settingsFile.value("case_sensitive").toBool();
+    preset.isAutoconfirmExecute = settingsFile.value("autoconfirm_execute").toBool();
+    preset.isRegExpFilePattern = settingsFile.value("re_file_pattern").toBool();
+    preset.isRegExpSearchReplace = settingsFile.value("re_search_replace").toBool();
+    preset.isHighlightMatch = settingsFile.value("highlight_match").toBool();
+    preset.isRespectIgnoreFiles = settingsFile.value("respect_ignore_files").toBool();
+    preset.isSparePageCache = settingsFile.value("spare_page_cache").toBool();
+    preset.isOneFileSystem = settingsFile.value("one_file_system").toBool();
+    preset.dirPath = settingsFile.value("dir_path").toString();
+    preset.filePattern = settingsFile.value("file_pattern").toString();
+    preset.searchFor = settingsFile.value("search_for").toString();
+    preset.replaceWith = settingsFile.value("replace_with").toString();
+    preset.excludeDirs = settingsFile.value("exclude_dirs").toString();
+    preset.metadataFilter = settingsFile.value("metadata_filter").toString();
+    preset.replaceTable = settingsFile.value("replace_table").toString();
+    return preset;
+}
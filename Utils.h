@@ -7,6 +7,8 @@
 #include <QtCore/QRegularExpression>
 #include <QtCore/QString>
 
+class QSettings;
+
 #ifdef under_cast
 #error "under_cast macro already defined somewhere before - resolve this manually"
 #else
@@ -22,8 +24,16 @@ constexpr QFileDevice::Permissions allPermissions =
 
 #define g_presetsPath "../etc/qMultiFileEditor_Presets.ini"
 #define g_settingsPath "../etc/qMultiFileEditor_Settings.ini"
+#define g_trashListPath "../etc/qMultiFileEditor_Trash.ini"
+#define g_checkpointPath "../etc/qMultiFileEditor_Checkpoint"
 
+QStringList wildcardFiltersFromString(const QString& inputString);
 QString regExpFromWildcardFilters(const QString& inputString);
+// Paths of directory field: quoted paths as in "dir1" "dir2", otherwise the whole string is a single path
+QStringList dirPathsFromString(const QString& inputString);
+// Field of a tab separated record of a log (checkpoint, undo journal); backslashes, tabs and newlines are escaped
+QByteArray escapeLogField(const QString& field);
+QString unescapeLogField(const QByteArray& field);
 
 enum class ActionType : int
 {
@@ -141,13 +151,23 @@ struct MFEPreset
     bool isRegExpFilePattern;
     bool isRegExpSearchReplace;
     bool isHighlightMatch;
+    bool isRespectIgnoreFiles;
+    bool isSparePageCache;
+    bool isOneFileSystem;
     QString dirPath;
     QString filePattern;
     QString searchFor;
     QString replaceWith;
+    QString excludeDirs;
+    QString metadataFilter;
+    QString replaceTable;
     QString presetName;
 };
 
+// Preset as a group of settings file, the group being named after the preset; presetName isn't stored
+void writePreset(QSettings& settingsFile, const MFEPreset& preset);
+MFEPreset readPreset(const QSettings& settingsFile);
+
 struct FileInfoArgs
 {
     QStringList nameFilters;
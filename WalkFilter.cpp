@@ -0,0 +1,89 @@
+#include "WalkFilter.h"
+
+#include <algorithm>
+
+
+WalkFilter::WalkFilter(const QString& excludeDirFilters, bool isRespectIgnoreFiles, Qt::CaseSensitivity caseSensitivity)
+    : m_isRespectIgnoreFiles(isRespectIgnoreFiles)
+{
+    if (!excludeDirFilters.trimmed().isEmpty())
+    {
+        m_excludeDirMatcher = FileNameMatcher::fromWildcardFilters(excludeDirFilters, caseSensitivity);
+        m_hasExcludeDirs = m_excludeDirMatcher.isValid();
+    }
+}
+
+WalkFilter::DirScope::DirScope(WalkFilter& walkFilter, const QDir& dir)
+    : m_walkFilter(walkFilter)
+{
+    if (m_walkFilter.isActive())
+        m_walkFilter.enterDir(dir);
+}
+
+WalkFilter::DirScope::~DirScope()
+{
+    if (m_walkFilter.isActive())
+        m_walkFilter.leaveDir();
+}
+
+void WalkFilter::enterDir(const QDir& dir)
+{
+    Level level;
+    if (!m_levels.isEmpty())
+        level.name = dir.dirName();
+    if (m_isRespectIgnoreFiles)
+    {
+        level.rules.addFile(dir.filePath(".gitignore"));
+        level.rules.addFile(dir.filePath(".ignore"));
+        if (m_levels.isEmpty())
+            level.rules.addFile(dir.filePath(".git/info/exclude"));
+    }
+    m_levels.append(level);
+}
+
+void WalkFilter::leaveDir()
+{
+    m_levels.removeLast();
+}
+
+void WalkFilter::removeFiltered(QList<QFileInfo>& entries) const
+{
+    auto isEntryFiltered = [this](const QFileInfo& entry) { return isExcluded(entry); };
+    entries.erase(std::remove_if(entries.begin(), entries.end(), isEntryFiltered), entries.end());
+}
+
+bool WalkFilter::isExcluded(const QFileInfo& entry) const
+{
+    const QString name = entry.fileName();
+    const bool isDir = entry.isDir();
+    if (isDir && m_hasExcludeDirs && m_excludeDirMatcher.matches(name))
+        return true;
+    if (!m_isRespectIgnoreFiles)
+        return false;
+    if (isDir && (name == QLatin1String(".git")))
+        return true;
+    // rules of the deepest directory take precedence over rules of its parents
+    for (int i = m_levels.size() - 1; i >= 0; --i)
+    {
+        const IgnoreRules& rules = m_levels.at(i).rules;
+        if (rules.isEmpty())
+            continue;
+        const QString path = rules.hasPathRules() ? relativePath(i, name) : QString();
+        switch (rules.match(name, path, isDir))
+        {
+        case IgnoreRules::Result::Ignored:  return true;
+        case IgnoreRules::Result::Included: return false;
+        case IgnoreRules::Result::NoMatch:  break;
+        }
+    }
+    return false;
+}
+
+QString WalkFilter::relativePath(int levelIdx, const QString& name) const
+{
+    QString path;
+    for (int i = levelIdx + 1; i < m_levels.size(); ++i)
+        path.append(m_levels.at(i).name).append('/');
+    path.append(name);
+    return path;
+}
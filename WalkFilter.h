@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "FileNameMatcher.h"
+#include "IgnoreRules.h"
+
+/* Prunes entries of the search walk before they are matched or descended into:
+ *  - directories matching exclude patterns of the preset ("node_modules" "build*"),
+ *  - entries ignored by .gitignore\.ignore files found along the walk (plus .git/info/exclude of the root) and .git itself.
+ * Rules of each directory are read once when the walk enters it and dropped when it leaves.
+ * Keeps the stack of entered directories, so a filter instance serves one walker at a time. */
+class WalkFilter
+{
+public:
+    WalkFilter() = default;
+    // excludeDirFilters are quoted wildcards, same format as lineEdit_filePattern
+    WalkFilter(const QString& excludeDirFilters, bool isRespectIgnoreFiles, Qt::CaseSensitivity caseSensitivity);
+
+    bool isActive() const { return m_hasExcludeDirs || m_isRespectIgnoreFiles; }
+
+    // Removes excluded dirs and ignored entries of the current directory in place, keeping the order
+    void filter(QList<QFileInfo>& entries) const
+    {
+        if (isActive())
+            removeFiltered(entries);
+    }
+    // Same check for a single entry of the current directory
+    bool isFiltered(const QFileInfo& entry) const
+    {
+        return isActive() && isExcluded(entry);
+    }
+
+    // Enters dir on construction and leaves it on destruction; no-op if filter is inactive
+    class DirScope
+    {
+    public:
+        DirScope(WalkFilter& walkFilter, const QDir& dir);
+        ~DirScope();
+    private:
+        Q_DISABLE_COPY(DirScope)
+        WalkFilter& m_walkFilter;
+    };
+
+private:
+    struct Level
+    {
+        QString name; // empty for the root
+        IgnoreRules rules;
+    };
+
+    void enterDir(const QDir& dir);
+    void leaveDir();
+    void removeFiltered(QList<QFileInfo>& entries) const;
+    bool isExcluded(const QFileInfo& entry) const;
+    // Path of name relative to the directory of m_levels[levelIdx]
+    QString relativePath(int levelIdx, const QString& name) const;
+
+    FileNameMatcher m_excludeDirMatcher;
+    bool m_hasExcludeDirs = false;
+    bool m_isRespectIgnoreFiles = false;
+    QVector<Level> m_levels;
+};
@@ -0,0 +1,86 @@
+#include "WalkVisits.h"
+
+#include <QtCore/QFile>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+
+// false where there is no stat(), such directory is always new
+bool dirIdOf(const QString& dirPath, WalkVisits::FileId& dirId)
+{
+#ifdef Q_OS_UNIX
+    struct stat dirStat;
+    if (::stat(QFile::encodeName(dirPath).constData(), &dirStat) != 0)
+        return false;
+    dirId.device = dirStat.st_dev;
+    dirId.inode = dirStat.st_ino;
+    return true;
+#else
+    Q_UNUSED(dirPath)
+    Q_UNUSED(dirId)
+    return false;
+#endif
+}
+
+} // namespace
+
+
+void WalkVisits::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_dirIds.clear();
+    m_linkPaths.clear();
+    m_firstLinkIds.clear();
+}
+
+WalkVisits::Root WalkVisits::enterRoot(const QString& rootPath)
+{
+    FileId rootId;
+    Root root;
+    root.isKnown = dirIdOf(rootPath, rootId);
+    root.device = rootId.device;
+    if (root.isKnown)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_dirIds.insert(rootId);
+    }
+    return root;
+}
+
+WalkVisits::Dir WalkVisits::enterDir(const QString& dirPath, const Root& root)
+{
+    FileId dirId;
+    if (!dirIdOf(dirPath, dirId))
+        return Dir::New;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_dirIds.contains(dirId))
+            return Dir::Revisited;
+        m_dirIds.insert(dirId);
+    }
+    return (root.isKnown && (dirId.device != root.device)) ? Dir::NewOnOtherFileSystem : Dir::New;
+}
+
+QString WalkVisits::addFileLink(const FileId& fileId, const QString& filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList& paths = m_linkPaths[fileId];
+    paths.append(filePath);
+    if (paths.size() > 1)
+        return paths.first();
+    m_firstLinkIds.insert(filePath, fileId);
+    return QString();
+}
+
+QStringList WalkVisits::otherLinks(const QString& filePath) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto idIter = m_firstLinkIds.constFind(filePath);
+    if (idIter == m_firstLinkIds.constEnd())
+        return QStringList();
+    return m_linkPaths.value(idIter.value()).mid(1);
+}
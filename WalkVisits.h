@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QPair>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+/* Identities (st_dev, st_ino) of what a search walk has been through, so nothing is searched twice:
+ *  - directories reachable by several paths (symlinks, bind mounts) are walked under the first path met only,
+ *    which also stops symlink loops,
+ *  - files with several hard links or reached through a symlink are scanned under the first path met only,
+ *    the other paths are reported along with it.
+ * Also tells directories on other filesystems than the root's, so a walk can stay on one filesystem (find -xdev).
+ * Only directories entered and linked files are recorded. One instance serves all roots of a search, so a tree or file reachable
+ * from several roots is searched once too; it's filled by all walker threads at once and read after the walks are done. */
+class WalkVisits
+{
+public:
+    struct FileId
+    {
+        quint64 device = 0;
+        quint64 inode = 0;
+        bool operator==(const FileId& other) const { return (device == other.device) && (inode == other.inode); }
+    };
+    enum class Dir { Revisited, New, NewOnOtherFileSystem };
+    // Filesystem of a walk's root, the one enterDir() compares with
+    struct Root
+    {
+        quint64 device = 0;
+        bool isKnown = false;
+    };
+
+    // Forgets previous search
+    void clear();
+    // Records rootPath as entered; roots of a search are entered before any of them is walked, so each keeps its own tree
+    Root enterRoot(const QString& rootPath);
+    // Records dirPath as entered; Revisited if it was entered before under another path
+    Dir enterDir(const QString& dirPath, const Root& root);
+    // Records filePath as a path of file fileId; returns the path it was first met at, empty if that's filePath
+    QString addFileLink(const FileId& fileId, const QString& filePath);
+    // Paths of the file first met at filePath other than filePath, in order they were met
+    QStringList otherLinks(const QString& filePath) const;
+
+private:
+    mutable QMutex m_mutex;
+    QSet<FileId> m_dirIds;
+    QHash<FileId, QStringList> m_linkPaths;
+    QHash<QString, FileId> m_firstLinkIds;
+};
+
+inline uint qHash(const WalkVisits::FileId& fileId, uint seed = 0)
+{
+    return qHash(qMakePair(fileId.device, fileId.inode), seed);
+}
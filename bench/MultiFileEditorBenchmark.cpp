@@ -0,0 +1,670 @@
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QtTest>
+
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#endif
+
+#include "MultiFileEditor.h"
+#include "ResultExport.h"
+#include "TreeGenerator.h"
+
+Q_DECLARE_METATYPE(TreeSpec)
+
+// Copy of "Qt project (RE)" preset file pattern
+static const QString qtCleanupPattern =
+        "^(Makefile.*|build\\.ninja|CMakeFiles|CMakeCache\\.txt|cmake_install\\.cmake|qtcsettings\\.cmake|CMakeLists.txt.user.+|ui_.+\\.(h|hpp)|qrc_.+\\.cpp"
+        "|moc_.+\\.(o|cpp|h|hpp)(_parameters)?|object_script.+|.*\\.pro\\.user.+|\\.qmake\\.stash|.+\\.prl|\\.?(profile|release|debug|build|moc|obj|bin|ui)|.+\\.(a|o|exe))$";
+static const QString contentsFilePattern = "\"*.cpp\" \"*.h\" \"*.txt\"";
+
+/* Measures wall time and peak RSS of a single benchmark phase and prints files/s, MB/s, peak RSS and, for content searches, ns per line.
+ * On Linux peak RSS is reset at the start of every phase via /proc/self/clear_refs, elsewhere it's the peak of the whole process. */
+class PhaseMeter
+{
+public:
+    explicit PhaseMeter(const QString& phaseName)
+        : m_phaseName(phaseName)
+    {
+        resetPeakRss();
+        m_timer.start();
+    }
+
+    void report(qint64 fileCount, qint64 byteCount, int iterations = 1, qint64 lineCount = 0)
+    {
+        const qint64 elapsedNs = qMax<qint64>(m_timer.nsecsElapsed(), 1);
+        const double seconds = static_cast<double>(elapsedNs) / 1e9;
+        const double filesPerSec = static_cast<double>(fileCount) * iterations / seconds;
+        const double mbPerSec = static_cast<double>(byteCount) * iterations / (1024.0 * 1024.0) / seconds;
+        QString text = QString("%1: %2 files/s, %3 MB/s, peak RSS %4 MB (%5 ms per iteration")
+                       .arg(m_phaseName, -24)
+                       .arg(filesPerSec, 0, 'f', 0)
+                       .arg(mbPerSec, 0, 'f', 2)
+                       .arg(static_cast<double>(peakRssKb()) / 1024.0, 0, 'f', 1)
+                       .arg(seconds * 1000.0 / iterations, 0, 'f', 2);
+        if (lineCount > 0)
+            text.append(QString(", %1 ns per line").arg(static_cast<double>(elapsedNs) / iterations / lineCount, 0, 'f', 1));
+        qInfo().noquote() << text + ')';
+    }
+
+private:
+    static void resetPeakRss()
+    {
+#ifdef Q_OS_LINUX
+        QFile clearRefs("/proc/self/clear_refs");
+        if (clearRefs.open(QIODevice::WriteOnly))
+            clearRefs.write("5");
+#endif
+    }
+
+    static qint64 peakRssKb()
+    {
+#ifdef Q_OS_LINUX
+        QFile status("/proc/self/status");
+        if (status.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            const QList<QByteArray> lines = status.readAll().split('\n');
+            for (const QByteArray& line : lines)
+                if (line.startsWith("VmHWM:"))
+                    return line.mid(6).trimmed().split(' ').front().toLongLong();
+        }
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+            return usage.ru_maxrss;
+#endif
+        return 0;
+    }
+
+    QString m_phaseName;
+    QElapsedTimer m_timer;
+};
+
+
+class MultiFileEditorBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void fileNameMatching_data();
+    void fileNameMatching();
+
+    void searchFileDirToRemove_data();
+    void searchFileDirToRemove();
+    void searchFileDirToReplace_data();
+    void searchFileDirToReplace();
+    void searchFileContentsToReplaceRegExp_data();
+    void searchFileContentsToReplaceRegExp();
+    void searchFileContentsToReplaceString_data();
+    void searchFileContentsToReplaceString();
+    void searchFileContentsToReplaceTable_data();
+    void searchFileContentsToReplaceTable();
+    void searchFileContentsReadBackend_data();
+    void searchFileContentsReadBackend();
+    void searchFileContentsToFile_data();
+    void searchFileContentsToFile();
+
+    void executeRemoveFilesDirs_data();
+    void executeRemoveFilesDirs();
+    void executeReplaceFilesDirs_data();
+    void executeReplaceFilesDirs();
+    void executeReplaceFileContents_data();
+    void executeReplaceFileContents();
+    void executeReplaceFileContentsSpilled_data();
+    void executeReplaceFileContentsSpilled();
+
+private:
+    static void addTreeShapes();
+    static void prepareEditor(MultiFileEditor& editor, const QString& dirPath);
+    static void setupAction(MultiFileEditor& editor, ActionType actionType, ActionTarget actionTarget);
+    // Also restarts walk, so every iteration walks the whole tree again
+    static void clearResults(MultiFileEditor& editor, WalkContext& walk, QList<QTreeWidgetItem*>& results);
+
+    // Holds bin\ and etc\ so that editor's relative settings and presets paths never touch real ones
+    QTemporaryDir m_workDir;
+};
+
+void MultiFileEditorBenchmark::initTestCase()
+{
+    QVERIFY(m_workDir.isValid());
+    QDir workDir(m_workDir.path());
+    workDir.mkpath("bin");
+    workDir.mkpath("etc");
+    QDir::setCurrent(workDir.filePath("bin"));
+}
+
+void MultiFileEditorBenchmark::addTreeShapes()
+{
+    QTest::addColumn<TreeSpec>("spec");
+
+    TreeSpec spec;
+    QTest::newRow("default") << spec;
+
+    TreeSpec smallFiles;
+    smallFiles.depth = 4;
+    smallFiles.fanOut = 5;
+    smallFiles.filesPerDir = 24;
+    smallFiles.minFileSize = 64;
+    smallFiles.maxFileSize = 1024;
+    QTest::newRow("many_small_files") << smallFiles;
+
+    TreeSpec largeFiles;
+    largeFiles.depth = 1;
+    largeFiles.fanOut = 4;
+    largeFiles.filesPerDir = 8;
+    largeFiles.minFileSize = 1024 * 1024;
+    largeFiles.maxFileSize = 4 * 1024 * 1024;
+    QTest::newRow("large_files") << largeFiles;
+
+    TreeSpec longLines;
+    longLines.longLineRatio = 0.05;
+    QTest::newRow("long_lines") << longLines;
+
+    TreeSpec denseHits;
+    denseHits.hitDensity = 0.5;
+    QTest::newRow("dense_hits") << denseHits;
+
+    TreeSpec binaryFiles;
+    binaryFiles.binaryRatio = 0.5;
+    QTest::newRow("binary_files") << binaryFiles;
+}
+
+void MultiFileEditorBenchmark::prepareEditor(MultiFileEditor& editor, const QString& dirPath)
+{
+    editor.isRecursive = true;
+    editor.isHighlight = true;
+    editor.caseSensitivity = Qt::CaseSensitive;
+    editor.ui->lineEdit_dirPath->setText(dirPath);
+}
+
+void MultiFileEditorBenchmark::setupAction(MultiFileEditor& editor, ActionType actionType, ActionTarget actionTarget)
+{
+    Ui::MultiFileEditor* ui = editor.ui;
+    ui->comboBox_actionType->setCurrentIndex(ui->comboBox_actionType->findData(static_cast<int>(actionType), Qt::UserRole));
+    ui->comboBox_actionTarget->setCurrentIndex(ui->comboBox_actionTarget->findData(static_cast<int>(actionTarget), Qt::UserRole));
+    editor.onActionCombosActivated();
+    ui->checkBox_isRecursive->setChecked(true);
+    ui->checkBox_isCaseSensitive->setChecked(true);
+    ui->checkBox_isAutoconfirmExecute->setChecked(true);
+    ui->checkBox_isHighlightMatch->setChecked(true);
+}
+
+void MultiFileEditorBenchmark::clearResults(MultiFileEditor& editor, WalkContext& walk, QList<QTreeWidgetItem*>& results)
+{
+    qDeleteAll(results);
+    results.clear();
+    editor.m_fileDirEntryMap.clear();
+    editor.m_fileContentsEntryMap.clear();
+    editor.m_resultStore.clear();
+    editor.m_walkVisits.clear();
+    walk.visitsRoot = editor.m_walkVisits.enterRoot(walk.rootDir.canonicalPath());
+}
+
+// Matching cost of file pattern alone: PCRE (as used before FileNameMatcher) versus compiled matcher
+void MultiFileEditorBenchmark::fileNameMatching_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<bool>("isRegExp");
+    QTest::addColumn<bool>("isCompiled");
+    QTest::newRow("wildcard_pcre") << contentsFilePattern << false << false;
+    QTest::newRow("wildcard_compiled") << contentsFilePattern << false << true;
+    QTest::newRow("qt_cleanup_pcre") << qtCleanupPattern << true << false;
+    QTest::newRow("qt_cleanup_compiled") << qtCleanupPattern << true << true;
+}
+
+void MultiFileEditorBenchmark::fileNameMatching()
+{
+    QFETCH(QString, pattern);
+    QFETCH(bool, isRegExp);
+    QFETCH(bool, isCompiled);
+
+    // Names of a generated tree, without touching the disk
+    QStringList fileNames;
+    for (int i = 0; i < 10000; ++i)
+    {
+        switch (i % 8)
+        {
+        case 0: fileNames.append(QString("moc_file_%1.cpp").arg(i)); break;
+        case 1: fileNames.append(QString("file_%1.o").arg(i)); break;
+        case 2: fileNames.append(QString("dir_%1").arg(i)); break;
+        case 3: fileNames.append(QString("Makefile.%1").arg(i)); break;
+        default: fileNames.append(QString("file_%1.%2").arg(i).arg(QStringList({"cpp", "h", "txt", "md"}).at(i % 4)));
+        }
+    }
+
+    const QRegularExpression regExp(isRegExp ? pattern : regExpFromWildcardFilters(pattern), QRegularExpression::DontCaptureOption);
+    const FileNameMatcher matcher = isRegExp ? FileNameMatcher(regExp) : FileNameMatcher::fromWildcardFilters(pattern, Qt::CaseSensitive);
+    QVERIFY(matcher.isFullyCompiled());
+    int matchCount = 0;
+    int iterations = 0;
+    PhaseMeter meter(isCompiled ? "FileNameMatcher" : "QRegularExpression");
+    QBENCHMARK
+    {
+        matchCount = 0;
+        for (const QString& fileName : qAsConst(fileNames))
+            matchCount += isCompiled ? matcher.matches(fileName) : regExp.match(fileName).hasMatch();
+        ++iterations;
+    }
+    meter.report(fileNames.size(), 0, iterations);
+
+    int pcreMatchCount = 0;
+    for (const QString& fileName : qAsConst(fileNames))
+        pcreMatchCount += regExp.match(fileName).hasMatch();
+    QCOMPARE(matchCount, pcreMatchCount);
+}
+
+void MultiFileEditorBenchmark::searchFileDirToRemove_data()
+{
+    addTreeShapes();
+}
+
+void MultiFileEditorBenchmark::searchFileDirToRemove()
+{
+    QFETCH(TreeSpec, spec);
+    QTemporaryDir treeDir;
+    const TreeStats stats = TreeGenerator(spec).generate(QDir(treeDir.path()));
+
+    MultiFileEditor editor;
+    prepareEditor(editor, treeDir.path());
+    WalkContext walk = editor.newWalkContext(treeDir.path());
+    const FileNameMatcher matcher(QRegularExpression(qtCleanupPattern, QRegularExpression::DontCaptureOption));
+    QList<QTreeWidgetItem*> results;
+    int iterations = 0;
+    PhaseMeter meter("searchFileDirToRemove");
+    QBENCHMARK
+    {
+        clearResults(editor, walk, results);
+        results.append(editor.searchFileDirToRemove(walk, walk.rootDir, QDir::NoDotAndDotDot | QDir::Files | QDir::Dirs, matcher));
+        ++iterations;
+    }
+    meter.report(stats.fileCount + stats.dirCount, 0, iterations);
+    clearResults(editor, walk, results);
+}
+
+void MultiFileEditorBenchmark::searchFileDirToReplace_data()
+{
+    addTreeShapes();
+}
+
+void MultiFileEditorBenchmark::searchFileDirToReplace()
+{
+    QFETCH(TreeSpec, spec);
+    QTemporaryDir treeDir;
+    const TreeStats stats = TreeGenerator(spec).generate(QDir(treeDir.path()));
+
+    MultiFileEditor editor;
+    prepareEditor(editor, treeDir.path());
+    WalkContext walk = editor.newWalkContext(treeDir.path());
+    const QRegularExpression regExp("file_");
+    QList<QTreeWidgetItem*> results;
+    int iterations = 0;
+    PhaseMeter meter("searchFileDirToReplace");
+    QBENCHMARK
+    {
+        clearResults(editor, walk, results);
+        results.append(editor.searchFileDirToReplace(walk, walk.rootDir, QDir::NoDotAndDotDot | QDir::Files | QDir::Dirs, regExp, "renamed_"));
+        ++iterations;
+    }
+    meter.report(stats.fileCount + stats.dirCount, 0, iterations);
+    clearResults(editor, walk, results);
+}
+
+void MultiFileEditorBenchmark::searchFileContentsToReplaceRegExp_data()
+{
+    addTreeShapes();
+}
+
+void MultiFileEditorBenchmark::searchFileContentsToReplaceRegExp()
+{
+    QFETCH(TreeSpec, spec);
+    QTemporaryDir treeDir;
+    const TreeStats stats = TreeGenerator(spec).generate(QDir(treeDir.path()));
+
+    MultiFileEditor editor;
+    prepareEditor(editor, treeDir.path());
+    WalkContext walk = editor.newWalkContext(treeDir.path());
+    const FileNameMatcher fileMatcher = FileNameMatcher::fromWildcardFilters(contentsFilePattern, Qt::CaseSensitive);
+    const SearchRegExp searchRegExp(QRegularExpression(spec.hitToken + "\\w*"), "qmfe_replaced");
+    QList<QTreeWidgetItem*> results;
+    int iterations = 0;
+    PhaseMeter meter("searchFileContents (RE)");
+    QBENCHMARK
+    {
+        clearResults(editor, walk, results);
+        results = editor.searchFileContentsToReplace(walk, walk.rootDir, fileMatcher, searchRegExp);
+        ++iterations;
+    }
+    meter.report(stats.fileCount, stats.totalBytes, iterations, stats.lineCount);
+    clearResults(editor, walk, results);
+}
+
+void MultiFileEditorBenchmark::searchFileContentsToReplaceString_data()
+{
+    addTreeShapes();
+}
+
+void MultiFileEditorBenchmark::searchFileContentsToReplaceString()
+{
+    QFETCH(TreeSpec, spec);
+    QTemporaryDir treeDir;
+    const TreeStats stats = TreeGenerator(spec).generate(QDir(treeDir.path()));
+
+    MultiFileEditor editor;
+    prepareEditor(editor, treeDir.path());
+    WalkContext walk = editor.newWalkContext(treeDir.path());
+    const FileNameMatcher fileMatcher = FileNameMatcher::fromWildcardFilters(contentsFilePattern, Qt::CaseSensitive);
+    QList<QTreeWidgetItem*> results;
+    int iterations = 0;
+    PhaseMeter meter("searchFileContents (string)");
+    QBENCHMARK
+    {
+        clearResults(editor, walk, results);
+        results = editor.searchFileContentsToReplace(walk, walk.rootDir, fileMatcher, spec.hitToken, "qmfe_replaced");
+        ++iterations;
+    }
+    meter.report(stats.fileCount, stats.totalBytes, iterations, stats.lineCount);
+    clearResults(editor, walk, results);
+}
+
+// Throughput of a replace table is expected to stay roughly flat as the number of literal pairs grows
+void MultiFileEditorBenchmark::searchFileContentsToReplaceTable_data()
+{
+    QTest::addColumn<int>("pairCount");
+    QTest::newRow("pairs_1") << 1;
+    QTest::newRow("pairs_10") << 10;
+    QTest::newRow("pairs_100") << 100;
+    QTest::newRow("pairs_1000") << 1000;
+}
+
+void MultiFileEditorBenchmark::searchFileContentsToReplaceTable()
+{
+    QFETCH(int, pairCount);
+    TreeSpec spec;
+    QTemporaryDir treeDir;
+    const TreeStats stats = TreeGenerator(spec).generate(QDir(treeDir.path()));
+
+    MultiFileEditor editor;
+    prepareEditor(editor, treeDir.path());
+    WalkContext walk = editor.newWalkContext(treeDir.path());
+    const FileNameMatcher fileMatcher = FileNameMatcher::fromWildcardFilters(contentsFilePattern, Qt::CaseSensitive);
+    // hitToken is the last pair, the rest are identifiers that never occur in generated text
+    QVector<ReplaceTable::Pair> pairs;
+    for (int i = 1; i < pairCount; ++i)
+        pairs.append({QString("qmfe_identifier_%1").arg(i), QString("qmfe_renamed_%1").arg(i), false});
+    pairs.append({spec.hitToken, "qmfe_replaced", false});
+    ReplaceTable replaceTable;
+    replaceTable.setPairs(pairs);
+    QVERIFY(replaceTable.compile(Qt::CaseSensitive));
+    QList<QTreeWidgetItem*> results;
+    int iterations = 0;
+    PhaseMeter meter(QString("searchFileContents (table %1)").arg(pairCount));
+    QBENCHMARK
+    {
+        clearResults(editor, walk, results);
+        results = editor.searchFileContentsToReplace(walk, walk.rootDir, fileMatcher, replaceTable);
+        ++iterations;
+    }
+    meter.report(stats.fileCount, stats.totalBytes, iterations, stats.lineCount);
+    clearResults(editor, walk, results);
+}
+
+// Execute benchmarks modify the tree, so each one runs exactly once on a freshly generated tree
+// Same string search read through io_uring and synchronously; where io_uring is unavailable both rows measure the sync reader
+void MultiFileEditorBenchmark::searchFileContentsReadBackend_data()
+{
+    QTest::addColumn<TreeSpec>("spec");
+    QTest::addColumn<int>("backend");
+
+    TreeSpec spec;
+    TreeSpec smallFiles;
+    smallFiles.depth = 4;
+    smallFiles.fanOut = 5;
+    smallFiles.filesPerDir = 24;
+    smallFiles.minFileSize = 64;
+    smallFiles.maxFileSize = 1024;
+    for (FileReader::Backend backend : {FileReader::Backend::Uring, FileReader::Backend::Sync})
+    {
+        const char* backendName = (backend == FileReader::Backend::Uring) ? "io_uring" : "sync";
+        QTest::newRow(QString("default_%1").arg(backendName).toLatin1().constData()) << spec << static_cast<int>(backend);
+        QTest::newRow(QString("many_small_files_%1").arg(backendName).toLatin1().constData()) << smallFiles << static_cast<int>(backend);
+    }
+}
+
+void MultiFileEditorBenchmark::searchFileContentsReadBackend()
+{
+    QFETCH(TreeSpec, spec);
+    QFETCH(int, backend);
+    QTemporaryDir treeDir;
+    const TreeStats stats = TreeGenerator(spec).generate(QDir(treeDir.path()));
+
+    MultiFileEditor editor;
+    prepareEditor(editor, treeDir.path());
+    editor.m_ioBackend = static_cast<FileReader::Backend>(backend);
+    editor.m_ioQueueDepth = 32;
+    WalkContext walk = editor.newWalkContext(treeDir.path());
+    const FileNameMatcher fileMatcher = FileNameMatcher::fromWildcardFilters(contentsFilePattern, Qt::CaseSensitive);
+    QList<QTreeWidgetItem*> results;
+    int iterations = 0;
+    PhaseMeter meter(QString("searchFileContents (%1)").arg((walk.fileReader->backend() == FileReader::Backend::Uring) ? "io_uring" : "sync"));
+    QBENCHMARK
+    {
+        clearResults(editor, walk, results);
+        results = editor.searchFileContentsToReplace(walk, walk.rootDir, fileMatcher, spec.hitToken, "qmfe_replaced");
+        ++iterations;
+    }
+    meter.report(stats.fileCount, stats.totalBytes, iterations, stats.lineCount);
+    clearResults(editor, walk, results);
+}
+
+// Same string search into the results tree and streamed to a file in each export format; "tree" is the baseline
+void MultiFileEditorBenchmark::searchFileContentsToFile_data()
+{
+    QTest::addColumn<TreeSpec>("spec");
+    QTest::addColumn<QString>("exportFileName");
+
+    TreeSpec spec;
+    TreeSpec denseHits;
+    denseHits.hitDensity = 0.5;
+    for (const QString& exportFileName : {QString(), QString("results.jsonl"), QString("results.csv"), QString("results.jsonl.gz")})
+    {
+        const QString rowSuffix = exportFileName.isEmpty() ? QString("tree") : exportFileName.mid(exportFileName.indexOf('.') + 1).replace('.', '_');
+        QTest::newRow(QString("default_%1").arg(rowSuffix).toLatin1().constData()) << spec << exportFileName;
+        QTest::newRow(QString("dense_hits_%1").arg(rowSuffix).toLatin1().constData()) << denseHits << exportFileName;
+    }
+}
+
+void MultiFileEditorBenchmark::searchFileContentsToFile()
+{
+    QFETCH(TreeSpec, spec);
+    QFETCH(QString, exportFileName);
+    QTemporaryDir treeDir;
+    const TreeStats stats = TreeGenerator(spec).generate(QDir(treeDir.path()));
+    QTemporaryDir exportDir;
+
+    MultiFileEditor editor;
+    prepareEditor(editor, treeDir.path());
+    WalkContext walk = editor.newWalkContext(treeDir.path());
+    const FileNameMatcher fileMatcher = FileNameMatcher::fromWildcardFilters(contentsFilePattern, Qt::CaseSensitive);
+    QList<QTreeWidgetItem*> results;
+    qint64 rowCount = 0;
+    int iterations = 0;
+    const QString phaseName = QString("searchFileContents (to %1)").arg(exportFileName.isEmpty() ? QString("tree") : exportFileName);
+    PhaseMeter meter(phaseName);
+    QBENCHMARK
+    {
+        clearResults(editor, walk, results);
+        std::unique_ptr<ResultExport> resultExport;
+        if (!exportFileName.isEmpty())
+        {
+            resultExport.reset(new ResultExport(QDir(exportDir.path()).filePath(exportFileName)));
+            QVERIFY(resultExport->open());
+        }
+        editor.m_pExport = resultExport.get();
+        results = editor.searchFileContentsToReplace(walk, walk.rootDir, fileMatcher, spec.hitToken, "qmfe_replaced");
+        editor.m_pExport = nullptr;
+        if (resultExport)
+        {
+            QVERIFY(resultExport->finish());
+            QVERIFY(results.isEmpty());
+            rowCount = resultExport->rowCount();
+        }
+        ++iterations;
+    }
+    meter.report(stats.fileCount, stats.totalBytes, iterations, stats.lineCount);
+    if (!exportFileName.isEmpty())
+    {
+        // a row per hit, hit lines of files the pattern leaves out aren't rows
+        QVERIFY((rowCount > 0) && (rowCount <= stats.hitLines));
+        qInfo().noquote() << QString("%1: %2 rows exported").arg(phaseName, -24).arg(rowCount);
+    }
+    clearResults(editor, walk, results);
+}
+
+void MultiFileEditorBenchmark::executeRemoveFilesDirs_data()
+{
+    addTreeShapes();
+}
+
+void MultiFileEditorBenchmark::executeRemoveFilesDirs()
+{
+    QFETCH(TreeSpec, spec);
+    QTemporaryDir treeDir;
+    const TreeStats stats = TreeGenerator(spec).generate(QDir(treeDir.path()));
+
+    MultiFileEditor editor;
+    setupAction(editor, ActionType::Remove, ActionTarget::FilesDirs);
+    editor.ui->checkBox_isRegExpFilePattern->setChecked(true);
+    editor.ui->lineEdit_dirPath->setText(treeDir.path());
+    editor.ui->lineEdit_filePattern->setText(qtCleanupPattern);
+
+    PhaseMeter searchMeter("search remove");
+    editor.execute();
+    searchMeter.report(stats.fileCount + stats.dirCount, 0);
+    QVERIFY(editor.m_isSearchDone);
+
+    PhaseMeter executeMeter("execute remove");
+    QBENCHMARK_ONCE
+    {
+        editor.execute();
+    }
+    executeMeter.report(stats.fileCount + stats.dirCount, 0);
+}
+
+void MultiFileEditorBenchmark::executeReplaceFilesDirs_data()
+{
+    addTreeShapes();
+}
+
+void MultiFileEditorBenchmark::executeReplaceFilesDirs()
+{
+    QFETCH(TreeSpec, spec);
+    QTemporaryDir treeDir;
+    const TreeStats stats = TreeGenerator(spec).generate(QDir(treeDir.path()));
+
+    MultiFileEditor editor;
+    setupAction(editor, ActionType::Replace, ActionTarget::FilesDirs);
+    editor.ui->lineEdit_dirPath->setText(treeDir.path());
+    editor.ui->lineEdit_searchFor->setText("(file|dir)_");
+    editor.ui->lineEdit_replaceWith->setText("renamed_\\1_");
+
+    PhaseMeter searchMeter("search rename");
+    editor.execute();
+    searchMeter.report(stats.fileCount + stats.dirCount, 0);
+    QVERIFY(editor.m_isSearchDone);
+
+    PhaseMeter executeMeter("execute rename");
+    QBENCHMARK_ONCE
+    {
+        editor.execute();
+    }
+    executeMeter.report(stats.fileCount + stats.dirCount, 0);
+}
+
+void MultiFileEditorBenchmark::executeReplaceFileContents_data()
+{
+    addTreeShapes();
+}
+
+void MultiFileEditorBenchmark::executeReplaceFileContents()
+{
+    QFETCH(TreeSpec, spec);
+    QTemporaryDir treeDir;
+    const TreeStats stats = TreeGenerator(spec).generate(QDir(treeDir.path()));
+
+    MultiFileEditor editor;
+    setupAction(editor, ActionType::Replace, ActionTarget::FileContents);
+    editor.ui->checkBox_isRegExpFilePattern->setChecked(false);
+    editor.ui->checkBox_isRegExpSearchReplace->setChecked(false);
+    editor.ui->lineEdit_dirPath->setText(treeDir.path());
+    editor.ui->lineEdit_filePattern->setText(contentsFilePattern);
+    editor.ui->lineEdit_searchFor->setText(spec.hitToken);
+    editor.ui->lineEdit_replaceWith->setText("qmfe_replaced");
+
+    PhaseMeter searchMeter("search contents");
+    editor.execute();
+    searchMeter.report(stats.fileCount, stats.totalBytes);
+    QVERIFY(editor.m_isSearchDone);
+
+    PhaseMeter executeMeter("execute contents");
+    QBENCHMARK_ONCE
+    {
+        editor.execute();
+    }
+    executeMeter.report(stats.fileCount, stats.totalBytes);
+}
+
+// Lines of files with results held in memory against all of them spilled to disk: peak RSS of search and cost of reading back
+void MultiFileEditorBenchmark::executeReplaceFileContentsSpilled_data()
+{
+    QTest::addColumn<TreeSpec>("spec");
+    QTest::addColumn<qint64>("memoryLimit");
+
+    TreeSpec largeFiles;
+    largeFiles.depth = 1;
+    largeFiles.fanOut = 4;
+    largeFiles.filesPerDir = 8;
+    largeFiles.minFileSize = 1024 * 1024;
+    largeFiles.maxFileSize = 4 * 1024 * 1024;
+    TreeSpec denseHits;
+    denseHits.hitDensity = 0.5;
+    QTest::newRow("large_files_held") << largeFiles << qint64(-1);
+    QTest::newRow("large_files_spilled") << largeFiles << qint64(0);
+    QTest::newRow("dense_hits_held") << denseHits << qint64(-1);
+    QTest::newRow("dense_hits_spilled") << denseHits << qint64(0);
+}
+
+void MultiFileEditorBenchmark::executeReplaceFileContentsSpilled()
+{
+    QFETCH(TreeSpec, spec);
+    QFETCH(qint64, memoryLimit);
+    QTemporaryDir treeDir;
+    const TreeStats stats = TreeGenerator(spec).generate(QDir(treeDir.path()));
+
+    MultiFileEditor editor;
+    editor.m_resultStore.setMemoryLimit(memoryLimit);
+    setupAction(editor, ActionType::Replace, ActionTarget::FileContents);
+    editor.ui->checkBox_isRegExpFilePattern->setChecked(false);
+    editor.ui->checkBox_isRegExpSearchReplace->setChecked(false);
+    editor.ui->lineEdit_dirPath->setText(treeDir.path());
+    editor.ui->lineEdit_filePattern->setText(contentsFilePattern);
+    editor.ui->lineEdit_searchFor->setText(spec.hitToken);
+    editor.ui->lineEdit_replaceWith->setText("qmfe_replaced");
+
+    PhaseMeter searchMeter("search contents");
+    editor.execute();
+    searchMeter.report(stats.fileCount, stats.totalBytes);
+    QVERIFY(editor.m_isSearchDone);
+    QCOMPARE(editor.m_resultStore.spilledBytes() > 0, memoryLimit == 0);
+
+    PhaseMeter executeMeter("execute contents");
+    QBENCHMARK_ONCE
+    {
+        editor.execute();
+    }
+    executeMeter.report(stats.fileCount, stats.totalBytes);
+}
+
+QTEST_MAIN(MultiFileEditorBenchmark)
+#include "MultiFileEditorBenchmark.moc"
@@ -0,0 +1,118 @@
+#include "TreeGenerator.h"
+
+#include <QtCore/QFile>
+
+
+// Names matched by "Qt project (RE)" preset, so remove benchmarks have something to find
+static const QStringList artifactDirNames = {"build", "debug", "release", "obj", "moc", "bin", "ui", "CMakeFiles"};
+
+TreeGenerator::TreeGenerator(const TreeSpec& spec)
+    : m_spec(spec)
+    , m_random(spec.seed)
+{}
+
+TreeStats TreeGenerator::generate(const QDir& rootDir)
+{
+    m_random.seed(m_spec.seed);
+    m_stats = TreeStats();
+    generateDir(rootDir, 0);
+    return m_stats;
+}
+
+void TreeGenerator::generateDir(const QDir& dir, int level)
+{
+    ++m_stats.dirCount;
+    for (int i = 0; i < m_spec.filesPerDir; ++i)
+        generateFile(dir.filePath(makeEntryName("file", i, false)));
+
+    if (level >= m_spec.depth)
+        return;
+    for (int i = 0; i < m_spec.fanOut; ++i)
+    {
+        const QString dirName = makeEntryName("dir", i, true);
+        dir.mkdir(dirName);
+        generateDir(QDir(dir.filePath(dirName)), level + 1);
+    }
+}
+
+void TreeGenerator::generateFile(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+
+    const int fileSize = (m_spec.maxFileSize > m_spec.minFileSize)
+                       ? m_spec.minFileSize + static_cast<int>(m_random.bounded(static_cast<quint32>(m_spec.maxFileSize - m_spec.minFileSize)))
+                       : m_spec.minFileSize;
+    QByteArray content;
+    content.reserve(fileSize + m_spec.longLineLength);
+    if (roll(m_spec.binaryRatio))
+    {
+        content.resize(fileSize);
+        for (int i = 0; i < fileSize; ++i)
+            content[i] = static_cast<char>(m_random.bounded(256));
+    }
+    else
+    {
+        while (content.size() < fileSize)
+        {
+            const bool isHit = roll(m_spec.hitDensity);
+            const int length = roll(m_spec.longLineRatio)
+                             ? m_spec.longLineLength
+                             : m_spec.lineLength / 2 + static_cast<int>(m_random.bounded(static_cast<quint32>(m_spec.lineLength + 1)));
+            content.append(makeTextLine(length, isHit)).append('\n');
+            ++m_stats.lineCount;
+            if (isHit)
+                ++m_stats.hitLines;
+        }
+    }
+    file.write(content);
+    ++m_stats.fileCount;
+    m_stats.totalBytes += content.size();
+}
+
+QByteArray TreeGenerator::makeTextLine(int length, bool isHit)
+{
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ";
+    QByteArray line(length, ' ');
+    for (int i = 0; i < length; ++i)
+        line[i] = alphabet[m_random.bounded(static_cast<quint32>(sizeof(alphabet) - 1))];
+    if (isHit)
+    {
+        const QByteArray token = m_spec.hitToken.toUtf8();
+        const int pos = (length > token.size()) ? static_cast<int>(m_random.bounded(static_cast<quint32>(length - token.size()))) : 0;
+        line.replace(pos, qMin(token.size(), line.size() - pos), token);
+    }
+    return line;
+}
+
+QString TreeGenerator::makeEntryName(const QString& baseName, int index, bool isDir)
+{
+    const bool isArtifact = roll(m_spec.artifactRatio);
+    if (isDir)
+    {
+        if (isArtifact && (index < artifactDirNames.size()))
+            return artifactDirNames.at(index);
+        return QString("%1_%2").arg(baseName).arg(index);
+    }
+
+    if (isArtifact)
+    {
+        switch (index % 4)
+        {
+        case 0: return QString("moc_%1_%2.cpp").arg(baseName).arg(index);
+        case 1: return QString("%1_%2.o").arg(baseName).arg(index);
+        case 2: return QString("ui_%1_%2.h").arg(baseName).arg(index);
+        default: return QString("Makefile.%1").arg(index);
+        }
+    }
+    const QString& suffix = m_spec.fileSuffixes.at(index % m_spec.fileSuffixes.size());
+    return QString("%1_%2.%3").arg(baseName).arg(index).arg(suffix);
+}
+
+bool TreeGenerator::roll(double probability)
+{
+    if (probability <= 0.0)
+        return false;
+    return m_random.generateDouble() < probability;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QtCore/QDir>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+/* Parameters of a synthetic directory tree.
+ * Same TreeSpec (including seed) always produces byte-identical tree, so results of different builds are comparable. */
+struct TreeSpec
+{
+    quint32 seed = 1;
+    int depth = 3;              // levels of subdirectories below root
+    int fanOut = 4;             // subdirectories per directory
+    int filesPerDir = 16;
+    int minFileSize = 256;      // bytes
+    int maxFileSize = 16384;    // bytes
+    int lineLength = 80;        // average length of a regular line
+    double longLineRatio = 0.0; // fraction of lines that are longLineLength long
+    int longLineLength = 65536;
+    double hitDensity = 0.05;   // fraction of lines containing hitToken
+    double binaryRatio = 0.0;   // fraction of files filled with random bytes instead of text
+    double artifactRatio = 0.1; // fraction of files\dirs named as build artifacts (matched by Qt cleanup presets)
+    QString hitToken = "qmfe_needle";
+    QStringList fileSuffixes = {"cpp", "h", "txt", "md"};
+};
+
+struct TreeStats
+{
+    qint64 dirCount = 0;
+    qint64 fileCount = 0;
+    qint64 totalBytes = 0;
+    qint64 lineCount = 0; // lines of text files
+    qint64 hitLines = 0;
+};
+
+class TreeGenerator
+{
+public:
+    explicit TreeGenerator(const TreeSpec& spec);
+
+    // Creates tree inside rootDir (which must exist and is expected to be empty). Returns statistics of what was written.
+    TreeStats generate(const QDir& rootDir);
+
+private:
+    void generateDir(const QDir& dir, int level);
+    void generateFile(const QString& filePath);
+    QByteArray makeTextLine(int length, bool isHit);
+    QString makeEntryName(const QString& baseName, int index, bool isDir);
+    bool roll(double probability);
+
+    TreeSpec m_spec;
+    QRandomGenerator m_random;
+    TreeStats m_stats;
+};
@@ -0,0 +1,97 @@
+QT += \
+    core    \
+    gui     \
+    widgets \
+    concurrent \
+    testlib
+
+TARGET = qMultiFileEditor_bench
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG += warn_on
+CONFIG -= app_bundle
+win32: !contains(CONFIG, build_all): CONFIG -= debug_and_release
+
+CONFIG(debug, debug|release) {
+    BUILD_TYPE = debug
+    DEFINES *= DEBUG_BUILD
+}
+CONFIG(release, debug|release) {
+    BUILD_TYPE = release
+    DEFINES *= RELEASE_BUILD
+    QMAKE_CXXFLAGS += -O2
+}
+
+SRC_DIR     = $$PWD/..
+DESTDIR     = $$SRC_DIR/bin
+UI_DIR      = $$OUT_PWD/ui
+TARGET      = $${TARGET}.$${BUILD_TYPE}
+INCLUDEPATH += $$SRC_DIR
+
+SOURCES += \
+        TreeGenerator.cpp \
+        MultiFileEditorBenchmark.cpp \
+        $$SRC_DIR/AhoCorasick.cpp \
+        $$SRC_DIR/Checkpoint.cpp \
+        $$SRC_DIR/ExecuteJournal.cpp \
+        $$SRC_DIR/ExecutionPlan.cpp \
+        $$SRC_DIR/FileFingerprint.cpp \
+        $$SRC_DIR/FileReader.cpp \
+        $$SRC_DIR/FileNameMatcher.cpp \
+        $$SRC_DIR/IgnoreRules.cpp \
+        $$SRC_DIR/LinearRegExp.cpp \
+        $$SRC_DIR/MetadataFilter.cpp \
+        $$SRC_DIR/MulticolorDelegate.cpp \
+        $$SRC_DIR/Profiler.cpp \
+        $$SRC_DIR/Progress.cpp \
+        $$SRC_DIR/RenamePlan.cpp \
+        $$SRC_DIR/ReplaceTable.cpp \
+        $$SRC_DIR/ReplaceTableDialog.cpp \
+        $$SRC_DIR/ResultExport.cpp \
+        $$SRC_DIR/ResultStore.cpp \
+        $$SRC_DIR/SearchRegExp.cpp \
+        $$SRC_DIR/TaskGroup.cpp \
+        $$SRC_DIR/Throttle.cpp \
+        $$SRC_DIR/Trash.cpp \
+        $$SRC_DIR/TreeRemover.cpp \
+        $$SRC_DIR/Utils.cpp \
+        $$SRC_DIR/WalkFilter.cpp \
+        $$SRC_DIR/WalkVisits.cpp \
+        $$SRC_DIR/MultiFileEditor.cpp
+
+HEADERS += \
+        TreeGenerator.h \
+        $$SRC_DIR/AhoCorasick.h \
+        $$SRC_DIR/Checkpoint.h \
+        $$SRC_DIR/ExecuteJournal.h \
+        $$SRC_DIR/ExecutionPlan.h \
+        $$SRC_DIR/FileFingerprint.h \
+        $$SRC_DIR/FileReader.h \
+        $$SRC_DIR/FileNameMatcher.h \
+        $$SRC_DIR/IgnoreRules.h \
+        $$SRC_DIR/LineMatchers.h \
+        $$SRC_DIR/LinearRegExp.h \
+        $$SRC_DIR/MetadataFilter.h \
+        $$SRC_DIR/MultiFileEditor.h \
+        $$SRC_DIR/MulticolorDelegate.h \
+        $$SRC_DIR/Profiler.h \
+        $$SRC_DIR/Progress.h \
+        $$SRC_DIR/RenamePlan.h \
+        $$SRC_DIR/ReplaceTable.h \
+        $$SRC_DIR/ReplaceTableDialog.h \
+        $$SRC_DIR/ResultExport.h \
+        $$SRC_DIR/ResultStore.h \
+        $$SRC_DIR/SearchRegExp.h \
+        $$SRC_DIR/TaskGroup.h \
+        $$SRC_DIR/Throttle.h \
+        $$SRC_DIR/Trash.h \
+        $$SRC_DIR/TreeRemover.h \
+        $$SRC_DIR/Utils.h \
+        $$SRC_DIR/WalkFilter.h \
+        $$SRC_DIR/WalkVisits.h
+
+FORMS += \
+        $$SRC_DIR/MultiFileEditor.ui
+
+RESOURCES += \
+    $$SRC_DIR/Icons.qrc
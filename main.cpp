@@ -1,3 +1,5 @@
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QTextStream>
 #include <QtCore/QTimer>
 #include <QtWidgets/QApplication>
 
@@ -7,8 +9,33 @@ int main(int argc, char* argv[])
 {
     QApplication::setStyle("Fusion");
     QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption executePlanOption("execute-plan",
+        "Execute a saved execution plan without showing the window and exit (run with -platform offscreen where there's no display).",
+        "file");
+    const QCommandLineOption rootOption("root", "Where a search root of the plan is now, in the order of the plan's roots. Can be repeated.", "dir");
+    parser.addOption(executePlanOption);
+    parser.addOption(rootOption);
+    parser.process(app);
+    // given relative to where it's run from, before it changes
+    const QString planFilePath = parser.isSet(executePlanOption) ? QFileInfo(parser.value(executePlanOption)).absoluteFilePath() : QString();
+    QStringList rootPaths;
+    for (const QString& rootPath : parser.values(rootOption))
+        rootPaths.append(QFileInfo(rootPath).absoluteFilePath());
+
     QDir::setCurrent(qApp->applicationDirPath());
 
+    if (!planFilePath.isEmpty())
+    {
+        MultiFileEditor editor;
+        QString summary;
+        const bool isExecuted = editor.executePlan(planFilePath, rootPaths, summary);
+        QTextStream(isExecuted ? stdout : stderr) << summary << '\n';
+        return isExecuted ? 0 : 1;
+    }
+
     QTimer::singleShot(0, &app, [](){
         MultiFileEditor* w = new MultiFileEditor;
         w->show();
@@ -1,7 +1,8 @@
 QT += \
     core    \
     gui     \
-    widgets
+    widgets \
+    concurrent
 
 TARGET = qMultiFileEditor
 TEMPLATE = app
@@ -37,18 +38,78 @@ UI_DIR      = $$PWD/ui
 
 
 SOURCES += \
+        AhoCorasick.cpp \
+        Checkpoint.cpp \
+        ExecuteJournal.cpp \
+        ExecutionPlan.cpp \
+        FileFingerprint.cpp \
+        FileReader.cpp \
+        FileNameMatcher.cpp \
+        IgnoreRules.cpp \
+        LinearRegExp.cpp \
+        MetadataFilter.cpp \
         MulticolorDelegate.cpp \
+        Profiler.cpp \
+        Progress.cpp \
+        RenamePlan.cpp \
+        ReplaceTable.cpp \
+        ReplaceTableDialog.cpp \
+        ResultExport.cpp \
+        ResultStore.cpp \
+        SearchRegExp.cpp \
+        TaskGroup.cpp \
+        Throttle.cpp \
+        Trash.cpp \
+        TreeRemover.cpp \
         Utils.cpp \
+        WalkFilter.cpp \
+        WalkVisits.cpp \
         main.cpp \
         MultiFileEditor.cpp
 
 HEADERS += \
+        AhoCorasick.h \
+        Checkpoint.h \
+        ExecuteJournal.h \
+        ExecutionPlan.h \
+        FileFingerprint.h \
+        FileReader.h \
+        FileNameMatcher.h \
+        IgnoreRules.h \
+        LineMatchers.h \
+        LinearRegExp.h \
+        MetadataFilter.h \
         MultiFileEditor.h \
         MulticolorDelegate.h \
-        Utils.h
+        Profiler.h \
+        Progress.h \
+        RenamePlan.h \
+        ReplaceTable.h \
+        ReplaceTableDialog.h \
+        ResultExport.h \
+        ResultStore.h \
+        SearchRegExp.h \
+        TaskGroup.h \
+        Throttle.h \
+        Trash.h \
+        TreeRemover.h \
+        Utils.h \
+        WalkFilter.h \
+        WalkVisits.h
 
 FORMS += \
         MultiFileEditor.ui
 
 RESOURCES += \
     Icons.qrc
+
+# `make benchmark` builds bench/qMultiFileEditor_bench.pro in release mode and runs it.
+# Extra arguments for QtTest (e.g. "-iterations 5" or a single test function name) can be passed via BENCH_ARGS.
+BENCH_BUILD_DIR = $$shell_path($$OUT_PWD/build/bench)
+benchmark.commands = \
+    ($(CHK_DIR_EXISTS) $$BENCH_BUILD_DIR || $(MKDIR) $$BENCH_BUILD_DIR) && \
+    cd $$BENCH_BUILD_DIR && \
+    $(QMAKE) $$shell_path($$PWD/bench/qMultiFileEditor_bench.pro) CONFIG+=release && \
+    $(MAKE) && \
+    $$shell_path($$PWD/bin/qMultiFileEditor_bench.release) $(BENCH_ARGS)
+QMAKE_EXTRA_TARGETS += benchmark
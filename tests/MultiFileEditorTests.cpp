@@ -0,0 +1,376 @@
+#include <QtCore/QRandomGenerator>
+#include <QtTest/QtTest>
+
+#include "AhoCorasick.h"
+#include "IgnoreRules.h"
+#include "LinearRegExp.h"
+#include "ReplaceTable.h"
+#include "SearchRegExp.h"
+
+Q_DECLARE_METATYPE(IgnoreRules::Result)
+
+/* Correctness tests of the search building blocks that don't need the window: ignore rules, replace tables and matching engines.
+ * The engines are checked against what they stand in for: LinearRegExp against QRegularExpression, AhoCorasick against QString::indexOf().
+ * Run with "make check" (CONFIG += testcase) or the built binary directly. */
+class MultiFileEditorTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void ignoreRules_data();
+    void ignoreRules();
+    void replaceTable_data();
+    void replaceTable();
+    void linearRegExp_data();
+    void linearRegExp();
+    void linearRegExpRandom();
+    void ahoCorasick_data();
+    void ahoCorasick();
+    void ahoCorasickRandom();
+    void searchRegExpMatchLimit();
+};
+
+namespace
+{
+// Captures of every match as QRegularExpression::globalMatch() finds them: start and end of each group, -1 if it didn't participate
+QVector<QVector<int>> pcreMatches(const QString& pattern, Qt::CaseSensitivity caseSensitivity, const QString& text)
+{
+    const QRegularExpression regExp(pattern, (caseSensitivity == Qt::CaseInsensitive) ? QRegularExpression::CaseInsensitiveOption
+                                                                                       : QRegularExpression::NoPatternOption);
+    QVector<QVector<int>> matches;
+    QRegularExpressionMatchIterator matchIter = regExp.globalMatch(text);
+    while (matchIter.hasNext())
+    {
+        const QRegularExpressionMatch match = matchIter.next();
+        QVector<int> captures;
+        for (int group = 0; group <= regExp.captureCount(); ++group)
+            captures << match.capturedStart(group) << match.capturedEnd(group);
+        matches.append(captures);
+    }
+    return matches;
+}
+
+// Same iteration as SearchRegExp::matchLine() does with LinearRegExp
+QVector<QVector<int>> linearMatches(const LinearRegExp& regExp, const QString& text)
+{
+    QVector<QVector<int>> matches;
+    LinearRegExp::MatchContext context;
+    QVector<int> captures;
+    int position = 0;
+    bool isNotEmptyAtOffset = false;
+    while ((position <= text.size()) && regExp.match(text, position, isNotEmptyAtOffset, captures, context))
+    {
+        matches.append(captures);
+        isNotEmptyAtOffset = (captures.at(0) == captures.at(1));
+        position = captures.at(1);
+    }
+    return matches;
+}
+
+// Random pattern over the syntax LinearRegExp supports, mixing in characters outside of ASCII and the BMP
+QString randomPattern(QRandomGenerator& random, int depth = 0)
+{
+    static const QStringList atoms{"a", "b", "c", "1", ".", "[ab]", "[^a]", "[a-c]", "\\d", "\\w", "\\s", "\\W", "[^\\d]", " ",
+                                   QStringLiteral("\u00e9"), QStringLiteral("\U0001F600"), QStringLiteral("[\U0001F600b]"),
+                                   QStringLiteral("[^\U0001F600]"), "\\x{1F600}", "\\."};
+    static const QStringList quantifiers{"*", "+", "?", "{0,2}", "{2}", "{1,}", "*?", "+?", "??", "{1,3}?"};
+    static const QStringList assertions{"^", "$", "\\b", "\\B"};
+    QString pattern;
+    const int atomCount = int(random.bounded(depth ? 0 : 1, 4));
+    for (int i = 0; i < atomCount; ++i)
+    {
+        const int kind = (depth > 2) ? 0 : int(random.bounded(20));
+        QString atom;
+        if (kind < 12)
+            atom = atoms.at(int(random.bounded(atoms.size())));
+        else if (kind < 14)
+            atom = "(" + randomPattern(random, depth + 1) + ")";
+        else if (kind < 16)
+            atom = "(?:" + randomPattern(random, depth + 1) + ")";
+        else if (kind < 18)
+            atom = "(" + randomPattern(random, depth + 1) + "|" + randomPattern(random, depth + 1) + ")";
+        else
+        {
+            pattern += assertions.at(int(random.bounded(assertions.size())));
+            continue;
+        }
+        if (random.bounded(2))
+            atom += quantifiers.at(int(random.bounded(quantifiers.size())));
+        pattern += atom;
+    }
+    return pattern;
+}
+
+QString randomText(QRandomGenerator& random, const QStringList& chars, int maxLength)
+{
+    QString text;
+    const int length = int(random.bounded(maxLength + 1));
+    for (int i = 0; i < length; ++i)
+        text += chars.at(int(random.bounded(chars.size())));
+    return text;
+}
+
+// Leftmost-longest non-overlapping matches found by QString::indexOf(), the first of identical patterns winning
+QVector<AhoCorasick::Match> indexOfMatches(const QStringList& patterns, Qt::CaseSensitivity caseSensitivity, const QString& text)
+{
+    QVector<AhoCorasick::Match> matches;
+    int from = 0;
+    while (true)
+    {
+        AhoCorasick::Match best{-1, 0, -1};
+        for (int patternIdx = 0; patternIdx < patterns.size(); ++patternIdx)
+        {
+            const QString& pattern = patterns.at(patternIdx);
+            if (pattern.isEmpty())
+                continue;
+            const int start = text.indexOf(pattern, from, caseSensitivity);
+            if ((start != -1) && ((best.start == -1) || (start < best.start) || ((start == best.start) && (pattern.size() > best.length))))
+                best = AhoCorasick::Match{start, pattern.size(), patternIdx};
+        }
+        if (best.start == -1)
+            return matches;
+        matches.append(best);
+        from = best.start + best.length;
+    }
+}
+
+QString matchesToString(const QVector<AhoCorasick::Match>& matches)
+{
+    QStringList parts;
+    for (const AhoCorasick::Match& match : matches)
+        parts << QString("%1+%2:%3").arg(match.start).arg(match.length).arg(match.patternIdx);
+    return parts.join(' ');
+}
+}
+
+void MultiFileEditorTests::ignoreRules_data()
+{
+    QTest::addColumn<QStringList>("patterns");
+    QTest::addColumn<QString>("relativePath");
+    QTest::addColumn<bool>("isDir");
+    QTest::addColumn<IgnoreRules::Result>("result");
+
+    using Result = IgnoreRules::Result;
+    QTest::newRow("name_at_root") << QStringList{"build"} << "build" << true << Result::Ignored;
+    QTest::newRow("name_nested") << QStringList{"build"} << "x/y/build" << true << Result::Ignored;
+    QTest::newRow("dir_only_file") << QStringList{"build/"} << "x/build" << false << Result::NoMatch;
+    QTest::newRow("suffix") << QStringList{"*.o"} << "x/main.o" << false << Result::Ignored;
+    QTest::newRow("prefix") << QStringList{"tmp*"} << "x/tmp_1" << false << Result::Ignored;
+    QTest::newRow("negated") << QStringList{"*.o", "!keep.o"} << "x/keep.o" << false << Result::Included;
+    QTest::newRow("anchored_root") << QStringList{"/build"} << "build" << true << Result::Ignored;
+    QTest::newRow("anchored_nested") << QStringList{"/build"} << "x/build" << true << Result::NoMatch;
+    QTest::newRow("path_at_root") << QStringList{"a/b"} << "a/b" << false << Result::Ignored;
+    QTest::newRow("path_nested") << QStringList{"a/b"} << "x/a/b" << false << Result::NoMatch;
+    QTest::newRow("any_dirs_name") << QStringList{"**/b"} << "x/y/b" << false << Result::Ignored;
+    QTest::newRow("any_dirs_path_at_root") << QStringList{"**/a/b"} << "a/b" << false << Result::Ignored;
+    QTest::newRow("any_dirs_path_nested") << QStringList{"**/a/b"} << "x/y/a/b" << false << Result::Ignored;
+    QTest::newRow("any_dirs_path_other") << QStringList{"**/a/b"} << "x/a/c/b" << false << Result::NoMatch;
+    QTest::newRow("middle_any_dirs") << QStringList{"a/**/b"} << "a/x/y/b" << false << Result::Ignored;
+    QTest::newRow("middle_any_dirs_none") << QStringList{"a/**/b"} << "a/b" << false << Result::Ignored;
+    QTest::newRow("everything_inside") << QStringList{"a/**"} << "a/x/y" << false << Result::Ignored;
+    QTest::newRow("char_class") << QStringList{"file[0-9].txt"} << "x/file7.txt" << false << Result::Ignored;
+}
+
+void MultiFileEditorTests::ignoreRules()
+{
+    QFETCH(QStringList, patterns);
+    QFETCH(QString, relativePath);
+    QFETCH(bool, isDir);
+    QFETCH(IgnoreRules::Result, result);
+
+    IgnoreRules rules;
+    for (const QString& pattern : patterns)
+        rules.addPattern(pattern);
+    const QString name = relativePath.mid(relativePath.lastIndexOf('/') + 1);
+    QCOMPARE(rules.match(name, relativePath, isDir), result);
+}
+
+void MultiFileEditorTests::replaceTable_data()
+{
+    // pairs as lines of a table file: "search<TAB>replace[<TAB>re]"
+    QTest::addColumn<QStringList>("pairs");
+    QTest::addColumn<QString>("line");
+    QTest::addColumn<QString>("replaced"); // empty if compile() is expected to fail
+
+    QTest::newRow("literals") << QStringList{"a\tA", "bc\tBC"} << "abcab" << "ABCAb";
+    QTest::newRow("longest_literal") << QStringList{"ab\t1", "abc\t2"} << "abcd" << "2d";
+    QTest::newRow("regexp") << QStringList{"[0-9]+\tN\tre"} << "a12b3" << "aNbN";
+    QTest::newRow("regexp_group") << QStringList{"(\\w)=(\\w)\t\\2=\\1\tre"} << "a=b c=d" << "b=a d=c";
+    QTest::newRow("literal_before_regexp") << QStringList{"xa\tL", "a[a-z]*\tR\tre"} << "xabc" << "Lbc";
+    QTest::newRow("longer_regexp_on_tie") << QStringList{"ab\tL", "ab[a-z]\tR\tre"} << "abcd" << "Rd";
+    // a match dropped for overlapping a taken one doesn't hide the one starting inside it
+    QTest::newRow("regexp_inside_dropped_regexp") << QStringList{"ab\tX", "bcd|c\tY\tre"} << "abcd" << "XYd";
+    QTest::newRow("literal_inside_dropped_literal") << QStringList{"a.\tR\tre", "bcd\tL1", "c\tL2"} << "abcd" << "RL2d";
+    QTest::newRow("named_backreference") << QStringList{"(?<c>[a-z])\\k<c>\tD\tre"} << "abbc" << "aDc";
+    QTest::newRow("numbered_backreference") << QStringList{"([a-z])\\1\tD\tre"} << "abbc" << "";
+    QTest::newRow("relative_backreference") << QStringList{"([a-z])\\g{-1}\tD\tre"} << "abbc" << "";
+    QTest::newRow("escaped_digit_in_class") << QStringList{"[\\1-3]\tD\tre"} << "a2" << "aD";
+}
+
+void MultiFileEditorTests::replaceTable()
+{
+    QFETCH(QStringList, pairs);
+    QFETCH(QString, line);
+    QFETCH(QString, replaced);
+
+    QVector<ReplaceTable::Pair> tablePairs;
+    for (const QString& pairLine : pairs)
+    {
+        const QStringList fields = pairLine.split('\t');
+        tablePairs.append(ReplaceTable::Pair{fields.at(0), fields.value(1), fields.value(2) == QLatin1String("re")});
+    }
+    ReplaceTable table;
+    table.setPairs(tablePairs);
+    const bool isCompiled = table.compile(Qt::CaseSensitive);
+    QCOMPARE(isCompiled, !replaced.isEmpty());
+    if (!isCompiled)
+        return;
+    QVector<ReplaceTable::Match> matches;
+    table.matchLine(line, matches);
+    QCOMPARE(ReplaceTable::replaced(line, matches), replaced);
+}
+
+void MultiFileEditorTests::linearRegExp_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<bool>("isCaseSensitive");
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<bool>("isValid"); // supported by LinearRegExp, otherwise left to PCRE
+
+    const QString smiley = QStringLiteral("\U0001F600");
+    QTest::newRow("literal") << "ab" << true << "xabyab" << true;
+    QTest::newRow("alternation_first_wins") << "a|ab" << true << "abab" << true;
+    QTest::newRow("captures") << "(\\w+)=(\\d*)" << true << "a=1 b= c=23" << true;
+    QTest::newRow("lazy") << "<(.+?)>" << true << "<a><b>" << true;
+    QTest::newRow("counted") << "(a|b){2,3}" << true << "ababab" << true;
+    QTest::newRow("empty_matches") << "x*" << true << "axxb" << true;
+    QTest::newRow("anchors") << "^a|b$|\\bc\\B" << true << "abcd cb" << true;
+    QTest::newRow("case_insensitive") << QStringLiteral("[a-c]\u00e9") << false << QStringLiteral("A\u00c9 b\u00e9") << true;
+    QTest::newRow("backtracking_prone") << "(a+)+b" << true << "aaaaaaaaaaaaaaaaaaaaaaaac aab" << true;
+    QTest::newRow("astral_literal") << smiley + "+" << true << "a" + smiley + smiley + "b" << true;
+    QTest::newRow("astral_dot") << "a.b" << true << "a" + smiley + "b a" + smiley << true;
+    QTest::newRow("astral_negated_class") << "[^a]" << true << smiley + "a" + smiley << true;
+    QTest::newRow("astral_class_range") << "[\\x{1F600}-\\x{1F64F}]" << true << "x" + smiley + "y" << true;
+    QTest::newRow("astral_empty_matches") << "b*" << true << smiley + "b" + smiley << true;
+    QTest::newRow("nullable_repeat") << "(a?)+" << true << "aab" << false;
+    QTest::newRow("backreference") << "(a)\\1" << true << "aa" << false;
+    QTest::newRow("lookahead") << "a(?=b)" << true << "ab" << false;
+}
+
+void MultiFileEditorTests::linearRegExp()
+{
+    QFETCH(QString, pattern);
+    QFETCH(bool, isCaseSensitive);
+    QFETCH(QString, text);
+    QFETCH(bool, isValid);
+
+    const Qt::CaseSensitivity caseSensitivity = isCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    const LinearRegExp regExp(pattern, caseSensitivity);
+    QCOMPARE(regExp.isValid(), isValid);
+    if (isValid)
+        QCOMPARE(linearMatches(regExp, text), pcreMatches(pattern, caseSensitivity, text));
+}
+
+void MultiFileEditorTests::linearRegExpRandom()
+{
+    QRandomGenerator random(1);
+    const QStringList textChars{"a", "b", "c", "A", "B", "1", "2", " ", "\n", "_", ".", QStringLiteral("\u00e9"),
+                                QStringLiteral("\u00c9"), QStringLiteral("\U0001F600")};
+    int checkedCount = 0;
+    for (int i = 0; i < 3000; ++i)
+    {
+        QString pattern = randomPattern(random);
+        if (random.bounded(3) == 0)
+            pattern += "|" + randomPattern(random);
+        const QString text = randomText(random, textChars, 12);
+        const Qt::CaseSensitivity caseSensitivity = (random.bounded(4) == 0) ? Qt::CaseInsensitive : Qt::CaseSensitive;
+        const LinearRegExp regExp(pattern, caseSensitivity);
+        if (!regExp.isValid())
+            continue;
+        ++checkedCount;
+        const QVector<QVector<int>> linear = linearMatches(regExp, text);
+        const QVector<QVector<int>> pcre = pcreMatches(pattern, caseSensitivity, text);
+        if (linear != pcre)
+            qWarning().noquote() << "pattern" << pattern << "text" << text << "case sensitive" << (caseSensitivity == Qt::CaseSensitive);
+        QCOMPARE(linear, pcre);
+    }
+    // a good part of the patterns is supported, otherwise the comparison above proves little
+    QVERIFY(checkedCount > 1000);
+}
+
+void MultiFileEditorTests::ahoCorasick_data()
+{
+    QTest::addColumn<QStringList>("patterns");
+    QTest::addColumn<bool>("isCaseSensitive");
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("single") << QStringList{"ab"} << true << "xabyabab";
+    QTest::newRow("longest_at_start") << QStringList{"a", "ab", "abc"} << true << "abcab";
+    QTest::newRow("leftmost_over_longest") << QStringList{"bcd", "ab"} << true << "abcd";
+    QTest::newRow("suffix_of_other") << QStringList{"abcd", "bc"} << true << "abcabcd";
+    QTest::newRow("repeated_char") << QStringList{"aa", "aaa"} << true << "aaaaaaa";
+    QTest::newRow("identical_first_wins") << QStringList{"ab", "ab"} << true << "abab";
+    QTest::newRow("case_insensitive") << QStringList{"Ab", "AB"} << false << "ab aB AB";
+    QTest::newRow("case_insensitive_non_ascii") << QStringList{QStringLiteral("\u00e9t\u00e9")} << false << QStringLiteral("\u00c9T\u00c9 \u00e9t\u00e9");
+    QTest::newRow("empty_pattern") << QStringList{"", "b"} << true << "abc";
+    QTest::newRow("astral") << QStringList{QStringLiteral("\U0001F600a")} << true << QStringLiteral("\U0001F600\U0001F600a");
+}
+
+void MultiFileEditorTests::ahoCorasick()
+{
+    QFETCH(QStringList, patterns);
+    QFETCH(bool, isCaseSensitive);
+    QFETCH(QString, text);
+
+    const Qt::CaseSensitivity caseSensitivity = isCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    const AhoCorasick automaton(patterns, caseSensitivity);
+    QVector<AhoCorasick::Match> matches;
+    automaton.findAll(text, matches);
+    QCOMPARE(matchesToString(matches), matchesToString(indexOfMatches(patterns, caseSensitivity, text)));
+}
+
+void MultiFileEditorTests::ahoCorasickRandom()
+{
+    QRandomGenerator random(1);
+    const QStringList chars{"a", "b", "c", "A", "B", QStringLiteral("\u00e9"), QStringLiteral("\u00c9")};
+    for (int i = 0; i < 2000; ++i)
+    {
+        QStringList patterns;
+        const int patternCount = int(random.bounded(1, 6));
+        for (int patternIdx = 0; patternIdx < patternCount; ++patternIdx)
+            patterns << randomText(random, chars, 4);
+        const QString text = randomText(random, chars, 30);
+        const Qt::CaseSensitivity caseSensitivity = random.bounded(2) ? Qt::CaseInsensitive : Qt::CaseSensitive;
+        const AhoCorasick automaton(patterns, caseSensitivity);
+        QVector<AhoCorasick::Match> matches;
+        automaton.findAll(text, matches);
+        QCOMPARE(matchesToString(matches), matchesToString(indexOfMatches(patterns, caseSensitivity, text)));
+    }
+}
+
+void MultiFileEditorTests::searchRegExpMatchLimit()
+{
+    // exponential backtracking in PCRE: the match limit ends it and the line is reported as timed out instead of unmatched
+    const QString line = QString(30, 'a') + "x";
+    const SearchRegExp limited(QRegularExpression("(a+)+\\d"), QString(), SearchRegExp::Engine::Pcre, 10000);
+    SearchRegExp::MatchContext context;
+    QVector<SearchRegExp::Match> matches;
+    QString replacedLine;
+    QVERIFY(!limited.matchLine(line, matches, replacedLine, context));
+    QVERIFY(context.isTimedOut());
+
+    // the deadline is checked between matches
+    const SearchRegExp everyChar(QRegularExpression("."), QString(), SearchRegExp::Engine::Linear);
+    QElapsedTimer timer;
+    timer.start();
+    context.setDeadline(&timer, -1);
+    QVERIFY(!everyChar.matchLine(line, matches, replacedLine, context));
+    QVERIFY(context.isTimedOut());
+    context.setDeadline(nullptr, 0);
+    QVERIFY(everyChar.matchLine(line, matches, replacedLine, context));
+    QVERIFY(!context.isTimedOut());
+    QCOMPARE(matches.size(), line.size());
+}
+
+QTEST_MAIN(MultiFileEditorTests)
+#include "MultiFileEditorTests.moc"
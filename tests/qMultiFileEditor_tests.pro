@@ -0,0 +1,41 @@
+QT += \
+    core    \
+    testlib
+
+TARGET = qMultiFileEditor_tests
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG += warn_on
+CONFIG += testcase
+CONFIG -= app_bundle
+win32: !contains(CONFIG, build_all): CONFIG -= debug_and_release
+
+CONFIG(debug, debug|release) {
+    BUILD_TYPE = debug
+    DEFINES *= DEBUG_BUILD
+}
+CONFIG(release, debug|release) {
+    BUILD_TYPE = release
+    DEFINES *= RELEASE_BUILD
+    QMAKE_CXXFLAGS += -O2
+}
+
+SRC_DIR     = $$PWD/..
+DESTDIR     = $$SRC_DIR/bin
+TARGET      = $${TARGET}.$${BUILD_TYPE}
+INCLUDEPATH += $$SRC_DIR
+
+SOURCES += \
+        MultiFileEditorTests.cpp \
+        $$SRC_DIR/AhoCorasick.cpp \
+        $$SRC_DIR/IgnoreRules.cpp \
+        $$SRC_DIR/LinearRegExp.cpp \
+        $$SRC_DIR/ReplaceTable.cpp \
+        $$SRC_DIR/SearchRegExp.cpp
+
+HEADERS += \
+        $$SRC_DIR/AhoCorasick.h \
+        $$SRC_DIR/IgnoreRules.h \
+        $$SRC_DIR/LinearRegExp.h \
+        $$SRC_DIR/ReplaceTable.h \
+        $$SRC_DIR/SearchRegExp.h